@@ -105,6 +105,17 @@ def _validate_server_name(name: str) -> None:
 
 
 def _render_toml(data: dict[str, Any]) -> str:
+    # Plain keys must come before the first table, or TOML would read them as part of it
+    lines = _render_toml_keys({k: v for k, v in data.items() if not isinstance(v, dict)})
+    for table_name, table in data.items():
+        if isinstance(table, dict):
+            lines.append("")
+            lines.append(f"[{table_name}]")
+            lines.extend(_render_toml_keys(table))
+    return "\n".join(lines) + "\n"
+
+
+def _render_toml_keys(data: dict[str, Any]) -> list[str]:
     lines: list[str] = []
     for key, value in data.items():
         if isinstance(value, str):
@@ -133,7 +144,7 @@ def _render_toml(data: dict[str, Any]) -> str:
             raise DeploymentError(
                 f"Unsupported TOML value type for key '{key}': {type(value).__name__}"
             )
-    return "\n".join(lines) + "\n"
+    return lines
 
 
 def _convert_value_to_template_type(template_value: Any, incoming_value: Any) -> Any:
@@ -390,11 +401,15 @@ def deploy_service(service_name: str, server_name: str, params: dict[str, Any])
     with toml_template_path.open("rb") as fh:
         template_data = tomllib.load(fh)
 
+    # Tables (e.g. [risk_limits] in oms.toml) are copied as they are; only top-level keys can be
+    # overridden
     if not isinstance(template_data, dict) or any(
-        isinstance(v, dict) for v in template_data.values()
+        isinstance(v, dict) and any(isinstance(nested, dict) for nested in v.values())
+        for v in template_data.values()
     ):
         raise DeploymentError(
-            f"Template TOML must be a flat key/value document: {toml_template_path}"
+            f"Template TOML must be key/values with at most one level of tables: "
+            f"{toml_template_path}"
         )
 
     gateway_special_keys = {"fix_server_port", "whitelist"}
@@ -419,7 +434,10 @@ def deploy_service(service_name: str, server_name: str, params: dict[str, Any])
         allowed_non_template_keys = set()
     
     unknown_keys = [
-        k for k in params.keys() if k not in template_data and k not in allowed_non_template_keys
+        k
+        for k in params.keys()
+        if (k not in template_data or isinstance(template_data[k], dict))
+        and k not in allowed_non_template_keys
     ]
     if unknown_keys:
         raise DeploymentError(
@@ -1,4 +1,4 @@
-import React, {useRef, useEffect, useState, useCallback} from 'react';
+import React, {useRef, useEffect, useState, useCallback, useMemo} from 'react';
 import {useParams, useNavigate, useLocation} from 'react-router-dom';
 import {createChart} from 'lightweight-charts';
 import useWebSocket from './hooks/useWebSocket';
@@ -437,7 +437,14 @@ function App() {
         }
     }, [ingestTrade, normalizeBookLevels, normalizeTimestampMs]);
 
-    const {isConnected} = useWebSocket(mdpEndpoint, handleMessage);
+    // Only the selected ticker's trades and book are streamed from the MDP
+    const mdpSubscriptions = useMemo(
+        () => selectedTicker
+            ? [{symbol: selectedTicker, channel: 'trades'}, {symbol: selectedTicker, channel: 'depth'}]
+            : [],
+        [selectedTicker]
+    );
+    const {isConnected} = useWebSocket(mdpEndpoint, handleMessage, mdpSubscriptions);
 
     // Initialize chart once
     useEffect(() => {
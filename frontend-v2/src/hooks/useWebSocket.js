@@ -1,6 +1,15 @@
 import {useEffect, useRef, useState, useCallback} from 'react';
 
-export default function useWebSocket(url, onMessage) {
+const subscriptionKey = ({symbol, channel}) => `${symbol}:${channel}`;
+
+const sendSubscription = (ws, op, {symbol, channel, levels}) => {
+    const request = levels === undefined ? {op, symbol, channel} : {op, symbol, channel, levels};
+    ws.send(JSON.stringify(request));
+};
+
+// subscriptions lists the {symbol, channel, levels?} the server should send, channel being trades,
+// depth or top_of_book. Leave it undefined to receive every message of every symbol.
+export default function useWebSocket(url, onMessage, subscriptions) {
     const [isConnected, setIsConnected] = useState(false);
     const wsRef = useRef(null);
     // Keep onMessage in a ref so the WebSocket never needs to reconnect when the
@@ -10,6 +19,10 @@ export default function useWebSocket(url, onMessage) {
         onMessageRef.current = onMessage;
     }, [onMessage]);
 
+    // What the server has been asked for on the current socket
+    const subscriptionsRef = useRef(subscriptions);
+    const sentSubscriptionsRef = useRef(new Map());
+
     const reconnectTimerRef = useRef(null);
     const intentionalCloseRef = useRef(false);
 
@@ -23,6 +36,11 @@ export default function useWebSocket(url, onMessage) {
 
         ws.onopen = () => {
             console.log('WebSocket connected');
+            sentSubscriptionsRef.current = new Map();
+            for (const subscription of subscriptionsRef.current ?? []) {
+                sendSubscription(ws, 'subscribe', subscription);
+                sentSubscriptionsRef.current.set(subscriptionKey(subscription), subscription);
+            }
             setIsConnected(true);
         };
 
@@ -61,5 +79,30 @@ export default function useWebSocket(url, onMessage) {
         };
     }, [connect]);
 
+    // Only the difference goes out when the subscriptions change, e.g. on a ticker switch
+    useEffect(() => {
+        subscriptionsRef.current = subscriptions;
+        const ws = wsRef.current;
+        if (!subscriptions || !ws || ws.readyState !== WebSocket.OPEN) {
+            return;
+        }
+        const wanted = new Map(
+            subscriptions.map((subscription) => [subscriptionKey(subscription), subscription])
+        );
+        for (const [key, subscription] of sentSubscriptionsRef.current) {
+            if (!wanted.has(key)) {
+                sendSubscription(ws, 'unsubscribe', subscription);
+                sentSubscriptionsRef.current.delete(key);
+            }
+        }
+        for (const [key, subscription] of wanted) {
+            const sent = sentSubscriptionsRef.current.get(key);
+            if (!sent || sent.levels !== subscription.levels) {
+                sendSubscription(ws, 'subscribe', subscription);
+                sentSubscriptionsRef.current.set(key, subscription);
+            }
+        }
+    }, [subscriptions]);
+
     return {isConnected};
 }
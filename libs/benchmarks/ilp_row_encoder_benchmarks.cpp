@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include "database/ilp_row_encoder.h"
+
+#include <cstddef>
+#include <format>
+#include <string>
+
+// Rows per buffer before it is cleared, as the AsyncWriter's default flush_threshold
+static constexpr std::size_t rows_per_flush{64};
+
+static core::NewOrderSingleContainer make_new_order() {
+    return core::NewOrderSingleContainer{.sender_comp_id = "BENCHMARK_CLIENT_0001",
+                                         .target_comp_id = "ELSA",
+                                         .order_id = std::nullopt,
+                                         .cl_ord_id = 42,
+                                         .symbol = "AAPL",
+                                         .side = core::Side::bid,
+                                         .order_qty = 100,
+                                         .ord_type = core::OrderType::limit,
+                                         .price = 18'250,
+                                         .time_in_force = core::TimeInForce::day};
+}
+
+static core::ExecutionReportContainer make_execution_report() {
+    return core::ExecutionReportContainer{.sender_comp_id = "BENCHMARK_CLIENT_0001",
+                                          .target_comp_id = "ELSA",
+                                          .order_id = 1'000'001,
+                                          .cl_order_id = 42,
+                                          .orig_cl_ord_id = std::nullopt,
+                                          .exec_id = "E1000001",
+                                          .exec_trans_type = core::ExecTransType::exec_trans_new,
+                                          .exec_type = core::ExecType::status_partially_filled,
+                                          .ord_status = core::OrderStatus::status_partially_filled,
+                                          .text = std::nullopt,
+                                          .symbol = "AAPL",
+                                          .side = core::Side::bid,
+                                          .price = 18'250,
+                                          .time_in_force = core::TimeInForce::day,
+                                          .leaves_qty = 60,
+                                          .cum_qty = 40,
+                                          .avg_px = 18'250};
+}
+
+static core::TradeContainer make_trade() {
+    return core::TradeContainer{.ticker = "AAPL",
+                                .price = 18'250,
+                                .quantity = 40,
+                                .trade_id = "T1000001",
+                                .taker_id = "BENCHMARK_CLIENT_0001",
+                                .maker_id = "BENCHMARK_CLIENT_0002",
+                                .taker_order_id = 1'000'001,
+                                .maker_order_id = 1'000'000,
+                                .is_taker_buyer = true};
+}
+
+// Appends rows one writer thread's worth at a time; items_per_second is rows/s per writer
+template <typename AppendRow>
+static void run_encoder_benchmark(benchmark::State& state, AppendRow&& append_row) {
+    questdb::ingress::line_sender_buffer buffer{questdb::ingress::protocol_version::v1};
+    std::size_t buffered_rows{0};
+
+    for (auto _ : state) {
+        append_row(buffer);
+        if (++buffered_rows == rows_per_flush) {
+            benchmark::DoNotOptimize(buffer.size());
+            buffer.clear();
+            buffered_rows = 0;
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+
+static void BM_IlpRowEncoder_NewOrder(benchmark::State& state) {
+    const database::IlpRowEncoder row_encoder{"benchmark"};
+    const auto new_order = make_new_order();
+    run_encoder_benchmark(state, [&](questdb::ingress::line_sender_buffer& buffer) {
+        row_encoder.append(buffer, new_order, 1'000'001, true);
+    });
+}
+
+static void BM_IlpRowEncoder_ExecutionReport(benchmark::State& state) {
+    const database::IlpRowEncoder row_encoder{"benchmark"};
+    const auto execution_report = make_execution_report();
+    run_encoder_benchmark(state, [&](questdb::ingress::line_sender_buffer& buffer) {
+        row_encoder.append(buffer, execution_report);
+    });
+}
+
+static void BM_IlpRowEncoder_Trade(benchmark::State& state) {
+    const database::IlpRowEncoder row_encoder{"benchmark"};
+    const auto trade = make_trade();
+    run_encoder_benchmark(state, [&](questdb::ingress::line_sender_buffer& buffer) {
+        row_encoder.append(buffer, trade);
+    });
+}
+
+// What a fill costs the writer: the taker's and maker's reports plus the trade
+static void BM_IlpRowEncoder_Fill(benchmark::State& state) {
+    const database::IlpRowEncoder row_encoder{"benchmark"};
+    const auto execution_report = make_execution_report();
+    const auto trade = make_trade();
+    run_encoder_benchmark(state, [&](questdb::ingress::line_sender_buffer& buffer) {
+        row_encoder.append(buffer, execution_report);
+        row_encoder.append(buffer, execution_report);
+        row_encoder.append(buffer, trade);
+    });
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * 3);
+}
+
+// Baseline: table and column names formatted and validated for every row, as the writer used to
+static void BM_IlpRowNamesPerRow_Trade(benchmark::State& state) {
+    using namespace questdb::ingress::literals;
+    const auto trade = make_trade();
+    run_encoder_benchmark(state, [&](questdb::ingress::line_sender_buffer& buffer) {
+        const auto trades_table_name = std::format("trades_{}", "benchmark");
+        const questdb::ingress::table_name_view trades_table{trades_table_name.c_str(),
+                                                             trades_table_name.length()};
+        buffer.table(trades_table)
+            .symbol("symbol"_cn, trade.ticker)
+            .column("price"_cn, static_cast<std::int64_t>(trade.price))
+            .column("quantity"_cn, static_cast<std::int64_t>(trade.quantity))
+            .column("trade_id"_cn, trade.trade_id)
+            .column("taker_id"_cn, trade.taker_id)
+            .column("maker_id"_cn, trade.maker_id)
+            .column("taker_order_id"_cn, static_cast<std::int64_t>(trade.taker_order_id))
+            .column("maker_order_id"_cn, static_cast<std::int64_t>(trade.maker_order_id))
+            .column("is_taker_buyer"_cn, trade.is_taker_buyer)
+            .at(questdb::ingress::timestamp_micros::now());
+    });
+}
+
+BENCHMARK(BM_IlpRowEncoder_NewOrder);
+BENCHMARK(BM_IlpRowEncoder_ExecutionReport);
+BENCHMARK(BM_IlpRowEncoder_Trade);
+BENCHMARK(BM_IlpRowEncoder_Fill);
+BENCHMARK(BM_IlpRowNamesPerRow_Trade);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,319 @@
+// Cross-process shared-memory IPC benchmarks.
+//
+// Every case maps a real shm_open-backed channel: the benchmark process creates it and consumes,
+// and forked producer processes open it with open_exist_shm, mirroring the engine -> MDP topology.
+// Producers stamp publish_timestamp_ns before pushing, so the reported percentiles are end-to-end
+// push-to-read latency under the given contention, including time spent queued in the channel.
+//
+// The production channels (the trade broadcast ring and the orderbook snapshot seqlock slot) have
+// a single producer that never waits, so a slow reader loses messages instead of stalling it. Their
+// cases report delivered_ratio, the share of published messages the reader actually saw.
+//
+// Arguments: producers (1-8, MPSC only) x pinned (0 = scheduler decides, 1 = consumer on core 0,
+// producer i on core i + 1). Machine-readable output for regression tracking:
+//   ipc_ring_buffer_benchmark --benchmark_out=ipc.json --benchmark_out_format=json
+// or build the ipc_benchmark_json target.
+
+#include <benchmark/benchmark.h>
+
+#include "core/latency_histogram.h"
+#include "core/orderbook_snapshot.h"
+#include "core/trade.h"
+#include "inter_process/broadcast_shared_memory_ring_buffer.h"
+#include "inter_process/mpsc_shared_memory_ring_buffer.h"
+#include "inter_process/seqlock_shared_memory_slot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+constexpr std::int64_t messages_per_producer = 4096;
+constexpr std::uint64_t stop_generation = UINT64_MAX;
+
+// Lives in an anonymous MAP_SHARED mapping so it survives fork() shared between all processes.
+struct ProducerControl {
+    alignas(64) std::atomic<std::uint64_t> generation{0};
+    alignas(64) std::atomic<std::uint32_t> ready{0};
+    // Generations every producer has finished publishing, summed over producers
+    alignas(64) std::atomic<std::uint64_t> published{0};
+};
+
+bool pin_to_core(int core) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    const int core_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    CPU_SET(core % core_count, &cpu_set);
+    return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+template <typename T>
+T make_payload() {
+    if constexpr (std::is_same_v<T, Trade>) {
+        return Trade{"AAPL", 17000, 100, "00000000-0000-0000-0000-000000000000",
+                     "taker", "maker", 1, 2, true, 0};
+    } else {
+        TopOrderBookLevelAggregates snapshot{"AAPL", 0};
+        for (int i = 0; i < core::constants::ORDER_BOOK_AGGREGATE_LEVELS; ++i) {
+            snapshot.bid_level_aggregates[i] = {17000 - i, 100};
+            snapshot.ask_level_aggregates[i] = {17001 + i, 100};
+        }
+        return snapshot;
+    }
+}
+
+template <typename T, typename Channel>
+[[noreturn]] void run_producer(const std::string& shm_prefix, ProducerControl& control,
+                               int producer_index, bool pinned) {
+    if (pinned) {
+        pin_to_core(producer_index + 1);
+    }
+    auto channel = Channel::open_exist_shm(shm_prefix);
+    T payload = make_payload<T>();
+    control.ready.fetch_add(1, std::memory_order_acq_rel);
+
+    std::uint64_t seen_generation = 0;
+    while (true) {
+        std::uint64_t generation;
+        while ((generation = control.generation.load(std::memory_order_acquire)) ==
+               seen_generation) {
+            std::this_thread::yield();
+        }
+        if (generation == stop_generation) {
+            // skip destructors: the parent owns and unlinks the shm
+            _exit(0);
+        }
+        seen_generation = generation;
+        for (std::int64_t i = 0; i < messages_per_producer; ++i) {
+            payload.publish_timestamp_ns = core::steady_clock_ns();
+            if constexpr (requires { channel.push_blocking(payload); }) {
+                channel.push_blocking(payload);
+            } else {
+                channel.try_push(payload);
+            }
+        }
+        control.published.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+// Forks producer_count producers onto channel, then times one generation per iteration.
+// consume(generation) reads what the producers publish for that generation and returns how many
+// messages it saw. Returns the total seen, or nullopt if the run was skipped.
+template <typename T, typename Channel, typename Consume>
+std::optional<std::int64_t> run_cross_process(benchmark::State& state,
+                                              const std::string& shm_prefix, int producer_count,
+                                              bool pinned, ProducerControl& control,
+                                              Consume consume) {
+#ifdef __linux__
+    cpu_set_t original_affinity;
+    sched_getaffinity(0, sizeof(original_affinity), &original_affinity);
+#endif
+    if (pinned && !pin_to_core(0)) {
+        state.SkipWithError("Core pinning is not supported on this platform");
+        return std::nullopt;
+    }
+
+    std::vector<pid_t> producers;
+    const auto stop_producers = [&] {
+        control.generation.store(stop_generation, std::memory_order_release);
+        for (const pid_t pid : producers) {
+            waitpid(pid, nullptr, 0);
+        }
+#ifdef __linux__
+        sched_setaffinity(0, sizeof(original_affinity), &original_affinity);
+#endif
+    };
+
+    for (int i = 0; i < producer_count; ++i) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            stop_producers();
+            state.SkipWithError("Failed to fork a producer process");
+            return std::nullopt;
+        }
+        if (pid == 0) {
+            run_producer<T, Channel>(shm_prefix, control, i, pinned);
+        }
+        producers.push_back(pid);
+    }
+    while (control.ready.load(std::memory_order_acquire) <
+           static_cast<std::uint32_t>(producer_count)) {
+        std::this_thread::yield();
+    }
+
+    std::int64_t received = 0;
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t generation =
+            control.generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+        received += consume(generation);
+        const auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+
+    stop_producers();
+    return received;
+}
+
+// Maps the producer control block shared with the forked producers
+ProducerControl* map_producer_control(benchmark::State& state) {
+    void* control_mapping = mmap(nullptr, sizeof(ProducerControl), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (control_mapping == MAP_FAILED) {
+        state.SkipWithError("Failed to mmap producer control block");
+        return nullptr;
+    }
+    return new (control_mapping) ProducerControl{};
+}
+
+void report_latency(benchmark::State& state, const core::LatencyHistogram& latency,
+                    std::int64_t messages_per_iteration, std::size_t payload_bytes) {
+    state.SetItemsProcessed(state.iterations() * messages_per_iteration);
+    state.SetBytesProcessed(state.iterations() * messages_per_iteration *
+                            static_cast<std::int64_t>(payload_bytes));
+    state.counters["payload_bytes"] = payload_bytes;
+    state.counters["p50_ns"] = static_cast<double>(latency.value_at_percentile(50.0));
+    state.counters["p99_ns"] = static_cast<double>(latency.value_at_percentile(99.0));
+    state.counters["p99.9_ns"] = static_cast<double>(latency.value_at_percentile(99.9));
+    state.counters["max_ns"] = static_cast<double>(latency.max());
+}
+
+template <typename T, std::size_t CAPACITY>
+void BM_CrossProcessMpsc(benchmark::State& state) {
+    using Channel = MpscSharedMemoryRingBuffer<T, CAPACITY>;
+    const auto producer_count = static_cast<int>(state.range(0));
+    const bool pinned = state.range(1) != 0;
+    const std::string shm_prefix =
+        "/bm_ipc_" + std::to_string(getpid()) + "_" + std::to_string(sizeof(T));
+
+    auto ring_buffer = Channel::create(shm_prefix);
+    auto* control = map_producer_control(state);
+    if (control == nullptr) {
+        return;
+    }
+
+    core::LatencyHistogram latency;
+    const std::int64_t messages_per_iteration = messages_per_producer * producer_count;
+    const auto received = run_cross_process<T, Channel>(
+        state, shm_prefix, producer_count, pinned, *control, [&](std::uint64_t) {
+            for (std::int64_t popped = 0; popped < messages_per_iteration;) {
+                if (auto message = ring_buffer.try_pop(); message.has_value()) {
+                    latency.record(core::steady_clock_ns() - message->publish_timestamp_ns);
+                    ++popped;
+                }
+            }
+            return messages_per_iteration;
+        });
+    munmap(control, sizeof(ProducerControl));
+    if (!received.has_value()) {
+        return;
+    }
+
+    report_latency(state, latency, messages_per_iteration, sizeof(T));
+    state.counters["capacity"] = CAPACITY;
+}
+
+// One producer that never waits, as the engine publishes in production. Messages the reader misses
+// (overwritten slot values, or ring laps) lower delivered_ratio rather than stalling the producer.
+template <typename T, typename Channel>
+void BM_CrossProcessSingleProducer(benchmark::State& state) {
+    const bool pinned = state.range(0) != 0;
+    const std::string shm_prefix =
+        "/bm_ipc_sp_" + std::to_string(getpid()) + "_" + std::to_string(sizeof(T));
+
+    auto channel = Channel::create(shm_prefix);
+    std::uint64_t last_seen_sequence = 0;
+    const auto read = [&]() -> std::optional<T> {
+        if constexpr (requires { channel.try_load_newer(last_seen_sequence); }) {
+            return channel.try_load_newer(last_seen_sequence);
+        } else {
+            return channel.try_pop();
+        }
+    };
+    auto* control = map_producer_control(state);
+    if (control == nullptr) {
+        return;
+    }
+
+    core::LatencyHistogram latency;
+    const auto received = run_cross_process<T, Channel>(
+        state, shm_prefix, 1, pinned, *control, [&](std::uint64_t generation) {
+            std::int64_t seen = 0;
+            for (;;) {
+                // Checked before draining, so the drain sees everything the producer published
+                const bool published =
+                    control->published.load(std::memory_order_acquire) >= generation;
+                while (auto message = read()) {
+                    latency.record(core::steady_clock_ns() - message->publish_timestamp_ns);
+                    ++seen;
+                }
+                if (published) {
+                    return seen;
+                }
+            }
+        });
+    munmap(control, sizeof(ProducerControl));
+    if (!received.has_value()) {
+        return;
+    }
+
+    report_latency(state, latency, messages_per_producer, sizeof(T));
+    state.counters["delivered_ratio"] =
+        static_cast<double>(received.value()) /
+        static_cast<double>(std::max<std::int64_t>(state.iterations() * messages_per_producer, 1));
+}
+
+void producer_and_pinning_args(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"producers", "pinned"})
+        ->ArgsProduct({{1, 2, 4, 8}, {0, 1}})
+        ->UseManualTime()
+        ->Unit(benchmark::kMicrosecond);
+}
+
+void pinning_args(benchmark::internal::Benchmark* benchmark) {
+    benchmark->ArgNames({"pinned"})
+        ->ArgsProduct({{0, 1}})
+        ->UseManualTime()
+        ->Unit(benchmark::kMicrosecond);
+}
+} // namespace
+
+// Production configurations
+BENCHMARK_TEMPLATE(BM_CrossProcessSingleProducer, Trade, TradeBroadcastRingBuffer)
+    ->Apply(pinning_args);
+BENCHMARK_TEMPLATE(BM_CrossProcessSingleProducer, TopOrderBookLevelAggregates,
+                   OrderbookSnapshotSlot)
+    ->Apply(pinning_args);
+
+// MPSC rings, which the production channels replaced
+BENCHMARK_TEMPLATE(BM_CrossProcessMpsc, Trade, core::constants::TradeRingBufferCapacity)
+    ->Apply(producer_and_pinning_args);
+BENCHMARK_TEMPLATE(BM_CrossProcessMpsc, TopOrderBookLevelAggregates,
+                   core::constants::OrderbookSnapshotRingBufferCapacity)
+    ->Apply(producer_and_pinning_args);
+
+// Capacity sweep, to size the rings from data rather than guesses
+BENCHMARK_TEMPLATE(BM_CrossProcessMpsc, Trade, 256)->Apply(producer_and_pinning_args);
+BENCHMARK_TEMPLATE(BM_CrossProcessMpsc, Trade, 4096)->Apply(producer_and_pinning_args);
+BENCHMARK_TEMPLATE(BM_CrossProcessMpsc, TopOrderBookLevelAggregates, 64)
+    ->Apply(producer_and_pinning_args);
+
+BENCHMARK_MAIN();
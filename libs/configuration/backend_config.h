@@ -7,5 +7,18 @@ struct BackendConfig {
     std::string host;
     int port;
     bool uat = false;
+    // Threads serving sockets, and threads running request handlers against the databases
+    int io_threads = 2;
+    int handler_threads = 8;
+    // Connections past this are answered 503 and closed
+    int max_connections = 1024;
+    // Time allowed to receive a request, or to wait for the next one on a kept-alive connection
+    int request_timeout_ms = 30000;
+    // Connections to edux_core_db shared by the handler threads, and how long a request waits
+    // for one before failing; more handler threads than connections only adds waiting
+    int db_pool_size = 8;
+    int db_checkout_timeout_ms = 1000;
+    // How long polled lookups such as /active_servers are served from memory; 0 disables caching
+    int response_cache_ttl_ms = 2000;
 };
 }
\ No newline at end of file
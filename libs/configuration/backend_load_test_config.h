@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+namespace backend {
+struct BackendLoadTestConfig {
+    // backend_service under test
+    std::string host;
+    int port;
+    // Keep-alive connections, each on a thread of its own
+    int connections = 16;
+    // Requests per second across all connections; 0 sends each request as soon as the previous
+    // one on its connection is answered
+    int target_rps = 0;
+    // Requests sent during warm-up are not measured
+    int warmup_s = 5;
+    int duration_s = 30;
+    // Account and server the requests are made for, e.g. the data seeded by uat = true
+    std::string user_name = "uat_trader1";
+    std::string password = "uat_pass";
+    std::string server_name = "UAT_Server";
+    std::string symbol = "AAPL";
+    // Relative share of each call in the mix
+    int login_weight = 1;
+    int active_servers_weight = 4;
+    int account_details_weight = 4;
+    int historical_trades_weight = 1;
+    // Page size of historical trade requests; 0 asks for every trade
+    int historical_trades_limit = 500;
+};
+}
@@ -1,14 +1,68 @@
 #pragma once
 
+#include "database/bounded_write_queue.h"
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace om {
+// Pre-trade limits applied to every request before balance checks. A limit of 0 disables the
+// check.
+struct RiskLimits {
+    int max_order_qty;
+    std::int64_t max_order_notional;
+    int max_open_orders_per_user;
+
+    // Per user session, allowing bursts of up to message_burst back-to-back requests
+    int max_messages_per_second;
+    int message_burst;
+
+    // Limit prices must lie within this many basis points of the symbol's last trade
+    int price_band_bps;
+};
+
+// Messages the run loop routes from one source before moving on to the next. Matching Engine
+// responses are drained again before every Gateway batch, so fills never wait behind a full sweep
+// of the Gateways.
+struct BatchSizes {
+    int matching_engine;
+    int gateway;
+};
+
+// Ingestion of orders and trades into QuestDB, done by one writer thread per shard
+struct QuestDbConfig {
+    std::string ilp_host;
+    int ilp_port;
+
+    int flush_threshold;
+    int flush_interval_ms;
+    int queue_capacity;
+    database::OverflowPolicy overflow_policy;
+
+    // Batches QuestDB does not take are journaled here and replayed once it is back. Leave empty
+    // to drop them instead; the spill overflow policy needs a journal.
+    std::string spill_directory;
+    std::int64_t spill_segment_bytes;
+    int replay_interval_ms;
+};
+
 struct OrderManagerConfig {
     std::string order_manager_host;
     int order_manager_port;
     std::vector<std::string> active_symbols;
 
+    // Users are partitioned across this many Order Manager shards, each on its own thread
+    int shard_count;
+
+    // Leave users who still hold only the server's initial USD out of the balance checkers until
+    // their first request, which keeps startup cheap with many idle users
+    bool defer_untraded_accounts;
+
+    RiskLimits risk_limits;
+    BatchSizes batch_sizes;
+    QuestDbConfig questdb;
+
     std::string downstream_matching_engine_host;
     int downstream_matching_engine_port;
 };
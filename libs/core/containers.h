@@ -60,11 +60,13 @@ struct FillCostQueryContainer {
     std::string symbol;
     std::int32_t quantity;
     Side side;
+    int request_id; // Echoed back in the response so the OM can match it to the parked order.
 };
 
 struct FillCostResponseContainer {
     // Optional because Matching Engine may fail to retreive data.
     std::optional<std::int32_t> total_cost;
+    int request_id;
 };
 
 struct TradeContainer {
@@ -167,9 +169,10 @@ struct std::formatter<core::FillCostQueryContainer> {
 
     template <typename FormatContext>
     auto format(const core::FillCostQueryContainer& fcqc, FormatContext& ctx) const {
-        return std::format_to(ctx.out(),
-                              "FillCostQueryContainer{{symbol: {}, quantity: {}, side: {}}}",
-                              fcqc.symbol, fcqc.quantity, fcqc.side);
+        return std::format_to(
+            ctx.out(),
+            "FillCostQueryContainer{{symbol: {}, quantity: {}, side: {}, request_id: {}}}",
+            fcqc.symbol, fcqc.quantity, fcqc.side, fcqc.request_id);
     }
 };
 
@@ -181,8 +184,9 @@ struct std::formatter<core::FillCostResponseContainer> {
 
     template <typename FormatContext>
     auto format(const core::FillCostResponseContainer& fcrc, FormatContext& ctx) const {
-        return std::format_to(ctx.out(), "FillCostResponseContainer{{total_cost: {}}}",
-                              fcrc.total_cost.value_or(-1));
+        return std::format_to(ctx.out(),
+                              "FillCostResponseContainer{{total_cost: {}, request_id: {}}}",
+                              fcrc.total_cost.value_or(-1), fcrc.request_id);
     }
 };
 
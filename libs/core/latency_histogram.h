@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <string>
+
+namespace core {
+// Monotonic nanoseconds. steady_clock is CLOCK_MONOTONIC on Linux, which is shared by every process
+// on the host, so stamps taken in the engine can be subtracted from stamps taken in the MDP.
+inline std::uint64_t steady_clock_ns() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+// Fixed-size log-linear histogram in the style of HdrHistogram: values below 32 are exact, above
+// that every power of two is split into 16 linear sub-buckets, giving ~6% worst-case relative
+// error over the full uint64 range with no allocation on record().
+class LatencyHistogram {
+  private:
+    static constexpr std::size_t linear_buckets = 32;
+    static constexpr std::size_t sub_buckets = 16;
+    static constexpr std::size_t bucket_count =
+        linear_buckets + (std::numeric_limits<std::uint64_t>::digits - 5) * sub_buckets;
+
+    std::array<std::uint64_t, bucket_count> counts{};
+    std::uint64_t total_count{0};
+    std::uint64_t min_value{std::numeric_limits<std::uint64_t>::max()};
+    std::uint64_t max_value{0};
+    long double sum{0};
+
+    static std::size_t bucket_index(std::uint64_t value) {
+        if (value < linear_buckets) {
+            return static_cast<std::size_t>(value);
+        }
+        const std::size_t shift = std::bit_width(value) - 5;
+        return linear_buckets + (shift - 1) * sub_buckets +
+               static_cast<std::size_t>((value >> shift) - sub_buckets);
+    }
+
+    // Highest value that maps to the bucket
+    static std::uint64_t bucket_upper_bound(std::size_t index) {
+        if (index < linear_buckets) {
+            return index;
+        }
+        const std::size_t offset = index - linear_buckets;
+        const std::size_t shift = offset / sub_buckets + 1;
+        const std::uint64_t mantissa = offset % sub_buckets + sub_buckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+  public:
+    void record(std::uint64_t value) {
+        ++counts[bucket_index(value)];
+        ++total_count;
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+        sum += value;
+    }
+
+    // Value at or below which percentile (0-100) of recordings fall, within bucket precision.
+    [[nodiscard]] std::uint64_t value_at_percentile(double percentile) const {
+        if (total_count == 0) {
+            return 0;
+        }
+        const auto target = static_cast<std::uint64_t>(
+            std::max(1.0, percentile / 100.0 * static_cast<double>(total_count) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return std::clamp(bucket_upper_bound(i), min_value, max_value);
+            }
+        }
+        return max_value;
+    }
+
+    [[nodiscard]] std::uint64_t count() const {
+        return total_count;
+    }
+
+    [[nodiscard]] std::uint64_t min() const {
+        return total_count == 0 ? 0 : min_value;
+    }
+
+    [[nodiscard]] std::uint64_t max() const {
+        return max_value;
+    }
+
+    [[nodiscard]] double mean() const {
+        return total_count == 0 ? 0.0 : static_cast<double>(sum / total_count);
+    }
+
+    // Adds other's recordings, e.g. to combine histograms kept per thread
+    void merge(const LatencyHistogram& other) {
+        if (other.total_count == 0) {
+            return;
+        }
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            counts[i] += other.counts[i];
+        }
+        total_count += other.total_count;
+        min_value = std::min(min_value, other.min_value);
+        max_value = std::max(max_value, other.max_value);
+        sum += other.sum;
+    }
+
+    void reset() {
+        counts.fill(0);
+        total_count = 0;
+        min_value = std::numeric_limits<std::uint64_t>::max();
+        max_value = 0;
+        sum = 0;
+    }
+
+    [[nodiscard]] std::string summary() const {
+        return std::format("count={} min={}ns p50={}ns p99={}ns p99.9={}ns max={}ns", total_count,
+                           min(), value_at_percentile(50.0), value_at_percentile(99.0),
+                           value_at_percentile(99.9), max_value);
+    }
+};
+} // namespace core
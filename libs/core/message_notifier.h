@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace core {
+
+/*
+ * Lets one consumer sleep on many message queues at once instead of polling each in turn.
+ * Producers call notify() after every enqueue. The consumer takes a ticket, drains its queues and
+ * only waits if they were all empty. wait() returns at once if anything was notified since the
+ * ticket was taken, so a message queued between the last dequeue and the wait is never missed.
+ */
+class MessageNotifier {
+  public:
+    using Ticket = std::uint64_t;
+
+    void notify() {
+        m_sequence.fetch_add(1, std::memory_order_release);
+        m_sequence.notify_one();
+    }
+
+    Ticket ticket() const {
+        return m_sequence.load(std::memory_order_acquire);
+    }
+
+    // Blocks until notify() has been called since ticket was taken
+    void wait(Ticket ticket) const {
+        m_sequence.wait(ticket, std::memory_order_acquire);
+    }
+
+  private:
+    std::atomic<std::uint64_t> m_sequence{0};
+};
+
+} // namespace core
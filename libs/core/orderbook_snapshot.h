@@ -2,7 +2,9 @@
 
 #include "constants.h"
 #include "inter_process/mpsc_shared_memory_ring_buffer.h"
+#include "inter_process/seqlock_shared_memory_slot.h"
 #include "nlohmann/json.hpp"
+#include <algorithm>
 #include <array>
 #include <cassert>
 
@@ -18,6 +20,7 @@ struct TopOrderBookLevelAggregates {
     std::array<LevelAggregate, core::constants::ORDER_BOOK_AGGREGATE_LEVELS> bid_level_aggregates;
     std::array<LevelAggregate, core::constants::ORDER_BOOK_AGGREGATE_LEVELS> ask_level_aggregates;
     uint64_t create_timestamp;
+    uint64_t publish_timestamp_ns{0}; // core::steady_clock_ns() when handed to shm, for tracing
 
     TopOrderBookLevelAggregates(const char* ticker_str, uint64_t create_timestamp)
         : create_timestamp(create_timestamp) {
@@ -43,19 +46,23 @@ struct TopOrderBookLevelAggregates {
         return os;
     }
 
-    void to_json(json& j) {
+    // Writes the best levels on each side, all of them by default
+    void to_json(json& j, std::size_t levels = core::constants::ORDER_BOOK_AGGREGATE_LEVELS) {
         j = json{{"ticker", ticker},
                  {"bids", json::array()},
                  {"asks", json::array()},
                  {"create_timestamp", create_timestamp}};
 
-        for (const auto& level : bid_level_aggregates) {
+        levels = std::min(levels, bid_level_aggregates.size());
+        for (std::size_t i = 0; i < levels; ++i) {
+            const auto& level = bid_level_aggregates[i];
             j["bids"].push_back(
                 json{{"price", level.price / core::constants::decimal_to_int_multiplier},
                      {"quantity", level.quantity / core::constants::decimal_to_int_multiplier}});
         }
 
-        for (const auto& level : ask_level_aggregates) {
+        for (std::size_t i = 0; i < levels; ++i) {
+            const auto& level = ask_level_aggregates[i];
             j["asks"].push_back(
                 json{{"price", level.price / core::constants::decimal_to_int_multiplier},
                      {"quantity", level.quantity / core::constants::decimal_to_int_multiplier}});
@@ -90,3 +97,6 @@ struct TopOrderBookLevelAggregates {
 using OrderbookSnapshotRingBuffer =
     MpscSharedMemoryRingBuffer<TopOrderBookLevelAggregates,
                                core::constants::OrderbookSnapshotRingBufferCapacity>;
+
+// typed latest-value slot for communication with MDP; a lagging MDP only ever sees the newest book
+using OrderbookSnapshotSlot = SeqlockSharedMemorySlot<TopOrderBookLevelAggregates>;
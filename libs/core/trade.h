@@ -1,6 +1,7 @@
 #pragma once
 
 #include "constants.h"
+#include "inter_process/broadcast_shared_memory_ring_buffer.h"
 #include "inter_process/mpsc_shared_memory_ring_buffer.h"
 #include "nlohmann/json.hpp"
 #include <assert.h>
@@ -19,6 +20,7 @@ struct Trade {
     int maker_order_id{0};
     bool is_taker_buyer{false};
     uint64_t create_timestamp;
+    uint64_t publish_timestamp_ns{0}; // core::steady_clock_ns() when handed to shm, for tracing
 
     Trade(const char* ticker_str, int price, int quantity, const char* trade_id,
           const char* taker_id, const char* maker_id, int taker_order_id, int maker_order_id,
@@ -94,3 +96,7 @@ struct Trade {
 
 // typed ring buffer for communication with MDP
 using TradeRingBuffer = MpscSharedMemoryRingBuffer<Trade, core::constants::TradeRingBufferCapacity>;
+
+// typed broadcast ring so any number of downstream processes can tail the same trade stream
+using TradeBroadcastRingBuffer =
+    BroadcastSharedMemoryRingBuffer<Trade, core::constants::TradeRingBufferCapacity>;
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace database {
+using namespace std::chrono_literals;
+
+struct BalanceUpsertRow {
+    int user_id;
+    std::string symbol;
+    std::int64_t balance;
+};
+
+/*
+ * Write-behind persister for absolute balances. Callers stage the latest balance of a
+ * (user, server, symbol) and return immediately; a background thread coalesces repeated updates to
+ * the same key (last write wins) and hands each server's dirty set to the flush function as one
+ * batch, either every flush_interval or as soon as flush_threshold keys are dirty.
+ *
+ * Because rows carry absolute balances rather than deltas, flushes are idempotent and a later
+ * flush fully supersedes an earlier one. A failed batch is merged back into the dirty set (without
+ * overwriting anything staged since) and retried after a backoff that starts at flush_interval and
+ * doubles with every consecutive failure up to max_retry_delay; the dirty-key threshold does not
+ * cut it short, so a database outage is not hammered with retries. An explicit flush() still
+ * retries at once.
+ *
+ * Shutdown: the destructor stops the thread and makes one final synchronous flush of everything
+ * still dirty; rows that fail that last attempt are reported through on_error and dropped.
+ * Crash: anything staged since the last successful flush is lost. While the database is
+ * reachable that is at most one interval, or flush_threshold keys; while it is down it is
+ * everything staged since the outage began, however long it lasts. This includes termination
+ * through the logger's signal handler, which _Exits without running destructors. The in-memory
+ * state is the source of truth while the process is up and is rebuilt from Postgres on restart.
+ */
+class BalanceWriteBehind {
+  public:
+    using FlushFunction = std::function<std::expected<void, std::string>(
+        int server_id, const std::vector<BalanceUpsertRow>& rows)>;
+    using ErrorHandler = std::function<void(const std::string&)>;
+
+    static constexpr std::chrono::milliseconds max_retry_delay = 10s;
+
+    explicit BalanceWriteBehind(FlushFunction flush_function, int flush_threshold = 256,
+                                std::chrono::milliseconds flush_interval = 100ms,
+                                ErrorHandler on_error = {})
+        : m_flush_function{std::move(flush_function)}, m_on_error{std::move(on_error)},
+          m_flush_threshold{flush_threshold}, m_flush_interval{flush_interval},
+          m_writer_thread{[this] { writer_loop(); }} {
+    }
+
+    BalanceWriteBehind(const BalanceWriteBehind&) = delete;
+    BalanceWriteBehind& operator=(const BalanceWriteBehind&) = delete;
+
+    ~BalanceWriteBehind() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_condition_var.notify_one();
+        if (m_writer_thread.joinable()) {
+            m_writer_thread.join();
+        }
+
+        flush_dirty(take_dirty(), false);
+    }
+
+    void stage(int user_id, int server_id, std::string_view symbol, std::int64_t balance) {
+        bool should_wake{false};
+        {
+            std::lock_guard lock{m_mutex};
+            auto [it, inserted] =
+                m_dirty.insert_or_assign(Key{server_id, user_id, std::string{symbol}}, balance);
+            if (!inserted) {
+                ++m_coalesced_count;
+            }
+            should_wake = m_dirty.size() >= static_cast<std::size_t>(m_flush_threshold);
+        }
+        if (should_wake) {
+            m_condition_var.notify_one();
+        }
+    }
+
+    // Blocks until everything staged before the call has been handed to the flush function.
+    void flush() {
+        std::unique_lock lock{m_mutex};
+        const auto target_generation = m_flush_generation + 1;
+        m_flush_requested = true;
+        m_condition_var.notify_one();
+        m_flushed_var.wait(lock, [&] { return m_completed_generation >= target_generation; });
+    }
+
+    // Number of staged updates absorbed by a newer update to the same key before being flushed.
+    std::uint64_t coalesced_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_coalesced_count;
+    }
+
+    std::uint64_t flushed_row_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_flushed_row_count;
+    }
+
+    std::uint64_t failed_flush_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_failed_flush_count;
+    }
+
+  private:
+    // (server_id, user_id, symbol); ordered so each server's rows are contiguous for batching
+    using Key = std::tuple<int, int, std::string>;
+    using DirtyMap = std::map<Key, std::int64_t>;
+
+    void writer_loop() {
+        // Zero while the last flush succeeded
+        std::chrono::milliseconds retry_delay{0};
+        const auto retry_delay_cap = std::max(max_retry_delay, m_flush_interval);
+        while (true) {
+            std::uint64_t generation;
+            {
+                std::unique_lock lock{m_mutex};
+                if (retry_delay == 0ms) {
+                    m_condition_var.wait_for(lock, m_flush_interval, [this] {
+                        return m_stop || m_flush_requested ||
+                               m_dirty.size() >= static_cast<std::size_t>(m_flush_threshold);
+                    });
+                } else {
+                    m_condition_var.wait_for(lock, retry_delay,
+                                             [this] { return m_stop || m_flush_requested; });
+                }
+                if (m_stop) {
+                    return;
+                }
+                m_flush_requested = false;
+                generation = ++m_flush_generation;
+            }
+
+            if (flush_dirty(take_dirty(), true)) {
+                retry_delay = 0ms;
+            } else {
+                retry_delay = retry_delay == 0ms ? m_flush_interval
+                                                 : std::min(retry_delay * 2, retry_delay_cap);
+            }
+
+            {
+                std::lock_guard lock{m_mutex};
+                m_completed_generation = generation;
+            }
+            m_flushed_var.notify_all();
+        }
+    }
+
+    DirtyMap take_dirty() {
+        std::lock_guard lock{m_mutex};
+        DirtyMap dirty;
+        dirty.swap(m_dirty);
+        return dirty;
+    }
+
+    // Returns false if any batch failed
+    bool flush_dirty(DirtyMap&& dirty, bool retry_on_failure) {
+        bool all_flushed{true};
+        auto it = dirty.begin();
+        while (it != dirty.end()) {
+            const int server_id = std::get<0>(it->first);
+            const auto batch_begin = it;
+            std::vector<BalanceUpsertRow> rows;
+            for (; it != dirty.end() && std::get<0>(it->first) == server_id; ++it) {
+                rows.emplace_back(std::get<1>(it->first), std::get<2>(it->first), it->second);
+            }
+
+            const auto result = m_flush_function(server_id, rows);
+
+            {
+                std::lock_guard lock{m_mutex};
+                if (result.has_value()) {
+                    m_flushed_row_count += rows.size();
+                    continue;
+                }
+
+                ++m_failed_flush_count;
+                all_flushed = false;
+                if (retry_on_failure) {
+                    // Keep anything staged while we were flushing, it is newer
+                    for (auto retry_it = batch_begin; retry_it != it; ++retry_it) {
+                        m_dirty.try_emplace(retry_it->first, retry_it->second);
+                    }
+                }
+            }
+            if (m_on_error) {
+                m_on_error(result.error());
+            }
+        }
+        return all_flushed;
+    }
+
+    FlushFunction m_flush_function;
+    ErrorHandler m_on_error;
+    int m_flush_threshold;
+    std::chrono::milliseconds m_flush_interval;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition_var;
+    std::condition_variable m_flushed_var;
+    DirtyMap m_dirty;
+    bool m_stop{false};
+    bool m_flush_requested{false};
+    std::uint64_t m_flush_generation{0};
+    std::uint64_t m_completed_generation{0};
+
+    std::uint64_t m_coalesced_count{0};
+    std::uint64_t m_flushed_row_count{0};
+    std::uint64_t m_failed_flush_count{0};
+
+    // Declared last so every member above is initialized before the thread starts
+    std::thread m_writer_thread;
+};
+} // namespace database
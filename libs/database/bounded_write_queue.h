@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace database {
+
+// What a producer does when the write queue is full
+enum class OverflowPolicy {
+    block, // Wait for the writer to make room, pushing back on the producer
+    drop,  // Discard the task and count it, the producer never waits
+    spill  // Hand the task back for the producer to journal, the producer never waits
+};
+
+/*
+ * Bounded multi-producer queue feeding a single background writer. The writer takes tasks in
+ * batches and sleeps on a condition variable until tasks arrive or its timeout elapses, so tasks
+ * are picked up as soon as they are queued without polling.
+ *
+ * The bound keeps memory flat when the database stalls; overflow_policy decides whether producers
+ * then wait, lose the task or keep it somewhere else. Depth, high watermark and drops are tracked
+ * for monitoring.
+ */
+template <typename T>
+class BoundedWriteQueue {
+  public:
+    BoundedWriteQueue(std::size_t capacity, OverflowPolicy overflow_policy)
+        : m_capacity{std::max<std::size_t>(capacity, 1)}, m_overflow_policy{overflow_policy} {
+    }
+
+    BoundedWriteQueue(const BoundedWriteQueue&) = delete;
+    BoundedWriteQueue& operator=(const BoundedWriteQueue&) = delete;
+
+    // Returns false, leaving value untouched, if the queue is full and the policy does not block
+    bool enqueue(T&& value) {
+        {
+            std::unique_lock lock{m_mutex};
+            if (m_queue.size() >= m_capacity) {
+                if (m_overflow_policy != OverflowPolicy::block) {
+                    if (m_overflow_policy == OverflowPolicy::drop) {
+                        ++m_dropped_count;
+                    }
+                    return false;
+                }
+                m_not_full_var.wait(lock, [this] { return m_queue.size() < m_capacity; });
+            }
+
+            m_queue.push_back(std::move(value));
+            m_high_watermark = std::max(m_high_watermark, m_queue.size());
+        }
+        m_not_empty_var.notify_one();
+        return true;
+    }
+
+    // Moves up to max_count tasks into out, waiting up to timeout for the first one. Returns
+    // early, possibly empty-handed, once wake() is called.
+    std::size_t wait_and_dequeue_batch(std::vector<T>& out, std::size_t max_count,
+                                       std::chrono::milliseconds timeout) {
+        std::size_t dequeued_count{0};
+        {
+            std::unique_lock lock{m_mutex};
+            m_not_empty_var.wait_for(lock, timeout,
+                                     [this] { return !m_queue.empty() || m_wake_requested; });
+            m_wake_requested = false;
+
+            for (; dequeued_count < max_count && !m_queue.empty(); ++dequeued_count) {
+                out.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            }
+        }
+        if (dequeued_count > 0) {
+            m_not_full_var.notify_all();
+        }
+        return dequeued_count;
+    }
+
+    // Makes the writer's pending or next wait return immediately, e.g. to notice it should stop
+    void wake() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_wake_requested = true;
+        }
+        m_not_empty_var.notify_one();
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock{m_mutex};
+        return m_queue.size();
+    }
+
+    std::size_t capacity() const {
+        return m_capacity;
+    }
+
+    // Deepest the queue has been
+    std::size_t high_watermark() const {
+        std::lock_guard lock{m_mutex};
+        return m_high_watermark;
+    }
+
+    std::uint64_t dropped_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_dropped_count;
+    }
+
+  private:
+    const std::size_t m_capacity;
+    const OverflowPolicy m_overflow_policy;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty_var;
+    std::condition_variable m_not_full_var;
+    std::deque<T> m_queue;
+    bool m_wake_requested{false};
+
+    std::size_t m_high_watermark{0};
+    std::uint64_t m_dropped_count{0};
+};
+} // namespace database
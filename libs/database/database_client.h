@@ -1,24 +1,37 @@
 #pragma once
 
+#include "balance_write_behind.h"
+#include "bounded_write_queue.h"
 #include "config.h"
+#include "ilp_row_encoder.h"
+#include "pg_connection_pool.h"
+#include "spill_journal.h"
+#include <algorithm>
 #include <atomic>
+#include <cassert>
 #include <chrono>
 #include <core/constants.h>
 #include <core/containers.h>
+#include <core/latency_histogram.h>
 #include <core/orders.h>
 #include <core/service.h>
-#include <core/thread_safe_queue.h>
 #include <cstdint>
 #include <cstdlib>
 #include <expected>
 #include <format>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <pqxx/pqxx>
 #include <questdb/ingress/line_sender.hpp>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace database {
@@ -28,59 +41,6 @@ using namespace questdb::ingress::literals;
 using namespace std::chrono_literals;
 using namespace core;
 
-// Enum to string helpers since questdb does not support enum types natively.
-inline std::string_view to_string(Side s) {
-    switch (s) {
-    case Side::bid:
-        return "BID";
-    case Side::ask:
-        return "ASK";
-    default:
-        return "UNKNOWN";
-    }
-}
-
-inline std::string_view to_string(OrderType t) {
-    switch (t) {
-    case OrderType::limit:
-        return "LIMIT";
-    case OrderType::market:
-        return "MARKET";
-    default:
-        return "UNKNOWN";
-    }
-}
-
-inline std::string_view to_string(TimeInForce tif) {
-    switch (tif) {
-    case TimeInForce::day:
-        return "DAY";
-    case TimeInForce::gtc:
-        return "GTC";
-    default:
-        return "UNKNOWN";
-    }
-}
-
-inline std::string_view to_string(ExecTypeOrOrderStatus s) {
-    switch (s) {
-    case OrderStatus::status_new:
-        return "NEW";
-    case OrderStatus::status_partially_filled:
-        return "PARTIALLY_FILLED";
-    case OrderStatus::status_filled:
-        return "FILLED";
-    case OrderStatus::status_canceled:
-        return "CANCELED";
-    case OrderStatus::status_pending_cancel:
-        return "PENDING_CANCEL";
-    case OrderStatus::status_rejected:
-        return "REJECTED";
-    default:
-        return "UNKNOWN";
-    }
-}
-
 // Write tasks for async writer.
 // Mainly an abstraction layer so that std::variant can be used cleanly.
 struct OrderInsertionTask {
@@ -110,260 +70,257 @@ using WriteTask =
     std::variant<OrderInsertionTask, CancelRequestInsertionTask, ExecutionInsertionTask,
                  TradeInsertionTask, CancelResponseInsertionTask>;
 
-// Async writer for QuestDB ILP protocol.
+struct AsyncWriterConfig {
+    // Rows buffered before a flush, and the longest a row waits for one
+    int flush_threshold{64};
+    std::chrono::milliseconds flush_interval{100ms};
+
+    // Tasks queued between the callers and the writer thread
+    std::size_t queue_capacity{1 << 16};
+    OverflowPolicy overflow_policy{OverflowPolicy::block};
+
+    // QuestDB ILP-over-TCP endpoint
+    std::string ilp_host{"localhost"};
+    std::uint16_t ilp_port{9009};
+
+    // Batches QuestDB does not take are kept here until a SpillReplayer delivers them; without a
+    // journal they are dropped. Required by OverflowPolicy::spill.
+    std::shared_ptr<SpillJournal> spill_journal{};
+
+    // Told why rows were spilled or dropped
+    std::function<void(const std::string&)> on_error{};
+};
+
+struct AsyncWriterMetrics {
+    std::size_t queue_depth;
+    std::size_t queue_high_watermark;
+    std::uint64_t dropped_task_count;
+    std::uint64_t flushed_row_count;
+    std::uint64_t failed_flush_count;
+    std::uint64_t spilled_row_count;
+    std::uint64_t lost_row_count;
+    core::LatencyHistogram flush_latency_ns;
+};
+
+/*
+ * Async writer for QuestDB ILP protocol. The writer thread sleeps on the queue and wakes as soon as
+ * tasks arrive (or a buffered row is due to be flushed), rather than polling.
+ *
+ * With a spill journal, a batch the sender fails to flush is journaled and the sender reconnected
+ * on a later flush. Batches keep going to the journal for as long as it holds undelivered ones, so
+ * QuestDB receives them in flush order once the replayer has caught up. QuestDB must be reachable
+ * when the writer starts.
+ */
 class AsyncWriter {
   public:
-    explicit AsyncWriter(ThreadSafeQueue<WriteTask>& write_queue, int flush_threshold = 64,
-                         std::chrono::milliseconds flush_interval = 100ms)
-        : m_write_queue{write_queue}, m_flush_threshold{flush_threshold},
-          m_flush_interval{flush_interval},
-          m_sender{questdb::ingress::line_sender::from_conf("tcp::addr=localhost:9009")},
-          m_buffer{m_sender.new_buffer()}, m_stop{false},
+    explicit AsyncWriter(BoundedWriteQueue<WriteTask>& write_queue,
+                         const AsyncWriterConfig& config = {})
+        : m_write_queue{write_queue}, m_flush_threshold{config.flush_threshold},
+          m_flush_interval{config.flush_interval},
+          m_ilp_conf{std::format("tcp::addr={}:{}", config.ilp_host, config.ilp_port)},
+          m_sender{questdb::ingress::line_sender::from_conf(m_ilp_conf)},
+          m_buffer{m_sender->new_buffer()}, m_spill_journal{config.spill_journal},
+          m_on_error{config.on_error}, m_spill_buffer{m_sender->new_buffer()}, m_stop{false},
           m_writer_thread{[this] { writer_loop(); }} {
     }
 
     ~AsyncWriter() {
         m_stop.store(true);
+        m_write_queue.wake();
         if (m_writer_thread.joinable()) {
             m_writer_thread.join();
         }
 
-        while (auto task = m_write_queue.dequeue()) {
-            std::visit([this](const auto& t) { append(t); }, *task);
+        std::vector<WriteTask> tasks;
+        while (m_write_queue.wait_and_dequeue_batch(tasks, m_write_queue.capacity(), 0ms) > 0) {
+            for (const auto& task : tasks) {
+                append(m_buffer, task);
+            }
+            tasks.clear();
         }
 
-        try {
-            if (m_buffer.size() > 0) {
-                m_sender.flush(m_buffer);
-            }
-        } catch (...) {
-            // TODO: logging
+        if (m_buffer.size() > 0) {
+            flush();
         }
     }
 
+    AsyncWriterMetrics metrics() const {
+        std::lock_guard lock{m_metrics_mutex};
+        return AsyncWriterMetrics{.queue_depth = m_write_queue.size(),
+                                  .queue_high_watermark = m_write_queue.high_watermark(),
+                                  .dropped_task_count = m_write_queue.dropped_count(),
+                                  .flushed_row_count = m_flushed_row_count,
+                                  .failed_flush_count = m_failed_flush_count,
+                                  .spilled_row_count = m_spilled_row_count,
+                                  .lost_row_count = m_lost_row_count,
+                                  .flush_latency_ns = m_flush_latency_ns};
+    }
+
+    // Journals a task the queue had no room for, on the caller's thread
+    std::expected<void, std::string> spill(const WriteTask& task) {
+        std::lock_guard lock{m_spill_mutex};
+        append(m_spill_buffer, task);
+        return spill_buffer(m_spill_buffer);
+    }
+
   private:
     void writer_loop() {
+        std::vector<WriteTask> tasks;
+        tasks.reserve(m_flush_threshold);
         auto last_flush = std::chrono::steady_clock::now();
-        // TODO: switch to wait and dequeue
+
         while (!m_stop.load()) {
-            while (auto task = m_write_queue.dequeue()) {
-                std::visit([this](const auto& t) { append(t); }, *task);
+            // Sleep until tasks arrive, or until buffered rows are due to be flushed
+            auto timeout{m_flush_interval};
+            if (m_buffer.row_count() > 0) {
+                timeout = std::max(0ms, std::chrono::ceil<std::chrono::milliseconds>(
+                                            last_flush + m_flush_interval -
+                                            std::chrono::steady_clock::now()));
+            }
+            m_write_queue.wait_and_dequeue_batch(tasks, m_flush_threshold, timeout);
+
+            for (const auto& task : tasks) {
+                append(m_buffer, task);
             }
+            tasks.clear();
 
             const auto now{std::chrono::steady_clock::now()};
-            if ((m_buffer.row_count() > 0 && (now - last_flush > m_flush_interval)) ||
+            if ((m_buffer.row_count() > 0 && (now - last_flush >= m_flush_interval)) ||
                 (m_buffer.row_count() >= static_cast<size_t>(m_flush_threshold))) {
-                m_sender.flush(m_buffer);
+                flush();
                 last_flush = now;
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds{10ms});
         }
     }
 
-    void append(const OrderInsertionTask& order) {
-        const auto new_order_request = order.new_order_request;
-
-        try {
-            const auto orders_table_name = std::format("orders_{}", SERVER_NAME);
-            const questdb::ingress::table_name_view orders_table{orders_table_name.c_str(),
-                                                                 orders_table_name.length()};
-            const auto order_id = "order_id"_cn;
-            const auto cl_order_id = "cl_order_id"_cn;
-            const auto sender_comp_id = "sender_comp_id"_cn;
-            const auto symbol = "symbol"_cn;
-            const auto side = "side"_cn;
-            const auto order_qty = "order_qty"_cn;
-            const auto filled_qty = "filled_qty"_cn;
-            const auto ord_type = "ord_type"_cn;
-            const auto price = "price"_cn;
-            const auto time_in_force = "time_in_force"_cn;
-            const auto order_status = "order_status"_cn;
-
-            m_buffer.table(orders_table)
-                .symbol(symbol, new_order_request.symbol)
-                .symbol(side, to_string(new_order_request.side))
-                .symbol(ord_type, to_string(new_order_request.ord_type))
-                .symbol(time_in_force, to_string(new_order_request.time_in_force))
-                .symbol(order_status, order.is_order_valid ? std::string_view("NEW")
-                                                           : std::string_view("REJECTED"))
-                .column(sender_comp_id, new_order_request.sender_comp_id)
-                .column(order_id, static_cast<std::int64_t>(order.internal_order_id))
-                .column(cl_order_id, static_cast<std::int64_t>(new_order_request.cl_ord_id))
-                .column(order_qty, static_cast<std::int64_t>(new_order_request.order_qty))
-                .column(filled_qty, static_cast<std::int64_t>(0))
-                // price is optional for market orders; store 0 if not present
-                .column(price, static_cast<std::int64_t>(
-                                   new_order_request.price ? *new_order_request.price : 0))
-                // initial order_status is NEW
-                .at(questdb::ingress::timestamp_micros::now());
-
+    void flush() {
+        if (m_spill_journal && !m_spill_journal->empty()) {
+            std::ignore = spill_buffer(m_buffer);
             return;
-
-        } catch (const std::exception& e) {
-            // TODO: logging
-
-            // return std::unexpected{
-            //     std::format("Error faced when inserting order: {}", e.what())};
         }
-    }
-
-    // append methods for adding to line sender buffer
-    void append(const CancelRequestInsertionTask& cancel_request) {
-        const auto cancel_order_request{cancel_request.cancel_order_request};
 
+        const auto row_count{m_buffer.row_count()};
+        const auto flush_start_ns{core::steady_clock_ns()};
         try {
-            const auto orders_table_name = std::format("orders_{}", SERVER_NAME);
-            const questdb::ingress::table_name_view orders_table{orders_table_name.c_str(),
-                                                                 orders_table_name.length()};
-            const auto order_id = "order_id"_cn;
-            const auto cl_order_id = "cl_order_id"_cn;
-            const auto sender_comp_id = "sender_comp_id"_cn;
-            const auto symbol = "symbol"_cn;
-            const auto side = "side"_cn;
-            const auto order_qty = "order_qty"_cn;
-            const auto filled_qty = "filled_qty"_cn;
-            const auto order_status = "order_status"_cn;
-
-            m_buffer.table(orders_table)
-                .symbol(symbol, cancel_order_request.symbol)
-                .symbol(side, to_string(cancel_order_request.side))
-                .symbol(order_status, cancel_request.is_request_valid
-                                          ? std::string_view("PENDING_CANCEL")
-                                          : std::string_view("REJECTED_CANCEL"))
-                .column(sender_comp_id, cancel_order_request.sender_comp_id)
-                .column(order_id, static_cast<int64_t>(cancel_order_request.order_id.value_or(-1)))
-                .column(cl_order_id, static_cast<int64_t>(cancel_order_request.orig_cl_ord_id))
-                .column(order_qty, static_cast<std::int64_t>(cancel_order_request.order_qty))
-                .column(filled_qty, static_cast<std::int64_t>(0))
-                .at(questdb::ingress::timestamp_micros::now());
+            if (!m_sender.has_value()) {
+                m_sender.emplace(questdb::ingress::line_sender::from_conf(m_ilp_conf));
+            }
+            m_sender->flush(m_buffer);
 
+            std::lock_guard lock{m_metrics_mutex};
+            m_flushed_row_count += row_count;
+            m_flush_latency_ns.record(core::steady_clock_ns() - flush_start_ns);
             return;
         } catch (const std::exception& e) {
-            // TODO: logger
-
-            // return std::unexpected{
-            //     std::format("Error faced when inserting cancel: {}", e.what())};
+            // A sender that failed to flush is unusable, so it is rebuilt on the next flush
+            m_sender.reset();
+            {
+                std::lock_guard lock{m_metrics_mutex};
+                ++m_failed_flush_count;
+            }
+            report_error(
+                std::format("Failed to flush {} rows to QuestDB: {}", row_count, e.what()));
         }
-    }
 
-    void append(const ExecutionInsertionTask& exec_report) {
-        const auto execution_report = exec_report.execution_report;
-        try {
-            const auto orders_table_name = std::format("orders_{}", SERVER_NAME);
-            const questdb::ingress::table_name_view orders_table{orders_table_name.c_str(),
-                                                                 orders_table_name.length()};
-            const auto order_id = "order_id"_cn;
-            const auto cl_order_id = "cl_order_id"_cn;
-            const auto sender_comp_id = "sender_comp_id"_cn;
-            const auto symbol = "symbol"_cn;
-            const auto side = "side"_cn;
-            const auto order_qty = "order_qty"_cn;
-            const auto filled_qty = "filled_qty"_cn;
-            const auto price = "price"_cn;
-            const auto time_in_force = "time_in_force"_cn;
-            const auto order_status = "order_status"_cn;
-
-            // Map execution report to orders table row; use cum_qty as filled_qty and
-            // ord_status from the report.
-            m_buffer.table(orders_table)
-                .symbol(symbol, execution_report.symbol)
-                .symbol(side, to_string(execution_report.side))
-                .symbol(order_status, to_string(execution_report.ord_status))
-                .symbol(time_in_force, to_string(execution_report.time_in_force))
-                .column(sender_comp_id, execution_report.sender_comp_id)
-                .column(order_id, static_cast<std::int64_t>(execution_report.order_id))
-                .column(cl_order_id, static_cast<std::int64_t>(execution_report.cl_order_id))
-                .column(order_qty, static_cast<std::int64_t>(execution_report.leaves_qty +
-                                                             execution_report.cum_qty))
-                .column(filled_qty, static_cast<std::int64_t>(execution_report.cum_qty))
-                .column(price, static_cast<std::int64_t>(
-                                   execution_report.price ? *execution_report.price : 0))
-                .at(questdb::ingress::timestamp_micros::now());
-
-            return;
-        } catch (const std::exception& e) {
-            // TODO: logger
+        // Rows are never retried from the buffer, so a stalled QuestDB cannot grow it without bound
+        std::ignore = spill_buffer(m_buffer);
+    }
 
-            // return std::unexpected{std::format(
-            //     "Error faced when inserting execution: {}", e.what())};
+    // Moves the buffer's rows to the spill journal, or drops them if there is none
+    std::expected<void, std::string> spill_buffer(questdb::ingress::line_sender_buffer& buffer) {
+        const auto row_count{buffer.row_count()};
+        std::expected<void, std::string> result{
+            std::unexpected{std::format("Dropped {} rows, no spill journal", row_count)}};
+        if (m_spill_journal) {
+            const auto batch = buffer.peek();
+            result = m_spill_journal->append(
+                {reinterpret_cast<const char*>(batch.data()), batch.size()});
         }
+        buffer.clear();
+
+        {
+            std::lock_guard lock{m_metrics_mutex};
+            if (result.has_value()) {
+                m_spilled_row_count += row_count;
+            } else {
+                m_lost_row_count += row_count;
+            }
+        }
+        if (!result.has_value()) {
+            report_error(result.error());
+        }
+        return result;
     }
 
-    void append(const TradeInsertionTask& trade_task) {
-        const auto trade{trade_task.trade};
+    void report_error(const std::string& err) const {
+        if (m_on_error) {
+            m_on_error(err);
+        }
+    }
 
+    // A row that cannot be encoded is reported and skipped, it would fail the whole batch
+    void append(questdb::ingress::line_sender_buffer& buffer, const WriteTask& task) {
         try {
-            const auto trades_table_name = std::format("trades_{}", SERVER_NAME);
-            const questdb::ingress::table_name_view trades_table{trades_table_name.c_str(),
-                                                                 trades_table_name.length()};
-            const auto symbol = "symbol"_cn;
-            const auto price = "price"_cn;
-            const auto quantity_cn = "quantity"_cn;
-            const auto trade_id_cn = "trade_id"_cn;
-            const auto taker_id_cn = "taker_id"_cn;
-            const auto maker_id_cn = "maker_id"_cn;
-            const auto taker_order_id_cn = "taker_order_id"_cn;
-            const auto maker_order_id_cn = "maker_order_id"_cn;
-            const auto is_taker_buyer_cn = "is_taker_buyer"_cn;
-
-            m_buffer
-                .table(trades_table)
-                // symbols
-                .symbol(symbol, trade.ticker)
-                // columns
-                .column(price, static_cast<std::int64_t>(trade.price))
-                .column(quantity_cn, static_cast<std::int64_t>(trade.quantity))
-                .column(trade_id_cn, trade.trade_id)
-                .column(taker_id_cn, trade.taker_id)
-                .column(maker_id_cn, trade.maker_id)
-                .column(taker_order_id_cn, static_cast<std::int64_t>(trade.taker_order_id))
-                .column(maker_order_id_cn, static_cast<std::int64_t>(trade.maker_order_id))
-                .column(is_taker_buyer_cn, trade.is_taker_buyer)
-                .at(questdb::ingress::timestamp_micros::now());
-
-            return;
+            std::visit([&](const auto& t) { append(buffer, t); }, task);
         } catch (const std::exception& e) {
-            // TODO: logger
-            std::cout << "Exception: " << e.what() << std::endl;
-            // return std::unexpected{
-            //     std::format("Error faced when inserting trade: {}", e.what())};
+            report_error(std::format("Failed to encode QuestDB row: {}", e.what()));
         }
     }
 
-    void append(const CancelResponseInsertionTask& cancel_response) {
-        const auto cancel_order_response{cancel_response.cancel_order_response};
+    void append(questdb::ingress::line_sender_buffer& buffer, const OrderInsertionTask& order) {
+        m_row_encoder.append(buffer, order.new_order_request, order.internal_order_id,
+                             order.is_order_valid);
+    }
+
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const CancelRequestInsertionTask& cancel_request) {
+        m_row_encoder.append(buffer, cancel_request.cancel_order_request,
+                             cancel_request.is_request_valid);
+    }
 
-        try {
-            const auto orders_table = "orders"_tn;
-            const auto order_id = "order_id"_cn;
-            const auto order_status = "order_status"_cn;
-
-            // Represent cancel as an order row with status CANCELED and filled_qty = 0.
-            m_buffer.table(orders_table)
-                .symbol(order_status, cancel_order_response.success
-                                          ? std::string_view("CANCELLED")
-                                          : std::string_view("REJECTED_CANCEL"))
-                .column(order_id, static_cast<int64_t>(cancel_order_response.order_id))
-                .at(questdb::ingress::timestamp_micros::now());
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const ExecutionInsertionTask& exec_report) {
+        m_row_encoder.append(buffer, exec_report.execution_report);
+    }
 
-            return;
-        } catch (const std::exception& e) {
-            // TODO: logger
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const TradeInsertionTask& trade_task) {
+        m_row_encoder.append(buffer, trade_task.trade);
+    }
 
-            // return std::unexpected{
-            //     std::format("Error faced when inserting cancel: {}", e.what())};
-        }
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const CancelResponseInsertionTask& cancel_response) {
+        m_row_encoder.append(buffer, cancel_response.cancel_order_response);
     }
 
-    ThreadSafeQueue<WriteTask>& m_write_queue;
+    BoundedWriteQueue<WriteTask>& m_write_queue;
 
     int m_flush_threshold;
     std::chrono::milliseconds m_flush_interval;
 
-    questdb::ingress::line_sender m_sender;
+    const IlpRowEncoder m_row_encoder{SERVER_NAME};
+
+    std::string m_ilp_conf;
+    // Only touched by the writer thread once it has started
+    std::optional<questdb::ingress::line_sender> m_sender;
     questdb::ingress::line_sender_buffer m_buffer;
+
+    std::shared_ptr<SpillJournal> m_spill_journal;
+    std::function<void(const std::string&)> m_on_error;
+
+    // Encodes tasks spilled by callers, whose threads must not touch m_buffer
+    std::mutex m_spill_mutex;
+    questdb::ingress::line_sender_buffer m_spill_buffer;
+
     std::atomic<bool> m_stop;
 
+    mutable std::mutex m_metrics_mutex;
+    std::uint64_t m_flushed_row_count{0};
+    std::uint64_t m_failed_flush_count{0};
+    std::uint64_t m_spilled_row_count{0};
+    std::uint64_t m_lost_row_count{0};
+    core::LatencyHistogram m_flush_latency_ns;
+
     std::thread m_writer_thread;
 };
 
@@ -371,6 +328,12 @@ class DatabaseClient {
   public:
     struct ServiceInsertRow;
 
+    static PgConnectionPoolConfig default_timeseries_db_pool_config() {
+        return PgConnectionPoolConfig{
+            .connection_string =
+                "host=localhost port=8812 user=admin password=quest dbname=qdb connect_timeout=3"};
+    }
+
     /*
      * @param ensure_init Whether to ensure the timeseries connection and async writer on
      * construction. It seems like too many concurrent connections cause a seg fault, especially for
@@ -381,7 +344,26 @@ class DatabaseClient {
      */
     DatabaseClient(bool ensure_init = false, int async_threshold = 64,
                    std::chrono::milliseconds async_flush_interval = 100ms)
-        : m_flush_interval(async_flush_interval), m_flush_threshold(async_threshold) {
+        : DatabaseClient(ensure_init, AsyncWriterConfig{.flush_threshold = async_threshold,
+                                                        .flush_interval = async_flush_interval}) {
+    }
+
+    // @param async_writer_config Flush thresholds, queue bound, overflow policy, QuestDB endpoint
+    // and spill journal of the writer.
+    // @param core_db_pool_config Size and checkout timeout of the edux_core_db connection pool.
+    // Callers that query from many threads at once, like the backend, need one connection each.
+    // @param timeseries_db_pool_config The same for the QuestDB connection pool.
+    DatabaseClient(bool ensure_init, const AsyncWriterConfig& async_writer_config,
+                   const PgConnectionPoolConfig& core_db_pool_config = {},
+                   const PgConnectionPoolConfig& timeseries_db_pool_config =
+                       default_timeseries_db_pool_config())
+        : m_async_writer_config{async_writer_config},
+          m_write_queue{async_writer_config.queue_capacity, async_writer_config.overflow_policy},
+          m_core_db_pool{core_db_pool_config,
+                         [this](pqxx::connection& connection) { prepare_statements(connection); }},
+          m_timeseries_db_pool_config{timeseries_db_pool_config} {
+        assert(async_writer_config.overflow_policy != OverflowPolicy::spill ||
+               async_writer_config.spill_journal);
         if (ensure_init) {
             ensure_timeseries_connection();
             ensure_async_writer();
@@ -398,7 +380,8 @@ class DatabaseClient {
     auto read_balance(int user_id, int server_id, std::string_view symbol)
         -> std::expected<std::int64_t, std::string> {
         try {
-            pqxx::work transaction{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work transaction{*connection};
 
             std::int64_t balance{transaction.query_value<std::int64_t>(
                 "SELECT balance FROM balances WHERE user_id = "
@@ -421,11 +404,11 @@ class DatabaseClient {
     auto read_balances(int user_id, int server_id) const
         -> std::expected<std::vector<BalanceRow>, std::string> {
         try {
-            pqxx::work transaction{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work transaction{*connection};
             std::vector<BalanceRow> balances;
-            auto res = transaction.exec(
-                "SELECT symbol, balance FROM balances WHERE user_id = $1 AND server_id = $2",
-                pqxx::params{user_id, server_id});
+            auto res = transaction.exec(pqxx::prepped{read_balances_statement},
+                                        pqxx::params{user_id, server_id});
             transaction.commit();
 
             balances.reserve(res.size());
@@ -444,7 +427,8 @@ class DatabaseClient {
     auto update_balance(int user_id, int server_id, std::string_view symbol,
                         std::int64_t balance) const -> std::expected<void, std::string> {
         try {
-            pqxx::work transaction{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work transaction{*connection};
 
             transaction.exec("UPDATE balances SET balance = $4 WHERE user_id = $1 AND server_id = "
                              "$2 AND symbol = $3",
@@ -457,11 +441,94 @@ class DatabaseClient {
         }
     }
 
+    // Batched form of update_balance used by the OM's BalanceWriteBehind: one round trip upserts
+    // every row for the server.
+    auto upsert_balances(int server_id, const std::vector<BalanceUpsertRow>& rows) const
+        -> std::expected<void, std::string> {
+        if (rows.empty()) {
+            return {};
+        }
+        try {
+            const auto arrays = build_balance_row_arrays(rows);
+
+            auto connection = m_core_db_pool.checkout();
+
+            pqxx::work transaction{*connection};
+            transaction.exec(
+                "INSERT INTO balances (user_id, server_id, symbol, balance) "
+                "SELECT u, $1, s, b FROM unnest($2::int[], $3::varchar[], $4::bigint[]) AS t(u, s, b) "
+                "ON CONFLICT (user_id, server_id, symbol) DO UPDATE SET balance = EXCLUDED.balance",
+                pqxx::params{server_id, arrays.user_ids, arrays.symbols, arrays.balances});
+            transaction.commit();
+            return {};
+        } catch (const std::exception& e) {
+            return std::unexpected{
+                std::format("Error faced when upserting {} balances: {}", rows.size(), e.what())};
+        }
+    }
+
+    // Raises the shard's order ID ceiling by block_size, starting from no lower than
+    // floor_order_id, and returns the new ceiling. The reserved block is
+    // [ceiling - block_size, ceiling). A single upsert, so concurrent reservations never overlap.
+    auto reserve_order_id_block(int server_id, int shard_id, int floor_order_id,
+                                int block_size) const -> std::expected<int, std::string> {
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work transaction{*connection};
+            const auto res = transaction.exec(
+                "INSERT INTO order_id_blocks (server_id, shard_id, reserved_through) "
+                "VALUES ($1, $2, $3::int + $4::int) "
+                "ON CONFLICT (server_id, shard_id) DO UPDATE SET "
+                "reserved_through = GREATEST(order_id_blocks.reserved_through, $3::int) + $4::int, "
+                "modified_ts = CURRENT_TIMESTAMP "
+                "RETURNING reserved_through",
+                pqxx::params{server_id, shard_id, floor_order_id, block_size});
+            transaction.commit();
+            return res[0]["reserved_through"].as<int>();
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format(
+                "Error faced when reserving order IDs for shard {}: {}", shard_id, e.what())};
+        }
+    }
+
+    // Records shard_count as the server's order ID shard count unless one is recorded already,
+    // and returns the recorded count.
+    auto claim_order_id_shard_count(int server_id, int shard_count) const
+        -> std::expected<int, std::string> {
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work transaction{*connection};
+            // The no-op update makes RETURNING yield the existing row on conflict
+            const auto res = transaction.exec(
+                "INSERT INTO order_id_shard_counts (server_id, shard_count) VALUES ($1, $2) "
+                "ON CONFLICT (server_id) DO UPDATE SET "
+                "shard_count = order_id_shard_counts.shard_count "
+                "RETURNING shard_count",
+                pqxx::params{server_id, shard_count});
+            transaction.commit();
+            return res[0]["shard_count"].as<int>();
+        } catch (const std::exception& e) {
+            return std::unexpected{
+                std::format("Error faced when claiming the order ID shard count: {}", e.what())};
+        }
+    }
+
     struct UserRow {
         int user_id{};
         std::string username;
     };
 
+    struct InitBotPortfolioRow {
+        int user_id{};
+        std::int64_t balance{};
+    };
+
+    // Rows created together with a server, in the same transaction
+    struct ServerSeedRows {
+        std::vector<BalanceUpsertRow> balances;
+        std::vector<InitBotPortfolioRow> init_bot_portfolio_balances;
+    };
+
     struct ServerRow {
         int server_id{};
         int admin_id{};
@@ -500,16 +567,58 @@ class DatabaseClient {
         int price{};
         int quantity{};
         long long ts_ms{};
+        long long ts_micros{};
+    };
+
+    // Position just past the last trade of a page. Trades are paged in (timestamp, trade_id)
+    // order, so trades sharing a timestamp are never skipped or repeated.
+    struct TradeCursor {
+        long long ts_micros{};
+        std::string trade_id;
+    };
+
+    struct TradePage {
+        std::vector<HistoricalTradeRow> trades;
+        // Set when more trades follow this page
+        std::optional<TradeCursor> next_cursor;
+    };
+
+    struct OhlcvBarRow {
+        long long ts_ms{};
+        int open{};
+        int high{};
+        int low{};
+        int close{};
+        std::int64_t volume{};
+        std::int64_t trade_count{};
     };
 
+    // A QuestDB SAMPLE BY interval such as "1m" or "4h": a positive count of s, m, h or d
+    static bool is_bar_resolution_valid(std::string_view resolution) {
+        if (resolution.size() < 2 || resolution.size() > 5 ||
+            std::string_view{"smhd"}.find(resolution.back()) == std::string_view::npos) {
+            return false;
+        }
+        const auto count = resolution.substr(0, resolution.size() - 1);
+        return std::ranges::all_of(count, [](char c) { return c >= '0' && c <= '9'; }) &&
+               count.find_first_not_of('0') != std::string_view::npos;
+    }
+
+    // The server's QuestDB trades table, quoted as an identifier: the name can come straight
+    // from a request, so it must never be spliced into a query as SQL
+    static std::string quoted_trades_table(const pqxx::transaction_base& txn,
+                                           std::string_view server_name) {
+        return txn.quote_name(std::format("trades_{}", server_name));
+    }
+
     // Verify credentials; returns the user row on success or nullopt on mismatch.
     auto authenticate_user(std::string_view username, std::string_view password)
         -> std::expected<std::optional<UserRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
-            auto res = txn.exec(
-                "SELECT user_id, username FROM users WHERE username = $1 AND password = $2",
-                pqxx::params{username, password});
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            auto res = txn.exec(pqxx::prepped{authenticate_user_statement},
+                                pqxx::params{username, password});
             txn.commit();
             if (res.empty())
                 return std::nullopt;
@@ -523,7 +632,8 @@ class DatabaseClient {
     auto create_user(std::string_view username, std::string_view password)
         -> std::expected<UserRow, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("INSERT INTO users (username, password) VALUES ($1, $2) RETURNING "
                                 "user_id, username",
                                 pqxx::params{username, password});
@@ -539,9 +649,9 @@ class DatabaseClient {
     // Lookup a user by username; returns nullopt when not found.
     auto get_user(std::string_view username) -> std::expected<std::optional<UserRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
-            auto res = txn.exec("SELECT user_id, username FROM users WHERE username = $1",
-                                pqxx::params{username});
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            auto res = txn.exec(pqxx::prepped{get_user_statement}, pqxx::params{username});
             txn.commit();
             if (res.empty())
                 return std::nullopt;
@@ -553,17 +663,9 @@ class DatabaseClient {
 
     auto get_active_servers() -> std::expected<std::vector<ServerRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
-            const bool has_initial_usd = servers_has_initial_usd_column(txn);
-            auto res = has_initial_usd
-                           ? txn.exec("SELECT s.server_id, s.admin_id, s.server_name, "
-                                      "u.username AS admin_name, "
-                                      "s.active_tickers, s.description, s.initial_usd "
-                                      "FROM servers s JOIN users u ON s.admin_id = u.user_id")
-                           : txn.exec("SELECT s.server_id, s.admin_id, s.server_name, "
-                                      "u.username AS admin_name, "
-                                      "s.active_tickers, s.description "
-                                      "FROM servers s JOIN users u ON s.admin_id = u.user_id");
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            auto res = txn.exec(pqxx::prepped{active_servers_statement});
             txn.commit();
             std::vector<ServerRow> result;
             result.reserve(res.size());
@@ -575,7 +677,7 @@ class DatabaseClient {
                 srv.admin_name = row["admin_name"].as<std::string>();
                 srv.description = row["description"].as<std::string>("");
                 srv.active_tickers = parse_pg_array(row["active_tickers"].as<std::string>("{}"));
-                srv.initial_usd = has_initial_usd ? row["initial_usd"].as<int>(100000) : 100000;
+                srv.initial_usd = row["initial_usd"].as<int>(100000);
                 result.push_back(std::move(srv));
             }
             return result;
@@ -587,7 +689,8 @@ class DatabaseClient {
     auto get_server(const std::string_view& server_name)
         -> std::expected<std::optional<ServerRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             const bool has_initial_usd = servers_has_initial_usd_column(txn);
             auto res = has_initial_usd
                            ? txn.exec("SELECT s.server_id, s.admin_id, s.server_name, "
@@ -624,7 +727,8 @@ class DatabaseClient {
     auto get_server_active_symbols(std::string_view server_name)
         -> std::expected<std::vector<std::string>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT active_tickers FROM servers WHERE server_name = $1",
                                 pqxx::params{server_name});
             txn.commit();
@@ -641,7 +745,8 @@ class DatabaseClient {
     auto get_user_servers(std::string_view username)
         -> std::expected<std::vector<UserServerRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
 
             auto user_res =
                 txn.exec("SELECT user_id FROM users WHERE username = $1", pqxx::params{username});
@@ -683,8 +788,7 @@ class DatabaseClient {
                 usr.active_tickers = parse_pg_array(row["active_tickers"].as<std::string>("{}"));
                 usr.initial_usd = has_initial_usd ? row["initial_usd"].as<int>(100000) : 100000;
 
-                auto bal_res = txn.exec("SELECT symbol, balance FROM balances "
-                                        "WHERE user_id = $1 AND server_id = $2",
+                auto bal_res = txn.exec(pqxx::prepped{read_balances_statement},
                                         pqxx::params{user_id, usr.server_id});
                 usr.balances.reserve(bal_res.size());
                 for (const auto& bal_row : bal_res) {
@@ -704,38 +808,11 @@ class DatabaseClient {
     auto get_account_details(std::string_view username, std::string_view server_name)
         -> std::expected<std::optional<AccountDetailsRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
 
-            const bool has_initial_usd = servers_has_initial_usd_column(txn);
-            auto res = has_initial_usd
-                           ? txn.exec("SELECT s.server_id, s.server_name, s.description, "
-                                      "s.active_tickers, s.initial_usd, "
-                                      "u_admin.username AS admin_name, u.user_id, "
-                                      "CASE WHEN s.admin_id = u.user_id THEN 'admin' ELSE 'member' "
-                                      "END AS role "
-                                      "FROM users u "
-                                      "JOIN servers s ON s.server_name = $2 "
-                                      "JOIN users u_admin ON u_admin.user_id = s.admin_id "
-                                      "WHERE u.username = $1 "
-                                      "AND (s.admin_id = u.user_id "
-                                      "     OR EXISTS (SELECT 1 FROM allowlist a "
-                                      "                WHERE a.server_id = s.server_id AND "
-                                      "a.user_id = u.user_id))",
-                                      pqxx::params{username, server_name})
-                           : txn.exec("SELECT s.server_id, s.server_name, s.description, "
-                                      "s.active_tickers, "
-                                      "u_admin.username AS admin_name, u.user_id, "
-                                      "CASE WHEN s.admin_id = u.user_id THEN 'admin' ELSE 'member' "
-                                      "END AS role "
-                                      "FROM users u "
-                                      "JOIN servers s ON s.server_name = $2 "
-                                      "JOIN users u_admin ON u_admin.user_id = s.admin_id "
-                                      "WHERE u.username = $1 "
-                                      "AND (s.admin_id = u.user_id "
-                                      "     OR EXISTS (SELECT 1 FROM allowlist a "
-                                      "                WHERE a.server_id = s.server_id AND "
-                                      "a.user_id = u.user_id))",
-                                      pqxx::params{username, server_name});
+            auto res = txn.exec(pqxx::prepped{account_details_statement},
+                                pqxx::params{username, server_name});
             if (res.empty())
                 return std::nullopt;
 
@@ -749,16 +826,14 @@ class DatabaseClient {
             details.description = row["description"].as<std::string>("");
             details.role = row["role"].as<std::string>();
             details.active_tickers = parse_pg_array(row["active_tickers"].as<std::string>("{}"));
-            details.initial_usd = has_initial_usd ? row["initial_usd"].as<int>(100000) : 100000;
+            details.initial_usd = row["initial_usd"].as<int>(100000);
 
             // Fetch all balances for the user
-            auto bal_res = txn.exec("SELECT symbol, balance FROM balances "
-                                    "WHERE user_id = $1 AND server_id = $2",
+            auto bal_res = txn.exec(pqxx::prepped{read_balances_statement},
                                     pqxx::params{user_id, server_id});
-            auto bot_init_balance_res = txn.exec(
-                "SELECT balance FROM init_bot_portfolio_balances "
-                "WHERE user_id = $1 AND server_id = $2",
-                pqxx::params{user_id, server_id});
+            auto bot_init_balance_res =
+                txn.exec(pqxx::prepped{init_bot_portfolio_balance_statement},
+                         pqxx::params{user_id, server_id});
             txn.commit();
 
             if (!bot_init_balance_res.empty()) {
@@ -778,40 +853,118 @@ class DatabaseClient {
     auto query_trades(const std::string_view& server_name, const std::string_view& symbol,
                       long long after_ts_ms)
         -> std::expected<std::vector<HistoricalTradeRow>, std::string> {
+        auto page = query_trades_page(server_name, symbol, after_ts_ms, std::nullopt, std::nullopt);
+        if (!page.has_value()) {
+            return std::unexpected{std::move(page.error())};
+        }
+        return std::move(page->trades);
+    }
+
+    // At most limit trades for a symbol at or after after_ts_ms, continuing from cursor when
+    // given. Without a limit every remaining trade is returned in one page.
+    auto query_trades_page(const std::string_view& server_name, const std::string_view& symbol,
+                           long long after_ts_ms, const std::optional<TradeCursor>& cursor,
+                           std::optional<std::size_t> limit)
+        -> std::expected<TradePage, std::string> {
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
-            // QuestDB: CAST(ts AS LONG) returns microseconds since epoch.
-            const auto after_ts_micros = after_ts_ms * 1000LL;
-            const auto trades_table = std::format("trades_{}", server_name);
-            const auto quoted_symbol = txn.quote(symbol);
-            const std::string query = std::format(
-                "SELECT trade_id, symbol, price, quantity, CAST(timestamp AS LONG) AS ts_micros "
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
+            // Bounds are compared against the designated timestamp column itself, so QuestDB can
+            // skip every partition before them. CAST(ts AS LONG) is microseconds since epoch.
+            const auto from_ts_micros =
+                std::max(after_ts_ms * 1000LL, cursor.has_value() ? cursor->ts_micros : 0LL);
+            std::string query = std::format(
+                "SELECT trade_id, price, quantity, CAST(timestamp AS LONG) AS ts_micros "
                 "FROM {} "
                 "WHERE symbol = {} "
-                "AND CAST(timestamp AS LONG) >= {} "
-                "ORDER BY timestamp ASC, trade_id ASC",
-                trades_table, quoted_symbol, after_ts_micros);
+                "AND timestamp >= CAST({} AS TIMESTAMP)",
+                quoted_trades_table(txn, server_name), txn.quote(symbol), from_ts_micros);
+            if (cursor.has_value()) {
+                query += std::format(" AND (timestamp > CAST({} AS TIMESTAMP) OR trade_id > {})",
+                                     cursor->ts_micros, txn.quote(cursor->trade_id));
+            }
+            query += " ORDER BY timestamp ASC, trade_id ASC";
+            if (limit.has_value()) {
+                // The extra row only tells whether another page follows
+                query += std::format(" LIMIT {}", limit.value() + 1);
+            }
             auto res = txn.exec(query);
             txn.commit();
 
-            std::vector<HistoricalTradeRow> result;
-            result.reserve(res.size());
-            for (const auto& row : res) {
+            const auto result_size = static_cast<std::size_t>(res.size());
+            const auto row_count = std::min(result_size, limit.value_or(result_size));
+            TradePage page;
+            page.trades.reserve(row_count);
+            for (std::size_t i = 0; i < row_count; ++i) {
+                const auto row = res[static_cast<pqxx::result::size_type>(i)];
                 HistoricalTradeRow trade;
                 trade.trade_id = row["trade_id"].as<std::string>("");
-                trade.symbol = row["symbol"].as<std::string>("");
+                trade.symbol = symbol;
                 trade.price = row["price"].as<int>(0);
                 trade.quantity = row["quantity"].as<int>(0);
-                trade.ts_ms = row["ts_micros"].as<long long>(0) / 1000;
-                result.push_back(std::move(trade));
+                trade.ts_micros = row["ts_micros"].as<long long>(0);
+                trade.ts_ms = trade.ts_micros / 1000;
+                page.trades.push_back(std::move(trade));
             }
-            return result;
+            if (result_size > row_count && !page.trades.empty()) {
+                page.next_cursor =
+                    TradeCursor{page.trades.back().ts_micros, page.trades.back().trade_id};
+            }
+            return page;
         } catch (const std::exception& e) {
             return std::unexpected{std::format("Error querying trades: {}", e.what())};
         }
     }
 
+    // OHLCV bars for a symbol at or after after_ts_ms, aggregated by QuestDB at the given
+    // resolution (see is_bar_resolution_valid) and aligned to calendar boundaries, oldest first
+    auto query_trade_bars(const std::string_view& server_name, const std::string_view& symbol,
+                          long long after_ts_ms, std::string_view resolution,
+                          std::optional<std::size_t> limit = std::nullopt)
+        -> std::expected<std::vector<OhlcvBarRow>, std::string> {
+        if (!is_bar_resolution_valid(resolution)) {
+            return std::unexpected{std::format("Invalid bar resolution: {}", resolution)};
+        }
+        try {
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
+            std::string query = std::format(
+                "SELECT CAST(timestamp AS LONG) AS ts_micros, open, high, low, close, volume, "
+                "trade_count "
+                "FROM (SELECT timestamp, first(price) AS open, max(price) AS high, "
+                "min(price) AS low, last(price) AS close, sum(quantity) AS volume, "
+                "count() AS trade_count "
+                "FROM {} "
+                "WHERE symbol = {} "
+                "AND timestamp >= CAST({} AS TIMESTAMP) "
+                "SAMPLE BY {} ALIGN TO CALENDAR)",
+                quoted_trades_table(txn, server_name), txn.quote(symbol), after_ts_ms * 1000LL,
+                resolution);
+            if (limit.has_value()) {
+                query += std::format(" LIMIT {}", limit.value());
+            }
+            auto res = txn.exec(query);
+            txn.commit();
+
+            std::vector<OhlcvBarRow> result;
+            result.reserve(res.size());
+            for (const auto& row : res) {
+                OhlcvBarRow bar;
+                bar.ts_ms = row["ts_micros"].as<long long>(0) / 1000;
+                bar.open = row["open"].as<int>(0);
+                bar.high = row["high"].as<int>(0);
+                bar.low = row["low"].as<int>(0);
+                bar.close = row["close"].as<int>(0);
+                bar.volume = row["volume"].as<std::int64_t>(0);
+                bar.trade_count = row["trade_count"].as<std::int64_t>(0);
+                result.push_back(bar);
+            }
+            return result;
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format("Error querying trade bars: {}", e.what())};
+        }
+    }
+
     auto query_trades(const std::string_view& symbol, long long after_ts_ms)
         -> std::expected<std::vector<HistoricalTradeRow>, std::string> {
         return query_trades(SERVER_NAME, symbol, after_ts_ms);
@@ -827,16 +980,19 @@ class DatabaseClient {
                                            allowlist_user_ids, {}, initial_usd);
     }
 
-    // Insert a new server, allowlist, and service endpoints in one transaction.
+    // Insert a new server, allowlist, service endpoints and seed balances in one transaction.
     // Returns the newly created server_id.
     auto create_server_with_services(std::string_view server_name, int admin_id,
                                      std::string_view description,
                                      const std::vector<std::string>& symbols,
                                      const std::vector<int>& allowlist_user_ids,
                                      const std::vector<ServiceInsertRow>& services,
-                                     int initial_usd = 100000) -> std::expected<int, std::string> {
+                                     int initial_usd = 100000,
+                                     const ServerSeedRows& seed_rows = {})
+        -> std::expected<int, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             const std::string arr = build_pg_array(symbols);
             const bool has_initial_usd = servers_has_initial_usd_column(txn);
             auto res =
@@ -852,16 +1008,15 @@ class DatabaseClient {
             if (res.empty())
                 return std::unexpected{std::string{"Failed to create server"}};
             const int server_id = res[0]["server_id"].as<int>();
-            for (int uid : allowlist_user_ids) {
-                txn.exec("INSERT INTO allowlist (server_id, user_id) VALUES ($1, $2)",
-                         pqxx::params{server_id, uid});
-            }
+            insert_allowlist_rows(txn, server_id, allowlist_user_ids);
             for (const auto& service : services) {
                 txn.exec("INSERT INTO services (machine_id, server_id, service_type, port) "
                          "VALUES ($1, $2, $3, $4)",
                          pqxx::params{service.machine_id, server_id,
                                       service_enum_to_str(service.service_type), service.port});
             }
+            insert_balance_rows(txn, server_id, seed_rows.balances);
+            upsert_init_bot_portfolio_rows(txn, server_id, seed_rows.init_bot_portfolio_balances);
             txn.commit();
             return server_id;
         } catch (const std::exception& e) {
@@ -876,7 +1031,8 @@ class DatabaseClient {
                           const std::vector<int>& allowlist_user_ids)
         -> std::expected<bool, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto srv_res =
                 txn.exec("SELECT server_id, admin_id FROM servers WHERE server_name = $1",
                          pqxx::params{server_name});
@@ -892,10 +1048,7 @@ class DatabaseClient {
                      pqxx::params{description, arr, server_id});
 
             txn.exec("DELETE FROM allowlist WHERE server_id = $1", pqxx::params{server_id});
-            for (int uid : allowlist_user_ids) {
-                txn.exec("INSERT INTO allowlist (server_id, user_id) VALUES ($1, $2)",
-                         pqxx::params{server_id, uid});
-            }
+            insert_allowlist_rows(txn, server_id, allowlist_user_ids);
             txn.commit();
             return true;
         } catch (const std::exception& e) {
@@ -905,7 +1058,8 @@ class DatabaseClient {
 
     auto delete_server(std::string_view server_name) -> std::expected<bool, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto srv_res = txn.exec("SELECT server_id FROM servers WHERE server_name = $1",
                                     pqxx::params{server_name});
             if (srv_res.empty())
@@ -923,58 +1077,95 @@ class DatabaseClient {
         }
     }
 
-    // Resolve a list of usernames to user_ids; returns an error naming the first
+    // Resolve a list of usernames to user_ids in one query; returns an error naming the first
     // unknown username.
     auto resolve_user_ids(const std::vector<std::string>& usernames)
         -> std::expected<std::vector<int>, std::string> {
-        std::vector<int> ids;
-        ids.reserve(usernames.size());
-        for (const auto& uname : usernames) {
-            auto res = get_user(uname);
-            if (!res.has_value())
-                return std::unexpected{res.error()};
-            if (!res.value().has_value())
-                return std::unexpected{"User not found: " + uname};
-            ids.push_back(res.value()->user_id);
+        if (usernames.empty())
+            return std::vector<int>{};
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            const auto ids_by_username = select_user_ids(txn, usernames);
+            txn.commit();
+
+            std::vector<int> ids;
+            ids.reserve(usernames.size());
+            for (const auto& uname : usernames) {
+                const auto it = ids_by_username.find(uname);
+                if (it == ids_by_username.end())
+                    return std::unexpected{"User not found: " + uname};
+                ids.push_back(it->second);
+            }
+            return ids;
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format("Error resolving user ids: {}", e.what())};
+        }
+    }
+
+    // Resolve usernames to user_ids, creating the missing users with the given password, in one
+    // transaction. Ids are returned in the order of usernames.
+    auto get_or_create_users(const std::vector<std::string>& usernames, std::string_view password)
+        -> std::expected<std::vector<int>, std::string> {
+        if (usernames.empty())
+            return std::vector<int>{};
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            const std::string arr = build_pg_array(usernames);
+            txn.exec("INSERT INTO users (username, password) "
+                     "SELECT unnest($1::varchar[]), $2 "
+                     "ON CONFLICT (username) DO NOTHING",
+                     pqxx::params{arr, password});
+            const auto ids_by_username = select_user_ids(txn, usernames);
+            txn.commit();
+
+            std::vector<int> ids;
+            ids.reserve(usernames.size());
+            for (const auto& uname : usernames) {
+                const auto it = ids_by_username.find(uname);
+                if (it == ids_by_username.end())
+                    return std::unexpected{"Failed to create user: " + uname};
+                ids.push_back(it->second);
+            }
+            return ids;
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format("Error getting or creating users: {}", e.what())};
         }
-        return ids;
     }
 
     // -----------------------------------------------------------------------
-    // Insert-based functions for questdb should also be asynchronous.
+    // Insert-based functions for questdb should also be asynchronous. The containers are taken
+    // by value and moved into the queued task, the writer encodes straight from them.
     auto insert_order(int internal_order_id, core::NewOrderSingleContainer new_order_request,
                       bool is_order_valid) -> std::expected<void, std::string> {
         ensure_async_writer();
-        m_write_queue.enqueue(
-            OrderInsertionTask{internal_order_id, new_order_request, is_order_valid});
-        return {};
+        return enqueue_write(
+            OrderInsertionTask{internal_order_id, std::move(new_order_request), is_order_valid});
     }
 
     auto insert_cancel_request(core::CancelOrderRequestContainer cancel_order_request,
                                bool is_request_valid) -> std::expected<void, std::string> {
         ensure_async_writer();
-        m_write_queue.enqueue(CancelRequestInsertionTask{cancel_order_request, is_request_valid});
-        return {};
+        return enqueue_write(
+            CancelRequestInsertionTask{std::move(cancel_order_request), is_request_valid});
     }
 
     auto insert_execution(core::ExecutionReportContainer execution_report)
         -> std::expected<void, std::string> {
         ensure_async_writer();
-        m_write_queue.enqueue(ExecutionInsertionTask{execution_report});
-        return {};
+        return enqueue_write(ExecutionInsertionTask{std::move(execution_report)});
     }
 
     auto insert_trade(core::TradeContainer trade) -> std::expected<void, std::string> {
         ensure_async_writer();
-        m_write_queue.enqueue(TradeInsertionTask{trade});
-        return {};
+        return enqueue_write(TradeInsertionTask{std::move(trade)});
     }
 
     auto insert_cancel_response(core::CancelOrderResponseContainer cancel_order_response)
         -> std::expected<void, std::string> {
         ensure_async_writer();
-        m_write_queue.enqueue(CancelResponseInsertionTask{cancel_order_response});
-        return {};
+        return enqueue_write(CancelResponseInsertionTask{cancel_order_response});
     }
 
     // TODO: this is public but maybe i should put this elsewhere
@@ -1012,7 +1203,8 @@ class DatabaseClient {
 
     auto query_machines() const -> std::expected<std::vector<MachineRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT machine_id, machine_name, ip FROM machines;");
             txn.commit();
             std::vector<MachineRow> result;
@@ -1049,7 +1241,8 @@ class DatabaseClient {
 
     auto query_services() const -> std::expected<std::vector<ServiceRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT "
                                 "s.service_type,"
                                 "m.ip,"
@@ -1078,7 +1271,8 @@ class DatabaseClient {
     auto query_services(const std::string_view machine_name) const
         -> std::expected<std::vector<ServiceRow>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT "
                                 "s.service_type,"
                                 "m.ip,"
@@ -1109,7 +1303,8 @@ class DatabaseClient {
     auto get_service_endpoint(const std::string_view server_name, Service service_type) const
         -> std::expected<std::optional<ServiceEndpoint>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT m.ip, s.port::VARCHAR AS port "
                                 "FROM services s "
                                 "INNER JOIN servers sv ON s.server_id = sv.server_id "
@@ -1133,7 +1328,8 @@ class DatabaseClient {
     auto insert_service(int machine_id, int server_id, Service service_type, int port) const
         -> std::expected<void, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             txn.exec("INSERT INTO services (machine_id, server_id, service_type, port) "
                      "VALUES ($1, $2, $3, $4)",
                      pqxx::params{machine_id, server_id, service_enum_to_str(service_type), port});
@@ -1148,8 +1344,8 @@ class DatabaseClient {
     auto query_orders(const std::string_view& server_name)
         -> std::expected<std::vector<OrderRow>, std::string> {
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             const auto orders_table = std::format("orders_{}", server_name);
             pqxx::result res = txn.exec(
                 std::format("SELECT order_id, cl_order_id, sender_comp_id, symbol, side, "
@@ -1188,8 +1384,8 @@ class DatabaseClient {
     auto query_trades(const std::string_view& server_name)
         -> std::expected<std::vector<TradeRow>, std::string> {
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             const auto trades_table = std::format("trades_{}", server_name);
             pqxx::result res = txn.exec(
                 std::format("SELECT price, quantity, symbol, trade_id, taker_id, maker_id, "
@@ -1223,10 +1419,114 @@ class DatabaseClient {
         return query_trades(SERVER_NAME);
     }
 
+    struct LiveOrderRow {
+        int order_id{};
+        int cl_order_id{};
+        std::string sender_comp_id;
+        std::string symbol;
+        std::string side;
+        int order_qty{};
+        int price{};
+        std::string time_in_force;
+        int filled_qty{};
+        std::int64_t filled_notional{}; // Sum of price * quantity over the order's fills
+    };
+
+    // Limit orders accepted on the server that have been neither cancelled nor fully filled, i.e.
+    // those still resting on the Matching Engine as far as the persisted rows tell. Writes are
+    // asynchronous, so rows from the last flush interval before a crash may be missing.
+    auto query_live_orders(const std::string_view& server_name)
+        -> std::expected<std::vector<LiveOrderRow>, std::string> {
+        try {
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
+            const auto orders_table = std::format("orders_{}", server_name);
+            const auto trades_table = std::format("trades_{}", server_name);
+
+            const pqxx::result accepted_res = txn.exec(std::format(
+                "SELECT order_id, cl_order_id, sender_comp_id, symbol, side, order_qty, price, "
+                "time_in_force FROM {} WHERE order_status = 'NEW' AND ord_type = 'LIMIT'",
+                orders_table));
+            const pqxx::result cancelled_res = txn.exec(std::format(
+                "SELECT DISTINCT order_id FROM {} WHERE order_status = 'CANCELLED'", orders_table));
+            const pqxx::result fills_res = txn.exec(std::format(
+                "SELECT order_id, sum(quantity) AS filled_qty, "
+                "sum(price * quantity) AS filled_notional FROM ("
+                "SELECT taker_order_id AS order_id, quantity, price FROM {0} UNION ALL "
+                "SELECT maker_order_id AS order_id, quantity, price FROM {0}) "
+                "GROUP BY order_id",
+                trades_table));
+            txn.commit();
+
+            std::unordered_set<int> cancelled_order_ids;
+            cancelled_order_ids.reserve(cancelled_res.size());
+            for (const auto& r : cancelled_res) {
+                cancelled_order_ids.insert(r["order_id"].as<int>());
+            }
+
+            std::unordered_map<int, std::pair<int, std::int64_t>> fills;
+            fills.reserve(fills_res.size());
+            for (const auto& r : fills_res) {
+                fills.emplace(r["order_id"].as<int>(),
+                              std::pair{r["filled_qty"].as<int>(0),
+                                        r["filled_notional"].as<std::int64_t>(0)});
+            }
+
+            std::vector<LiveOrderRow> rows;
+            for (const auto& r : accepted_res) {
+                LiveOrderRow row;
+                row.order_id = r["order_id"].as<int>();
+                if (cancelled_order_ids.contains(row.order_id)) {
+                    continue;
+                }
+                row.order_qty = r["order_qty"].as<int>(0);
+                if (const auto it = fills.find(row.order_id); it != fills.end()) {
+                    std::tie(row.filled_qty, row.filled_notional) = it->second;
+                }
+                if (row.filled_qty >= row.order_qty) {
+                    continue;
+                }
+
+                row.cl_order_id = r["cl_order_id"].as<int>(0);
+                row.sender_comp_id = r["sender_comp_id"].as<std::string>("");
+                row.symbol = r["symbol"].as<std::string>("");
+                row.side = r["side"].as<std::string>("");
+                row.price = r["price"].as<int>(0);
+                row.time_in_force = r["time_in_force"].as<std::string>("");
+                rows.push_back(std::move(row));
+            }
+            return rows;
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format("Error querying live orders: {}", e.what())};
+        }
+    }
+
+    // Highest persisted order ID in [first_order_id, end_order_id), nullopt if there is none
+    auto query_max_order_id(const std::string_view& server_name, int first_order_id,
+                            int end_order_id) -> std::expected<std::optional<int>, std::string> {
+        try {
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
+            const pqxx::result res = txn.exec(
+                std::format("SELECT max(order_id) AS max_order_id FROM orders_{} "
+                            "WHERE order_id >= {} AND order_id < {}",
+                            server_name, first_order_id, end_order_id));
+            txn.commit();
+
+            if (res.empty() || res[0]["max_order_id"].is_null()) {
+                return std::nullopt;
+            }
+            return res[0]["max_order_id"].as<int>();
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format("Error querying max order ID: {}", e.what())};
+        }
+    }
+
     auto insert_balance(int user_id, int server_id, std::string_view symbol, std::int64_t balance)
         -> std::expected<void, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             txn.exec("INSERT INTO balances (user_id, server_id, symbol, balance) "
                      "VALUES ($1, $2, $3, $4)",
                      pqxx::params{user_id, server_id, symbol, balance});
@@ -1237,10 +1537,41 @@ class DatabaseClient {
         }
     }
 
+    // Multi-row form of insert_balance: every row in one statement and transaction
+    auto insert_balances(int server_id, const std::vector<BalanceUpsertRow>& rows)
+        -> std::expected<void, std::string> {
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            insert_balance_rows(txn, server_id, rows);
+            txn.commit();
+            return {};
+        } catch (const std::exception& e) {
+            return std::unexpected{
+                std::format("Error inserting {} balances: {}", rows.size(), e.what())};
+        }
+    }
+
+    auto upsert_init_bot_portfolio_balances(int server_id,
+                                            const std::vector<InitBotPortfolioRow>& rows)
+        -> std::expected<void, std::string> {
+        try {
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
+            upsert_init_bot_portfolio_rows(txn, server_id, rows);
+            txn.commit();
+            return {};
+        } catch (const std::exception& e) {
+            return std::unexpected{std::format(
+                "Error upserting {} initial bot portfolio balances: {}", rows.size(), e.what())};
+        }
+    }
+
     auto upsert_init_bot_portfolio_balance(int user_id, int server_id, std::int64_t balance)
         -> std::expected<void, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             txn.exec("INSERT INTO init_bot_portfolio_balances (user_id, server_id, balance) "
                      "VALUES ($1, $2, $3) "
                      "ON CONFLICT (user_id, server_id) DO UPDATE SET balance = EXCLUDED.balance, "
@@ -1257,7 +1588,8 @@ class DatabaseClient {
     // Get all user_ids from allowlist for a given server_id
     auto get_users_by_server(int server_id) -> std::expected<std::vector<int>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             auto res = txn.exec("SELECT user_id FROM allowlist WHERE server_id = $1",
                                 pqxx::params{server_id});
             txn.commit();
@@ -1278,7 +1610,8 @@ class DatabaseClient {
     auto ensure_initial_usd_balances(std::string_view server_name, int initial_usd_amount)
         -> std::expected<int, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
 
             // Get server details
             const bool has_initial_usd = servers_has_initial_usd_column(txn);
@@ -1347,12 +1680,14 @@ class DatabaseClient {
         std::vector<BalanceRow> balances;
     };
 
-    // Get all users (including admin) and their balances for a given server.
-    // Returns a map of username -> balances for efficient lookup.
+    // Get all users (including admin) and their balances for a given server. The balances are
+    // streamed over COPY in one query ordered by user, rather than two round trips per user, so
+    // loading stays fast with many users.
     auto get_all_users_balances_for_server(std::string_view server_name)
         -> std::expected<std::vector<UserBalanceInfo>, std::string> {
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
 
             // Get server_id and admin_id
             auto server_res =
@@ -1364,51 +1699,28 @@ class DatabaseClient {
                     std::format("Server not found: {}", std::string(server_name))};
             }
 
-            int server_id = server_res[0]["server_id"].as<int>();
-            int admin_id = server_res[0]["admin_id"].as<int>();
+            const int server_id = server_res[0]["server_id"].as<int>();
+            const int admin_id = server_res[0]["admin_id"].as<int>();
 
-            // Get all users from allowlist + admin
-            auto allowlist_res = txn.exec("SELECT user_id FROM allowlist WHERE server_id = $1",
-                                          pqxx::params{server_id});
-
-            std::vector<int> user_ids;
-            user_ids.reserve(allowlist_res.size() + 1);
-            for (const auto& row : allowlist_res) {
-                user_ids.push_back(row["user_id"].as<int>());
-            }
-            // Add admin if not already in the list
-            if (std::find(user_ids.begin(), user_ids.end(), admin_id) == user_ids.end()) {
-                user_ids.push_back(admin_id);
-            }
+            // Users from the allowlist + admin, with a row per balance (or one null row if none)
+            const auto query = std::format(
+                "SELECT u.user_id, u.username, b.symbol, b.balance FROM users u "
+                "LEFT JOIN balances b ON b.user_id = u.user_id AND b.server_id = {0} "
+                "WHERE u.user_id = {1} "
+                "OR u.user_id IN (SELECT user_id FROM allowlist WHERE server_id = {0}) "
+                "ORDER BY u.user_id",
+                server_id, admin_id);
 
-            // Get usernames and balances for all users in a single query
             std::vector<UserBalanceInfo> result;
-            result.reserve(user_ids.size());
-
-            for (int user_id : user_ids) {
-                // Get username
-                auto user_res = txn.exec("SELECT username FROM users WHERE user_id = $1",
-                                         pqxx::params{user_id});
-
-                if (user_res.empty()) {
-                    continue; // Skip if user not found
+            for (const auto& [user_id, username, symbol, balance] :
+                 txn.stream<int, std::string_view, std::optional<std::string_view>,
+                            std::optional<std::int64_t>>(query)) {
+                if (result.empty() || result.back().user_id != user_id) {
+                    result.emplace_back(user_id, std::string{username}, std::vector<BalanceRow>{});
                 }
-
-                std::string username = user_res[0]["username"].as<std::string>();
-
-                // Get all balances for this user
-                auto balance_res = txn.exec(
-                    "SELECT symbol, balance FROM balances WHERE user_id = $1 AND server_id = $2",
-                    pqxx::params{user_id, server_id});
-
-                std::vector<BalanceRow> balances;
-                balances.reserve(balance_res.size());
-                for (const auto& row : balance_res) {
-                    balances.emplace_back(BalanceRow{row["symbol"].as<std::string>(),
-                                                     row["balance"].as<std::int64_t>()});
+                if (symbol.has_value() && balance.has_value()) {
+                    result.back().balances.emplace_back(BalanceRow{std::string{*symbol}, *balance});
                 }
-
-                result.emplace_back(user_id, std::move(username), std::move(balances));
             }
 
             txn.commit();
@@ -1425,7 +1737,8 @@ class DatabaseClient {
         if (user_ids.empty() && server_ids.empty())
             return {};
         try {
-            pqxx::work txn{*m_core_db_sql_connection};
+            auto connection = m_core_db_pool.checkout();
+            pqxx::work txn{*connection};
             for (int sid : server_ids)
                 txn.exec("DELETE FROM allowlist WHERE server_id = $1", pqxx::params{sid});
             for (int uid : user_ids)
@@ -1444,8 +1757,8 @@ class DatabaseClient {
     auto create_quest_tables(const std::string_view& server_name)
         -> std::expected<void, std::string> {
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             auto trades_create_sql =
                 std::format("CREATE TABLE IF NOT EXISTS trades_{} "
                             "(ts TIMESTAMP,"
@@ -1489,8 +1802,8 @@ class DatabaseClient {
     auto drop_quest_tables(const std::string_view& server_name)
         -> std::expected<void, std::string> {
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             txn.exec(std::format("DROP TABLE IF EXISTS orders_{};", server_name));
             txn.exec(std::format("DROP TABLE IF EXISTS trades_{};", server_name));
             txn.commit();
@@ -1506,8 +1819,8 @@ class DatabaseClient {
             return std::unexpected{setup.error()};
         }
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             txn.exec(std::format("TRUNCATE TABLE orders_{}", server_name));
             txn.commit();
             return {};
@@ -1525,8 +1838,8 @@ class DatabaseClient {
             return std::unexpected{setup.error()};
         }
         try {
-            ensure_timeseries_connection();
-            pqxx::work txn{*m_timeseries_db_sql_connection};
+            auto connection = timeseries_db_pool().checkout();
+            pqxx::work txn{*connection};
             txn.exec(std::format("TRUNCATE TABLE trades_{}", server_name));
             txn.commit();
             return {};
@@ -1544,28 +1857,107 @@ class DatabaseClient {
     // These seemed to fix them, however if we want fast initial connections we want to pre-call
     // them for hot paths.
     void ensure_timeseries_connection() {
-        if (!m_timeseries_db_sql_connection || !m_timeseries_db_sql_connection->is_open()) {
-            m_timeseries_db_sql_connection = std::make_unique<pqxx::connection>(
-                "host=localhost port=8812 user=admin password=quest dbname=qdb connect_timeout=3");
-        }
+        timeseries_db_pool();
     }
 
     void ensure_async_writer() {
         if (!m_async_writer.has_value()) {
-            m_async_writer.emplace(m_write_queue, m_flush_threshold, m_flush_interval);
+            m_async_writer.emplace(m_write_queue, m_async_writer_config);
         }
     }
 
+    // nullopt until the first asynchronous insert starts the writer
+    std::optional<AsyncWriterMetrics> async_writer_metrics() const {
+        return m_async_writer.transform([](const AsyncWriter& writer) { return writer.metrics(); });
+    }
+
   private:
+    // Opened on first use. Throws if QuestDB cannot be reached, a later call retries.
+    PgConnectionPool& timeseries_db_pool() const {
+        std::lock_guard lock{m_timeseries_db_pool_mutex};
+        if (!m_timeseries_db_pool.has_value()) {
+            m_timeseries_db_pool.emplace(m_timeseries_db_pool_config);
+        }
+        return m_timeseries_db_pool.value();
+    }
+
+    // Only reached once the writer has fallen a full queue behind and the policy does not block
+    auto enqueue_write(WriteTask task) -> std::expected<void, std::string> {
+        if (m_write_queue.enqueue(std::move(task))) {
+            return {};
+        }
+        if (m_async_writer_config.overflow_policy == OverflowPolicy::spill) {
+            return m_async_writer->spill(task);
+        }
+        return std::unexpected{std::string{"Write queue is full, task dropped"}};
+    }
+
+    enum class ColumnPresence : std::uint8_t { unknown, present, absent };
+
+    // Checked once and shared by every pooled connection
     bool servers_has_initial_usd_column(pqxx::transaction_base& txn) const {
-        if (m_has_servers_initial_usd_column.has_value()) {
-            return m_has_servers_initial_usd_column.value();
+        if (const auto presence = m_servers_initial_usd_column.load();
+            presence != ColumnPresence::unknown) {
+            return presence == ColumnPresence::present;
         }
         auto res = txn.exec("SELECT 1 FROM information_schema.columns "
                             "WHERE table_schema = 'public' AND table_name = 'servers' "
                             "AND column_name = 'initial_usd'");
-        m_has_servers_initial_usd_column = !res.empty();
-        return m_has_servers_initial_usd_column.value();
+        m_servers_initial_usd_column.store(res.empty() ? ColumnPresence::absent
+                                                       : ColumnPresence::present);
+        return !res.empty();
+    }
+
+    static constexpr const char* authenticate_user_statement{"authenticate_user"};
+    static constexpr const char* get_user_statement{"get_user"};
+    static constexpr const char* read_balances_statement{"read_balances"};
+    static constexpr const char* active_servers_statement{"active_servers"};
+    static constexpr const char* account_details_statement{"account_details"};
+    static constexpr const char* init_bot_portfolio_balance_statement{"init_bot_portfolio_balance"};
+
+    // Prepared on every pooled connection, for the queries behind login, the server list and the
+    // account page
+    void prepare_statements(pqxx::connection& connection) const {
+        bool has_initial_usd;
+        {
+            pqxx::nontransaction txn{connection};
+            has_initial_usd = servers_has_initial_usd_column(txn);
+        }
+        // Databases from before servers.initial_usd existed get the default
+        const std::string_view initial_usd{has_initial_usd ? "s.initial_usd" : "100000"};
+
+        connection.prepare(authenticate_user_statement,
+                           "SELECT user_id, username FROM users "
+                           "WHERE username = $1 AND password = $2");
+        connection.prepare(get_user_statement,
+                           "SELECT user_id, username FROM users WHERE username = $1");
+        connection.prepare(read_balances_statement,
+                           "SELECT symbol, balance FROM balances "
+                           "WHERE user_id = $1 AND server_id = $2");
+        connection.prepare(active_servers_statement,
+                           std::format("SELECT s.server_id, s.admin_id, s.server_name, "
+                                       "u.username AS admin_name, "
+                                       "s.active_tickers, s.description, {} AS initial_usd "
+                                       "FROM servers s JOIN users u ON s.admin_id = u.user_id",
+                                       initial_usd));
+        connection.prepare(account_details_statement,
+                           std::format("SELECT s.server_id, s.server_name, s.description, "
+                                       "s.active_tickers, {} AS initial_usd, "
+                                       "u_admin.username AS admin_name, u.user_id, "
+                                       "CASE WHEN s.admin_id = u.user_id "
+                                       "THEN 'admin' ELSE 'member' END AS role "
+                                       "FROM users u "
+                                       "JOIN servers s ON s.server_name = $2 "
+                                       "JOIN users u_admin ON u_admin.user_id = s.admin_id "
+                                       "WHERE u.username = $1 "
+                                       "AND (s.admin_id = u.user_id "
+                                       "     OR EXISTS (SELECT 1 FROM allowlist a "
+                                       "                WHERE a.server_id = s.server_id AND "
+                                       "a.user_id = u.user_id))",
+                                       initial_usd));
+        connection.prepare(init_bot_portfolio_balance_statement,
+                           "SELECT balance FROM init_bot_portfolio_balances "
+                           "WHERE user_id = $1 AND server_id = $2");
     }
 
     // Parse a PostgreSQL text-array literal (e.g. "{AAPL,GOOGL}") into a vector.
@@ -1592,34 +1984,127 @@ class DatabaseClient {
         return result;
     }
 
-    // Build a PostgreSQL text-array literal from a vector of strings.
+    // user_id of every username that exists, in one round trip
+    static std::unordered_map<std::string, int>
+    select_user_ids(pqxx::transaction_base& txn, const std::vector<std::string>& usernames) {
+        auto res = txn.exec("SELECT user_id, username FROM users "
+                            "WHERE username = ANY($1::varchar[])",
+                            pqxx::params{build_pg_array(usernames)});
+        std::unordered_map<std::string, int> ids_by_username;
+        ids_by_username.reserve(res.size());
+        for (const auto& row : res) {
+            ids_by_username.emplace(row["username"].as<std::string>(), row["user_id"].as<int>());
+        }
+        return ids_by_username;
+    }
+
+    static void insert_allowlist_rows(pqxx::transaction_base& txn, int server_id,
+                                      const std::vector<int>& user_ids) {
+        if (user_ids.empty())
+            return;
+        txn.exec("INSERT INTO allowlist (server_id, user_id) SELECT $1, unnest($2::int[])",
+                 pqxx::params{server_id, build_pg_array(user_ids)});
+    }
+
+    struct BalanceRowArrays {
+        std::string user_ids;
+        std::string symbols;
+        std::string balances;
+    };
+
+    // Column-wise array literals of the rows, for unnest()
+    static BalanceRowArrays build_balance_row_arrays(const std::vector<BalanceUpsertRow>& rows) {
+        std::vector<std::string> user_ids;
+        std::vector<std::string> symbols;
+        std::vector<std::string> balances;
+        user_ids.reserve(rows.size());
+        symbols.reserve(rows.size());
+        balances.reserve(rows.size());
+        for (const auto& [user_id, symbol, balance] : rows) {
+            user_ids.push_back(std::to_string(user_id));
+            symbols.push_back(symbol);
+            balances.push_back(std::to_string(balance));
+        }
+        return BalanceRowArrays{build_pg_array(user_ids), build_pg_array(symbols),
+                                build_pg_array(balances)};
+    }
+
+    static void insert_balance_rows(pqxx::transaction_base& txn, int server_id,
+                                    const std::vector<BalanceUpsertRow>& rows) {
+        if (rows.empty())
+            return;
+        const auto arrays = build_balance_row_arrays(rows);
+        txn.exec("INSERT INTO balances (user_id, server_id, symbol, balance) "
+                 "SELECT u, $1, s, b FROM unnest($2::int[], $3::varchar[], $4::bigint[]) "
+                 "AS t(u, s, b)",
+                 pqxx::params{server_id, arrays.user_ids, arrays.symbols, arrays.balances});
+    }
+
+    static void upsert_init_bot_portfolio_rows(pqxx::transaction_base& txn, int server_id,
+                                               const std::vector<InitBotPortfolioRow>& rows) {
+        if (rows.empty())
+            return;
+        std::vector<std::string> user_ids;
+        std::vector<std::string> balances;
+        user_ids.reserve(rows.size());
+        balances.reserve(rows.size());
+        for (const auto& [user_id, balance] : rows) {
+            user_ids.push_back(std::to_string(user_id));
+            balances.push_back(std::to_string(balance));
+        }
+        txn.exec("INSERT INTO init_bot_portfolio_balances (user_id, server_id, balance) "
+                 "SELECT u, $1, b FROM unnest($2::int[], $3::bigint[]) AS t(u, b) "
+                 "ON CONFLICT (user_id, server_id) DO UPDATE SET balance = EXCLUDED.balance, "
+                 "modified_ts = CURRENT_TIMESTAMP",
+                 pqxx::params{server_id, build_pg_array(user_ids), build_pg_array(balances)});
+    }
+
+    static std::string build_pg_array(const std::vector<int>& items) {
+        std::vector<std::string> strings;
+        strings.reserve(items.size());
+        for (const int item : items) {
+            strings.push_back(std::to_string(item));
+        }
+        return build_pg_array(strings);
+    }
+
+    // Build a PostgreSQL text-array literal from a vector of strings. Elements are quoted, so
+    // user input such as usernames cannot split into extra elements.
     static std::string build_pg_array(const std::vector<std::string>& items) {
         std::string arr = "{";
         for (size_t i = 0; i < items.size(); ++i) {
             if (i > 0)
                 arr += ',';
-            arr += items[i];
+            arr += '"';
+            for (const char c : items[i]) {
+                if (c == '"' || c == '\\')
+                    arr += '\\';
+                arr += c;
+            }
+            arr += '"';
         }
         arr += '}';
         return arr;
     }
 
     // This will be shared with async writer
-    ThreadSafeQueue<WriteTask> m_write_queue{};
-    std::chrono::milliseconds m_flush_interval{0};
-    int m_flush_threshold{0};
+    AsyncWriterConfig m_async_writer_config;
+    BoundedWriteQueue<WriteTask> m_write_queue;
+
+    // Declared before the pool, whose connections look it up as they are prepared
+    mutable std::atomic<ColumnPresence> m_servers_initial_usd_column{ColumnPresence::unknown};
 
-    // SQL-based connection for edux_core_db (PostgreSQL on port 5432).
-    std::unique_ptr<pqxx::connection> m_core_db_sql_connection{
-        std::make_unique<pqxx::connection>("host=localhost port=5432 dbname=edux_core_db")};
+    // SQL-based connections for edux_core_db (PostgreSQL on port 5432).
+    mutable PgConnectionPool m_core_db_pool;
 
-    // SQL-based connection for QuestDB (PG wire protocol on port 8812).
-    // Opus suggestion: lazy init — only created when QuestDB queries are needed.
-    std::unique_ptr<pqxx::connection> m_timeseries_db_sql_connection;
+    // SQL-based connections for QuestDB (PG wire protocol on port 8812). Only opened once a
+    // QuestDB query is needed, so clients that never query it do not need it running.
+    const PgConnectionPoolConfig m_timeseries_db_pool_config;
+    mutable std::mutex m_timeseries_db_pool_mutex;
+    mutable std::optional<PgConnectionPool> m_timeseries_db_pool;
 
     // Opus suggestion: ILP async writer for QuestDB — lazily initialized on first ILP insert.
     std::optional<AsyncWriter> m_async_writer;
-    mutable std::optional<bool> m_has_servers_initial_usd_column;
 };
 
 } // namespace database
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <core/containers.h>
+#include <core/orders.h>
+#include <cstdint>
+#include <format>
+#include <questdb/ingress/line_sender.hpp>
+#include <string>
+#include <string_view>
+
+namespace database {
+
+using namespace questdb::ingress::literals;
+
+// Enum to string helpers since questdb does not support enum types natively.
+inline std::string_view to_string(core::Side s) {
+    switch (s) {
+    case core::Side::bid:
+        return "BID";
+    case core::Side::ask:
+        return "ASK";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+inline std::string_view to_string(core::OrderType t) {
+    switch (t) {
+    case core::OrderType::limit:
+        return "LIMIT";
+    case core::OrderType::market:
+        return "MARKET";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+inline std::string_view to_string(core::TimeInForce tif) {
+    switch (tif) {
+    case core::TimeInForce::day:
+        return "DAY";
+    case core::TimeInForce::gtc:
+        return "GTC";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+inline std::string_view to_string(core::ExecTypeOrOrderStatus s) {
+    switch (s) {
+    case core::OrderStatus::status_new:
+        return "NEW";
+    case core::OrderStatus::status_partially_filled:
+        return "PARTIALLY_FILLED";
+    case core::OrderStatus::status_filled:
+        return "FILLED";
+    case core::OrderStatus::status_canceled:
+        return "CANCELED";
+    case core::OrderStatus::status_pending_cancel:
+        return "PENDING_CANCEL";
+    case core::OrderStatus::status_rejected:
+        return "REJECTED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/*
+ * Appends OM containers to an ILP buffer as rows of a server's orders and trades tables. Table and
+ * column names are built and validated once on construction rather than for every row, and enums
+ * and tickers go out as symbols, so a row costs little more than copying its values into the
+ * buffer.
+ *
+ * Holds views into its own table names, so it can be neither copied nor moved. Appends throw
+ * questdb::ingress::line_sender_error if a value cannot be encoded.
+ */
+class IlpRowEncoder {
+  public:
+    explicit IlpRowEncoder(std::string_view server_name)
+        : m_orders_table_name{std::format("orders_{}", server_name)},
+          m_trades_table_name{std::format("trades_{}", server_name)},
+          m_orders_table{m_orders_table_name.c_str(), m_orders_table_name.length()},
+          m_trades_table{m_trades_table_name.c_str(), m_trades_table_name.length()} {
+    }
+
+    IlpRowEncoder(const IlpRowEncoder&) = delete;
+    IlpRowEncoder& operator=(const IlpRowEncoder&) = delete;
+
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const core::NewOrderSingleContainer& new_order_request, int internal_order_id,
+                bool is_order_valid) const {
+        buffer.table(m_orders_table)
+            .symbol(m_symbol, new_order_request.symbol)
+            .symbol(m_side, to_string(new_order_request.side))
+            .symbol(m_ord_type, to_string(new_order_request.ord_type))
+            .symbol(m_time_in_force, to_string(new_order_request.time_in_force))
+            .symbol(m_order_status,
+                    is_order_valid ? std::string_view("NEW") : std::string_view("REJECTED"))
+            .column(m_sender_comp_id, new_order_request.sender_comp_id)
+            .column(m_order_id, static_cast<std::int64_t>(internal_order_id))
+            .column(m_cl_order_id, static_cast<std::int64_t>(new_order_request.cl_ord_id))
+            .column(m_order_qty, static_cast<std::int64_t>(new_order_request.order_qty))
+            .column(m_filled_qty, static_cast<std::int64_t>(0))
+            // price is optional for market orders; store 0 if not present
+            .column(m_price, static_cast<std::int64_t>(new_order_request.price.value_or(0)))
+            .at(questdb::ingress::timestamp_micros::now());
+    }
+
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const core::CancelOrderRequestContainer& cancel_order_request,
+                bool is_request_valid) const {
+        buffer.table(m_orders_table)
+            .symbol(m_symbol, cancel_order_request.symbol)
+            .symbol(m_side, to_string(cancel_order_request.side))
+            .symbol(m_order_status, is_request_valid ? std::string_view("PENDING_CANCEL")
+                                                     : std::string_view("REJECTED_CANCEL"))
+            .column(m_sender_comp_id, cancel_order_request.sender_comp_id)
+            .column(m_order_id,
+                    static_cast<std::int64_t>(cancel_order_request.order_id.value_or(-1)))
+            .column(m_cl_order_id, static_cast<std::int64_t>(cancel_order_request.orig_cl_ord_id))
+            .column(m_order_qty, static_cast<std::int64_t>(cancel_order_request.order_qty))
+            .column(m_filled_qty, static_cast<std::int64_t>(0))
+            .at(questdb::ingress::timestamp_micros::now());
+    }
+
+    // Maps the report to an orders table row, with cum_qty as filled_qty
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const core::ExecutionReportContainer& execution_report) const {
+        buffer.table(m_orders_table)
+            .symbol(m_symbol, execution_report.symbol)
+            .symbol(m_side, to_string(execution_report.side))
+            .symbol(m_order_status, to_string(execution_report.ord_status))
+            .symbol(m_time_in_force, to_string(execution_report.time_in_force))
+            .column(m_sender_comp_id, execution_report.sender_comp_id)
+            .column(m_order_id, static_cast<std::int64_t>(execution_report.order_id))
+            .column(m_cl_order_id, static_cast<std::int64_t>(execution_report.cl_order_id))
+            .column(m_order_qty, static_cast<std::int64_t>(execution_report.leaves_qty +
+                                                           execution_report.cum_qty))
+            .column(m_filled_qty, static_cast<std::int64_t>(execution_report.cum_qty))
+            .column(m_price, static_cast<std::int64_t>(execution_report.price.value_or(0)))
+            .at(questdb::ingress::timestamp_micros::now());
+    }
+
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const core::TradeContainer& trade) const {
+        buffer.table(m_trades_table)
+            .symbol(m_symbol, trade.ticker)
+            .column(m_price, static_cast<std::int64_t>(trade.price))
+            .column(m_quantity, static_cast<std::int64_t>(trade.quantity))
+            .column(m_trade_id, trade.trade_id)
+            .column(m_taker_id, trade.taker_id)
+            .column(m_maker_id, trade.maker_id)
+            .column(m_taker_order_id, static_cast<std::int64_t>(trade.taker_order_id))
+            .column(m_maker_order_id, static_cast<std::int64_t>(trade.maker_order_id))
+            .column(m_is_taker_buyer, trade.is_taker_buyer)
+            .at(questdb::ingress::timestamp_micros::now());
+    }
+
+    // Represents the cancel as an order row carrying only its new status
+    void append(questdb::ingress::line_sender_buffer& buffer,
+                const core::CancelOrderResponseContainer& cancel_order_response) const {
+        buffer.table(m_orders_table)
+            .symbol(m_order_status, cancel_order_response.success
+                                        ? std::string_view("CANCELLED")
+                                        : std::string_view("REJECTED_CANCEL"))
+            .column(m_order_id, static_cast<std::int64_t>(cancel_order_response.order_id))
+            .at(questdb::ingress::timestamp_micros::now());
+    }
+
+  private:
+    const std::string m_orders_table_name;
+    const std::string m_trades_table_name;
+    const questdb::ingress::table_name_view m_orders_table;
+    const questdb::ingress::table_name_view m_trades_table;
+
+    // Shared by both tables
+    const questdb::ingress::column_name_view m_symbol{"symbol"_cn};
+    const questdb::ingress::column_name_view m_price{"price"_cn};
+
+    const questdb::ingress::column_name_view m_order_id{"order_id"_cn};
+    const questdb::ingress::column_name_view m_cl_order_id{"cl_order_id"_cn};
+    const questdb::ingress::column_name_view m_sender_comp_id{"sender_comp_id"_cn};
+    const questdb::ingress::column_name_view m_side{"side"_cn};
+    const questdb::ingress::column_name_view m_order_qty{"order_qty"_cn};
+    const questdb::ingress::column_name_view m_filled_qty{"filled_qty"_cn};
+    const questdb::ingress::column_name_view m_ord_type{"ord_type"_cn};
+    const questdb::ingress::column_name_view m_time_in_force{"time_in_force"_cn};
+    const questdb::ingress::column_name_view m_order_status{"order_status"_cn};
+
+    const questdb::ingress::column_name_view m_quantity{"quantity"_cn};
+    const questdb::ingress::column_name_view m_trade_id{"trade_id"_cn};
+    const questdb::ingress::column_name_view m_taker_id{"taker_id"_cn};
+    const questdb::ingress::column_name_view m_maker_id{"maker_id"_cn};
+    const questdb::ingress::column_name_view m_taker_order_id{"taker_order_id"_cn};
+    const questdb::ingress::column_name_view m_maker_order_id{"maker_order_id"_cn};
+    const questdb::ingress::column_name_view m_is_taker_buyer{"is_taker_buyer"_cn};
+};
+} // namespace database
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace database {
+/*
+ * Raw ILP-over-TCP connection for batches that are already encoded, such as those replayed from a
+ * SpillJournal; the QuestDB client only sends rows built in its own buffers. Connects on the first
+ * send and again after any failure. Not thread-safe.
+ */
+class IlpTcpConnection {
+  public:
+    IlpTcpConnection(std::string host, std::uint16_t port)
+        : m_host{std::move(host)}, m_port{port} {
+    }
+
+    std::expected<void, std::string> send(std::string_view batch) {
+        try {
+            if (!m_socket.has_value()) {
+                boost::asio::ip::tcp::resolver resolver{m_io_context};
+                m_socket.emplace(m_io_context);
+                boost::asio::connect(*m_socket, resolver.resolve(m_host, std::to_string(m_port)));
+            }
+            boost::asio::write(*m_socket, boost::asio::buffer(batch.data(), batch.size()));
+            return {};
+        } catch (const std::exception& e) {
+            m_socket.reset();
+            return std::unexpected{
+                std::format("Failed to send ILP batch to {}:{}: {}", m_host, m_port, e.what())};
+        }
+    }
+
+  private:
+    std::string m_host;
+    std::uint16_t m_port;
+
+    boost::asio::io_context m_io_context;
+    std::optional<boost::asio::ip::tcp::socket> m_socket;
+};
+} // namespace database
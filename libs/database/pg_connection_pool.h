@@ -0,0 +1,157 @@
+#pragma once
+
+#include <pqxx/pqxx>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace database {
+using namespace std::chrono_literals;
+
+struct PgConnectionPoolConfig {
+    std::string connection_string{"host=localhost port=5432 dbname=edux_core_db"};
+    std::size_t size{1};
+    // How long checkout() waits for a connection to be returned before giving up
+    std::chrono::milliseconds checkout_timeout{1000ms};
+};
+
+/*
+ * Fixed-size pool of PostgreSQL connections, so concurrent callers each run on a connection of
+ * their own instead of racing over a shared one (pqxx connections are not thread-safe). checkout()
+ * lends a connection for the lifetime of the returned lease, waiting up to checkout_timeout for
+ * one to be returned.
+ *
+ * on_connect runs on every new connection before it is first lent out, e.g. to prepare
+ * statements. A connection found closed at checkout is reopened in place.
+ */
+class PgConnectionPool {
+  public:
+    using ConnectHook = std::function<void(pqxx::connection&)>;
+
+    // Returns its connection to the pool on destruction
+    class Lease {
+      public:
+        Lease(Lease&& other) noexcept
+            : m_pool{std::exchange(other.m_pool, nullptr)},
+              m_connection{std::move(other.m_connection)} {
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        ~Lease() {
+            if (m_pool != nullptr) {
+                m_pool->release(std::move(m_connection));
+            }
+        }
+
+        pqxx::connection& operator*() const {
+            return *m_connection;
+        }
+
+        pqxx::connection* operator->() const {
+            return m_connection.get();
+        }
+
+      private:
+        friend class PgConnectionPool;
+
+        Lease(PgConnectionPool& pool, std::unique_ptr<pqxx::connection> connection)
+            : m_pool{&pool}, m_connection{std::move(connection)} {
+        }
+
+        PgConnectionPool* m_pool;
+        std::unique_ptr<pqxx::connection> m_connection;
+    };
+
+    // Opens every connection up front, so an unreachable database fails here rather than on the
+    // first request. Throws if a connection cannot be opened or on_connect throws.
+    explicit PgConnectionPool(PgConnectionPoolConfig config, ConnectHook on_connect = {})
+        : m_config{std::move(config)}, m_on_connect{std::move(on_connect)} {
+        m_idle_connections.reserve(m_config.size);
+        for (std::size_t i = 0; i < std::max<std::size_t>(m_config.size, 1); ++i) {
+            m_idle_connections.push_back(connect());
+        }
+    }
+
+    PgConnectionPool(const PgConnectionPool&) = delete;
+    PgConnectionPool& operator=(const PgConnectionPool&) = delete;
+
+    // Throws std::runtime_error if no connection is returned within checkout_timeout, or if a
+    // closed connection cannot be reopened
+    Lease checkout() {
+        std::unique_ptr<pqxx::connection> connection;
+        {
+            std::unique_lock lock{m_mutex};
+            if (!m_returned_var.wait_for(lock, m_config.checkout_timeout,
+                                         [this] { return !m_idle_connections.empty(); })) {
+                ++m_checkout_timeout_count;
+                throw std::runtime_error{
+                    std::format("Timed out after {}ms waiting for a database connection",
+                                m_config.checkout_timeout.count())};
+            }
+            connection = std::move(m_idle_connections.back());
+            m_idle_connections.pop_back();
+        }
+
+        if (connection == nullptr || !connection->is_open()) {
+            try {
+                connection = connect();
+            } catch (...) {
+                // Keep the slot, a later checkout retries the connection
+                release(nullptr);
+                throw;
+            }
+        }
+        return Lease{*this, std::move(connection)};
+    }
+
+    std::size_t idle_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_idle_connections.size();
+    }
+
+    std::uint64_t checkout_timeout_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_checkout_timeout_count;
+    }
+
+  private:
+    std::unique_ptr<pqxx::connection> connect() const {
+        auto connection = std::make_unique<pqxx::connection>(m_config.connection_string);
+        if (m_on_connect) {
+            m_on_connect(*connection);
+        }
+        return connection;
+    }
+
+    void release(std::unique_ptr<pqxx::connection> connection) {
+        {
+            std::lock_guard lock{m_mutex};
+            m_idle_connections.push_back(std::move(connection));
+        }
+        m_returned_var.notify_one();
+    }
+
+    const PgConnectionPoolConfig m_config;
+    const ConnectHook m_on_connect;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_returned_var;
+    // Null entries are slots whose connection failed to reopen
+    std::vector<std::unique_ptr<pqxx::connection>> m_idle_connections;
+    std::uint64_t m_checkout_timeout_count{0};
+};
+} // namespace database
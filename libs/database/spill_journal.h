@@ -0,0 +1,335 @@
+#pragma once
+
+#include <inter_process/shared_memory_mapping.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace database {
+using namespace std::chrono_literals;
+
+struct SpillJournalConfig {
+    std::filesystem::path directory;
+    // Segments are preallocated at this size; a batch that does not fit starts the next one
+    std::size_t segment_size{64 << 20};
+};
+
+/*
+ * Append-only local journal of ILP batches that could not be sent to QuestDB, kept until a
+ * replayer delivers them. Batches are copied into a memory-mapped segment file; a full segment is
+ * sealed and the next one started, so an append never touches earlier data or blocks on I/O.
+ *
+ * Each record is a 4-byte length followed by the batch. Replay marks a record delivered by
+ * setting the top bit of its length and deletes a segment once all its records are delivered, so
+ * segments left behind by an earlier process are picked up where it stopped. A batch is sent twice
+ * if the process dies between sending and marking it. Mapped pages survive a process crash, but an
+ * OS crash can lose whatever the kernel has not written back yet.
+ *
+ * Any number of threads may append while a single replayer drains.
+ */
+class SpillJournal {
+  public:
+    using SendFunction = std::function<std::expected<void, std::string>(std::string_view batch)>;
+
+    // Throws std::filesystem::filesystem_error or std::runtime_error if the directory or an
+    // existing segment cannot be opened
+    explicit SpillJournal(SpillJournalConfig config) : m_config{std::move(config)} {
+        std::filesystem::create_directories(m_config.directory);
+
+        for (const auto& entry : std::filesystem::directory_iterator{m_config.directory}) {
+            if (entry.path().extension() == segment_extension) {
+                m_sealed_segments.push_back(std::stoull(entry.path().stem().string()));
+            }
+        }
+        std::ranges::sort(m_sealed_segments);
+
+        for (const auto segment_index : m_sealed_segments) {
+            const auto path = segment_path(segment_index);
+            const auto size = std::filesystem::file_size(path);
+            auto* data = static_cast<char*>(
+                inter_process::map_shared_memory(path.string(), size, false, false));
+            for_each_record(data, size, [&](std::uint32_t length, std::size_t) {
+                if (!(length & delivered_bit)) {
+                    m_pending_bytes += length;
+                }
+            });
+            inter_process::unmap_shared_memory(data, size, path.string(), false, false);
+        }
+        m_next_segment_index = m_sealed_segments.empty() ? 0 : m_sealed_segments.back() + 1;
+    }
+
+    SpillJournal(const SpillJournal&) = delete;
+    SpillJournal& operator=(const SpillJournal&) = delete;
+
+    ~SpillJournal() {
+        std::lock_guard lock{m_mutex};
+        close_active_segment();
+    }
+
+    std::expected<void, std::string> append(std::string_view batch) {
+        if (batch.size() >= delivered_bit) {
+            return std::unexpected{std::format("Batch of {} bytes is too large", batch.size())};
+        }
+        const auto record_size = sizeof(std::uint32_t) + batch.size();
+
+        std::lock_guard lock{m_mutex};
+        if (!m_active_segment.has_value() ||
+            m_active_segment->write_offset + record_size > m_active_segment->size) {
+            close_active_segment();
+            try {
+                open_active_segment(std::max(m_config.segment_size, record_size));
+            } catch (const std::exception& e) {
+                return std::unexpected{std::format("Failed to open spill segment: {}", e.what())};
+            }
+        }
+
+        // The length goes in last, so a torn append reads as the end of the segment
+        auto* record = m_active_segment->data + m_active_segment->write_offset;
+        std::memcpy(record + sizeof(std::uint32_t), batch.data(), batch.size());
+        const auto length = static_cast<std::uint32_t>(batch.size());
+        std::memcpy(record, &length, sizeof(length));
+
+        m_active_segment->write_offset += record_size;
+        m_pending_bytes += batch.size();
+        return {};
+    }
+
+    // Sends undelivered batches oldest first, until send fails or none are left. Returns the
+    // number of batches delivered.
+    std::expected<std::size_t, std::string> replay(const SendFunction& send) {
+        std::size_t delivered_count{0};
+        while (true) {
+            std::uint64_t segment_index;
+            {
+                std::lock_guard lock{m_mutex};
+                if (m_sealed_segments.empty()) {
+                    // Seal the active segment so appends move on to a new file while it drains
+                    if (!m_active_segment.has_value() || m_active_segment->write_offset == 0) {
+                        return delivered_count;
+                    }
+                    close_active_segment();
+                }
+                segment_index = m_sealed_segments.front();
+            }
+
+            // Sealed segments are only touched by the replayer, so the lock is not held while
+            // sending
+            const auto path = segment_path(segment_index);
+            std::size_t size;
+            char* data;
+            try {
+                size = std::filesystem::file_size(path);
+                data = static_cast<char*>(
+                    inter_process::map_shared_memory(path.string(), size, false, false));
+            } catch (const std::exception& e) {
+                return std::unexpected{std::format("Failed to open spill segment: {}", e.what())};
+            }
+
+            std::optional<std::string> send_error;
+            for_each_record(data, size, [&](std::uint32_t length, std::size_t offset) {
+                if ((length & delivered_bit) || send_error.has_value()) {
+                    return;
+                }
+                if (auto result = send({data + offset + sizeof(length), length}); !result) {
+                    send_error = std::move(result.error());
+                    return;
+                }
+
+                const std::uint32_t delivered_length{length | delivered_bit};
+                std::memcpy(data + offset, &delivered_length, sizeof(delivered_length));
+                ++delivered_count;
+
+                std::lock_guard lock{m_mutex};
+                m_pending_bytes -= length;
+            });
+
+            inter_process::unmap_shared_memory(data, size, path.string(), !send_error.has_value(),
+                                               false);
+            if (send_error.has_value()) {
+                return std::unexpected{std::move(send_error.value())};
+            }
+
+            std::lock_guard lock{m_mutex};
+            m_sealed_segments.pop_front();
+        }
+    }
+
+    bool empty() const {
+        std::lock_guard lock{m_mutex};
+        return m_pending_bytes == 0;
+    }
+
+    // Bytes of batches not yet delivered
+    std::uint64_t pending_bytes() const {
+        std::lock_guard lock{m_mutex};
+        return m_pending_bytes;
+    }
+
+    std::size_t segment_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_sealed_segments.size() + (m_active_segment.has_value() ? 1 : 0);
+    }
+
+  private:
+    static constexpr std::uint32_t delivered_bit{1U << 31};
+    static constexpr std::string_view segment_extension{".journal"};
+
+    struct ActiveSegment {
+        std::uint64_t index;
+        char* data;
+        std::size_t size;
+        std::size_t write_offset;
+    };
+
+    // Calls on_record(length, offset) for every complete record, including delivered ones
+    template <typename OnRecord>
+    static void for_each_record(const char* data, std::size_t size, OnRecord&& on_record) {
+        std::size_t offset{0};
+        while (offset + sizeof(std::uint32_t) <= size) {
+            std::uint32_t length;
+            std::memcpy(&length, data + offset, sizeof(length));
+            const auto batch_size = length & ~delivered_bit;
+            if (batch_size == 0 || offset + sizeof(length) + batch_size > size) {
+                return;
+            }
+            on_record(length, offset);
+            offset += sizeof(length) + batch_size;
+        }
+    }
+
+    std::filesystem::path segment_path(std::uint64_t segment_index) const {
+        return m_config.directory / std::format("{}{}", segment_index, segment_extension);
+    }
+
+    void open_active_segment(std::size_t size) {
+        const auto segment_index = m_next_segment_index;
+        auto* data = static_cast<char*>(inter_process::map_shared_memory(
+            segment_path(segment_index).string(), size, true, false));
+        ++m_next_segment_index;
+        m_active_segment = ActiveSegment{
+            .index = segment_index, .data = data, .size = size, .write_offset = 0};
+    }
+
+    // Empty segments are deleted rather than sealed
+    void close_active_segment() {
+        if (!m_active_segment.has_value()) {
+            return;
+        }
+
+        const bool is_empty = m_active_segment->write_offset == 0;
+        inter_process::unmap_shared_memory(m_active_segment->data, m_active_segment->size,
+                                           segment_path(m_active_segment->index).string(), is_empty,
+                                           false);
+        if (!is_empty) {
+            m_sealed_segments.push_back(m_active_segment->index);
+        }
+        m_active_segment.reset();
+    }
+
+    const SpillJournalConfig m_config;
+
+    mutable std::mutex m_mutex;
+    std::optional<ActiveSegment> m_active_segment;
+    std::deque<std::uint64_t> m_sealed_segments;
+    std::uint64_t m_next_segment_index{0};
+    std::uint64_t m_pending_bytes{0};
+};
+
+/*
+ * Drains a SpillJournal back into QuestDB in the background. Every replay_interval it hands the
+ * journal's batches, oldest first, to the send function; a failed send is reported through
+ * on_error and retried from the same batch on the next cycle.
+ */
+class SpillReplayer {
+  public:
+    using ErrorHandler = std::function<void(const std::string&)>;
+
+    SpillReplayer(SpillJournal& journal, SpillJournal::SendFunction send_function,
+                  std::chrono::milliseconds replay_interval = 1s, ErrorHandler on_error = {})
+        : m_journal{journal}, m_send_function{std::move(send_function)},
+          m_replay_interval{replay_interval}, m_on_error{std::move(on_error)},
+          m_replayer_thread{[this] { replayer_loop(); }} {
+    }
+
+    SpillReplayer(const SpillReplayer&) = delete;
+    SpillReplayer& operator=(const SpillReplayer&) = delete;
+
+    ~SpillReplayer() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_condition_var.notify_one();
+        if (m_replayer_thread.joinable()) {
+            m_replayer_thread.join();
+        }
+    }
+
+    std::uint64_t replayed_batch_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_replayed_batch_count;
+    }
+
+    std::uint64_t failed_replay_count() const {
+        std::lock_guard lock{m_mutex};
+        return m_failed_replay_count;
+    }
+
+  private:
+    void replayer_loop() {
+        while (true) {
+            {
+                std::unique_lock lock{m_mutex};
+                m_condition_var.wait_for(lock, m_replay_interval, [this] { return m_stop; });
+                if (m_stop) {
+                    return;
+                }
+            }
+
+            if (m_journal.empty()) {
+                continue;
+            }
+
+            const auto result = m_journal.replay(m_send_function);
+            {
+                std::lock_guard lock{m_mutex};
+                if (result.has_value()) {
+                    m_replayed_batch_count += result.value();
+                    continue;
+                }
+                ++m_failed_replay_count;
+            }
+            if (m_on_error) {
+                m_on_error(result.error());
+            }
+        }
+    }
+
+    SpillJournal& m_journal;
+    SpillJournal::SendFunction m_send_function;
+    std::chrono::milliseconds m_replay_interval;
+    ErrorHandler m_on_error;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition_var;
+    bool m_stop{false};
+
+    std::uint64_t m_replayed_batch_count{0};
+    std::uint64_t m_failed_replay_count{0};
+
+    std::thread m_replayer_thread;
+};
+} // namespace database
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "shared_memory_mapping.h"
+
+// What a subscriber does when the producer has lapped it and the messages at its cursor are gone.
+enum class LagPolicy {
+    drop, // skip ahead to the oldest message still in the ring and count what was missed
+    fail, // throw, so the subscriber has to resubscribe explicitly
+};
+
+// Single-producer broadcast ring. Every subscriber keeps its own read cursor outside the shared
+// region, so the producer never observes readers and can never be stalled by a slow one; instead a
+// reader that falls more than a full ring behind detects it on its next read.
+template <typename T, std::size_t POWER_OF_2_CAPACITY>
+class BroadcastRingBuffer {
+    static_assert((POWER_OF_2_CAPACITY & (POWER_OF_2_CAPACITY - 1)) == 0,
+                  "Buffer capacity must be a power of 2");
+    static_assert(POWER_OF_2_CAPACITY > 0, "Negative buffer capacity");
+    static_assert(std::is_trivially_copyable_v<T>, "T is not trivially copyable for shm");
+
+  private:
+    static constexpr std::size_t mask = POWER_OF_2_CAPACITY - 1;
+    static constexpr std::uint64_t magic_number = 0xB40ADCA57B40ADC0ULL;
+
+    struct Slot {
+        // 2 * position + 1 while position is being written, 2 * position + 2 once it is readable
+        std::atomic<std::uint64_t> version;
+        alignas(T) std::byte data[sizeof(T)];
+    };
+
+    using Bytes = std::array<std::byte, sizeof(T)>;
+
+    // cache line padding
+    static constexpr std::size_t cache_line_padding_size = 64;
+
+    alignas(cache_line_padding_size) std::atomic<std::uint64_t> initialized_{0};
+    alignas(cache_line_padding_size) std::atomic<std::uint64_t> head_;
+    alignas(cache_line_padding_size) Slot slots_[POWER_OF_2_CAPACITY];
+
+  public:
+    void init() {
+        head_.store(0, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < POWER_OF_2_CAPACITY; ++i) {
+            slots_[i].version.store(0, std::memory_order_relaxed);
+        }
+        initialized_.store(magic_number, std::memory_order_release);
+    }
+
+    void destroy() {
+        initialized_.store(0, std::memory_order_release);
+    }
+
+    bool is_initialized() const {
+        return initialized_.load(std::memory_order_acquire) == magic_number;
+    }
+
+    // Only one process/thread may publish to a ring. Never blocks; the oldest message is
+    // overwritten once the ring is full.
+    void push(const T& value) {
+        const std::uint64_t position = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[position & mask];
+        slot.version.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(slot.data, &value, sizeof(T));
+        slot.version.store(2 * position + 2, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_release);
+    }
+
+    // Reads the message at cursor and advances it. Returns nullopt when the subscriber is caught
+    // up. Messages lost to the producer lapping the cursor are added to dropped under
+    // LagPolicy::drop.
+    std::optional<T> try_read(std::uint64_t& cursor, LagPolicy lag_policy,
+                              std::uint64_t& dropped) const {
+        Bytes copy;
+        for (;;) {
+            const Slot& slot = slots_[cursor & mask];
+            const std::uint64_t readable_version = 2 * cursor + 2;
+            const std::uint64_t before = slot.version.load(std::memory_order_acquire);
+            if (before < readable_version) {
+                // not written yet, or being written right now
+                return std::nullopt;
+            }
+            if (before == readable_version) {
+                std::memcpy(copy.data(), slot.data, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.version.load(std::memory_order_relaxed) == before) {
+                    ++cursor;
+                    return std::bit_cast<T>(copy);
+                }
+            }
+
+            // the producer has lapped us
+            if (lag_policy == LagPolicy::fail) {
+                throw std::runtime_error("Broadcast subscriber lagged by more than " +
+                                         std::to_string(POWER_OF_2_CAPACITY) + " messages");
+            }
+            const std::uint64_t oldest = oldest_available();
+            if (oldest > cursor) {
+                dropped += oldest - cursor;
+                cursor = oldest;
+            }
+        }
+    }
+
+    std::uint64_t head() const {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    // Oldest position that is not at risk of being overwritten by the next push.
+    std::uint64_t oldest_available() const {
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        return head < POWER_OF_2_CAPACITY ? 0 : head - POWER_OF_2_CAPACITY + 1;
+    }
+
+    static constexpr std::size_t capacity() {
+        return POWER_OF_2_CAPACITY;
+    }
+
+    static constexpr std::size_t shm_size() {
+        return sizeof(BroadcastRingBuffer);
+    }
+};
+
+// Each instance mapped with create/open_exist_shm is an independent subscriber that starts at the
+// current head; the producer side only ever calls try_push.
+template <typename T, std::size_t POWER_OF_2_CAPACITY>
+class BroadcastSharedMemoryRingBuffer {
+    using Buffer = BroadcastRingBuffer<T, POWER_OF_2_CAPACITY>;
+
+  private:
+    BroadcastSharedMemoryRingBuffer() = default;
+
+    Buffer* buffer_ = nullptr;
+    bool is_owner_ = false;
+    std::string shm_file_path_;
+    bool use_shm_open_ = true;
+    LagPolicy lag_policy_ = LagPolicy::drop;
+    std::uint64_t cursor_ = 0;
+    std::uint64_t dropped_ = 0;
+
+    static BroadcastSharedMemoryRingBuffer map(const std::string& shm_file_name_prefix,
+                                               bool is_owner, bool use_shm_open,
+                                               LagPolicy lag_policy) {
+        BroadcastSharedMemoryRingBuffer buf;
+        buf.is_owner_ = is_owner;
+        buf.shm_file_path_ = get_shm_file_full_name(shm_file_name_prefix);
+        buf.use_shm_open_ = use_shm_open;
+        buf.lag_policy_ = lag_policy;
+
+        buf.buffer_ = static_cast<Buffer*>(inter_process::map_shared_memory(
+            buf.shm_file_path_, Buffer::shm_size(), is_owner, use_shm_open));
+        if (!buf.buffer_->is_initialized()) {
+            buf.buffer_->init();
+        }
+        buf.cursor_ = buf.buffer_->head();
+
+        return buf;
+    }
+
+    void release() {
+        if (buffer_) {
+            if (is_owner_) {
+                buffer_->destroy();
+            }
+            inter_process::unmap_shared_memory(buffer_, Buffer::shm_size(), shm_file_path_,
+                                               is_owner_, use_shm_open_);
+        }
+    }
+
+  public:
+    BroadcastSharedMemoryRingBuffer(BroadcastSharedMemoryRingBuffer&& other) noexcept
+        : buffer_{other.buffer_}, is_owner_(other.is_owner_), shm_file_path_{other.shm_file_path_},
+          use_shm_open_{other.use_shm_open_}, lag_policy_{other.lag_policy_},
+          cursor_{other.cursor_}, dropped_{other.dropped_} {
+        other.buffer_ = nullptr;
+    }
+
+    // Same prefix as the MPSC ring ({symbol}_td_{server}), with a distinct suffix so the two
+    // layouts never map the same file.
+    static std::string get_shm_file_full_name(const std::string& shm_file_name_prefix) {
+        return shm_file_name_prefix + "_bcast_" + std::to_string(POWER_OF_2_CAPACITY);
+    }
+
+    // As with the MPSC ring, the primary consumer creates and owns the shm; further subscribers
+    // and the producer open it.
+    static BroadcastSharedMemoryRingBuffer create(const std::string& shm_file_name_prefix,
+                                                  LagPolicy lag_policy = LagPolicy::drop,
+                                                  bool use_shm_open = true) {
+        return map(shm_file_name_prefix, true, use_shm_open, lag_policy);
+    }
+
+    static BroadcastSharedMemoryRingBuffer open_exist_shm(const std::string& shm_file_name_prefix,
+                                                          LagPolicy lag_policy = LagPolicy::drop,
+                                                          bool use_shm_open = true) {
+        return map(shm_file_name_prefix, false, use_shm_open, lag_policy);
+    }
+
+    // Always succeeds; named to match the MPSC ring so either can back a publisher.
+    bool try_push(T& value) {
+        buffer_->push(value);
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        return buffer_->try_read(cursor_, lag_policy_, dropped_);
+    }
+
+    // Total messages this subscriber has skipped under LagPolicy::drop.
+    std::uint64_t dropped() const {
+        return dropped_;
+    }
+
+    // Messages published but not yet read by this subscriber.
+    std::uint64_t lag() const {
+        return buffer_->head() - cursor_;
+    }
+
+    ~BroadcastSharedMemoryRingBuffer() {
+        release();
+    }
+
+    BroadcastSharedMemoryRingBuffer& operator=(BroadcastSharedMemoryRingBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            buffer_ = other.buffer_;
+            is_owner_ = other.is_owner_;
+            shm_file_path_ = other.shm_file_path_;
+            use_shm_open_ = other.use_shm_open_;
+            lag_policy_ = other.lag_policy_;
+            cursor_ = other.cursor_;
+            dropped_ = other.dropped_;
+            other.buffer_ = nullptr;
+        }
+        return *this;
+    }
+
+    BroadcastSharedMemoryRingBuffer(const BroadcastSharedMemoryRingBuffer&) = delete;
+
+    BroadcastSharedMemoryRingBuffer& operator=(const BroadcastSharedMemoryRingBuffer&) = delete;
+
+    Buffer* operator->() {
+        return buffer_;
+    }
+    const Buffer* operator->() const {
+        return buffer_;
+    }
+    Buffer* get() {
+        return buffer_;
+    }
+    const Buffer* get() const {
+        return buffer_;
+    }
+};
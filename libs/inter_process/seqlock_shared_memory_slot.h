@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "shared_memory_mapping.h"
+
+// Single-writer "latest value" slot guarded by a sequence lock. Unlike the ring buffer, the writer
+// never waits for readers and never fails: each store overwrites the previous value, so a reader
+// that falls behind skips straight to the freshest consistent copy instead of replaying stale data.
+template <typename T>
+class SeqlockSlot {
+    static_assert(std::is_trivially_copyable_v<T>, "T is not trivially copyable for shm");
+
+  private:
+    static constexpr std::uint64_t magic_number = 0x5E910C4B1A7E5700ULL;
+
+    // cache line padding
+    static constexpr std::size_t cache_line_padding_size = 64;
+
+    alignas(cache_line_padding_size) std::atomic<std::uint64_t> initialized_{0};
+    // Odd while a write is in progress, even otherwise. Zero means nothing has been written yet.
+    alignas(cache_line_padding_size) std::atomic<std::uint64_t> sequence_;
+    alignas(cache_line_padding_size) std::byte data_[sizeof(T)];
+
+    using Bytes = std::array<std::byte, sizeof(T)>;
+
+  public:
+    void init() {
+        sequence_.store(0, std::memory_order_relaxed);
+        initialized_.store(magic_number, std::memory_order_release);
+    }
+
+    void destroy() {
+        initialized_.store(0, std::memory_order_release);
+    }
+
+    bool is_initialized() const {
+        return initialized_.load(std::memory_order_acquire) == magic_number;
+    }
+
+    // Only one process/thread may write to a slot.
+    void store(const T& value) {
+        const std::uint64_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(data_, &value, sizeof(T));
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns the current value if it was published after last_seen_sequence, updating
+    // last_seen_sequence on success. Never waits: a write racing the copy also returns nullopt, so
+    // a writer that died mid-write cannot stall the reader. The caller polls again later.
+    std::optional<T> try_load_newer(std::uint64_t& last_seen_sequence) const {
+        const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before == last_seen_sequence || (before & 1)) {
+            return std::nullopt;
+        }
+        Bytes copy;
+        std::memcpy(copy.data(), data_, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before) {
+            return std::nullopt;
+        }
+        last_seen_sequence = before;
+        return std::bit_cast<T>(copy);
+    }
+
+    std::optional<T> try_load() const {
+        std::uint64_t never_seen = 0;
+        return try_load_newer(never_seen);
+    }
+
+    std::uint64_t sequence() const {
+        return sequence_.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t shm_size() {
+        return sizeof(SeqlockSlot);
+    }
+};
+
+template <typename T>
+class SeqlockSharedMemorySlot {
+    using Slot = SeqlockSlot<T>;
+
+  private:
+    SeqlockSharedMemorySlot() = default;
+
+    Slot* slot_ = nullptr;
+    bool is_owner_ = false;
+    std::string shm_file_path_;
+    bool use_shm_open_ = true;
+
+    static SeqlockSharedMemorySlot map(const std::string& shm_file_name_prefix, bool is_owner,
+                                       bool use_shm_open) {
+        SeqlockSharedMemorySlot buf;
+        buf.is_owner_ = is_owner;
+        buf.shm_file_path_ = get_shm_file_full_name(shm_file_name_prefix);
+        buf.use_shm_open_ = use_shm_open;
+
+        buf.slot_ = static_cast<Slot*>(inter_process::map_shared_memory(
+            buf.shm_file_path_, Slot::shm_size(), is_owner, use_shm_open));
+        if (!buf.slot_->is_initialized()) {
+            buf.slot_->init();
+        }
+
+        return buf;
+    }
+
+    void release() {
+        if (slot_) {
+            if (is_owner_) {
+                slot_->destroy();
+            }
+            inter_process::unmap_shared_memory(slot_, Slot::shm_size(), shm_file_path_, is_owner_,
+                                               use_shm_open_);
+        }
+    }
+
+  public:
+    SeqlockSharedMemorySlot(SeqlockSharedMemorySlot&& other) noexcept
+        : slot_{other.slot_}, is_owner_(other.is_owner_), shm_file_path_{other.shm_file_path_},
+          use_shm_open_{other.use_shm_open_} {
+        other.slot_ = nullptr;
+    }
+
+    static std::string get_shm_file_full_name(const std::string& shm_file_name_prefix) {
+        return shm_file_name_prefix + "_latest";
+    }
+
+    // As with the ring buffer, the consumer creates and owns the shm.
+    static SeqlockSharedMemorySlot create(const std::string& shm_file_name_prefix,
+                                          bool use_shm_open = true) {
+        return map(shm_file_name_prefix, true, use_shm_open);
+    }
+
+    static SeqlockSharedMemorySlot open_exist_shm(const std::string& shm_file_name_prefix,
+                                                  bool use_shm_open = true) {
+        return map(shm_file_name_prefix, false, use_shm_open);
+    }
+
+    // Overwrites the latest value; always succeeds. Named to match the ring buffer so either can
+    // back a publisher.
+    bool try_push(T& value) {
+        slot_->store(value);
+        return true;
+    }
+
+    std::optional<T> try_load_newer(std::uint64_t& last_seen_sequence) const {
+        return slot_->try_load_newer(last_seen_sequence);
+    }
+
+    ~SeqlockSharedMemorySlot() {
+        release();
+    }
+
+    SeqlockSharedMemorySlot& operator=(SeqlockSharedMemorySlot&& other) noexcept {
+        if (this != &other) {
+            release();
+            slot_ = other.slot_;
+            is_owner_ = other.is_owner_;
+            shm_file_path_ = other.shm_file_path_;
+            use_shm_open_ = other.use_shm_open_;
+            other.slot_ = nullptr;
+        }
+        return *this;
+    }
+
+    SeqlockSharedMemorySlot(const SeqlockSharedMemorySlot&) = delete;
+
+    SeqlockSharedMemorySlot& operator=(const SeqlockSharedMemorySlot&) = delete;
+
+    Slot* operator->() {
+        return slot_;
+    }
+    const Slot* operator->() const {
+        return slot_;
+    }
+    Slot* get() {
+        return slot_;
+    }
+    const Slot* get() const {
+        return slot_;
+    }
+};
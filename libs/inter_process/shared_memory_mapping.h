@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace inter_process {
+// Maps size bytes of the named shm (or regular file when use_shm_open is false). When create is
+// set, the file is created and sized if it does not exist yet; otherwise it must already exist.
+inline void* map_shared_memory(const std::string& path, std::size_t size, bool create,
+                               bool use_shm_open) {
+    const int flags = create ? O_CREAT | O_RDWR : O_RDWR;
+    int fd;
+    if (use_shm_open) {
+        fd = shm_open(path.c_str(), flags, 0666);
+    } else {
+        fd = ::open(path.c_str(), flags, 0666);
+    }
+
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open shm: " + std::string(strerror(errno)));
+    }
+
+    if (create) {
+        struct stat stat_buf;
+        if (fstat(fd, &stat_buf) == -1) {
+            close(fd);
+            throw std::runtime_error("Failed to get fstat for shm: " +
+                                     std::string(strerror(errno)));
+        }
+
+        if (stat_buf.st_size == 0 && ftruncate(fd, size) == -1) {
+            close(fd);
+            throw std::runtime_error("Failed to create shm: " + std::string(strerror(errno)));
+        }
+    }
+
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("Failed to mmap shm: " + std::string(strerror(errno)));
+    }
+    return ptr;
+}
+
+inline void unmap_shared_memory(void* ptr, std::size_t size, const std::string& path, bool unlink_file,
+                                bool use_shm_open) {
+    munmap(ptr, size);
+    if (unlink_file) {
+        if (use_shm_open) {
+            shm_unlink(path.c_str());
+        } else {
+            unlink(path.c_str());
+        }
+    }
+}
+} // namespace inter_process
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "core/message_notifier.h"
 #include "message_format.h"
 
 #include <expected>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -19,6 +21,8 @@ class InboundServer {
     virtual ~InboundServer() = default;
 
     virtual std::expected<void, int> start() = 0;
+    // Notified after each message queued on any connection. Must be set before start().
+    virtual void set_message_notifier(std::shared_ptr<core::MessageNotifier> message_notifier) = 0;
     virtual std::vector<InboundConnectionInfo> get_connection_info() const = 0;
     virtual std::optional<std::string> dequeue_message(int id) = 0;
     virtual std::expected<void, int> send(int id, const std::string& payload,
@@ -23,6 +23,10 @@ class InboundWebsocketServer : public InboundServer {
         return inbound_ws_server.start();
     }
 
+    void set_message_notifier(std::shared_ptr<core::MessageNotifier> message_notifier) override {
+        inbound_ws_server.set_message_notifier(std::move(message_notifier));
+    }
+
     std::vector<InboundConnectionInfo> get_connection_info() const override {
         std::vector<InboundConnectionInfo> connection_info{};
         for (const auto& ws_info_map = inbound_ws_server.get_id_to_connection_map();
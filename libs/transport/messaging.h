@@ -182,6 +182,7 @@ inline std::string serialize_container(const core::FillCostQueryContainer& conta
     container_proto.set_quantity(container.quantity);
     container_proto.set_side(convert_to_proto(container.side));
     container_proto.set_symbol(container.symbol);
+    container_proto.set_request_id(container.request_id);
 
     *container_wrapper.mutable_fill_cost_query() = container_proto;
     return container_wrapper.SerializeAsString();
@@ -194,6 +195,7 @@ inline std::string serialize_container(const core::FillCostResponseContainer& co
     if (container.total_cost.has_value()) {
         container_proto.set_total_cost(container.total_cost.value());
     }
+    container_proto.set_request_id(container.request_id);
 
     *container_wrapper.mutable_fill_cost_response() = container_proto;
     return container_wrapper.SerializeAsString();
@@ -242,9 +244,12 @@ inline std::string serialize_container(const core::CancelOrderRequestContainer&
     return container_wrapper.SerializeAsString();
 }
 
-inline std::string serialize_container(const core::ExecutionReportContainer& container) {
-    transport::ContainerWrapper container_wrapper;
-    transport::ExecutionReportContainer container_proto;
+// Serializes into out, reusing its capacity and a per-thread message. The Order Manager sends two
+// reports per fill, so steady-state calls here must not allocate.
+inline void serialize_container(const core::ExecutionReportContainer& container, std::string& out) {
+    thread_local transport::ContainerWrapper container_wrapper;
+    auto& container_proto = *container_wrapper.mutable_execution_report();
+    container_proto.Clear();
 
     container_proto.set_sender_comp_id(container.sender_comp_id);
     container_proto.set_target_comp_id(container.target_comp_id);
@@ -270,8 +275,13 @@ inline std::string serialize_container(const core::ExecutionReportContainer& con
     container_proto.set_cum_qty(container.cum_qty);
     container_proto.set_avg_px(container.avg_px);
 
-    *container_wrapper.mutable_execution_report() = container_proto;
-    return container_wrapper.SerializeAsString();
+    container_wrapper.SerializeToString(&out);
+}
+
+inline std::string serialize_container(const core::ExecutionReportContainer& container) {
+    std::string out;
+    serialize_container(container, out);
+    return out;
 }
 
 inline core::Container deserialize_container(const std::string& data) {
@@ -349,6 +359,7 @@ inline core::Container deserialize_container(const std::string& data) {
         container.symbol = proto.symbol();
         container.side = convert_to_internal(proto.side());
         container.quantity = proto.quantity();
+        container.request_id = proto.request_id();
         return container;
     }
     case transport::ContainerWrapper::kFillCostResponse: {
@@ -357,6 +368,7 @@ inline core::Container deserialize_container(const std::string& data) {
         if (proto.has_total_cost()) {
             container.total_cost = proto.total_cost();
         }
+        container.request_id = proto.request_id();
         return container;
     }
     case transport::ContainerWrapper::kTrade: {
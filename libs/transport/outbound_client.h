@@ -1,8 +1,10 @@
 #pragma once
 
+#include "core/message_notifier.h"
 #include "message_format.h"
 
 #include <expected>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -12,6 +14,8 @@ class OutboundClient {
     virtual ~OutboundClient() = default;
 
     virtual std::expected<void, int> start() = 0;
+    // Notified after each message queued on any connection. Must be set before start().
+    virtual void set_message_notifier(std::shared_ptr<core::MessageNotifier> message_notifier) = 0;
     virtual std::expected<int, int> connect(std::string_view uri, std::string_view name) = 0;
     virtual std::optional<std::string> dequeue_message(int id) = 0;
     virtual std::optional<std::string> wait_and_dequeue_message(int id) = 0;
@@ -18,6 +18,10 @@ class OutboundWebsocketClient : public OutboundClient {
         return outbound_ws_client.start();
     }
 
+    void set_message_notifier(std::shared_ptr<core::MessageNotifier> message_notifier) override {
+        outbound_ws_client.set_message_notifier(std::move(message_notifier));
+    }
+
     std::expected<int, int> connect(std::string_view uri, std::string_view name) override {
         return outbound_ws_client.connect(uri, name);
     }
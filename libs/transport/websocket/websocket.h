@@ -1,6 +1,7 @@
 #pragma once
 
 #include "config.h"
+#include "core/message_notifier.h"
 #include "core/thread_safe_queue.h"
 #include "spdlog/async.h"
 #include "spdlog/sinks/basic_file_sink.h"
@@ -8,9 +9,12 @@
 #include <concepts>
 #include <expected>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
 #include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <websocketpp/client.hpp>
 #include <websocketpp/close.hpp>
 #include <websocketpp/common/connection_hdl.hpp>
@@ -110,6 +114,7 @@ struct ConnectionMetadata {
     // Makes a copy of the message store and returns it!
     // This is expensive, use cautiously.
     std::vector<std::string> get_message_store() const {
+        std::lock_guard lock{m_send_mutex};
         return m_message_store;
     }
 
@@ -122,11 +127,18 @@ struct ConnectionMetadata {
         return m_message_queue.wait_and_dequeue();
     }
 
+    // Held across a send and its record_sent_message(), as several threads may send on the same
+    // connection, e.g. the Order Manager shards replying to one Gateway
+    std::unique_lock<std::mutex> lock_for_send() {
+        return std::unique_lock{m_send_mutex};
+    }
+
     void record_sent_message(std::string_view message) {
         m_message_store.emplace_back(message);
     }
 
     friend std::ostream& operator<<(std::ostream& out, ConnectionMetadata const& data) {
+        std::lock_guard lock{data.m_send_mutex};
         out << "> URI: " << data.m_uri << "\n"
             << "> Status: " << static_cast<int>(data.m_status) << "\n"
             << "> Counter party: " << data.m_counter_party << "\n"
@@ -151,6 +163,7 @@ struct ConnectionMetadata {
     // separately? We may have to change the config...
     std::string m_counter_party;
     std::string m_error_reason;
+    mutable std::mutex m_send_mutex; // guards m_message_store
     std::vector<std::string> m_message_store;
     core::ThreadSafeQueue<std::string> m_message_queue;
 };
@@ -189,39 +202,40 @@ class WebsocketManager {
     virtual std::expected<void, int> start() = 0;
     virtual std::expected<void, int> stop() = 0;
 
+    // Safe to call from several threads at once, sends on one connection are serialized
     std::expected<void, int> send(int id, const std::string& message,
                                   MessageFormat message_format = MessageFormat::binary) {
         websocketpp::lib::error_code error_code;
 
-        auto metadata_it = m_id_to_connection_map.find(id);
-        if (metadata_it == m_id_to_connection_map.end()) {
+        const auto metadata = get_metadata(id);
+        if (!metadata) {
             m_logger->error("Sending failed, no connection found with id: {}", id);
             return std::unexpected{-1};
         }
         const auto opcode{message_format == MessageFormat::text
                               ? websocketpp::frame::opcode::text
                               : websocketpp::frame::opcode::binary};
-        m_endpoint.send(metadata_it->second->get_handle(), message, opcode, error_code);
+        const auto send_lock = metadata->lock_for_send();
+        m_endpoint.send(metadata->get_handle(), message, opcode, error_code);
         if (error_code) {
             m_logger->error("Error sending message: {}", error_code.message());
             return std::unexpected{-1};
         }
 
-        metadata_it->second->record_sent_message(message);
+        metadata->record_sent_message(message);
         return {};
     }
 
     std::expected<void, int> close(int id, websocketpp::close::status::value code) {
         websocketpp::lib::error_code error_code;
 
-        auto metadata_it = m_id_to_connection_map.find(id);
-
-        if (metadata_it == m_id_to_connection_map.end()) {
+        const auto metadata = get_metadata(id);
+        if (!metadata) {
             m_logger->error("No connection found with id: {}", id);
             return std::unexpected{-1};
         }
 
-        m_endpoint.close(metadata_it->second->get_handle(), code, "", error_code);
+        m_endpoint.close(metadata->get_handle(), code, "", error_code);
         if (error_code) {
             m_logger->error("Error initiating close: {}", error_code.message());
             return std::unexpected{-1};
@@ -262,29 +276,34 @@ class WebsocketManager {
     }
 
     std::optional<std::string> dequeue_message(int id) {
-        auto it{m_id_to_connection_map.find(id)};
-
-        if (it == m_id_to_connection_map.end()) {
+        const auto metadata = get_metadata(id);
+        if (!metadata) {
             return std::nullopt;
         }
 
-        return it->second->dequeue_message();
+        return metadata->dequeue_message();
     }
 
     // THIS IS A BLOCKING DEQUEUE METHOD.
     // It sleeps the thread if queue is non-emoty, do not use this if you want busy-waiting!
     // Returns a null optional if no id is found.
     std::optional<std::string> wait_and_dequeue_message(int id) {
-        auto it{m_id_to_connection_map.find(id)};
-
-        if (it == m_id_to_connection_map.end()) {
+        const auto metadata = get_metadata(id);
+        if (!metadata) {
             return std::nullopt;
         }
 
-        return it->second->wait_and_dequeue_message();
+        return metadata->wait_and_dequeue_message();
+    }
+
+    // Notified after a message is queued on any connection, and by the server when a connection
+    // opens. Set it before start(), the endpoint thread reads it without synchronization.
+    void set_message_notifier(std::shared_ptr<core::MessageNotifier> message_notifier) {
+        m_message_notifier = std::move(message_notifier);
     }
 
     ConnectionMetadata::conn_meta_shared_ptr get_metadata(int id) const {
+        std::shared_lock lock{m_connection_map_mutex};
         auto metadata_it = m_id_to_connection_map.find(id);
         if (metadata_it == m_id_to_connection_map.end()) {
             return {};
@@ -293,9 +312,22 @@ class WebsocketManager {
         return metadata_it->second;
     }
 
+    // Ids of every connection in the map, closed ones included, copied under the lock so they can
+    // be iterated while connections open.
+    std::vector<int> get_connection_ids() const {
+        std::shared_lock lock{m_connection_map_mutex};
+        std::vector<int> ids;
+        ids.reserve(m_id_to_connection_map.size());
+        for (const auto& it : m_id_to_connection_map) {
+            ids.push_back(it.first);
+        }
+        return ids;
+    }
+
     // Useful if you want to iterate over all connections in the map.
     // For example, getting the list of connection names.
-    // Since it returns a const reference, use cautiously to avoid dangling references.
+    // Since it returns a const reference, use cautiously to avoid dangling references. It is not
+    // locked either, unlike get_metadata(), so a connection opening meanwhile may race with it.
     const std::unordered_map<int, typename ConnectionMetadata::conn_meta_shared_ptr>&
     get_id_to_connection_map() const {
         return m_id_to_connection_map;
@@ -306,9 +338,18 @@ class WebsocketManager {
         std::unordered_map<int, typename ConnectionMetadata::conn_meta_shared_ptr>;
     Endpoint m_endpoint;
     websocketpp::lib::shared_ptr<websocketpp::lib::thread> m_thread;
+    // Connections are added on the endpoint thread while others look them up to send
+    mutable std::shared_mutex m_connection_map_mutex;
     IdToConnectionMap m_id_to_connection_map;
     int m_next_id{0};
     std::shared_ptr<spdlog::logger> m_logger;
+    std::shared_ptr<core::MessageNotifier> m_message_notifier;
+
+    void notify_message() {
+        if (m_message_notifier) {
+            m_message_notifier->notify();
+        }
+    }
 
     void init_logging(std::string_view logger_name) {
         // Intensive logging
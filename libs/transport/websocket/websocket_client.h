@@ -74,12 +74,14 @@ class WebsocketManagerClient : public WebsocketManager<Client> {
         // We use a user-provided label, to help the server side identify the client.
         connection->append_header("client_name", static_cast<std::string>(name));
 
+        std::unique_lock map_lock{m_connection_map_mutex};
         int new_id = m_next_id++;
 
         ConnectionMetadata::conn_meta_shared_ptr metadata_ptr{std::make_shared<ConnectionMetadata>(
             new_id, connection->get_handle(), static_cast<std::string>(uri))};
 
         m_id_to_connection_map[new_id] = metadata_ptr;
+        map_lock.unlock();
 
         connection->set_open_handler([metadata_ptr, capture0 = &m_endpoint](auto&& PH1) {
             metadata_ptr->on_open(capture0, std::forward<decltype(PH1)>(PH1));
@@ -90,9 +92,10 @@ class WebsocketManagerClient : public WebsocketManager<Client> {
         connection->set_close_handler([metadata_ptr, capture0 = &m_endpoint](auto&& PH1) {
             metadata_ptr->on_close(capture0, std::forward<decltype(PH1)>(PH1));
         });
-        connection->set_message_handler([metadata_ptr](auto&& PH1, auto&& PH2) {
+        connection->set_message_handler([this, metadata_ptr](auto&& PH1, auto&& PH2) {
             metadata_ptr->on_message(std::forward<decltype(PH1)>(PH1),
                                      std::forward<decltype(PH2)>(PH2));
+            notify_message();
         });
 
         m_endpoint.connect(connection);
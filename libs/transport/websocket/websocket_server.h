@@ -99,9 +99,9 @@ class WebsocketManagerServer : public WebsocketManager<Server> {
         m_logger->info("Broadcasting...");
         m_logger->flush();
         std::vector<int> failed_ids;
-        for (const auto& it : m_id_to_connection_map) {
-            if (!send(it.first, message, message_format)) {
-                failed_ids.push_back(it.first);
+        for (const auto id : get_connection_ids()) {
+            if (!send(id, message, message_format)) {
+                failed_ids.push_back(id);
             }
         }
 
@@ -135,13 +135,19 @@ class WebsocketManagerServer : public WebsocketManager<Server> {
             if (update_callback) {
                 (*update_callback)(metadata_ptr);
             }
-            m_id_to_connection_map.emplace(new_id, metadata_ptr);
+            {
+                std::unique_lock map_lock{m_connection_map_mutex};
+                m_id_to_connection_map.emplace(new_id, metadata_ptr);
+            }
             m_handle_to_connection_map.emplace(handle, std::move(metadata_ptr));
+            // Lets a polling owner pick up the new connection without waiting for its first message
+            notify_message();
         });
         m_endpoint.set_message_handler([this](ConnectionHandle handle, Server::message_ptr msg) {
             if (auto it{m_handle_to_connection_map.find(handle)};
                 it != m_handle_to_connection_map.end()) {
                 it->second->on_message(handle, msg);
+                notify_message();
             }
         });
         m_endpoint.set_close_handler([this](ConnectionHandle handle) {
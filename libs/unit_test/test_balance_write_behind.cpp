@@ -0,0 +1,149 @@
+#include "database/balance_write_behind.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace database;
+using namespace std::chrono_literals;
+
+namespace {
+// Records every batch handed to the flush function; can be told to fail the next N batches.
+struct FakeDatabase {
+    std::mutex mutex;
+    std::vector<std::pair<int, std::vector<BalanceUpsertRow>>> batches;
+    std::map<std::tuple<int, int, std::string>, std::int64_t> balances;
+    int failures_remaining{0};
+
+    BalanceWriteBehind::FlushFunction flush_function() {
+        return [this](int server_id,
+                      const std::vector<BalanceUpsertRow>& rows) -> std::expected<void, std::string> {
+            std::lock_guard lock{mutex};
+            if (failures_remaining > 0) {
+                --failures_remaining;
+                return std::unexpected("connection lost");
+            }
+            batches.emplace_back(server_id, rows);
+            for (const auto& row : rows) {
+                balances[{server_id, row.user_id, row.symbol}] = row.balance;
+            }
+            return {};
+        };
+    }
+
+    std::size_t batch_count() {
+        std::lock_guard lock{mutex};
+        return batches.size();
+    }
+};
+} // namespace
+
+TEST_CASE("RepeatedUpdatesToSameKeyAreCoalesced", "[BalanceWriteBehind][basic]") {
+    FakeDatabase database;
+    BalanceWriteBehind write_behind{database.flush_function(), 1024, 1h};
+
+    for (std::int64_t balance = 1; balance <= 100; ++balance) {
+        write_behind.stage(1, 0, "USD", balance);
+    }
+    write_behind.stage(2, 0, "USD", 7);
+    write_behind.flush();
+
+    REQUIRE(write_behind.coalesced_count() == 99);
+    REQUIRE(write_behind.flushed_row_count() == 2);
+    REQUIRE(database.batches.size() == 1);
+    REQUIRE(database.balances.at({0, 1, "USD"}) == 100);
+    REQUIRE(database.balances.at({0, 2, "USD"}) == 7);
+}
+
+TEST_CASE("EachServerIsFlushedAsOneBatch", "[BalanceWriteBehind][basic]") {
+    FakeDatabase database;
+    BalanceWriteBehind write_behind{database.flush_function(), 1024, 1h};
+
+    write_behind.stage(1, 0, "USD", 10);
+    write_behind.stage(1, 1, "USD", 20);
+    write_behind.stage(2, 0, "AAPL", 30);
+    write_behind.flush();
+
+    REQUIRE(database.batches.size() == 2);
+    REQUIRE(database.batches[0].first == 0);
+    REQUIRE(database.batches[0].second.size() == 2);
+    REQUIRE(database.batches[1].first == 1);
+    REQUIRE(database.batches[1].second.size() == 1);
+}
+
+TEST_CASE("ThresholdTriggersFlushBeforeInterval", "[BalanceWriteBehind][trigger]") {
+    FakeDatabase database;
+    BalanceWriteBehind write_behind{database.flush_function(), 4, 1h};
+
+    for (int user_id = 0; user_id < 4; ++user_id) {
+        write_behind.stage(user_id, 0, "USD", 1);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (database.batch_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(database.batch_count() == 1);
+}
+
+TEST_CASE("IntervalTriggersFlushBelowThreshold", "[BalanceWriteBehind][trigger]") {
+    FakeDatabase database;
+    BalanceWriteBehind write_behind{database.flush_function(), 1024, 10ms};
+
+    write_behind.stage(1, 0, "USD", 1);
+
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (database.batch_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(database.batch_count() == 1);
+}
+
+TEST_CASE("FailedBatchIsRetriedWithoutClobberingNewerBalance", "[BalanceWriteBehind][failure]") {
+    FakeDatabase database;
+    database.failures_remaining = 1;
+    int errors = 0;
+    BalanceWriteBehind write_behind{database.flush_function(), 1024, 1h,
+                                    [&](const std::string&) { ++errors; }};
+
+    write_behind.stage(1, 0, "USD", 10);
+    write_behind.stage(2, 0, "USD", 20);
+    write_behind.flush();
+    REQUIRE(write_behind.failed_flush_count() == 1);
+    REQUIRE(errors == 1);
+    REQUIRE(database.balances.empty());
+
+    write_behind.stage(1, 0, "USD", 11);
+    write_behind.flush();
+    REQUIRE(database.balances.at({0, 1, "USD"}) == 11);
+    REQUIRE(database.balances.at({0, 2, "USD"}) == 20);
+}
+
+TEST_CASE("FailedFlushesBackOffEvenAboveThreshold", "[BalanceWriteBehind][failure]") {
+    FakeDatabase database;
+    database.failures_remaining = 1000;
+    BalanceWriteBehind write_behind{database.flush_function(), 1, 20ms};
+
+    // Always at the threshold, so only the backoff keeps the writer from retrying in a loop
+    write_behind.stage(1, 0, "USD", 10);
+    std::this_thread::sleep_for(200ms);
+
+    // Attempts at 0, 20, 60 and 140ms, give or take scheduling
+    REQUIRE(write_behind.failed_flush_count() >= 2);
+    REQUIRE(write_behind.failed_flush_count() <= 6);
+}
+
+TEST_CASE("DestructorFlushesRemainingBalances", "[BalanceWriteBehind][shutdown]") {
+    FakeDatabase database;
+    {
+        BalanceWriteBehind write_behind{database.flush_function(), 1024, 1h};
+        write_behind.stage(1, 0, "USD", 42);
+    }
+    REQUIRE(database.balances.at({0, 1, "USD"}) == 42);
+}
@@ -0,0 +1,115 @@
+#include "database/bounded_write_queue.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace database;
+using namespace std::chrono_literals;
+
+TEST_CASE("BatchDequeuePreservesOrderAndRespectsMaxCount", "[BoundedWriteQueue][basic]") {
+    BoundedWriteQueue<int> queue{16, OverflowPolicy::block};
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(queue.enqueue(int{i}));
+    }
+
+    std::vector<int> batch;
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 3, 0ms) == 3);
+    REQUIRE(batch == std::vector<int>{0, 1, 2});
+    REQUIRE(queue.size() == 2);
+
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 3, 0ms) == 2);
+    REQUIRE(batch == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(queue.high_watermark() == 5);
+}
+
+TEST_CASE("EmptyQueueTimesOut", "[BoundedWriteQueue][basic]") {
+    BoundedWriteQueue<int> queue{4, OverflowPolicy::block};
+
+    std::vector<int> batch;
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 8, 20ms) == 0);
+    REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+    REQUIRE(batch.empty());
+}
+
+TEST_CASE("WaitingWriterIsWokenByEnqueue", "[BoundedWriteQueue][condition_variable]") {
+    BoundedWriteQueue<int> queue{4, OverflowPolicy::block};
+
+    std::jthread producer{[&queue] {
+        std::this_thread::sleep_for(10ms);
+        queue.enqueue(42);
+    }};
+
+    std::vector<int> batch;
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 8, 5s) == 1);
+    REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+    REQUIRE(batch == std::vector<int>{42});
+}
+
+TEST_CASE("WakeReturnsEarlyWithoutTasks", "[BoundedWriteQueue][condition_variable]") {
+    BoundedWriteQueue<int> queue{4, OverflowPolicy::block};
+
+    std::jthread waker{[&queue] {
+        std::this_thread::sleep_for(10ms);
+        queue.wake();
+    }};
+
+    std::vector<int> batch;
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 8, 5s) == 0);
+    REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+}
+
+TEST_CASE("DropPolicyCountsDiscardedTasks", "[BoundedWriteQueue][overflow]") {
+    BoundedWriteQueue<int> queue{2, OverflowPolicy::drop};
+    REQUIRE(queue.enqueue(1));
+    REQUIRE(queue.enqueue(2));
+    REQUIRE_FALSE(queue.enqueue(3));
+    REQUIRE_FALSE(queue.enqueue(4));
+
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.dropped_count() == 2);
+    REQUIRE(queue.high_watermark() == 2);
+
+    std::vector<int> batch;
+    queue.wait_and_dequeue_batch(batch, 8, 0ms);
+    REQUIRE(batch == std::vector<int>{1, 2});
+}
+
+TEST_CASE("BlockPolicyWaitsForRoom", "[BoundedWriteQueue][overflow]") {
+    BoundedWriteQueue<int> queue{1, OverflowPolicy::block};
+    REQUIRE(queue.enqueue(1));
+
+    std::atomic<bool> enqueued{false};
+    std::jthread producer{[&] {
+        queue.enqueue(2);
+        enqueued = true;
+    }};
+
+    std::this_thread::sleep_for(20ms);
+    REQUIRE_FALSE(enqueued);
+
+    std::vector<int> batch;
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 1, 0ms) == 1);
+    producer.join();
+    REQUIRE(enqueued);
+
+    REQUIRE(queue.wait_and_dequeue_batch(batch, 1, 0ms) == 1);
+    REQUIRE(batch == std::vector<int>{1, 2});
+    REQUIRE(queue.dropped_count() == 0);
+}
+
+TEST_CASE("SpillPolicyHandsTaskBackUntouched", "[BoundedWriteQueue][overflow]") {
+    BoundedWriteQueue<std::string> queue{1, OverflowPolicy::spill};
+    REQUIRE(queue.enqueue(std::string{"queued"}));
+
+    std::string task{"spilled"};
+    REQUIRE_FALSE(queue.enqueue(std::move(task)));
+    REQUIRE(task == "spilled");
+    REQUIRE(queue.dropped_count() == 0);
+}
@@ -0,0 +1,133 @@
+#include "inter_process/broadcast_shared_memory_ring_buffer.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+constexpr std::size_t capacity = 16;
+
+struct Message {
+    std::uint64_t sequence;
+    std::uint64_t payload[8];
+};
+
+using Ring = BroadcastSharedMemoryRingBuffer<Message, capacity>;
+
+Message make_message(std::uint64_t sequence) {
+    Message message{};
+    message.sequence = sequence;
+    for (auto& word : message.payload) {
+        word = sequence;
+    }
+    return message;
+}
+
+std::string unique_prefix(const char* name) {
+    return std::format("/test_broadcast_{}_{}", name, getpid());
+}
+} // namespace
+
+TEST_CASE("EverySubscriberSeesEveryMessage", "[BroadcastRingBuffer][basic]") {
+    const auto prefix = unique_prefix("fanout");
+    auto first = Ring::create(prefix);
+    auto second = Ring::open_exist_shm(prefix);
+    auto producer = Ring::open_exist_shm(prefix);
+
+    for (std::uint64_t i = 0; i < capacity; ++i) {
+        auto message = make_message(i);
+        REQUIRE(producer.try_push(message));
+    }
+
+    for (auto* subscriber : {&first, &second}) {
+        for (std::uint64_t i = 0; i < capacity; ++i) {
+            auto res = subscriber->try_pop();
+            REQUIRE(res.has_value());
+            REQUIRE(res->sequence == i);
+        }
+        REQUIRE_FALSE(subscriber->try_pop().has_value());
+        REQUIRE(subscriber->dropped() == 0);
+    }
+}
+
+TEST_CASE("LateSubscriberStartsAtHead", "[BroadcastRingBuffer][basic]") {
+    const auto prefix = unique_prefix("late");
+    auto owner = Ring::create(prefix);
+    auto message = make_message(1);
+    owner.try_push(message);
+
+    auto late = Ring::open_exist_shm(prefix);
+    REQUIRE_FALSE(late.try_pop().has_value());
+    message = make_message(2);
+    owner.try_push(message);
+    auto res = late.try_pop();
+    REQUIRE(res.has_value());
+    REQUIRE(res->sequence == 2);
+}
+
+TEST_CASE("LaggingSubscriberDropsUnderDropPolicy", "[BroadcastRingBuffer][lag]") {
+    const auto prefix = unique_prefix("drop");
+    auto subscriber = Ring::create(prefix, LagPolicy::drop);
+    auto producer = Ring::open_exist_shm(prefix);
+
+    constexpr std::uint64_t published = capacity * 3;
+    for (std::uint64_t i = 0; i < published; ++i) {
+        auto message = make_message(i);
+        producer.try_push(message);
+    }
+
+    auto res = subscriber.try_pop();
+    REQUIRE(res.has_value());
+    REQUIRE(res->sequence == published - capacity + 1);
+    REQUIRE(subscriber.dropped() == published - capacity + 1);
+    REQUIRE(subscriber.lag() == capacity - 2);
+}
+
+TEST_CASE("LaggingSubscriberThrowsUnderFailPolicy", "[BroadcastRingBuffer][lag]") {
+    const auto prefix = unique_prefix("fail");
+    auto subscriber = Ring::create(prefix, LagPolicy::fail);
+    auto producer = Ring::open_exist_shm(prefix);
+
+    for (std::uint64_t i = 0; i < capacity + 1; ++i) {
+        auto message = make_message(i);
+        producer.try_push(message);
+    }
+    REQUIRE_THROWS_AS(subscriber.try_pop(), std::runtime_error);
+}
+
+TEST_CASE("ConcurrentSubscriberNeverSeesTornMessage", "[BroadcastRingBuffer][concurrency]") {
+    const auto prefix = unique_prefix("torn");
+    auto subscriber = Ring::create(prefix, LagPolicy::drop);
+    auto producer = Ring::open_exist_shm(prefix);
+    constexpr std::uint64_t num_messages = 200000;
+
+    std::thread writer([&] {
+        for (std::uint64_t i = 0; i < num_messages; ++i) {
+            auto message = make_message(i);
+            producer.try_push(message);
+        }
+    });
+
+    std::uint64_t received = 0;
+    std::uint64_t next_expected = 0;
+    bool consistent = true;
+    bool ordered = true;
+    while (received + subscriber.dropped() < num_messages) {
+        if (auto res = subscriber.try_pop()) {
+            for (const auto word : res->payload) {
+                consistent &= word == res->sequence;
+            }
+            ordered &= res->sequence >= next_expected;
+            next_expected = res->sequence + 1;
+            ++received;
+        }
+    }
+    writer.join();
+
+    REQUIRE(consistent);
+    REQUIRE(ordered);
+    REQUIRE(received + subscriber.dropped() == num_messages);
+}
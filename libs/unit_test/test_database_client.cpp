@@ -6,6 +6,7 @@
 #include <pqxx/pqxx>
 #include <atomic>
 #include <cstdint>
+#include <format>
 #include <set>
 #include <thread>
 #include <chrono>
@@ -1648,6 +1649,82 @@ TEST_CASE("query_trades returns empty for unknown symbol",
     CHECK(result->empty());
 }
 
+TEST_CASE("query_trades_page walks every trade once through its cursor",
+          "[DatabaseClient][trades]") {
+    DatabaseClient db;
+
+    REQUIRE(db.truncate_trades(TEST_QUESTDB_SERVER_NAME).has_value());
+    wait_for_questdb_ingestion();
+
+    Trade t1{"AMD", 16000, 5, "88881", "300", "301", 3001, 3002, true};
+    Trade t2{"AMD", 16100, 6, "88882", "302", "303", 3003, 3004, false};
+    Trade t3{"AMD", 16200, 7, "88883", "304", "305", 3005, 3006, true};
+    REQUIRE(db.insert_trade(t1).has_value());
+    REQUIRE(db.insert_trade(t2).has_value());
+    REQUIRE(db.insert_trade(t3).has_value());
+    wait_for_questdb_ingestion();
+
+    std::vector<std::string> trade_ids;
+    std::optional<DatabaseClient::TradeCursor> cursor;
+    do {
+        auto page = db.query_trades_page(TEST_QUESTDB_SERVER_NAME, "AMD", 0, cursor, 2);
+        REQUIRE(page.has_value());
+        REQUIRE(page->trades.size() <= 2);
+        for (const auto& row : page->trades)
+            trade_ids.push_back(row.trade_id);
+        cursor = page->next_cursor;
+    } while (cursor.has_value());
+
+    CHECK(trade_ids == std::vector<std::string>{"88881", "88882", "88883"});
+
+    [[maybe_unused]] auto cleanup = db.truncate_trades(TEST_QUESTDB_SERVER_NAME);
+}
+
+TEST_CASE("query_trade_bars aggregates trades into OHLCV bars",
+          "[DatabaseClient][trades]") {
+    DatabaseClient db;
+
+    REQUIRE(db.truncate_trades(TEST_QUESTDB_SERVER_NAME).has_value());
+    wait_for_questdb_ingestion();
+
+    Trade t1{"INTC", 3000, 4, "99991", "300", "301", 3001, 3002, true};
+    Trade t2{"INTC", 3200, 6, "99992", "302", "303", 3003, 3004, false};
+    REQUIRE(db.insert_trade(t1).has_value());
+    REQUIRE(db.insert_trade(t2).has_value());
+    wait_for_questdb_ingestion();
+
+    auto bars = db.query_trade_bars(TEST_QUESTDB_SERVER_NAME, "INTC", 0, "1d");
+    REQUIRE(bars.has_value());
+    REQUIRE_FALSE(bars->empty());
+
+    std::int64_t volume{0};
+    std::int64_t trade_count{0};
+    for (const auto& bar : bars.value()) {
+        CHECK(bar.low <= bar.open);
+        CHECK(bar.open <= bar.high);
+        volume += bar.volume;
+        trade_count += bar.trade_count;
+    }
+    CHECK(volume == 10);
+    CHECK(trade_count == 2);
+
+    [[maybe_unused]] auto cleanup = db.truncate_trades(TEST_QUESTDB_SERVER_NAME);
+}
+
+TEST_CASE("query_trade_bars rejects resolutions QuestDB cannot sample by",
+          "[DatabaseClient][trades]") {
+    CHECK(DatabaseClient::is_bar_resolution_valid("1m"));
+    CHECK(DatabaseClient::is_bar_resolution_valid("15s"));
+    CHECK(DatabaseClient::is_bar_resolution_valid("4h"));
+    CHECK_FALSE(DatabaseClient::is_bar_resolution_valid("0m"));
+    CHECK_FALSE(DatabaseClient::is_bar_resolution_valid("m"));
+    CHECK_FALSE(DatabaseClient::is_bar_resolution_valid("1y"));
+    CHECK_FALSE(DatabaseClient::is_bar_resolution_valid("1m; DROP TABLE trades"));
+
+    DatabaseClient db;
+    CHECK_FALSE(db.query_trade_bars(TEST_QUESTDB_SERVER_NAME, "AAPL", 0, "1w").has_value());
+}
+
 // ===========================================================================
 //  create_user / get_user / authenticate_user  (PostgreSQL – users table)
 // ===========================================================================
@@ -1679,6 +1756,24 @@ TEST_CASE_METHOD(UserManagementFixture,
     CHECK(result->user_id  >  0);
 }
 
+TEST_CASE_METHOD(UserManagementFixture,
+                 "get_or_create_users creates missing users once",
+                 "[DatabaseClient][user]") {
+    DatabaseClient db;
+    auto created = db.get_or_create_users({TEST_NEW_USERNAME}, TEST_NEW_PASSWORD);
+    REQUIRE(created.has_value());
+    REQUIRE(created->size() == 1);
+
+    auto again = db.get_or_create_users({TEST_NEW_USERNAME}, TEST_NEW_PASSWORD);
+    REQUIRE(again.has_value());
+    CHECK(again.value() == created.value());
+
+    auto auth = db.authenticate_user(TEST_NEW_USERNAME, TEST_NEW_PASSWORD);
+    REQUIRE(auth.has_value());
+    REQUIRE(auth->has_value());
+    CHECK(auth.value()->user_id == created->at(0));
+}
+
 TEST_CASE_METHOD(UserManagementFixture,
                  "create_user fails on duplicate username",
                  "[DatabaseClient][user]") {
@@ -2111,3 +2206,29 @@ TEST_CASE("resolve_user_ids returns empty vector for empty input",
     REQUIRE(result.has_value());
     CHECK(result->empty());
 }
+
+TEST_CASE_METHOD(ResolveUserFixture,
+                 "resolve_user_ids does not split usernames containing array delimiters",
+                 "[DatabaseClient][utility]") {
+    DatabaseClient db;
+    const std::string spliced = std::format("{},{}", TEST2_ADMIN_USERNAME, TEST2_MEMBER_USERNAME);
+    auto result = db.resolve_user_ids({spliced});
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error().find(spliced) != std::string::npos);
+}
+
+TEST_CASE_METHOD(ResolveUserFixture,
+                 "get_or_create_users reuses existing users",
+                 "[DatabaseClient][utility]") {
+    DatabaseClient db;
+    auto result = db.get_or_create_users({TEST2_MEMBER_USERNAME, TEST2_ADMIN_USERNAME}, "unused");
+    REQUIRE(result.has_value());
+    REQUIRE(result->size() == 2);
+    CHECK(result->at(0) == TEST2_MEMBER_USER_ID);
+    CHECK(result->at(1) == TEST2_ADMIN_USER_ID);
+
+    // The existing password is kept
+    auto auth = db.authenticate_user(TEST2_ADMIN_USERNAME, TEST2_ADMIN_PASSWORD);
+    REQUIRE(auth.has_value());
+    CHECK(auth->has_value());
+}
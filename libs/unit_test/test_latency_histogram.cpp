@@ -0,0 +1,74 @@
+#include "core/latency_histogram.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+using namespace core;
+
+TEST_CASE("EmptyHistogramReportsZero", "[LatencyHistogram][basic]") {
+    LatencyHistogram histogram;
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.min() == 0);
+    REQUIRE(histogram.max() == 0);
+    REQUIRE(histogram.value_at_percentile(99.0) == 0);
+}
+
+TEST_CASE("SmallValuesAreExact", "[LatencyHistogram][basic]") {
+    LatencyHistogram histogram;
+    for (std::uint64_t v = 1; v <= 20; ++v) {
+        histogram.record(v);
+    }
+    REQUIRE(histogram.count() == 20);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 20);
+    REQUIRE(histogram.value_at_percentile(50.0) == 10);
+    REQUIRE(histogram.value_at_percentile(100.0) == 20);
+}
+
+TEST_CASE("LargeValuesStayWithinRelativeError", "[LatencyHistogram][precision]") {
+    LatencyHistogram histogram;
+    for (std::uint64_t v = 1; v <= 100000; ++v) {
+        histogram.record(v * 1000);
+    }
+    const auto check = [&](double percentile, std::uint64_t exact) {
+        const auto reported = histogram.value_at_percentile(percentile);
+        REQUIRE(reported >= exact * 94 / 100);
+        REQUIRE(reported <= exact * 107 / 100);
+    };
+    check(50.0, 50'000'000);
+    check(99.0, 99'000'000);
+    check(99.9, 99'900'000);
+    REQUIRE(histogram.value_at_percentile(100.0) == 100'000'000);
+}
+
+TEST_CASE("ExtremeValueDoesNotOverflow", "[LatencyHistogram][precision]") {
+    LatencyHistogram histogram;
+    histogram.record(UINT64_MAX);
+    REQUIRE(histogram.max() == UINT64_MAX);
+    REQUIRE(histogram.value_at_percentile(50.0) == UINT64_MAX);
+}
+
+TEST_CASE("ResetClearsRecordings", "[LatencyHistogram][basic]") {
+    LatencyHistogram histogram;
+    histogram.record(123);
+    histogram.reset();
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.max() == 0);
+    histogram.record(7);
+    REQUIRE(histogram.min() == 7);
+}
+
+TEST_CASE("MergeCombinesRecordings", "[LatencyHistogram][basic]") {
+    LatencyHistogram first;
+    LatencyHistogram second;
+    for (std::uint64_t v = 1; v <= 10; ++v) {
+        first.record(v);
+        second.record(v + 10);
+    }
+    first.merge(second);
+    first.merge(LatencyHistogram{});
+    REQUIRE(first.count() == 20);
+    REQUIRE(first.min() == 1);
+    REQUIRE(first.max() == 20);
+    REQUIRE(first.value_at_percentile(50.0) == 10);
+    REQUIRE(first.mean() == 10.5);
+}
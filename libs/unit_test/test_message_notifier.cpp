@@ -0,0 +1,72 @@
+#include "core/message_notifier.h"
+#include "core/thread_safe_queue.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace core;
+
+TEST_CASE("WaitReturnsIfNotifiedAfterTicket", "[MessageNotifier][basic]") {
+    MessageNotifier notifier;
+    const auto ticket = notifier.ticket();
+
+    notifier.notify();
+
+    notifier.wait(ticket);
+    REQUIRE(notifier.ticket() != ticket);
+}
+
+TEST_CASE("WaitSleepsUntilNotified", "[MessageNotifier][concurrency]") {
+    MessageNotifier notifier;
+    const auto ticket = notifier.ticket();
+    std::atomic<bool> notified{false};
+
+    std::thread producer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        notified.store(true);
+        notifier.notify();
+    });
+
+    notifier.wait(ticket);
+    REQUIRE(notified.load());
+    producer.join();
+}
+
+TEST_CASE("ConsumerDrainsEveryQueueWithoutLostWakeups", "[MessageNotifier][concurrency]") {
+    constexpr int num_producers = 4;
+    constexpr int num_items = 10000;
+
+    MessageNotifier notifier;
+    std::vector<ThreadSafeQueue<int>> queues(num_producers);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < num_items; ++i) {
+                queues[p].enqueue(i);
+                notifier.notify();
+            }
+        });
+    }
+
+    int consumed{0};
+    while (consumed < num_producers * num_items) {
+        const auto ticket = notifier.ticket();
+        int drained{0};
+        for (auto& queue : queues) {
+            while (queue.dequeue().has_value()) {
+                ++drained;
+            }
+        }
+        if (drained == 0) {
+            notifier.wait(ticket);
+        }
+        consumed += drained;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    REQUIRE(consumed == num_producers * num_items);
+}
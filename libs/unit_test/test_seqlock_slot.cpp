@@ -0,0 +1,99 @@
+#include "inter_process/seqlock_shared_memory_slot.h"
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <format>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+struct Book {
+    std::uint64_t version;
+    std::uint64_t levels[32];
+};
+
+Book make_book(std::uint64_t version) {
+    Book book{};
+    book.version = version;
+    for (auto& level : book.levels) {
+        level = version;
+    }
+    return book;
+}
+
+std::string unique_prefix(const char* name) {
+    return std::format("/test_seqlock_{}_{}", name, getpid());
+}
+} // namespace
+
+TEST_CASE("EmptySlotReturnsNullopt", "[SeqlockSlot][basic]") {
+    auto slot = SeqlockSharedMemorySlot<Book>::create(unique_prefix("empty"));
+    std::uint64_t last_seen = 0;
+    REQUIRE_FALSE(slot.try_load_newer(last_seen).has_value());
+    REQUIRE_FALSE(slot->try_load().has_value());
+}
+
+TEST_CASE("ReaderSkipsToLatestValue", "[SeqlockSlot][basic]") {
+    auto slot = SeqlockSharedMemorySlot<Book>::create(unique_prefix("latest"));
+    for (std::uint64_t v = 1; v <= 10; ++v) {
+        auto book = make_book(v);
+        REQUIRE(slot.try_push(book));
+    }
+    std::uint64_t last_seen = 0;
+    auto res = slot.try_load_newer(last_seen);
+    REQUIRE(res.has_value());
+    REQUIRE(res->version == 10);
+    // Same value is not delivered twice
+    REQUIRE_FALSE(slot.try_load_newer(last_seen).has_value());
+
+    auto book = make_book(11);
+    slot.try_push(book);
+    res = slot.try_load_newer(last_seen);
+    REQUIRE(res.has_value());
+    REQUIRE(res->version == 11);
+}
+
+TEST_CASE("WriterAndReaderShareMapping", "[SeqlockSlot][shm]") {
+    const auto prefix = unique_prefix("shared");
+    auto owner = SeqlockSharedMemorySlot<Book>::create(prefix);
+    auto writer = SeqlockSharedMemorySlot<Book>::open_exist_shm(prefix);
+    auto book = make_book(42);
+    writer.try_push(book);
+    std::uint64_t last_seen = 0;
+    auto res = owner.try_load_newer(last_seen);
+    REQUIRE(res.has_value());
+    REQUIRE(res->version == 42);
+}
+
+TEST_CASE("ConcurrentReaderNeverSeesTornValue", "[SeqlockSlot][concurrency]") {
+    auto slot = SeqlockSharedMemorySlot<Book>::create(unique_prefix("torn"));
+    constexpr std::uint64_t num_writes = 200000;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        for (std::uint64_t v = 1; v <= num_writes; ++v) {
+            auto book = make_book(v);
+            slot.try_push(book);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    std::uint64_t last_seen = 0;
+    std::uint64_t last_version = 0;
+    bool consistent = true;
+    bool monotonic = true;
+    while (!done.load(std::memory_order_acquire) || last_version != num_writes) {
+        if (auto res = slot.try_load_newer(last_seen)) {
+            for (const auto level : res->levels) {
+                consistent &= level == res->version;
+            }
+            monotonic &= res->version > last_version;
+            last_version = res->version;
+        }
+    }
+    writer.join();
+
+    REQUIRE(consistent);
+    REQUIRE(monotonic);
+    REQUIRE(last_version == num_writes);
+}
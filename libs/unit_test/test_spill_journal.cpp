@@ -0,0 +1,155 @@
+#include "database/spill_journal.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <expected>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace database;
+using namespace std::chrono_literals;
+
+namespace {
+// Fresh directory per test, removed afterwards
+struct TempDirectory {
+    std::filesystem::path path;
+
+    explicit TempDirectory(std::string_view name)
+        : path{std::filesystem::temp_directory_path() / name} {
+        std::filesystem::remove_all(path);
+    }
+
+    ~TempDirectory() {
+        std::filesystem::remove_all(path);
+    }
+
+    std::size_t file_count() const {
+        return std::distance(std::filesystem::directory_iterator{path},
+                             std::filesystem::directory_iterator{});
+    }
+};
+
+// Collects every batch sent; can be told to fail after accepting N more batches.
+struct FakeQuestDb {
+    std::mutex mutex;
+    std::vector<std::string> batches;
+    int accept_remaining{-1};
+
+    SpillJournal::SendFunction send_function() {
+        return [this](std::string_view batch) -> std::expected<void, std::string> {
+            std::lock_guard lock{mutex};
+            if (accept_remaining == 0) {
+                return std::unexpected("connection refused");
+            }
+            if (accept_remaining > 0) {
+                --accept_remaining;
+            }
+            batches.emplace_back(batch);
+            return {};
+        };
+    }
+};
+} // namespace
+
+TEST_CASE("ReplayDeliversBatchesInAppendOrder", "[SpillJournal][basic]") {
+    TempDirectory directory{"spill_journal_order"};
+    SpillJournal journal{{.directory = directory.path}};
+    REQUIRE(journal.empty());
+
+    REQUIRE(journal.append("orders a=1 1\n"));
+    REQUIRE(journal.append("orders a=2 2\n"));
+    REQUIRE(journal.pending_bytes() == 26);
+
+    FakeQuestDb questdb;
+    REQUIRE(journal.replay(questdb.send_function()) == 2);
+    REQUIRE(questdb.batches == std::vector<std::string>{"orders a=1 1\n", "orders a=2 2\n"});
+    REQUIRE(journal.empty());
+    REQUIRE(directory.file_count() == 0);
+}
+
+TEST_CASE("SegmentsRotateOnceFull", "[SpillJournal][rotation]") {
+    TempDirectory directory{"spill_journal_rotation"};
+    SpillJournal journal{{.directory = directory.path, .segment_size = 64}};
+
+    const std::string batch(40, 'x');
+    REQUIRE(journal.append(batch));
+    REQUIRE(journal.append(batch));
+    REQUIRE(journal.segment_count() == 2);
+
+    // A batch larger than a segment gets a segment of its own
+    const std::string large_batch(200, 'y');
+    REQUIRE(journal.append(large_batch));
+    REQUIRE(journal.segment_count() == 3);
+
+    FakeQuestDb questdb;
+    REQUIRE(journal.replay(questdb.send_function()) == 3);
+    REQUIRE(questdb.batches == std::vector<std::string>{batch, batch, large_batch});
+    REQUIRE(journal.segment_count() == 0);
+}
+
+TEST_CASE("FailedSendResumesFromSameBatch", "[SpillJournal][failure]") {
+    TempDirectory directory{"spill_journal_failure"};
+    SpillJournal journal{{.directory = directory.path}};
+    REQUIRE(journal.append("a"));
+    REQUIRE(journal.append("b"));
+    REQUIRE(journal.append("c"));
+
+    FakeQuestDb questdb;
+    questdb.accept_remaining = 1;
+    REQUIRE_FALSE(journal.replay(questdb.send_function()).has_value());
+    REQUIRE(journal.pending_bytes() == 2);
+
+    questdb.accept_remaining = -1;
+    REQUIRE(journal.replay(questdb.send_function()) == 2);
+    REQUIRE(questdb.batches == std::vector<std::string>{"a", "b", "c"});
+}
+
+TEST_CASE("ReopenedJournalSkipsDeliveredBatches", "[SpillJournal][recovery]") {
+    TempDirectory directory{"spill_journal_recovery"};
+    {
+        SpillJournal journal{{.directory = directory.path}};
+        REQUIRE(journal.append("a"));
+        REQUIRE(journal.append("b"));
+
+        FakeQuestDb questdb;
+        questdb.accept_remaining = 1;
+        REQUIRE_FALSE(journal.replay(questdb.send_function()).has_value());
+    }
+
+    SpillJournal journal{{.directory = directory.path}};
+    REQUIRE(journal.pending_bytes() == 1);
+    REQUIRE(journal.append("c"));
+
+    FakeQuestDb questdb;
+    REQUIRE(journal.replay(questdb.send_function()) == 2);
+    REQUIRE(questdb.batches == std::vector<std::string>{"b", "c"});
+}
+
+TEST_CASE("ReplayerDrainsJournalOnceQuestDbIsBack", "[SpillReplayer][basic]") {
+    TempDirectory directory{"spill_replayer"};
+    SpillJournal journal{{.directory = directory.path}};
+    REQUIRE(journal.append("a"));
+
+    FakeQuestDb questdb;
+    questdb.accept_remaining = 0;
+    SpillReplayer replayer{journal, questdb.send_function(), 5ms};
+
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (replayer.failed_replay_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(replayer.failed_replay_count() > 0);
+
+    {
+        std::lock_guard lock{questdb.mutex};
+        questdb.accept_remaining = -1;
+    }
+    while (!journal.empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(journal.empty());
+    REQUIRE(questdb.batches == std::vector<std::string>{"a"});
+}
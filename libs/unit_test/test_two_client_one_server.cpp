@@ -149,6 +149,46 @@ int main() {
     }
     std::cout << "Both clients received broadcast successfully" << std::endl;
 
+    // Several threads sending on one connection at once, like the Order Manager shards replying
+    // to a Gateway
+    constexpr int sender_threads = 4;
+    constexpr int messages_per_thread = 250;
+    const auto stored_before = server.get_metadata(0)->get_message_store().size();
+    {
+        std::vector<std::jthread> senders;
+        for (int t = 0; t < sender_threads; ++t) {
+            senders.emplace_back([&server] {
+                for (int i = 0; i < messages_per_thread; ++i) {
+                    if (!server.send(0, "concurrent", transport::MessageFormat::text)) {
+                        std::cerr << "Concurrent send failed" << std::endl;
+                    }
+                }
+            });
+        }
+    }
+    if (server.get_metadata(0)->get_message_store().size() - stored_before !=
+        static_cast<std::size_t>(sender_threads * messages_per_thread)) {
+        std::cerr << "Server did not record every concurrent send" << std::endl;
+        return -1;
+    }
+
+    int received = 0;
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (received < sender_threads * messages_per_thread &&
+           std::chrono::steady_clock::now() < deadline) {
+        if (client_a.dequeue_message(a_id) || client_b.dequeue_message(b_id)) {
+            ++received;
+        } else {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    if (received != sender_threads * messages_per_thread) {
+        std::cerr << "Clients received " << received << " of "
+                  << sender_threads * messages_per_thread << " concurrent sends" << std::endl;
+        return -1;
+    }
+    std::cout << "Concurrent sends on one connection all arrived" << std::endl;
+
     // Clean up
     client_a.stop();
     client_b.stop();
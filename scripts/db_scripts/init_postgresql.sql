@@ -93,3 +93,29 @@ CREATE TABLE IF NOT EXISTS services
     PRIMARY KEY(server_id, machine_id, port),
     CHECK (port BETWEEN 1 AND 65535)
 );
+
+-- 8. order_id_blocks
+-- Highest internal order ID each Order Manager shard may have handed out. Shards reserve IDs in
+-- blocks ahead of use, so a restarted Order Manager resumes above every ID still live on the
+-- Matching Engine.
+CREATE TABLE IF NOT EXISTS order_id_blocks
+(
+    server_id INT REFERENCES servers(server_id) ON DELETE CASCADE,
+    shard_id INT NOT NULL,
+    reserved_through INT NOT NULL,
+    created_ts TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    modified_ts TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    PRIMARY KEY(server_id, shard_id)
+);
+
+-- 9. order_id_shard_counts
+-- Shard count the order_id_blocks of each server were reserved under. Every shard allocates from
+-- a range that depends on the count, so an Order Manager restarted with another count would hand
+-- out IDs that collide with those of the previous run.
+CREATE TABLE IF NOT EXISTS order_id_shard_counts
+(
+    server_id INT PRIMARY KEY REFERENCES servers(server_id) ON DELETE CASCADE,
+    shard_count INT NOT NULL,
+    created_ts TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    CHECK (shard_count > 0)
+);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace backend {
+
+// Renders the JSON object {<head>,"<array_key>":[<rows>]} a piece at a time, so a large result is
+// never held as one serialized string. next() returns pieces of roughly chunk_bytes (a piece ends
+// after the row that crosses it) and nullopt once the closing brace has been returned.
+//
+// head holds already serialized members, e.g. "\"next_cursor\":\"42\"", or is empty. array_key is
+// written as is and must not need escaping. serialize_row appends one row's JSON to its output.
+//
+// Rows may also come in pages, starting with first_rows. next_rows is called for the next page
+// once the previous one has been rendered and released, so only one page is held at a time. An
+// empty page ends the array.
+template <typename Row>
+class ChunkedJsonArray {
+  public:
+    using SerializeRow = std::function<void(const Row&, std::string&)>;
+    using NextRows = std::function<std::vector<Row>()>;
+
+    ChunkedJsonArray(std::string head, std::string array_key, std::vector<Row> rows,
+                     SerializeRow serialize_row, std::size_t chunk_bytes = 64 * 1024)
+        : ChunkedJsonArray{std::move(head), std::move(array_key), std::move(rows), NextRows{},
+                           std::move(serialize_row), chunk_bytes} {
+    }
+
+    ChunkedJsonArray(std::string head, std::string array_key, std::vector<Row> first_rows,
+                     NextRows next_rows, SerializeRow serialize_row,
+                     std::size_t chunk_bytes = 64 * 1024)
+        : m_head{std::move(head)}, m_array_key{std::move(array_key)},
+          m_rows{std::move(first_rows)}, m_next_rows{std::move(next_rows)},
+          m_serialize_row{std::move(serialize_row)}, m_chunk_bytes{chunk_bytes} {
+    }
+
+    std::optional<std::string> next() {
+        if (m_finished) {
+            return std::nullopt;
+        }
+
+        std::string chunk;
+        chunk.reserve(m_chunk_bytes + m_chunk_bytes / 8);
+        if (!m_started) {
+            chunk += '{';
+            if (!m_head.empty()) {
+                chunk += m_head;
+                chunk += ',';
+            }
+            chunk += '"';
+            chunk += m_array_key;
+            chunk += "\":[";
+            m_started = true;
+        }
+
+        while (m_next_row < m_rows.size() && chunk.size() < m_chunk_bytes) {
+            if (m_rendered_row_count > 0) {
+                chunk += ',';
+            }
+            m_serialize_row(m_rows[m_next_row], chunk);
+            ++m_next_row;
+            ++m_rendered_row_count;
+
+            if (m_next_row == m_rows.size() && m_next_rows) {
+                m_rows = {};
+                m_rows = m_next_rows();
+                m_next_row = 0;
+            }
+        }
+
+        if (m_next_row == m_rows.size()) {
+            chunk += "]}";
+            m_finished = true;
+            // Rows are no longer needed once rendered
+            m_rows = {};
+        }
+        return chunk;
+    }
+
+  private:
+    const std::string m_head;
+    const std::string m_array_key;
+    std::vector<Row> m_rows; // The page being rendered
+    const NextRows m_next_rows;
+    const SerializeRow m_serialize_row;
+    const std::size_t m_chunk_bytes;
+
+    bool m_started{false};
+    bool m_finished{false};
+    std::size_t m_next_row{0}; // Within m_rows
+    std::size_t m_rendered_row_count{0};
+};
+
+} // namespace backend
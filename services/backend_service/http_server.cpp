@@ -0,0 +1,268 @@
+#include "http_server.h"
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace backend {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+class HttpServer::Session : public std::enable_shared_from_this<Session> {
+  public:
+    Session(tcp::socket socket, HttpServer& server)
+        : m_stream{std::move(socket)}, m_server{server} {
+        ++m_server.m_connection_count;
+    }
+
+    ~Session() {
+        --m_server.m_connection_count;
+    }
+
+    void start() {
+        net::dispatch(m_stream.get_executor(),
+                      [self = shared_from_this()] { self->read_request(); });
+    }
+
+    // Answers 503 without reading the request, then closes
+    void reject() {
+        http::response<http::string_body> response{http::status::service_unavailable, 11};
+        response.set(http::field::content_type, "application/json");
+        response.set(http::field::access_control_allow_origin, "*");
+        response.body() = R"({"error":"Too many connections"})";
+        response.keep_alive(false);
+        response.prepare_payload();
+        net::dispatch(m_stream.get_executor(),
+                      [self = shared_from_this(), response = std::move(response)]() mutable {
+                          self->write_response(std::move(response));
+                      });
+    }
+
+  private:
+    void read_request() {
+        m_request = {};
+        m_stream.expires_after(m_server.m_config.request_timeout);
+        http::async_read(m_stream, m_buffer, m_request,
+                         [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                             self->on_read(ec);
+                         });
+    }
+
+    void on_read(beast::error_code ec) {
+        if (ec == http::error::end_of_stream) {
+            return close();
+        }
+        if (failed(ec, "read")) {
+            return;
+        }
+
+        // Handlers block on the database, so they run off the io threads. The response is
+        // written back on this connection's strand.
+        m_stream.expires_never();
+        net::post(m_server.m_handler_pool, [self = shared_from_this()] {
+            auto response = self->handle_request();
+            net::post(self->m_stream.get_executor(),
+                      [self, response = std::move(response)]() mutable {
+                          if (auto* chunked = std::get_if<ChunkedResponse>(&response)) {
+                              self->write_chunked_header(std::move(*chunked));
+                          } else {
+                              self->write_response(
+                                  std::move(std::get<http::response<http::string_body>>(response)));
+                          }
+                      });
+        });
+    }
+
+    HandlerResponse handle_request() {
+        try {
+            auto response = m_server.m_handler.handle_streaming(m_request);
+            if (auto* chunked = std::get_if<ChunkedResponse>(&response)) {
+                chunked->header.keep_alive(m_request.keep_alive());
+            } else {
+                std::get<http::response<http::string_body>>(response).keep_alive(
+                    m_request.keep_alive());
+            }
+            return response;
+        } catch (const std::exception& e) {
+            std::cerr << "Session error: " << e.what() << '\n';
+            http::response<http::string_body> response{http::status::internal_server_error,
+                                                       m_request.version()};
+            response.set(http::field::content_type, "application/json");
+            response.set(http::field::access_control_allow_origin, "*");
+            response.body() = R"({"error":"Internal server error"})";
+            response.keep_alive(m_request.keep_alive());
+            response.prepare_payload();
+            return response;
+        }
+    }
+
+    void write_response(http::response<http::string_body> response) {
+        m_response = std::move(response);
+        m_stream.expires_after(m_server.m_config.request_timeout);
+        http::async_write(m_stream, m_response,
+                          [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                              self->on_write(ec, self->m_response.need_eof());
+                          });
+    }
+
+    void write_chunked_header(ChunkedResponse response) {
+        m_chunked_header = std::move(response.header);
+        m_next_chunk = std::move(response.next_chunk);
+        m_header_serializer.emplace(m_chunked_header);
+        m_stream.expires_after(m_server.m_config.request_timeout);
+        http::async_write_header(m_stream, *m_header_serializer,
+                                 [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                                     if (!self->failed(ec, "write")) {
+                                         self->pull_chunk();
+                                     }
+                                 });
+    }
+
+    // Serializing a chunk is CPU work proportional to its rows, so it runs on the handler pool as
+    // well. Only one chunk is pulled at a time, after the previous one was written.
+    void pull_chunk() {
+        net::post(m_server.m_handler_pool, [self = shared_from_this()] {
+            std::optional<std::string> chunk;
+            bool pull_failed{false};
+            try {
+                chunk = self->m_next_chunk();
+            } catch (const std::exception& e) {
+                std::cerr << "Session error: " << e.what() << '\n';
+                pull_failed = true;
+            }
+            net::post(self->m_stream.get_executor(),
+                      [self, chunk = std::move(chunk), pull_failed]() mutable {
+                          self->write_chunk(std::move(chunk), pull_failed);
+                      });
+        });
+    }
+
+    void write_chunk(std::optional<std::string> chunk, bool pull_failed) {
+        if (pull_failed) {
+            // The status line is already out; closing mid-body is the only way left to tell
+            return close();
+        }
+        m_stream.expires_after(m_server.m_config.request_timeout);
+        if (!chunk.has_value()) {
+            m_next_chunk = nullptr;
+            net::async_write(m_stream, http::make_chunk_last(),
+                             [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                                 self->on_write(ec, self->m_chunked_header.need_eof());
+                             });
+            return;
+        }
+        // An empty chunk would read as the end of the body
+        if (chunk->empty()) {
+            return pull_chunk();
+        }
+        m_chunk = std::move(chunk.value());
+        net::async_write(m_stream, http::make_chunk(net::buffer(m_chunk)),
+                         [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                             if (!self->failed(ec, "write")) {
+                                 self->pull_chunk();
+                             }
+                         });
+    }
+
+    void on_write(beast::error_code ec, bool close_after) {
+        if (failed(ec, "write")) {
+            return;
+        }
+        if (close_after) {
+            return close();
+        }
+        // Any pipelined request is already waiting in m_buffer
+        read_request();
+    }
+
+    // Logs unexpected errors; a timed out stream is already closed
+    bool failed(beast::error_code ec, std::string_view operation) const {
+        if (ec && ec != beast::error::timeout) {
+            std::cerr << "Session " << operation << " error: " << ec.message() << '\n';
+        }
+        return static_cast<bool>(ec);
+    }
+
+    void close() {
+        beast::error_code ec;
+        m_stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+    }
+
+    beast::tcp_stream m_stream;
+    HttpServer& m_server;
+    beast::flat_buffer m_buffer;
+    http::request<http::string_body> m_request;
+    http::response<http::string_body> m_response;
+
+    // State of a chunked response while its body is being sent
+    http::response<http::empty_body> m_chunked_header;
+    std::optional<http::response_serializer<http::empty_body>> m_header_serializer;
+    BodyChunks m_next_chunk;
+    std::string m_chunk;
+};
+
+HttpServer::HttpServer(const HttpServerConfig& config, RequestHandler& handler)
+    : m_config{config}, m_handler{handler},
+      m_acceptor{m_ioc, {tcp::v4(), config.port}}, m_signals{m_ioc, SIGINT, SIGTERM},
+      m_handler_pool{std::max<std::size_t>(config.handler_threads, 1)} {
+    m_signals.async_wait([this](const boost::system::error_code& ec, int) {
+        if (!ec) {
+            stop();
+        }
+    });
+    accept();
+}
+
+HttpServer::~HttpServer() {
+    stop();
+    // Let requests already in a handler finish before their sessions go away
+    m_handler_pool.join();
+}
+
+void HttpServer::run() {
+    std::vector<std::jthread> io_threads;
+    const auto io_thread_count = std::max<std::size_t>(m_config.io_threads, 1);
+    io_threads.reserve(io_thread_count);
+    for (std::size_t i = 0; i < io_thread_count; ++i) {
+        io_threads.emplace_back([this] { m_ioc.run(); });
+    }
+}
+
+void HttpServer::stop() {
+    m_ioc.stop();
+}
+
+void HttpServer::accept() {
+    // Each connection gets its own strand, so its handlers never run concurrently
+    m_acceptor.async_accept(net::make_strand(m_ioc), [this](beast::error_code ec,
+                                                            tcp::socket socket) {
+        if (ec == net::error::operation_aborted) {
+            return;
+        }
+        if (ec) {
+            std::cerr << "Accept error: " << ec.message() << '\n';
+        } else {
+            auto session = std::make_shared<Session>(std::move(socket), *this);
+            if (m_connection_count.load() > m_config.max_connections) {
+                session->reject();
+            } else {
+                session->start();
+            }
+        }
+        accept();
+    });
+}
+
+} // namespace backend
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#include "request_handler.h"
+
+namespace backend {
+
+struct HttpServerConfig {
+    unsigned short port;
+    // Threads running the sockets; they never wait on the database
+    std::size_t io_threads{2};
+    // Threads running RequestHandler, which blocks on Postgres and QuestDB. A connection has at
+    // most one request in flight, so no more than max_connections requests ever queue for them.
+    std::size_t handler_threads{8};
+    // Connections beyond this are answered 503 and closed
+    std::size_t max_connections{1024};
+    // Allowed for receiving a request, including the idle time before the next request on a
+    // kept-alive connection, and for sending its response
+    std::chrono::milliseconds request_timeout{std::chrono::seconds{30}};
+};
+
+/*
+ * Asynchronous HTTP/1.1 server for the backend. Connections are kept alive, and pipelined
+ * requests are answered one after the other in the order they arrive. Reading and writing happen
+ * on a fixed set of io threads, while RequestHandler runs on a separate fixed pool so that slow
+ * queries never hold up other connections' I/O. A ChunkedResponse is sent one chunk at a time,
+ * with the next chunk serialized on that pool once the previous one is written.
+ *
+ * run() serves until stop() is called or the process receives SIGINT or SIGTERM.
+ */
+class HttpServer {
+  public:
+    // Binds the port; throws boost::system::system_error if it is taken
+    HttpServer(const HttpServerConfig& config, RequestHandler& handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    void run();
+    void stop();
+
+    std::size_t connection_count() const {
+        return m_connection_count.load();
+    }
+
+  private:
+    class Session;
+
+    void accept();
+
+    const HttpServerConfig m_config;
+    RequestHandler& m_handler;
+
+    // Declared before everything that can own a Session, since sessions update it on destruction
+    std::atomic<std::size_t> m_connection_count{0};
+
+    boost::asio::io_context m_ioc;
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    boost::asio::signal_set m_signals;
+    boost::asio::thread_pool m_handler_pool;
+};
+
+} // namespace backend
@@ -0,0 +1,251 @@
+// Load generator for backend_service. Replays a weighted mix of the calls the frontend makes
+// (login, active_servers, account_details, historical_trades) over keep-alive connections against
+// a running backend and reports throughput and latency percentiles per endpoint.
+//
+// With target_rps set the load is open loop: every connection sends on a fixed schedule and
+// latency is measured from the scheduled send time, so a backend that stalls shows up as higher
+// latency instead of quietly receiving fewer requests. With target_rps = 0 each connection sends
+// its next request as soon as the previous one is answered, which finds the saturation point.
+//
+// Usage: backend_load_test [backend_load_test.toml]
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/url.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "configuration/backend_load_test_config.h"
+#include "core/latency_histogram.h"
+#include "rfl/toml/load.hpp"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum class Endpoint : std::size_t { login, active_servers, account_details, historical_trades };
+
+constexpr std::size_t endpoint_count = 4;
+constexpr std::array<const char*, endpoint_count> endpoint_names{
+    "login", "active_servers", "account_details", "historical_trades"};
+
+struct EndpointStats {
+    core::LatencyHistogram latency_ns;
+    std::uint64_t errors{0};
+};
+
+// Written only by its connection's thread, read after every thread has joined
+using ConnectionStats = std::array<EndpointStats, endpoint_count>;
+
+std::string make_target(Endpoint endpoint, const backend::BackendLoadTestConfig& config) {
+    boost::urls::url url;
+    switch (endpoint) {
+    case Endpoint::login:
+        url.set_path("/login");
+        url.params().append({"user_name", config.user_name});
+        url.params().append({"password", config.password});
+        break;
+    case Endpoint::active_servers:
+        url.set_path("/active_servers");
+        break;
+    case Endpoint::account_details:
+        url.set_path("/get_account_details");
+        url.params().append({"user_name", config.user_name});
+        url.params().append({"server_name", config.server_name});
+        break;
+    case Endpoint::historical_trades:
+        url.set_path("/get_historical_trades");
+        url.params().append({"server", config.server_name});
+        url.params().append({"symbol", config.symbol});
+        url.params().append({"after_ts_ms", "0"});
+        if (config.historical_trades_limit > 0) {
+            url.params().append({"limit", std::to_string(config.historical_trades_limit)});
+        }
+        break;
+    }
+    return std::string(url.buffer());
+}
+
+// The backend reports most failures as a 200 with an error member, so both count as errors
+bool is_success(const http::response<http::string_body>& response) {
+    return response.result() == http::status::ok &&
+           response.body().find("\"error\"") == std::string::npos &&
+           response.body().find("\"success\":false") == std::string::npos;
+}
+
+void run_connection(const backend::BackendLoadTestConfig& config, std::size_t index,
+                    Clock::time_point start, Clock::time_point measure_from,
+                    Clock::time_point end, ConnectionStats& stats) {
+    std::array<std::string, endpoint_count> targets;
+    for (std::size_t i = 0; i < endpoint_count; ++i) {
+        targets[i] = make_target(static_cast<Endpoint>(i), config);
+    }
+
+    std::mt19937 rng{static_cast<std::mt19937::result_type>(index + 1)};
+    std::discrete_distribution<std::size_t> mix{
+        static_cast<double>(config.login_weight),
+        static_cast<double>(config.active_servers_weight),
+        static_cast<double>(config.account_details_weight),
+        static_cast<double>(config.historical_trades_weight)};
+
+    // Connections send in turn rather than in bursts
+    const auto interval = config.target_rps > 0
+                              ? std::chrono::nanoseconds{1'000'000'000LL * config.connections /
+                                                         config.target_rps}
+                              : std::chrono::nanoseconds{0};
+    auto next_send = start + interval * static_cast<long long>(index) / config.connections;
+
+    net::io_context ioc;
+    tcp::resolver resolver{ioc};
+    std::optional<beast::tcp_stream> stream;
+    beast::flat_buffer buffer;
+
+    while (true) {
+        Clock::time_point scheduled;
+        if (interval.count() > 0) {
+            if (next_send >= end) {
+                break;
+            }
+            std::this_thread::sleep_until(next_send);
+            scheduled = next_send;
+            next_send += interval;
+        } else {
+            scheduled = Clock::now();
+            if (scheduled >= end) {
+                break;
+            }
+        }
+
+        const auto endpoint = mix(rng);
+        bool succeeded{false};
+        try {
+            if (!stream.has_value()) {
+                stream.emplace(ioc);
+                stream->connect(resolver.resolve(config.host, std::to_string(config.port)));
+                buffer.clear();
+            }
+
+            http::request<http::string_body> request{http::verb::get, targets[endpoint], 11};
+            request.set(http::field::host, config.host);
+            http::write(*stream, request);
+
+            http::response_parser<http::string_body> parser;
+            parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+            http::read(*stream, buffer, parser);
+            succeeded = is_success(parser.get());
+            if (!parser.get().keep_alive()) {
+                stream.reset();
+            }
+        } catch (const std::exception& e) {
+            // Reconnect for the next request
+            stream.reset();
+            if (scheduled >= measure_from && stats[endpoint].errors == 0) {
+                std::println(stderr, "Connection {}: {}", index, e.what());
+            }
+        }
+
+        if (scheduled < measure_from) {
+            continue;
+        }
+        auto& endpoint_stats = stats[endpoint];
+        if (!succeeded) {
+            ++endpoint_stats.errors;
+        }
+        endpoint_stats.latency_ns.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled)
+                .count()));
+    }
+}
+
+void print_row(const char* name, const EndpointStats& stats, double measured_s) {
+    const auto ms = [&](double percentile) {
+        return static_cast<double>(stats.latency_ns.value_at_percentile(percentile)) / 1e6;
+    };
+    std::println("{:<18} {:>9} {:>7} {:>9.1f} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f}", name,
+                 stats.latency_ns.count(), stats.errors,
+                 static_cast<double>(stats.latency_ns.count()) / measured_s, ms(50.0), ms(90.0),
+                 ms(99.0), ms(99.9), static_cast<double>(stats.latency_ns.max()) / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const auto config_path = argc == 2 ? argv[1] : "backend_load_test.toml";
+    backend::BackendLoadTestConfig config;
+    try {
+        config = rfl::toml::load<backend::BackendLoadTestConfig>(config_path).value();
+    } catch (const std::exception& e) {
+        std::println(stderr, "Cannot load {}: {}", config_path, e.what());
+        return 1;
+    }
+
+    const std::array weights{config.login_weight, config.active_servers_weight,
+                             config.account_details_weight, config.historical_trades_weight};
+    if (config.connections <= 0 || config.duration_s <= 0 || config.warmup_s < 0 ||
+        config.target_rps < 0 || std::ranges::any_of(weights, [](int w) { return w < 0; }) ||
+        std::ranges::all_of(weights, [](int w) { return w == 0; })) {
+        std::println(stderr, "connections and duration_s must be positive, warmup_s, target_rps "
+                             "and weights non-negative, and at least one weight non-zero");
+        return 1;
+    }
+
+    std::println("Load testing {}:{} with {} connections, target {} for {}s after {}s warm-up",
+                 config.host, config.port, config.connections,
+                 config.target_rps > 0 ? std::format("{} req/s", config.target_rps)
+                                       : std::string{"max req/s"},
+                 config.duration_s, config.warmup_s);
+
+    const auto start = Clock::now();
+    const auto measure_from = start + std::chrono::seconds{config.warmup_s};
+    const auto end = measure_from + std::chrono::seconds{config.duration_s};
+
+    std::vector<ConnectionStats> stats(static_cast<std::size_t>(config.connections));
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(stats.size());
+        for (std::size_t i = 0; i < stats.size(); ++i) {
+            threads.emplace_back(run_connection, std::cref(config), i, start, measure_from, end,
+                                 std::ref(stats[i]));
+        }
+    }
+
+    const auto measured_s = static_cast<double>(config.duration_s);
+    std::println("{:<18} {:>9} {:>7} {:>9} {:>8} {:>8} {:>8} {:>8} {:>8}", "endpoint", "requests",
+                 "errors", "req/s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    EndpointStats total;
+    for (std::size_t e = 0; e < endpoint_count; ++e) {
+        EndpointStats endpoint;
+        for (const auto& connection : stats) {
+            endpoint.latency_ns.merge(connection[e].latency_ns);
+            endpoint.errors += connection[e].errors;
+        }
+        if (endpoint.latency_ns.count() == 0) {
+            continue;
+        }
+        print_row(endpoint_names[e], endpoint, measured_s);
+        total.latency_ns.merge(endpoint.latency_ns);
+        total.errors += endpoint.errors;
+    }
+    print_row("total", total, measured_s);
+    return 0;
+}
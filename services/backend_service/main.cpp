@@ -1,48 +1,21 @@
-#include <boost/beast/core.hpp>
-#include <boost/beast/http.hpp>
-#include <boost/asio.hpp>
-#include <boost/system/error_code.hpp>
-#include <csignal>
-#include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <memory>
-#include <thread>
 #include <print>
 #include "rfl/toml/load.hpp"
 #include "configuration/backend_config.h"
+#include "http_server.h"
 #include "request_handler.h"
 #include "uat_seeder.h"
 
-using tcp = boost::asio::ip::tcp;
-namespace http = boost::beast::http;
-
-static boost::asio::ip::tcp::acceptor* g_acceptor_ptr = nullptr;
-
-void signal_handler(int) {
-    if (g_acceptor_ptr) {
-        boost::system::error_code ec;
-        g_acceptor_ptr->close(ec); // unblocks the synchronous accept() call
-    }
-}
-
-// Handles a single HTTP session
-void handle_session(tcp::socket socket, backend::RequestHandler& handler) {
-    try {
-        boost::beast::flat_buffer buffer;
-        http::request<http::string_body> req;
-        http::read(socket, buffer, req);
-
-        auto response = handler.handle(req);
-        http::write(socket, response);
-    } catch (std::exception& e) {
-        std::cerr << "Session error: " << e.what() << std::endl;
-    }
-}
-
 int main(int argc, char* argv[]) {
     auto backend_cfg = argc == 2 ? argv[1] : "backend.toml";
     try {
         backend::BackendConfig backend_config = rfl::toml::load<backend::BackendConfig>(backend_cfg).value();
-        backend::RequestHandler handler;
+        backend::RequestHandler handler{database::PgConnectionPoolConfig{
+            .size = static_cast<std::size_t>(std::max(backend_config.db_pool_size, 1)),
+            .checkout_timeout = std::chrono::milliseconds{backend_config.db_checkout_timeout_ms}},
+            std::chrono::milliseconds{std::max(backend_config.response_cache_ttl_ms, 0)}};
 
         std::unique_ptr<backend::UatSeeder> uat_seeder;
         if (backend_config.uat) {
@@ -50,28 +23,25 @@ int main(int argc, char* argv[]) {
             uat_seeder->seed();
         }
 
-        boost::asio::io_context ioc{1};
-
-        std::signal(SIGINT,  signal_handler);
-        std::signal(SIGTERM, signal_handler);
-
-        tcp::acceptor acceptor{ioc, {tcp::v4(), static_cast<unsigned short>(backend_config.port)}};
-        g_acceptor_ptr = &acceptor;
-        std::println("Server started on port {}", backend_config.port);
-        if (backend_config.uat)
-            std::println("[UAT] Running in UAT mode — test data populated");
-
-        try {
-            for (;;) {
-                tcp::socket socket{ioc};
-                acceptor.accept(socket);
-                std::thread([s = std::move(socket), &handler]() mutable {
-                    handle_session(std::move(s), handler);
-                }).detach();
-            }
-        } catch (const boost::system::system_error&) {
-            // Expected: io_context was stopped via signal handler.
-        }
+        {
+            backend::HttpServer server{
+                backend::HttpServerConfig{
+                    .port = static_cast<unsigned short>(backend_config.port),
+                    .io_threads = static_cast<std::size_t>(std::max(backend_config.io_threads, 1)),
+                    .handler_threads =
+                        static_cast<std::size_t>(std::max(backend_config.handler_threads, 1)),
+                    .max_connections =
+                        static_cast<std::size_t>(std::max(backend_config.max_connections, 1)),
+                    .request_timeout =
+                        std::chrono::milliseconds{backend_config.request_timeout_ms}},
+                handler};
+            std::println("Server started on port {}", backend_config.port);
+            if (backend_config.uat)
+                std::println("[UAT] Running in UAT mode — test data populated");
+
+            // Returns on SIGINT or SIGTERM
+            server.run();
+        } // Requests still in a handler finish here
 
         if (uat_seeder) {
             uat_seeder->cleanup();
@@ -1,4 +1,5 @@
 #include "request_handler.h"
+#include "chunked_json.h"
 #include <algorithm>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core.hpp>
@@ -7,13 +8,20 @@
 #include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <expected>
 #include <format>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <stdexcept>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <variant>
+#include <vector>
 
 namespace backend {
 
@@ -23,6 +31,7 @@ namespace {
 
 constexpr std::size_t kServerNameMaxLength = 11;
 constexpr std::int64_t kDefaultInitialTickerPriceUsd = 100;
+constexpr std::size_t kMaxHistoricalPageSize = 10000;
 
 bool is_server_name_valid(const std::string& server_name) {
     if (server_name.empty() || server_name.size() > kServerNameMaxLength) {
@@ -32,6 +41,128 @@ bool is_server_name_valid(const std::string& server_name) {
                                [](unsigned char c) { return std::isalnum(static_cast<int>(c)) != 0; });
 }
 
+// Read-mostly endpoints the frontend polls; they only change through the server write handlers
+bool is_response_cacheable(std::string_view path) {
+    return path == "/active_servers" || path == "/active_symbols" || path == "/user_servers" ||
+           path == "/server_mdp_endpoint";
+}
+
+http::response<http::string_body> make_json_response(http::status status, unsigned version,
+                                                     std::string body) {
+    http::response<http::string_body> response{status, version};
+    response.set(http::field::content_type, "application/json");
+    response.set(http::field::access_control_allow_origin, "*");
+    response.body() = std::move(body);
+    response.prepare_payload();
+    return response;
+}
+
+// Collects a streamed response into one body, for callers that want it whole
+http::response<http::string_body> collect_response(HandlerResponse response) {
+    if (auto* buffered = std::get_if<http::response<http::string_body>>(&response)) {
+        return std::move(*buffered);
+    }
+    auto& chunked = std::get<ChunkedResponse>(response);
+    std::string body;
+    while (auto chunk = chunked.next_chunk()) {
+        body += chunk.value();
+    }
+    return make_json_response(chunked.header.result(), chunked.header.version(), std::move(body));
+}
+
+HandlerResponse make_streamed_json_response(std::variant<bj::object, BodyChunks> body,
+                                            unsigned version) {
+    if (auto* object = std::get_if<bj::object>(&body)) {
+        return make_json_response(http::status::ok, version, bj::serialize(*object));
+    }
+    ChunkedResponse response{http::response<http::empty_body>{http::status::ok, version},
+                             std::move(std::get<BodyChunks>(body))};
+    response.header.set(http::field::content_type, "application/json");
+    response.header.set(http::field::access_control_allow_origin, "*");
+    response.header.chunked(true);
+    return response;
+}
+
+// Streams {<members of head>,"<array_key>":[<rows>]}, serializing rows only as chunks are pulled.
+// Pages after rows are fetched through next_rows, if given, as the earlier ones are rendered.
+template <typename Row>
+BodyChunks stream_json_array(const bj::object& head, std::string array_key, std::vector<Row> rows,
+                             typename ChunkedJsonArray<Row>::NextRows next_rows,
+                             typename ChunkedJsonArray<Row>::SerializeRow serialize_row) {
+    auto head_members = bj::serialize(head);
+    head_members = head_members.substr(1, head_members.size() - 2);
+    auto array = std::make_shared<ChunkedJsonArray<Row>>(
+        std::move(head_members), std::move(array_key), std::move(rows), std::move(next_rows),
+        std::move(serialize_row));
+    return [array] { return array->next(); };
+}
+
+void serialize_trade(const database::DatabaseClient::HistoricalTradeRow& t, std::string& out) {
+    const double trade_multiplier = core::constants::decimal_to_int_multiplier;
+    bj::object trade;
+    trade["trade_id"] = t.trade_id;
+    trade["ticker"] = t.symbol;
+    trade["price"] = static_cast<double>(t.price) / trade_multiplier;
+    trade["quantity"] = static_cast<double>(t.quantity) / trade_multiplier;
+    trade["create_timestamp"] = t.ts_ms;
+    out += bj::serialize(trade);
+}
+
+void serialize_bar(const database::DatabaseClient::OhlcvBarRow& b, std::string& out) {
+    const double trade_multiplier = core::constants::decimal_to_int_multiplier;
+    bj::object bar;
+    bar["timestamp"] = b.ts_ms;
+    bar["open"] = static_cast<double>(b.open) / trade_multiplier;
+    bar["high"] = static_cast<double>(b.high) / trade_multiplier;
+    bar["low"] = static_cast<double>(b.low) / trade_multiplier;
+    bar["close"] = static_cast<double>(b.close) / trade_multiplier;
+    bar["volume"] = static_cast<double>(b.volume) / trade_multiplier;
+    bar["trade_count"] = b.trade_count;
+    out += bj::serialize(bar);
+}
+
+// Parses the optional "limit" parameter of the historical endpoints; nullopt when absent
+std::expected<std::optional<std::size_t>, std::string>
+parse_page_limit(const boost::urls::params_view& params) {
+    auto limit_it = params.find("limit");
+    if (limit_it == params.end()) {
+        return std::nullopt;
+    }
+    try {
+        const auto limit = std::stoull(std::string((*limit_it).value));
+        if (limit == 0 || limit > kMaxHistoricalPageSize) {
+            return std::unexpected{
+                std::format("limit must be between 1 and {}", kMaxHistoricalPageSize)};
+        }
+        return limit;
+    } catch (...) {
+        return std::unexpected{std::string{"Invalid limit"}};
+    }
+}
+
+// Trade cursors are handed to clients as "<ts_micros>:<trade_id>"
+std::string encode_trade_cursor(const database::DatabaseClient::TradeCursor& cursor) {
+    return std::format("{}:{}", cursor.ts_micros, cursor.trade_id);
+}
+
+std::optional<database::DatabaseClient::TradeCursor> decode_trade_cursor(std::string_view cursor) {
+    const auto separator = cursor.find(':');
+    if (separator == std::string_view::npos || separator + 1 == cursor.size()) {
+        return std::nullopt;
+    }
+    try {
+        std::size_t parsed_length{};
+        const auto ts_micros = std::stoll(std::string(cursor.substr(0, separator)), &parsed_length);
+        if (parsed_length != separator) {
+            return std::nullopt;
+        }
+        return database::DatabaseClient::TradeCursor{ts_micros,
+                                                     std::string(cursor.substr(separator + 1))};
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
 } // namespace
 
 http::response<http::string_body>
@@ -51,6 +182,16 @@ RequestHandler::handle(const http::request<http::string_body>& req) {
     std::string path(url.path());
     auto params = url.params();
 
+    // Cached bodies are served as rendered, without touching the database
+    const bool cacheable = req.method() == http::verb::get && m_response_cache.enabled() &&
+                           is_response_cacheable(path);
+    if (cacheable) {
+        if (auto body = m_response_cache.find(target)) {
+            return make_json_response(http::status::ok, req.version(), std::move(body.value()));
+        }
+    }
+    const auto cache_generation = m_response_cache.generation();
+
     bj::object res;
     http::status status = http::status::ok;
 
@@ -67,12 +208,14 @@ RequestHandler::handle(const http::request<http::string_body>& req) {
             res = handle_user_servers(params);
         } else if (path == "/get_account_details") {
             res = handle_account_details(params);
-        } else if (path == "/get_historical_trades") {
-            res = handle_historical_trades(params);
+        } else if (path == "/get_historical_trades" || path == "/get_historical_bars") {
+            return collect_response(handle_streaming(req));
         } else if (path == "/server_mdp_endpoint") {
             res = handle_server_mdp_endpoint(params);
             if (res.contains("error"))
                 status = http::status::bad_request;
+        } else if (path == "/cache_stats") {
+            res = handle_cache_stats();
         } else {
             status = http::status::not_found;
             res["error"] = "Unknown endpoint";
@@ -100,17 +243,46 @@ RequestHandler::handle(const http::request<http::string_body>& req) {
             status = http::status::not_found;
             res["error"] = "Unknown endpoint";
         }
+        // Even a failed write may have changed servers or allowlists part way
+        m_response_cache.invalidate();
     } else {
         status = http::status::method_not_allowed;
         res["error"] = "Method not allowed";
     }
 
-    http::response<http::string_body> response{status, req.version()};
-    response.set(http::field::content_type, "application/json");
-    response.set(http::field::access_control_allow_origin, "*");
-    response.body() = bj::serialize(res);
-    response.prepare_payload();
-    return response;
+    std::string body = bj::serialize(res);
+    if (cacheable && status == http::status::ok && !res.contains("error")) {
+        m_response_cache.store(target, body, cache_generation);
+    }
+    return make_json_response(status, req.version(), std::move(body));
+}
+
+HandlerResponse RequestHandler::handle_streaming(const http::request<http::string_body>& req) {
+    if (req.method() == http::verb::get) {
+        const std::string target = std::string(req.target());
+        const boost::urls::url_view url(target);
+        const std::string path(url.path());
+        if (path == "/get_historical_trades") {
+            return make_streamed_json_response(handle_historical_trades(url.params()),
+                                               req.version());
+        }
+        if (path == "/get_historical_bars") {
+            return make_streamed_json_response(handle_historical_bars(url.params()),
+                                               req.version());
+        }
+    }
+    return handle(req);
+}
+
+bj::object RequestHandler::handle_cache_stats() {
+    const auto stats = m_response_cache.stats();
+    bj::object res;
+    res["hits"] = stats.hits;
+    res["misses"] = stats.misses;
+    res["invalidations"] = stats.invalidations;
+    res["entries"] = stats.entries;
+    res["ttl_ms"] = m_response_cache_ttl.count();
+    return res;
 }
 
 bj::object RequestHandler::handle_login(const boost::urls::params_view& params) {
@@ -333,7 +505,8 @@ bj::object RequestHandler::handle_user_servers(const boost::urls::params_view& p
     return res;
 }
 
-bj::object RequestHandler::handle_historical_trades(const boost::urls::params_view& params) {
+std::variant<bj::object, BodyChunks>
+RequestHandler::handle_historical_trades(const boost::urls::params_view& params) {
     bj::object res;
 
     auto server_it = params.find("server");
@@ -345,42 +518,131 @@ bj::object RequestHandler::handle_historical_trades(const boost::urls::params_vi
 
     const std::string server_name = (*server_it).value;
     const std::string symbol = (*symbol_it).value;
+    if (!is_server_name_valid(server_name)) {
+        res["error"] = "Invalid server";
+        return res;
+    }
 
     auto after_ts_it = params.find("after_ts_ms");
-    std::expected<std::vector<database::DatabaseClient::HistoricalTradeRow>, std::string> result;
-    if (after_ts_it != params.end()) {
-        long long after_ts_ms{};
-        try {
-            after_ts_ms = std::stoll(std::string((*after_ts_it).value));
-        } catch (...) {
-            res["error"] = "Invalid after_ts_ms";
+    if (after_ts_it == params.end()) {
+        res["error"] = "No after_ts_ms specified";
+        return res;
+    }
+    long long after_ts_ms{};
+    try {
+        after_ts_ms = std::stoll(std::string((*after_ts_it).value));
+    } catch (...) {
+        res["error"] = "Invalid after_ts_ms";
+        return res;
+    }
+
+    // Without a limit every trade since after_ts_ms is returned, in one response
+    const auto limit = parse_page_limit(params);
+    if (!limit.has_value()) {
+        res["error"] = limit.error();
+        return res;
+    }
+
+    std::optional<database::DatabaseClient::TradeCursor> cursor;
+    if (auto cursor_it = params.find("cursor"); cursor_it != params.end()) {
+        cursor = decode_trade_cursor((*cursor_it).value);
+        if (!cursor.has_value()) {
+            res["error"] = "Invalid cursor";
             return res;
         }
-        result = m_db_client.query_trades(server_name, symbol, after_ts_ms);
+    }
+
+    // That response is still read from the database a page at a time, so only one page of trades
+    // is in memory however many trades it spans
+    auto result = m_db_client.query_trades_page(server_name, symbol, after_ts_ms, cursor,
+                                                limit.value().value_or(kMaxHistoricalPageSize));
+    if (!result.has_value()) {
+        std::cerr << result.error() << '\n';
+        res["error"] = "Internal server error";
+        return res;
+    }
+
+    bj::object head;
+    ChunkedJsonArray<database::DatabaseClient::HistoricalTradeRow>::NextRows next_trades;
+    if (limit.value().has_value()) {
+        // Passed back as cursor to fetch the next page; absent on the last one
+        if (result->next_cursor.has_value()) {
+            head["next_cursor"] = encode_trade_cursor(result->next_cursor.value());
+        }
     } else {
+        // Runs on a handler thread as chunks are pulled. A failure closes the connection, since
+        // the status line has gone out by then.
+        next_trades = [this, server_name, symbol, after_ts_ms,
+                       next_cursor = std::move(result->next_cursor)]() mutable {
+            if (!next_cursor.has_value()) {
+                return std::vector<database::DatabaseClient::HistoricalTradeRow>{};
+            }
+            auto page = m_db_client.query_trades_page(server_name, symbol, after_ts_ms,
+                                                      next_cursor, kMaxHistoricalPageSize);
+            if (!page.has_value()) {
+                throw std::runtime_error{page.error()};
+            }
+            next_cursor = std::move(page->next_cursor);
+            return std::move(page->trades);
+        };
+    }
+    return stream_json_array(head, "trades", std::move(result->trades), std::move(next_trades),
+                             serialize_trade);
+}
+
+std::variant<bj::object, BodyChunks>
+RequestHandler::handle_historical_bars(const boost::urls::params_view& params) {
+    bj::object res;
+
+    auto server_it = params.find("server");
+    auto symbol_it = params.find("symbol");
+    auto resolution_it = params.find("resolution");
+    if (server_it == params.end() || symbol_it == params.end() || resolution_it == params.end()) {
+        res["error"] = "Missing server, symbol or resolution";
+        return res;
+    }
+
+    const std::string server_name = (*server_it).value;
+    const std::string symbol = (*symbol_it).value;
+    if (!is_server_name_valid(server_name)) {
+        res["error"] = "Invalid server";
+        return res;
+    }
+
+    const std::string resolution = (*resolution_it).value;
+    if (!database::DatabaseClient::is_bar_resolution_valid(resolution)) {
+        res["error"] = "Invalid resolution";
+        return res;
+    }
+
+    auto after_ts_it = params.find("after_ts_ms");
+    if (after_ts_it == params.end()) {
         res["error"] = "No after_ts_ms specified";
         return res;
     }
+    long long after_ts_ms{};
+    try {
+        after_ts_ms = std::stoll(std::string((*after_ts_it).value));
+    } catch (...) {
+        res["error"] = "Invalid after_ts_ms";
+        return res;
+    }
+
+    const auto limit = parse_page_limit(params);
+    if (!limit.has_value()) {
+        res["error"] = limit.error();
+        return res;
+    }
+
+    auto result =
+        m_db_client.query_trade_bars(server_name, symbol, after_ts_ms, resolution, limit.value());
     if (!result.has_value()) {
         std::cerr << result.error() << '\n';
         res["error"] = "Internal server error";
         return res;
     }
 
-    bj::array trades;
-    const double trade_multiplier = core::constants::decimal_to_int_multiplier;
-    for (const auto& t : result.value()) {
-        bj::object trade;
-        trade["trade_id"] = t.trade_id;
-        trade["ticker"] = t.symbol;
-        trade["price"] = static_cast<double>(t.price) / trade_multiplier;
-        trade["quantity"] = static_cast<double>(t.quantity) / trade_multiplier;
-        trade["create_timestamp"] = t.ts_ms;
-        trades.emplace_back(std::move(trade));
-    }
-
-    res["trades"] = std::move(trades);
-    return res;
+    return stream_json_array(bj::object{}, "bars", std::move(result.value()), {}, serialize_bar);
 }
 
 bj::object RequestHandler::handle_account_details(const boost::urls::params_view& params) {
@@ -937,31 +1199,33 @@ bj::object RequestHandler::handle_create_server(const http::request<http::string
     }
 
     constexpr std::string_view kBotPassword = "eduxpassword";
+    std::vector<std::string> all_bot_usernames;
     for (auto& bot_cfg : bot_configs) {
         int running_index = 1;
         for (auto& group : bot_cfg.groups) {
             for (int i = 0; i < group.count; ++i) {
-                const std::string username = std::format("{}{}", bot_cfg.service_name, running_index++);
-                group.usernames.push_back(username);
-                auto user_result = m_db_client.get_user(username);
-                if (!user_result.has_value()) {
-                    res["error"] = user_result.error();
-                    return res;
-                }
-                if (user_result.value().has_value()) {
-                    group.user_ids.push_back(user_result.value()->user_id);
-                    continue;
-                }
-                auto create_user_result = m_db_client.create_user(username, kBotPassword);
-                if (!create_user_result.has_value()) {
-                    res["error"] = create_user_result.error();
-                    return res;
-                }
-                group.user_ids.push_back(create_user_result.value().user_id);
+                group.usernames.push_back(
+                    std::format("{}{}", bot_cfg.service_name, running_index++));
+                all_bot_usernames.push_back(group.usernames.back());
             }
         }
     }
 
+    // Look up and create every bot account in one transaction rather than one per bot
+    auto bot_ids_result = m_db_client.get_or_create_users(all_bot_usernames, kBotPassword);
+    if (!bot_ids_result.has_value()) {
+        res["error"] = bot_ids_result.error();
+        return res;
+    }
+    auto bot_id_it = bot_ids_result.value().begin();
+    for (auto& bot_cfg : bot_configs) {
+        for (auto& group : bot_cfg.groups) {
+            const auto group_size = static_cast<std::ptrdiff_t>(group.usernames.size());
+            group.user_ids.assign(bot_id_it, bot_id_it + group_size);
+            bot_id_it += group_size;
+        }
+    }
+
     std::vector<std::string> all_allowlist_names = allowlist_names;
     std::unordered_set<std::string> allowlist_set(all_allowlist_names.begin(), all_allowlist_names.end());
     for (const auto& bot_cfg : bot_configs) {
@@ -1110,14 +1374,8 @@ bj::object RequestHandler::handle_create_server(const http::request<http::string
     service_rows.push_back(
         database::DatabaseClient::ServiceInsertRow{machine_id, Service::oracle, oracle_port});
 
-    auto create_result =
-        m_db_client.create_server_with_services(server_name, caller_id, description, symbols,
-                                                 ids_result.value(), service_rows, initial_usd);
-    if (!create_result.has_value()) {
-        res["error"] = create_result.error();
-        return res;
-    }
-    int server_id = create_result.value();
+    // Starting balances and bot portfolios are written with the server, in its transaction
+    database::DatabaseClient::ServerSeedRows seed_rows;
 
     std::unordered_map<int, int> initial_usd_by_user_id;
     for (const int user_id : ids_result.value()) {
@@ -1138,11 +1396,7 @@ bj::object RequestHandler::handle_create_server(const http::request<http::string
     for (const auto& [user_id, user_initial_usd] : initial_usd_by_user_id) {
         const std::int64_t initial_usd_scaled =
             static_cast<std::int64_t>(user_initial_usd) * usd_multiplier;
-        auto balance_result = m_db_client.insert_balance(user_id, server_id, "USD", initial_usd_scaled);
-        if (!balance_result.has_value()) {
-            res["error"] = balance_result.error();
-            return res;
-        }
+        seed_rows.balances.push_back({user_id, "USD", initial_usd_scaled});
     }
 
     std::unordered_set<int> bot_user_ids;
@@ -1168,11 +1422,7 @@ bj::object RequestHandler::handle_create_server(const http::request<http::string
 
     for (const int user_id : non_bot_user_ids) {
         for (const auto& symbol : non_usd_active_symbols) {
-            auto balance_result = m_db_client.insert_balance(user_id, server_id, symbol, 0);
-            if (!balance_result.has_value()) {
-                res["error"] = balance_result.error();
-                return res;
-            }
+            seed_rows.balances.push_back({user_id, symbol, 0});
         }
     }
 
@@ -1191,25 +1441,25 @@ bj::object RequestHandler::handle_create_server(const http::request<http::string
                                                  : group.initial_inventory;
                     const std::int64_t inventory_scaled = static_cast<std::int64_t>(std::llround(
                         inventory * static_cast<double>(balance_multiplier)));
-                    auto balance_result =
-                        m_db_client.insert_balance(bot_user_id, server_id, symbol, inventory_scaled);
-                    if (!balance_result.has_value()) {
-                        res["error"] = balance_result.error();
-                        return res;
-                    }
+                    seed_rows.balances.push_back({bot_user_id, symbol, inventory_scaled});
                     bot_initial_portfolio_balance_scaled +=
                         inventory_scaled * kDefaultInitialTickerPriceUsd * balance_multiplier;
                 }
-                auto init_portfolio_result = m_db_client.upsert_init_bot_portfolio_balance(
-                    bot_user_id, server_id, bot_initial_portfolio_balance_scaled);
-                if (!init_portfolio_result.has_value()) {
-                    res["error"] = init_portfolio_result.error();
-                    return res;
-                }
+                seed_rows.init_bot_portfolio_balances.push_back(
+                    {bot_user_id, bot_initial_portfolio_balance_scaled});
             }
         }
     }
 
+    auto create_result = m_db_client.create_server_with_services(
+        server_name, caller_id, description, symbols, ids_result.value(), service_rows, initial_usd,
+        seed_rows);
+    if (!create_result.has_value()) {
+        res["error"] = create_result.error();
+        return res;
+    }
+    int server_id = create_result.value();
+
     // Now deploy the services - OMS can now read the server and allowlist from DB
     bj::object mdp_params;
     mdp_params["host"] = machine_ip;
@@ -5,8 +5,14 @@
 #include <boost/json.hpp>
 #include <boost/url.hpp>
 #include <core/constants.h>
+#include <chrono>
 #include <database/database_client.h>
+#include <functional>
+#include <optional>
 #include <string>
+#include <variant>
+
+#include "response_cache.h"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -14,14 +20,46 @@ namespace bj = boost::json;
 
 namespace backend {
 
+// Produces a response body piece by piece; returns nullopt after the last piece
+using BodyChunks = std::function<std::optional<std::string>()>;
+
+// Response sent with chunked transfer encoding. next_chunk is only called again once the previous
+// piece has been written, so at most one piece of the body is in memory at a time.
+struct ChunkedResponse {
+    http::response<http::empty_body> header;
+    BodyChunks next_chunk;
+};
+
+using HandlerResponse = std::variant<http::response<http::string_body>, ChunkedResponse>;
+
 class RequestHandler {
 public:
+    // Every handler thread runs its queries on a connection of its own, from the edux_core_db
+    // pool or the equally sized QuestDB pool.
+    // response_cache_ttl bounds how stale a polled endpoint can be; zero disables the cache.
+    explicit RequestHandler(const database::PgConnectionPoolConfig& db_pool_config = {},
+                            std::chrono::milliseconds response_cache_ttl = std::chrono::seconds{2})
+        : m_db_client{false, database::AsyncWriterConfig{}, db_pool_config,
+                      timeseries_db_pool_config(db_pool_config)},
+          m_response_cache_ttl{response_cache_ttl}, m_response_cache{response_cache_ttl} {}
+
     // Takes a parsed HTTP request, returns an HTTP response
     http::response<http::string_body> handle(const http::request<http::string_body>& req);
+    // Like handle(), but historical trades and bars come back as a ChunkedResponse so large
+    // downloads go out while they are being serialized
+    HandlerResponse handle_streaming(const http::request<http::string_body>& req);
     // Returns the underlying database client (e.g. for UAT seeding).
     database::DatabaseClient& get_db_client() { return m_db_client; }
 
 private:
+    static database::PgConnectionPoolConfig
+    timeseries_db_pool_config(const database::PgConnectionPoolConfig& db_pool_config) {
+        auto config = database::DatabaseClient::default_timeseries_db_pool_config();
+        config.size = db_pool_config.size;
+        config.checkout_timeout = db_pool_config.checkout_timeout;
+        return config;
+    }
+
     // Individual endpoint handlers
     bj::object handle_login(const boost::urls::params_view& params);
     bj::object handle_signup(const boost::urls::params_view& params);
@@ -29,11 +67,16 @@ private:
     bj::object handle_active_symbols(const boost::urls::params_view& params);
     bj::object handle_user_servers(const boost::urls::params_view& params);
     bj::object handle_account_details(const boost::urls::params_view& params);
-    bj::object handle_historical_trades(const boost::urls::params_view& params);
+    // Errors come back as an object, rows as a stream of JSON
+    std::variant<bj::object, BodyChunks>
+    handle_historical_trades(const boost::urls::params_view& params);
+    std::variant<bj::object, BodyChunks>
+    handle_historical_bars(const boost::urls::params_view& params);
     bj::object handle_server_mdp_endpoint(const boost::urls::params_view& params);
     bj::object handle_create_server(const http::request<http::string_body>& req);
     bj::object handle_configure_server(const http::request<http::string_body>& req);
     bj::object handle_remove_server(const http::request<http::string_body>& req);
+    bj::object handle_cache_stats();
 
     // Auth helper: returns the user_id of the requester if the
     // Authorization header carries a valid "Bearer <username>" token,
@@ -41,6 +84,8 @@ private:
     int authenticate_admin(const http::request<http::string_body>& req);
 
     database::DatabaseClient m_db_client;
+    const std::chrono::milliseconds m_response_cache_ttl;
+    ResponseCache m_response_cache;
 };
 
 } // namespace backend
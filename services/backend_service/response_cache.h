@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace backend {
+
+struct ResponseCacheStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t invalidations{0};
+    std::size_t entries{0};
+};
+
+// Read-through cache of rendered JSON response bodies, keyed by request target (path and query).
+// Entries expire after ttl and are all dropped by invalidate(), which the handlers call whenever
+// they change the data behind a cached endpoint. A ttl of zero disables caching.
+//
+// A body is only stored if no invalidation happened since the caller took generation() before
+// querying the database, so a slow read cannot put back data a concurrent write just replaced.
+class ResponseCache {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ResponseCache(std::chrono::milliseconds ttl, std::size_t max_entries = 4096)
+        : m_ttl{ttl}, m_max_entries{max_entries} {
+    }
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    bool enabled() const {
+        return m_ttl.count() > 0;
+    }
+
+    std::optional<std::string> find(const std::string& target) {
+        std::lock_guard lock{m_mutex};
+        const auto it = m_entries.find(target);
+        if (it == m_entries.end() || Clock::now() >= it->second.expiry) {
+            ++m_stats.misses;
+            return std::nullopt;
+        }
+        ++m_stats.hits;
+        return it->second.body;
+    }
+
+    std::uint64_t generation() const {
+        std::lock_guard lock{m_mutex};
+        return m_generation;
+    }
+
+    void store(const std::string& target, std::string body, std::uint64_t generation) {
+        if (!enabled()) {
+            return;
+        }
+        const auto now = Clock::now();
+        std::lock_guard lock{m_mutex};
+        if (generation != m_generation) {
+            return;
+        }
+        if (m_entries.size() >= m_max_entries && !m_entries.contains(target)) {
+            std::erase_if(m_entries, [now](const auto& entry) { return now >= entry.second.expiry; });
+            // Still full of live entries: start over rather than track recency
+            if (m_entries.size() >= m_max_entries) {
+                m_entries.clear();
+            }
+        }
+        m_entries.insert_or_assign(target, Entry{std::move(body), now + m_ttl});
+    }
+
+    void invalidate() {
+        std::lock_guard lock{m_mutex};
+        m_entries.clear();
+        ++m_generation;
+        ++m_stats.invalidations;
+    }
+
+    ResponseCacheStats stats() const {
+        std::lock_guard lock{m_mutex};
+        auto stats = m_stats;
+        stats.entries = m_entries.size();
+        return stats;
+    }
+
+  private:
+    struct Entry {
+        std::string body;
+        Clock::time_point expiry;
+    };
+
+    const std::chrono::milliseconds m_ttl;
+    const std::size_t m_max_entries;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::uint64_t m_generation{0};
+    ResponseCacheStats m_stats;
+};
+
+} // namespace backend
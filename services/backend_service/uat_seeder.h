@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
 #include <print>
@@ -34,32 +35,17 @@ public:
     bool seed() {
         std::println("[UAT] Seeding test data...");
 
-        struct UatUser { std::string name; std::string password; };
-        const std::vector<UatUser> uat_users = {
-            {"uat_admin",   "uat_pass"},
-            {"uat_trader1", "uat_pass"},
-            {"uat_trader2", "uat_pass"},
-        };
+        const std::vector<std::string> uat_usernames = {"uat_admin", "uat_trader1", "uat_trader2"};
 
-        for (const auto& u : uat_users) {
-            auto result = m_db.create_user(u.name, u.password);
-            if (!result.has_value()) {
-                // User might already exist from a previous unclean shutdown.
-                auto existing = m_db.get_user(u.name);
-                if (!existing.has_value() || !existing.value().has_value()) {
-                    std::println("[UAT] Error: cannot create or find user {}: {}",
-                                 u.name, result.error());
-                    return false;
-                }
-                m_uat_user_ids.push_back(existing.value()->user_id);
-                std::println("[UAT] Reusing existing user {} (id={})",
-                             u.name, existing.value()->user_id);
-            } else {
-                m_uat_user_ids.push_back(result.value().user_id);
-                std::println("[UAT] Created user {} (id={})",
-                             u.name, result.value().user_id);
-            }
+        // Users might already exist from a previous unclean shutdown; those are reused.
+        auto users_result = m_db.get_or_create_users(uat_usernames, "uat_pass");
+        if (!users_result.has_value()) {
+            std::println("[UAT] Error: cannot create or find users: {}", users_result.error());
+            return false;
         }
+        m_uat_user_ids = std::move(users_result.value());
+        for (std::size_t i = 0; i < uat_usernames.size(); ++i)
+            std::println("[UAT] Using user {} (id={})", uat_usernames[i], m_uat_user_ids[i]);
 
         // m_uat_user_ids: [0]=uat_admin [1]=uat_trader1 [2]=uat_trader2
         const int admin_id   = m_uat_user_ids[0];
@@ -95,8 +81,7 @@ public:
         const std::int64_t balance_multiplier_squared = static_cast<std::int64_t>(
             core::constants::decimal_to_int_multiplier * core::constants::decimal_to_int_multiplier);
         
-        struct BalanceSeed { int user_id; std::string symbol; std::int64_t balance; };
-        const std::vector<BalanceSeed> balances = {
+        std::vector<database::BalanceUpsertRow> balances = {
             {admin_id,   "USD",   100000}, {admin_id,   "AAPL",  50},
             {admin_id,   "GOOGL", 30},     {admin_id,   "TSLA",  20},
             {trader1_id, "USD",   85000},  {trader1_id, "AAPL",  100},
@@ -105,13 +90,13 @@ public:
             {trader2_id, "GOOGL", 60},     {trader2_id, "TSLA",  15},
         };
 
-        for (const auto& b : balances) {
-            const std::int64_t scaled_balance = b.balance * balance_multiplier_squared;
-            auto res = m_db.insert_balance(b.user_id, server_id, b.symbol, scaled_balance);
-            if (!res.has_value())
-                std::println("[UAT] Warning: balance insert failed (user={} sym={}): {}",
-                             b.user_id, b.symbol, res.error());
-        }
+        for (auto& b : balances)
+            b.balance *= balance_multiplier_squared;
+
+        // Upserted in one statement, so balances left by a previous run are reset too.
+        auto balances_result = m_db.upsert_balances(server_id, balances);
+        if (!balances_result.has_value())
+            std::println("[UAT] Warning: balance upsert failed: {}", balances_result.error());
 
         seed_trades(symbols);
 
@@ -24,6 +24,7 @@
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 #include <chrono>
 
 #include <sys/types.h>
@@ -127,6 +128,14 @@ static void start_backend() {
         f << "host = \"" << TEST_HOST << "\"\n";
         f << "port = " << TEST_PORT << "\n";
         f << "uat = false\n";
+        f << "io_threads = 2\n";
+        f << "handler_threads = 4\n";
+        f << "max_connections = 64\n";
+        f << "request_timeout_ms = 5000\n";
+        f << "db_pool_size = 4\n";
+        f << "db_checkout_timeout_ms = 1000\n";
+        // Tests reseed the database directly between requests, so responses are never cached
+        f << "response_cache_ttl_ms = 0\n";
     }
 
     g_backend_pid = fork();
@@ -459,6 +468,119 @@ TEST_F(BackendServiceTest, HistoricalTradesMissingServerParam) {
     EXPECT_TRUE(r.body.as_object().contains("error"));
 }
 
+TEST_F(BackendServiceTest, HistoricalTradesPageRespectsLimit) {
+    auto r = do_get(
+        "/get_historical_trades?server=test_server&symbol=AAPL&after_ts_ms=0&limit=1");
+    EXPECT_EQ(r.status, http::status::ok);
+    const auto& obj = r.body.as_object();
+    EXPECT_TRUE(obj.contains("trades") || obj.contains("error"));
+    if (obj.contains("trades")) {
+        EXPECT_LE(obj.at("trades").as_array().size(), 1u);
+    }
+}
+
+TEST_F(BackendServiceTest, HistoricalTradesAreSentChunked) {
+    net::io_context   ioc;
+    tcp::resolver     resolver{ioc};
+    beast::tcp_stream stream{ioc};
+    stream.connect(resolver.resolve(TEST_HOST, std::to_string(TEST_PORT)));
+
+    http::request<http::string_body> req{
+        http::verb::get, "/get_historical_trades?server=test_server&symbol=AAPL&after_ts_ms=0",
+        11};
+    req.set(http::field::host,       TEST_HOST);
+    req.set(http::field::connection, "close");
+    http::write(stream, req);
+
+    beast::flat_buffer                buf;
+    http::response<http::string_body> res;
+    http::read(stream, buf, res);
+    EXPECT_EQ(res.result(), http::status::ok);
+    const auto obj = json::parse(res.body()).as_object();
+    // Errors are answered whole; only rows are streamed
+    if (obj.contains("trades"))
+        EXPECT_TRUE(res.chunked());
+    else
+        EXPECT_TRUE(obj.contains("error"));
+
+    beast::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+
+TEST_F(BackendServiceTest, HistoricalTradesRejectsInvalidLimitAndCursor) {
+    auto zero_limit = do_get(
+        "/get_historical_trades?server=test_server&symbol=AAPL&after_ts_ms=0&limit=0");
+    EXPECT_TRUE(zero_limit.body.as_object().contains("error"));
+
+    auto bad_cursor = do_get(
+        "/get_historical_trades?server=test_server&symbol=AAPL&after_ts_ms=0&cursor=abc");
+    EXPECT_TRUE(bad_cursor.body.as_object().contains("error"));
+}
+
+// ── GET /get_historical_bars ──────────────────────────────────────────────────
+
+TEST_F(BackendServiceTest, HistoricalBarsResponseIsStructurallyValid) {
+    // As for trades, QuestDB may not be running; either shape is acceptable.
+    auto r = do_get(
+        "/get_historical_bars?server=test_server&symbol=AAPL&after_ts_ms=0&resolution=1m");
+    EXPECT_EQ(r.status, http::status::ok);
+    const auto& obj = r.body.as_object();
+    EXPECT_TRUE(obj.contains("bars") || obj.contains("error"));
+    if (obj.contains("bars")) {
+        EXPECT_TRUE(obj.at("bars").is_array());
+    }
+}
+
+TEST_F(BackendServiceTest, HistoricalBarsRejectsInvalidResolution) {
+    auto r = do_get(
+        "/get_historical_bars?server=test_server&symbol=AAPL&after_ts_ms=0&resolution=1m;DROP");
+    EXPECT_EQ(r.status, http::status::ok);
+    EXPECT_TRUE(r.body.as_object().contains("error"));
+}
+
+// ── GET /cache_stats ──────────────────────────────────────────────────────────
+
+TEST_F(BackendServiceTest, CacheStatsReportsCounters) {
+    auto r = do_get("/cache_stats");
+    EXPECT_EQ(r.status, http::status::ok);
+    const auto& obj = r.body.as_object();
+    for (const auto* key : {"hits", "misses", "invalidations", "entries", "ttl_ms"})
+        EXPECT_TRUE(obj.contains(key)) << key;
+    // Caching is disabled for these tests
+    EXPECT_EQ(obj.at("entries").to_number<std::int64_t>(), 0);
+}
+
+// ── Connection handling ───────────────────────────────────────────────────────
+
+TEST_F(BackendServiceTest, KeepAliveAnswersPipelinedRequestsInOrder) {
+    net::io_context   ioc;
+    tcp::resolver     resolver{ioc};
+    beast::tcp_stream stream{ioc};
+    stream.connect(resolver.resolve(TEST_HOST, std::to_string(TEST_PORT)));
+
+    // Both requests go out before either response is read
+    const std::vector<std::string> targets{"/active_servers", "/cache_stats"};
+    for (const auto& target : targets) {
+        http::request<http::string_body> req{http::verb::get, target, 11};
+        req.set(http::field::host, TEST_HOST);
+        http::write(stream, req);
+    }
+
+    beast::flat_buffer buf;
+    for (const auto& target : targets) {
+        http::response<http::string_body> res;
+        http::read(stream, buf, res);
+        EXPECT_EQ(res.result(), http::status::ok) << target;
+        EXPECT_TRUE(res.keep_alive()) << target;
+        const auto body = json::parse(res.body()).as_object();
+        // Only /cache_stats reports a ttl
+        EXPECT_EQ(body.contains("ttl_ms"), target == "/cache_stats") << target;
+    }
+
+    beast::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+
 // ── POST /create_server ───────────────────────────────────────────────────────
 
 TEST_F(BackendServiceTest, CreateServerSuccess) {
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "chunked_json.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+void serialize_int(const int& row, std::string& out) {
+    out += std::to_string(row);
+}
+
+std::vector<std::string> drain(backend::ChunkedJsonArray<int>& array) {
+    std::vector<std::string> chunks;
+    while (auto chunk = array.next()) {
+        chunks.push_back(std::move(chunk.value()));
+    }
+    return chunks;
+}
+
+std::string join(const std::vector<std::string>& chunks) {
+    std::string joined;
+    for (const auto& chunk : chunks) {
+        joined += chunk;
+    }
+    return joined;
+}
+
+} // namespace
+
+TEST(ChunkedJsonArrayTest, RendersEmptyArrayInOneChunk) {
+    backend::ChunkedJsonArray<int> array{"", "trades", {}, serialize_int};
+    const auto chunks = drain(array);
+    ASSERT_EQ(chunks.size(), 1u);
+    EXPECT_EQ(chunks[0], R"({"trades":[]})");
+}
+
+TEST(ChunkedJsonArrayTest, PlacesHeadBeforeArray) {
+    backend::ChunkedJsonArray<int> array{R"("next_cursor":"7:T1")", "trades", {1, 2, 3},
+                                         serialize_int};
+    EXPECT_EQ(join(drain(array)), R"({"next_cursor":"7:T1","trades":[1,2,3]})");
+}
+
+TEST(ChunkedJsonArrayTest, SplitsRowsAcrossChunks) {
+    std::vector<int> rows;
+    std::string expected = R"({"bars":[)";
+    for (int i = 0; i < 1000; ++i) {
+        rows.push_back(i);
+        expected += (i > 0 ? "," : "") + std::to_string(i);
+    }
+    expected += "]}";
+
+    backend::ChunkedJsonArray<int> array{"", "bars", rows, serialize_int, 64};
+    const auto chunks = drain(array);
+    EXPECT_GT(chunks.size(), 10u);
+    for (const auto& chunk : chunks) {
+        EXPECT_FALSE(chunk.empty());
+        // A chunk ends after the row crossing the limit, and rows here are at most 4 bytes
+        EXPECT_LE(chunk.size(), 64u + 5u);
+    }
+    EXPECT_EQ(join(chunks), expected);
+}
+
+TEST(ChunkedJsonArrayTest, StaysFinished) {
+    backend::ChunkedJsonArray<int> array{"", "trades", {1}, serialize_int};
+    drain(array);
+    EXPECT_FALSE(array.next().has_value());
+}
+
+TEST(ChunkedJsonArrayTest, FetchesPagesOneAtATime) {
+    int fetched_page_count = 0;
+    backend::ChunkedJsonArray<int> array{"",
+                                         "trades",
+                                         {1, 2},
+                                         [&fetched_page_count] {
+                                             ++fetched_page_count;
+                                             return fetched_page_count == 1 ? std::vector<int>{3}
+                                                                            : std::vector<int>{};
+                                         },
+                                         serialize_int,
+                                         1};
+
+    // Every chunk holds a single row, so the first page is not yet rendered after its first row
+    EXPECT_EQ(array.next(), R"({"trades":[)");
+    EXPECT_EQ(array.next(), "1");
+    EXPECT_EQ(fetched_page_count, 0);
+
+    std::string rest;
+    while (auto next_chunk = array.next()) {
+        rest += next_chunk.value();
+    }
+    EXPECT_EQ(rest, ",2,3]}");
+    EXPECT_EQ(fetched_page_count, 2);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "response_cache.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(ResponseCacheTest, ServesStoredBodyUntilExpiry) {
+    backend::ResponseCache cache{50ms};
+    EXPECT_FALSE(cache.find("/active_servers").has_value());
+
+    cache.store("/active_servers", R"({"servers":[]})", cache.generation());
+    auto body = cache.find("/active_servers");
+    ASSERT_TRUE(body.has_value());
+    EXPECT_EQ(body.value(), R"({"servers":[]})");
+
+    std::this_thread::sleep_for(60ms);
+    EXPECT_FALSE(cache.find("/active_servers").has_value());
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST(ResponseCacheTest, KeysIncludeTheQuery) {
+    backend::ResponseCache cache{1s};
+    cache.store("/active_symbols?server_name=a", "a", cache.generation());
+    EXPECT_FALSE(cache.find("/active_symbols?server_name=b").has_value());
+    EXPECT_EQ(cache.find("/active_symbols?server_name=a").value_or(""), "a");
+}
+
+TEST(ResponseCacheTest, InvalidateDropsEntries) {
+    backend::ResponseCache cache{1s};
+    cache.store("/active_servers", "old", cache.generation());
+    cache.invalidate();
+
+    EXPECT_FALSE(cache.find("/active_servers").has_value());
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+    EXPECT_EQ(cache.stats().entries, 0u);
+}
+
+TEST(ResponseCacheTest, StoreFromBeforeAnInvalidationIsDiscarded) {
+    backend::ResponseCache cache{1s};
+    // A read starts, a write invalidates, then the read finishes with what it saw before
+    const auto generation = cache.generation();
+    cache.invalidate();
+    cache.store("/active_servers", "stale", generation);
+
+    EXPECT_FALSE(cache.find("/active_servers").has_value());
+}
+
+TEST(ResponseCacheTest, ZeroTtlDisablesCaching) {
+    backend::ResponseCache cache{0ms};
+    EXPECT_FALSE(cache.enabled());
+    cache.store("/active_servers", "body", cache.generation());
+    EXPECT_FALSE(cache.find("/active_servers").has_value());
+}
+
+TEST(ResponseCacheTest, StaysWithinMaxEntries) {
+    backend::ResponseCache cache{1s, 2};
+    cache.store("/user_servers?user_name=a", "a", cache.generation());
+    cache.store("/user_servers?user_name=b", "b", cache.generation());
+    cache.store("/user_servers?user_name=c", "c", cache.generation());
+
+    EXPECT_LE(cache.stats().entries, 2u);
+    EXPECT_EQ(cache.find("/user_servers?user_name=c").value_or(""), "c");
+}
@@ -1,17 +1,71 @@
 #include "market_data_processor.h"
 
 namespace mdp {
+void StageLatencies::record(const uint64_t publish_ns, const uint64_t pop_ns,
+                            const uint64_t encoded_ns, const uint64_t sent_ns) {
+    // Producers that predate stamping leave publish_ns at zero
+    if (publish_ns != 0 && pop_ns >= publish_ns) {
+        in_shm.record(pop_ns - publish_ns);
+        total.record(sent_ns - publish_ns);
+    }
+    encode.record(encoded_ns - pop_ns);
+    send.record(sent_ns - encoded_ns);
+}
+
+void StageLatencies::report(spdlog::logger& logger, const std::string_view stream) const {
+    if (encode.count() == 0) {
+        return;
+    }
+    logger.info("[Latency] {} in_shm: {}", stream, in_shm.summary());
+    logger.info("[Latency] {} encode: {}", stream, encode.summary());
+    logger.info("[Latency] {} send: {}", stream, send.summary());
+    logger.info("[Latency] {} total: {}", stream, total.summary());
+}
+
+void StageLatencies::reset() {
+    in_shm.reset();
+    encode.reset();
+    send.reset();
+    total.reset();
+}
+
+namespace {
+std::string join_ids(const std::vector<int>& ids) {
+    std::string joined;
+    for (const auto id : ids) {
+        if (!joined.empty()) {
+            joined += ",";
+        }
+        joined += std::to_string(id);
+    }
+    return joined;
+}
+
+bool same_top_of_book(const TopOrderBookLevelAggregates& lhs,
+                      const TopOrderBookLevelAggregates& rhs) {
+    const auto same_level = [](const LevelAggregate& l, const LevelAggregate& r) {
+        return l.price == r.price && l.quantity == r.quantity;
+    };
+    return same_level(lhs.bid_level_aggregates[0], rhs.bid_level_aggregates[0]) &&
+           same_level(lhs.ask_level_aggregates[0], rhs.ask_level_aggregates[0]);
+}
+} // namespace
+
 MarketDataProcessor::MarketDataProcessor(const MdpConfig& config)
-    : websocket_server(config.ws_port, config.host, logger) {
-    orderbook_snapshot_ring_buffers.reserve(config.active_symbols.size());
+    : websocket_server(config.ws_port, config.host, logger),
+      client_message_notifier{std::make_shared<core::MessageNotifier>()},
+      subscription_router{config.active_symbols} {
+    orderbook_snapshot_slots.reserve(config.active_symbols.size());
     trade_ring_buffers.reserve(config.active_symbols.size());
     for (const auto& symbol : config.active_symbols) {
-        orderbook_snapshot_ring_buffers.emplace_back(
-            OrderbookSnapshotRingBuffer::create(std::format(
-                "{}_{}_{}", symbol, core::constants::ORDERBOOK_SNAPSHOT_SHM_FILE, SERVER_NAME)));
-        trade_ring_buffers.emplace_back(TradeRingBuffer::create(
+        orderbook_snapshot_slots.emplace_back(OrderbookSnapshotSlot::create(std::format(
+            "{}_{}_{}", symbol, core::constants::ORDERBOOK_SNAPSHOT_SHM_FILE, SERVER_NAME)));
+        trade_ring_buffers.emplace_back(TradeBroadcastRingBuffer::create(
             std::format("{}_{}_{}", symbol, core::constants::TRADE_SHM_FILE, SERVER_NAME)));
     }
+    last_orderbook_snapshot_sequences.assign(orderbook_snapshot_slots.size(), 0);
+    last_orderbook_snapshots.resize(orderbook_snapshot_slots.size());
+    websocket_server.set_message_notifier(client_message_notifier);
 }
 
 [[noreturn]] void MarketDataProcessor::start() {
@@ -20,51 +74,198 @@ MarketDataProcessor::MarketDataProcessor(const MdpConfig& config)
     }
     logger->info("MDP started");
 
+    auto last_latency_report = std::chrono::steady_clock::now();
     while (true) {
-        // publish orderbook snapshot
-        for (auto& orderbook_snapshot_ring_buffer : orderbook_snapshot_ring_buffers) {
-            auto orderbook_snapshot_res = orderbook_snapshot_ring_buffer.try_pop();
+        // Subscriptions first, so a new subscriber gets the updates popped below
+        if (const auto ticket = client_message_notifier->ticket();
+            ticket != handled_client_message_ticket) {
+            handled_client_message_ticket = ticket;
+            handle_client_messages();
+        }
+
+        // publish orderbook snapshot, skipping any intermediate books overwritten while we lagged
+        for (std::size_t i = 0; i < orderbook_snapshot_slots.size(); ++i) {
+            auto orderbook_snapshot_res =
+                orderbook_snapshot_slots[i].try_load_newer(last_orderbook_snapshot_sequences[i]);
             if (orderbook_snapshot_res.has_value()) {
-                orderbook_snapshot_res.value().to_json(orderbook_snapshot_json);
-                auto res = websocket_server.send_to_all(orderbook_snapshot_json.dump(),
-                                                        transport::MessageFormat::text);
-                logger->info(orderbook_snapshot_json.dump());
-                logger->info("Orderbook snapshot sent");
-
-                if (!res.has_value()) {
-                    auto failed_ids = res.error();
-                    std::string error_msg =
-                        "MDP failed to publish orderbook snapshot to client id=";
-                    for (const auto id : failed_ids) {
-                        error_msg += std::to_string(id);
-                        if (id != failed_ids.back()) {
-                            error_msg += ",";
-                        }
-                    }
-                    logger->error(error_msg);
-                }
+                publish_orderbook_snapshot(i, orderbook_snapshot_res.value());
             }
         }
         // publish public trades
-        for (auto& trade_ring_buffer : trade_ring_buffers) {
+        for (std::size_t i = 0; i < trade_ring_buffers.size(); ++i) {
+            auto& trade_ring_buffer = trade_ring_buffers[i];
+            const auto dropped_before = trade_ring_buffer.dropped();
             auto trade_res = trade_ring_buffer.try_pop();
+            if (const auto dropped = trade_ring_buffer.dropped() - dropped_before; dropped > 0) {
+                logger->warn("MDP lagged behind trade stream, dropped {} trades", dropped);
+            }
             if (trade_res.has_value()) {
-                trade_res.value().to_json(trade_json);
-                auto res =
-                    websocket_server.send_to_all(trade_json.dump(), transport::MessageFormat::text);
-                if (!res.has_value()) {
-                    auto failed_ids = res.error();
-                    std::string error_msg = "MDP failed to publish trade to client id=";
-                    for (const auto id : failed_ids) {
-                        error_msg += std::to_string(id);
-                        if (id != failed_ids.back()) {
-                            error_msg += ",";
-                        }
-                    }
-                    logger->error(error_msg);
-                }
+                publish_trade(i, trade_res.value());
+            }
+        }
+
+        if (const auto now = std::chrono::steady_clock::now();
+            now - last_latency_report >= latency_report_interval) {
+            orderbook_snapshot_latencies.report(*logger, "orderbook_snapshot");
+            trade_latencies.report(*logger, "trade");
+            orderbook_snapshot_latencies.reset();
+            trade_latencies.reset();
+            prune_closed_connections();
+            last_latency_report = now;
+        }
+    }
+}
+
+void MarketDataProcessor::handle_client_messages() {
+    const int first_new_id = next_connection_id;
+    for (const auto id : websocket_server.get_connection_ids()) {
+        if (id >= first_new_id) {
+            next_connection_id = std::max(next_connection_id, id + 1);
+            if (!is_connection_closed(id)) {
+                unsubscribed_connection_ids.push_back(id);
             }
         }
+        while (auto message = websocket_server.dequeue_message(id)) {
+            handle_client_message(id, message.value());
+        }
+    }
+}
+
+void MarketDataProcessor::handle_client_message(const int connection_id,
+                                                const std::string_view message) {
+    auto request = parse_subscription_request(message);
+    if (!request.has_value()) {
+        logger->warn("MDP ignored request from client id={}: {}", connection_id, request.error());
+        websocket_server.send(connection_id, make_subscription_error(request.error()),
+                              transport::MessageFormat::text);
+        return;
+    }
+
+    const auto& subscription = request.value().subscription;
+    if (!request.value().subscribe) {
+        subscription_router.unsubscribe(connection_id, subscription);
+        websocket_server.send(connection_id, make_subscription_ack(request.value()),
+                              transport::MessageFormat::text);
+        return;
+    }
+
+    if (auto res = subscription_router.subscribe(connection_id, subscription); !res.has_value()) {
+        logger->warn("MDP rejected subscription from client id={}: {}", connection_id,
+                     res.error());
+        websocket_server.send(connection_id, make_subscription_error(res.error()),
+                              transport::MessageFormat::text);
+        return;
+    }
+    std::erase(unsubscribed_connection_ids, connection_id);
+    logger->info("Client id={} subscribed to {} {}", connection_id, subscription.symbol,
+                 channel_name(subscription.channel));
+    websocket_server.send(connection_id, make_subscription_ack(request.value()),
+                          transport::MessageFormat::text);
+
+    // The book may not change for a while, so start the subscriber off with the latest one
+    const auto slot = subscription_router.symbol_index(subscription.symbol).value();
+    if (subscription.channel == Channel::trades || !last_orderbook_snapshots[slot].has_value()) {
+        return;
+    }
+    const auto levels = subscription.channel == Channel::depth ? subscription.levels : 1;
+    last_orderbook_snapshots[slot].value().to_json(routed_json, levels);
+    routed_json["channel"] = std::string{channel_name(subscription.channel)};
+    websocket_server.send(connection_id, routed_json.dump(), transport::MessageFormat::text);
+}
+
+void MarketDataProcessor::publish_orderbook_snapshot(const std::size_t slot,
+                                                     TopOrderBookLevelAggregates& snapshot) {
+    const auto pop_ns = core::steady_clock_ns();
+    const auto& routes = subscription_router.routes(slot);
+
+    // Only encode what some client is going to receive
+    const bool has_unsubscribed = !unsubscribed_connection_ids.empty();
+    std::string payload;
+    if (has_unsubscribed) {
+        snapshot.to_json(orderbook_snapshot_json);
+        payload = orderbook_snapshot_json.dump();
+    }
+    routed_payloads.clear();
+    for (const auto& [levels, connection_ids] : routes.depth) {
+        snapshot.to_json(routed_json, levels);
+        routed_json["channel"] = std::string{channel_name(Channel::depth)};
+        routed_payloads.emplace_back(&connection_ids, routed_json.dump());
+    }
+    const auto& last_snapshot = last_orderbook_snapshots[slot];
+    if (!routes.top_of_book.empty() &&
+        (!last_snapshot.has_value() || !same_top_of_book(last_snapshot.value(), snapshot))) {
+        snapshot.to_json(routed_json, 1);
+        routed_json["channel"] = std::string{channel_name(Channel::top_of_book)};
+        routed_payloads.emplace_back(&routes.top_of_book, routed_json.dump());
+    }
+    const auto encoded_ns = core::steady_clock_ns();
+
+    if (has_unsubscribed) {
+        send_to(unsubscribed_connection_ids, payload, "orderbook snapshot");
+        logger->info(payload);
+    }
+    for (const auto& [connection_ids, routed_payload] : routed_payloads) {
+        send_to(*connection_ids, routed_payload, "orderbook snapshot");
+    }
+    orderbook_snapshot_latencies.record(snapshot.publish_timestamp_ns, pop_ns, encoded_ns,
+                                        core::steady_clock_ns());
+    logger->info("Orderbook snapshot sent");
+    last_orderbook_snapshots[slot] = snapshot;
+}
+
+void MarketDataProcessor::publish_trade(const std::size_t slot, Trade& trade) {
+    const auto pop_ns = core::steady_clock_ns();
+    const auto& routes = subscription_router.routes(slot);
+
+    const bool has_unsubscribed = !unsubscribed_connection_ids.empty();
+    if (!has_unsubscribed && routes.trades.empty()) {
+        return;
+    }
+    trade.to_json(trade_json);
+    const auto payload = has_unsubscribed ? trade_json.dump() : std::string{};
+    std::string routed_payload;
+    if (!routes.trades.empty()) {
+        trade_json["channel"] = std::string{channel_name(Channel::trades)};
+        routed_payload = trade_json.dump();
+    }
+    const auto encoded_ns = core::steady_clock_ns();
+
+    if (has_unsubscribed) {
+        send_to(unsubscribed_connection_ids, payload, "trade");
+    }
+    send_to(routes.trades, routed_payload, "trade");
+    trade_latencies.record(trade.publish_timestamp_ns, pop_ns, encoded_ns,
+                           core::steady_clock_ns());
+}
+
+bool MarketDataProcessor::is_connection_closed(const int connection_id) const {
+    const auto connection = websocket_server.get_metadata(connection_id);
+    return !connection || connection->get_status() == transport::ConnectionStatus::closed ||
+           connection->get_status() == transport::ConnectionStatus::failed;
+}
+
+// Closed connections stay in the server's map, so they are forgotten here
+void MarketDataProcessor::prune_closed_connections() {
+    for (const auto id : subscription_router.connection_ids()) {
+        if (is_connection_closed(id)) {
+            logger->info("Dropping the subscriptions of closed client id={}", id);
+            subscription_router.remove_connection(id);
+        }
+    }
+    std::erase_if(unsubscribed_connection_ids,
+                  [this](const int id) { return is_connection_closed(id); });
+}
+
+void MarketDataProcessor::send_to(const std::vector<int>& connection_ids,
+                                  const std::string& payload, const std::string_view what) {
+    std::vector<int> failed_ids;
+    for (const auto id : connection_ids) {
+        if (!websocket_server.send(id, payload, transport::MessageFormat::text).has_value()) {
+            failed_ids.push_back(id);
+        }
+    }
+    if (!failed_ids.empty()) {
+        logger->error("MDP failed to publish {} to client id={}", what, join_ids(failed_ids));
     }
 }
-} // namespace mdp
\ No newline at end of file
+} // namespace mdp
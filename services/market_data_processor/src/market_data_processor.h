@@ -1,26 +1,73 @@
 #pragma once
 
 #include "configuration/mdp_config.h"
+#include "core/latency_histogram.h"
+#include "core/message_notifier.h"
 #include "core/orderbook_snapshot.h"
 #include "core/trade.h"
 #include "nlohmann/json.hpp"
 #include "logger/logger.h"
+#include "subscription_router.h"
 #include "websocket_server.h"
+#include <algorithm>
+#include <optional>
+#include <utility>
 #include <vector>
 
 using json = nlohmann::json;
 
 namespace mdp {
+// Per-stage latency of one stream, from the engine's publish stamp to the websocket send.
+struct StageLatencies {
+    core::LatencyHistogram in_shm; // engine publish -> MDP pop
+    core::LatencyHistogram encode; // MDP pop -> JSON encoded
+    core::LatencyHistogram send;   // JSON encoded -> handed to every websocket client
+    core::LatencyHistogram total;  // engine publish -> handed to every websocket client
+
+    void record(uint64_t publish_ns, uint64_t pop_ns, uint64_t encoded_ns, uint64_t sent_ns);
+    void report(spdlog::logger& logger, std::string_view stream) const;
+    void reset();
+};
+
 class MarketDataProcessor {
   private:
     std::shared_ptr<spdlog::logger> logger = logger::create_logger(
         "mdp_logger",
         std::format("{}/logs/{}/mdp.log", std::string(PROJECT_SOURCE_DIR), SERVER_NAME));
-    std::vector<OrderbookSnapshotRingBuffer> orderbook_snapshot_ring_buffers;
-    std::vector<TradeRingBuffer> trade_ring_buffers;
+    std::vector<OrderbookSnapshotSlot> orderbook_snapshot_slots;
+    std::vector<std::uint64_t> last_orderbook_snapshot_sequences; // One per slot
+    std::vector<TradeBroadcastRingBuffer> trade_ring_buffers;
     transport::WebsocketManagerServer websocket_server;
     json orderbook_snapshot_json;
     json trade_json;
+    json routed_json;
+
+    // The loop polls rather than waits, client requests are drained whenever the ticket moves on
+    std::shared_ptr<core::MessageNotifier> client_message_notifier;
+    core::MessageNotifier::Ticket handled_client_message_ticket{0};
+    SubscriptionRouter subscription_router;
+    // Open connections that never subscribed, which still receive every message
+    std::vector<int> unsubscribed_connection_ids;
+    // The server hands out connection ids in increasing order, every id below this has been seen
+    int next_connection_id{0};
+    // Latest book per slot, sent to new depth and top of book subscribers straight away
+    std::vector<std::optional<TopOrderBookLevelAggregates>> last_orderbook_snapshots;
+    // Reused per snapshot, encoded depth and top of book payloads with their subscribers
+    std::vector<std::pair<const std::vector<int>*, std::string>> routed_payloads;
+
+    static constexpr std::chrono::seconds latency_report_interval{10};
+    StageLatencies orderbook_snapshot_latencies;
+    StageLatencies trade_latencies;
+
+    void handle_client_messages();
+    void handle_client_message(int connection_id, std::string_view message);
+    void publish_orderbook_snapshot(std::size_t slot, TopOrderBookLevelAggregates& snapshot);
+    void publish_trade(std::size_t slot, Trade& trade);
+    bool is_connection_closed(int connection_id) const;
+    void prune_closed_connections();
+
+    void send_to(const std::vector<int>& connection_ids, const std::string& payload,
+                 std::string_view what);
 
   public:
     MarketDataProcessor(const MdpConfig& config);
@@ -0,0 +1,198 @@
+#include "subscription_router.h"
+
+#include "core/constants.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <format>
+
+using json = nlohmann::json;
+
+namespace mdp {
+std::string_view channel_name(const Channel channel) {
+    switch (channel) {
+    case Channel::trades:
+        return "trades";
+    case Channel::depth:
+        return "depth";
+    case Channel::top_of_book:
+        return "top_of_book";
+    }
+    return "unknown";
+}
+
+std::expected<SubscriptionRequest, std::string>
+parse_subscription_request(const std::string_view message) {
+    const auto j = json::parse(message, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        return std::unexpected{std::string{"Request is not a JSON object"}};
+    }
+
+    const auto op = j.find("op");
+    const auto symbol = j.find("symbol");
+    const auto channel = j.find("channel");
+    if (op == j.end() || !op->is_string() || symbol == j.end() || !symbol->is_string() ||
+        channel == j.end() || !channel->is_string()) {
+        return std::unexpected{std::string{"Request needs string op, symbol and channel"}};
+    }
+
+    SubscriptionRequest request{};
+    if (*op == "subscribe") {
+        request.subscribe = true;
+    } else if (*op == "unsubscribe") {
+        request.subscribe = false;
+    } else {
+        return std::unexpected{std::format("Unknown op {}", op->get<std::string>())};
+    }
+    request.subscription.symbol = symbol->get<std::string>();
+
+    if (*channel == "trades") {
+        request.subscription.channel = Channel::trades;
+    } else if (*channel == "depth") {
+        request.subscription.channel = Channel::depth;
+    } else if (*channel == "top_of_book") {
+        request.subscription.channel = Channel::top_of_book;
+    } else {
+        return std::unexpected{std::format("Unknown channel {}", channel->get<std::string>())};
+    }
+
+    constexpr auto max_levels =
+        static_cast<std::size_t>(core::constants::ORDER_BOOK_AGGREGATE_LEVELS);
+    const auto levels = j.find("levels");
+    if (request.subscription.channel != Channel::depth) {
+        if (levels != j.end()) {
+            return std::unexpected{std::string{"levels only applies to the depth channel"}};
+        }
+    } else if (levels == j.end()) {
+        request.subscription.levels = max_levels;
+    } else if (!levels->is_number_unsigned() || *levels == 0 || *levels > max_levels) {
+        return std::unexpected{std::format("levels must be between 1 and {}", max_levels)};
+    } else {
+        request.subscription.levels = levels->get<std::size_t>();
+    }
+    return request;
+}
+
+std::string make_subscription_ack(const SubscriptionRequest& request) {
+    json ack{{"op", request.subscribe ? "subscribed" : "unsubscribed"},
+             {"symbol", request.subscription.symbol},
+             {"channel", std::string{channel_name(request.subscription.channel)}}};
+    if (request.subscription.channel == Channel::depth && request.subscribe) {
+        ack["levels"] = request.subscription.levels;
+    }
+    return ack.dump();
+}
+
+std::string make_subscription_error(const std::string_view error) {
+    return json{{"op", "error"}, {"error", std::string{error}}}.dump();
+}
+
+SubscriptionRouter::SubscriptionRouter(const std::vector<std::string>& symbols)
+    : m_routes(symbols.size()) {
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        m_symbol_indices.emplace(symbols[i], i);
+    }
+}
+
+std::expected<void, std::string> SubscriptionRouter::subscribe(const int connection_id,
+                                                               const Subscription& subscription) {
+    const auto index = symbol_index(subscription.symbol);
+    if (!index.has_value()) {
+        return std::unexpected{std::format("Unknown symbol {}", subscription.symbol)};
+    }
+
+    auto& subscriptions = m_subscriptions[connection_id];
+    if (subscription.channel == Channel::depth) {
+        // Replaces the levels of an existing depth subscription
+        unsubscribe(connection_id, subscription);
+    }
+    if (subscriptions.insert(subscription).second) {
+        add_route(index.value(), connection_id, subscription);
+    }
+    return {};
+}
+
+void SubscriptionRouter::unsubscribe(const int connection_id, const Subscription& subscription) {
+    const auto index = symbol_index(subscription.symbol);
+    const auto subscriptions = m_subscriptions.find(connection_id);
+    if (!index.has_value() || subscriptions == m_subscriptions.end()) {
+        return;
+    }
+
+    // Depth is matched on symbol alone, whatever levels it was subscribed with
+    const auto existing = std::ranges::find_if(subscriptions->second, [&](const auto& s) {
+        return s.symbol == subscription.symbol && s.channel == subscription.channel &&
+               (s.channel == Channel::depth || s.levels == subscription.levels);
+    });
+    if (existing != subscriptions->second.end()) {
+        remove_route(index.value(), connection_id, *existing);
+        subscriptions->second.erase(existing);
+    }
+}
+
+void SubscriptionRouter::remove_connection(const int connection_id) {
+    const auto subscriptions = m_subscriptions.find(connection_id);
+    if (subscriptions == m_subscriptions.end()) {
+        return;
+    }
+    for (const auto& subscription : subscriptions->second) {
+        remove_route(symbol_index(subscription.symbol).value(), connection_id, subscription);
+    }
+    m_subscriptions.erase(subscriptions);
+}
+
+std::vector<int> SubscriptionRouter::connection_ids() const {
+    std::vector<int> ids;
+    ids.reserve(m_subscriptions.size());
+    for (const auto& [id, subscriptions] : m_subscriptions) {
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+std::optional<std::size_t> SubscriptionRouter::symbol_index(const std::string_view symbol) const {
+    const auto it = m_symbol_indices.find(std::string{symbol});
+    if (it == m_symbol_indices.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void SubscriptionRouter::add_route(const std::size_t symbol_index, const int connection_id,
+                                   const Subscription& subscription) {
+    auto& routes = m_routes[symbol_index];
+    switch (subscription.channel) {
+    case Channel::trades:
+        routes.trades.push_back(connection_id);
+        break;
+    case Channel::depth:
+        routes.depth[subscription.levels].push_back(connection_id);
+        break;
+    case Channel::top_of_book:
+        routes.top_of_book.push_back(connection_id);
+        break;
+    }
+}
+
+void SubscriptionRouter::remove_route(const std::size_t symbol_index, const int connection_id,
+                                      const Subscription& subscription) {
+    auto& routes = m_routes[symbol_index];
+    switch (subscription.channel) {
+    case Channel::trades:
+        std::erase(routes.trades, connection_id);
+        break;
+    case Channel::depth:
+        if (const auto it = routes.depth.find(subscription.levels); it != routes.depth.end()) {
+            std::erase(it->second, connection_id);
+            // No one left to encode these levels for
+            if (it->second.empty()) {
+                routes.depth.erase(it);
+            }
+        }
+        break;
+    case Channel::top_of_book:
+        std::erase(routes.top_of_book, connection_id);
+        break;
+    }
+}
+} // namespace mdp
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <expected>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mdp {
+enum class Channel {
+    trades,
+    depth,       // the best levels on each side, every update
+    top_of_book, // the best level on each side, only when it changes
+};
+
+struct Subscription {
+    std::string symbol;
+    Channel channel;
+    std::size_t levels{0}; // levels per side for depth, 0 otherwise
+
+    auto operator<=>(const Subscription&) const = default;
+};
+
+struct SubscriptionRequest {
+    bool subscribe; // false to unsubscribe
+    Subscription subscription;
+};
+
+/*
+ * Parses a client request such as
+ *   {"op":"subscribe","symbol":"AAPL","channel":"depth","levels":10}
+ * op is subscribe or unsubscribe and channel is trades, depth or top_of_book. levels is only
+ * accepted for depth and defaults to every level the engine publishes.
+ */
+std::expected<SubscriptionRequest, std::string>
+parse_subscription_request(std::string_view message);
+
+// Acknowledges a request, e.g. {"op":"subscribed","symbol":"AAPL","channel":"trades"}
+std::string make_subscription_ack(const SubscriptionRequest& request);
+std::string make_subscription_error(std::string_view error);
+
+std::string_view channel_name(Channel channel);
+
+/*
+ * Routing tables from each symbol and channel to the connections subscribed to it, so the MDP
+ * encodes and sends an update only for the clients that asked for it. A connection that never
+ * subscribed is not tracked here and keeps receiving every message of every symbol. Once it has
+ * subscribed it only receives its subscriptions, even after unsubscribing from all of them.
+ *
+ * A connection holds at most one depth subscription per symbol; subscribing again replaces the
+ * number of levels.
+ */
+class SubscriptionRouter {
+  public:
+    struct SymbolRoutes {
+        std::vector<int> trades;
+        std::vector<int> top_of_book;
+        std::map<std::size_t, std::vector<int>> depth; // subscribers by levels
+    };
+
+    explicit SubscriptionRouter(const std::vector<std::string>& symbols);
+
+    // Fails for a symbol this MDP does not publish
+    std::expected<void, std::string> subscribe(int connection_id,
+                                               const Subscription& subscription);
+    void unsubscribe(int connection_id, const Subscription& subscription);
+    void remove_connection(int connection_id);
+
+    bool has_subscribed(int connection_id) const {
+        return m_subscriptions.contains(connection_id);
+    }
+
+    std::size_t subscribed_connection_count() const {
+        return m_subscriptions.size();
+    }
+
+    std::vector<int> connection_ids() const;
+    std::optional<std::size_t> symbol_index(std::string_view symbol) const;
+
+    const SymbolRoutes& routes(std::size_t symbol_index) const {
+        return m_routes[symbol_index];
+    }
+
+  private:
+    void add_route(std::size_t symbol_index, int connection_id, const Subscription& subscription);
+    void remove_route(std::size_t symbol_index, int connection_id,
+                      const Subscription& subscription);
+
+    std::unordered_map<std::string, std::size_t> m_symbol_indices;
+    std::vector<SymbolRoutes> m_routes; // one per symbol
+    std::unordered_map<int, std::set<Subscription>> m_subscriptions;
+};
+} // namespace mdp
@@ -238,15 +238,15 @@ int main(int argc, char* argv[]) {
             std::chrono::system_clock::now().time_since_epoch()
         ).count();
 
-        OrderbookSnapshotRingBuffer orderbook_snapshot_buffer =
-            OrderbookSnapshotRingBuffer::open_exist_shm(
+        OrderbookSnapshotSlot orderbook_snapshot_buffer =
+            OrderbookSnapshotSlot::open_exist_shm(
                 core::constants::ORDERBOOK_SNAPSHOT_SHM_FILE);
 
         // Use the TopOrderBookLevelAggregates constructor
         TopOrderBookLevelAggregates snapshot("AAPL", now_ts_ms);
 
-        TradeRingBuffer trade_buffer =
-            TradeRingBuffer::open_exist_shm(core::constants::TRADE_SHM_FILE);
+        TradeBroadcastRingBuffer trade_buffer =
+            TradeBroadcastRingBuffer::open_exist_shm(core::constants::TRADE_SHM_FILE);
 
         std::random_device rd;
         std::mt19937 gen(rd());
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "core/constants.h"
+#include "subscription_router.h"
+
+#include <string>
+#include <vector>
+
+using namespace mdp;
+
+namespace {
+const std::vector<std::string> symbols{"AAPL", "MSFT"};
+}
+
+TEST(SubscriptionRequestTest, ParsesEachChannel) {
+    auto trades = parse_subscription_request(
+        R"({"op":"subscribe","symbol":"AAPL","channel":"trades"})");
+    ASSERT_TRUE(trades.has_value());
+    EXPECT_TRUE(trades->subscribe);
+    EXPECT_EQ(trades->subscription, (Subscription{"AAPL", Channel::trades, 0}));
+
+    auto depth = parse_subscription_request(
+        R"({"op":"unsubscribe","symbol":"MSFT","channel":"depth","levels":5})");
+    ASSERT_TRUE(depth.has_value());
+    EXPECT_FALSE(depth->subscribe);
+    EXPECT_EQ(depth->subscription, (Subscription{"MSFT", Channel::depth, 5}));
+
+    auto all_levels =
+        parse_subscription_request(R"({"op":"subscribe","symbol":"MSFT","channel":"depth"})");
+    ASSERT_TRUE(all_levels.has_value());
+    EXPECT_EQ(all_levels->subscription.levels,
+              static_cast<std::size_t>(core::constants::ORDER_BOOK_AGGREGATE_LEVELS));
+
+    auto top = parse_subscription_request(
+        R"({"op":"subscribe","symbol":"AAPL","channel":"top_of_book"})");
+    ASSERT_TRUE(top.has_value());
+    EXPECT_EQ(top->subscription.channel, Channel::top_of_book);
+}
+
+TEST(SubscriptionRequestTest, RejectsMalformedRequests) {
+    EXPECT_FALSE(parse_subscription_request("not json").has_value());
+    EXPECT_FALSE(parse_subscription_request(R"({"op":"subscribe","symbol":"AAPL"})").has_value());
+    EXPECT_FALSE(
+        parse_subscription_request(R"({"op":"watch","symbol":"AAPL","channel":"trades"})")
+            .has_value());
+    EXPECT_FALSE(
+        parse_subscription_request(R"({"op":"subscribe","symbol":"AAPL","channel":"quotes"})")
+            .has_value());
+    EXPECT_FALSE(parse_subscription_request(
+                     R"({"op":"subscribe","symbol":"AAPL","channel":"depth","levels":0})")
+                     .has_value());
+    EXPECT_FALSE(parse_subscription_request(
+                     R"({"op":"subscribe","symbol":"AAPL","channel":"depth","levels":51})")
+                     .has_value());
+    EXPECT_FALSE(parse_subscription_request(
+                     R"({"op":"subscribe","symbol":"AAPL","channel":"trades","levels":5})")
+                     .has_value());
+}
+
+TEST(SubscriptionRequestTest, AcknowledgesWithTheRequest) {
+    const SubscriptionRequest request{true, {"AAPL", Channel::depth, 10}};
+    EXPECT_EQ(make_subscription_ack(request),
+              R"({"channel":"depth","levels":10,"op":"subscribed","symbol":"AAPL"})");
+    EXPECT_EQ(make_subscription_error("Unknown symbol GOOG"),
+              R"({"error":"Unknown symbol GOOG","op":"error"})");
+}
+
+TEST(SubscriptionRouterTest, RoutesBySymbolAndChannel) {
+    SubscriptionRouter router{symbols};
+    EXPECT_FALSE(router.has_subscribed(1));
+
+    ASSERT_TRUE(router.subscribe(1, {"AAPL", Channel::trades, 0}).has_value());
+    ASSERT_TRUE(router.subscribe(2, {"AAPL", Channel::depth, 5}).has_value());
+    ASSERT_TRUE(router.subscribe(3, {"AAPL", Channel::depth, 5}).has_value());
+    ASSERT_TRUE(router.subscribe(3, {"MSFT", Channel::top_of_book, 0}).has_value());
+
+    const auto& aapl = router.routes(router.symbol_index("AAPL").value());
+    EXPECT_EQ(aapl.trades, (std::vector<int>{1}));
+    ASSERT_EQ(aapl.depth.size(), 1u);
+    EXPECT_EQ(aapl.depth.at(5), (std::vector<int>{2, 3}));
+    EXPECT_TRUE(aapl.top_of_book.empty());
+
+    const auto& msft = router.routes(router.symbol_index("MSFT").value());
+    EXPECT_TRUE(msft.trades.empty());
+    EXPECT_TRUE(msft.depth.empty());
+    EXPECT_EQ(msft.top_of_book, (std::vector<int>{3}));
+    EXPECT_EQ(router.subscribed_connection_count(), 3u);
+}
+
+TEST(SubscriptionRouterTest, RejectsUnknownSymbols) {
+    SubscriptionRouter router{symbols};
+    EXPECT_FALSE(router.subscribe(1, {"GOOG", Channel::trades, 0}).has_value());
+    EXPECT_FALSE(router.has_subscribed(1));
+}
+
+TEST(SubscriptionRouterTest, SubscribingToDepthAgainReplacesTheLevels) {
+    SubscriptionRouter router{symbols};
+    ASSERT_TRUE(router.subscribe(1, {"AAPL", Channel::depth, 5}).has_value());
+    ASSERT_TRUE(router.subscribe(1, {"AAPL", Channel::depth, 20}).has_value());
+
+    const auto& aapl = router.routes(router.symbol_index("AAPL").value());
+    ASSERT_EQ(aapl.depth.size(), 1u);
+    EXPECT_EQ(aapl.depth.at(20), (std::vector<int>{1}));
+
+    // Unsubscribing from depth does not need the levels
+    router.unsubscribe(1, {"AAPL", Channel::depth, 0});
+    EXPECT_TRUE(aapl.depth.empty());
+}
+
+TEST(SubscriptionRouterTest, UnsubscribedConnectionsStayOptedIn) {
+    SubscriptionRouter router{symbols};
+    ASSERT_TRUE(router.subscribe(1, {"AAPL", Channel::trades, 0}).has_value());
+    router.unsubscribe(1, {"AAPL", Channel::trades, 0});
+
+    EXPECT_TRUE(router.routes(router.symbol_index("AAPL").value()).trades.empty());
+    EXPECT_TRUE(router.has_subscribed(1));
+}
+
+TEST(SubscriptionRouterTest, RemovingAConnectionDropsItsRoutes) {
+    SubscriptionRouter router{symbols};
+    ASSERT_TRUE(router.subscribe(1, {"AAPL", Channel::trades, 0}).has_value());
+    ASSERT_TRUE(router.subscribe(1, {"MSFT", Channel::depth, 10}).has_value());
+    ASSERT_TRUE(router.subscribe(2, {"AAPL", Channel::trades, 0}).has_value());
+
+    router.remove_connection(1);
+    EXPECT_FALSE(router.has_subscribed(1));
+    EXPECT_EQ(router.routes(router.symbol_index("AAPL").value()).trades, (std::vector<int>{2}));
+    EXPECT_TRUE(router.routes(router.symbol_index("MSFT").value()).depth.empty());
+    EXPECT_EQ(router.connection_ids(), (std::vector<int>{2}));
+}
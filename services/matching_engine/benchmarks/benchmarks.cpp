@@ -27,6 +27,9 @@ class BenchmarkInboundServer final : public transport::InboundServer {
         return {};
     }
 
+    void set_message_notifier(std::shared_ptr<core::MessageNotifier>) override {
+    }
+
     [[nodiscard]] std::vector<transport::InboundConnectionInfo> get_connection_info() const override {
         return {};
     }
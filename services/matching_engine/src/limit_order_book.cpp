@@ -17,8 +17,8 @@ std::string_view LimitOrderBook::get_ticker() const {
     return ticker;
 }
 
-void LimitOrderBook::add_order(int order_id, int price, int quantity, Side side,
-                               std::string_view broker_id) {
+int LimitOrderBook::add_order(int order_id, int price, int quantity, Side side,
+                              std::string_view broker_id) {
     boost::contract::check c = boost::contract::public_function(this).precondition([&] {
         BOOST_CONTRACT_ASSERT(order_id >= 0);
         BOOST_CONTRACT_ASSERT(!order_id_map.contains(order_id));
@@ -28,15 +28,14 @@ void LimitOrderBook::add_order(int order_id, int price, int quantity, Side side,
     });
 
     if (side == Side::bid) {
-        match_order(bids, asks, price, quantity, order_id, side, broker_id);
-    } else {
-        match_order(asks, bids, price, quantity, order_id, side, broker_id);
+        return match_order(bids, asks, price, quantity, order_id, side, broker_id);
     }
+    return match_order(asks, bids, price, quantity, order_id, side, broker_id);
 }
 
-void LimitOrderBook::match_order(SideContainer& near_side, SideContainer& far_side, int price,
-                                 int remaining_quantity, int order_id, Side side,
-                                 std::string_view broker_id) {
+int LimitOrderBook::match_order(SideContainer& near_side, SideContainer& far_side, int price,
+                                int remaining_quantity, int order_id, Side side,
+                                std::string_view broker_id) {
     while (!far_side.empty() && remaining_quantity > 0) {
         const auto best_level = (side == Side::bid) ? far_side.begin() : std::prev(far_side.end());
 
@@ -83,6 +82,8 @@ void LimitOrderBook::match_order(SideContainer& near_side, SideContainer& far_si
         order_id_map[order_id] = near_side[price].emplace(near_side[price].end(), order_id, price,
                                                           remaining_quantity, side, broker_id);
     }
+
+    return remaining_quantity;
 }
 
 void LimitOrderBook::cancel_order(int order_id) {
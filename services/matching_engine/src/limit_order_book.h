@@ -32,7 +32,9 @@ class LimitOrderBook {
 
     [[nodiscard]] std::string_view get_ticker() const;
 
-    void add_order(int order_id, int price, int quantity, Side side, std::string_view broker_id);
+    // Returns the quantity left unfilled. It rests on the book for a limit order and is dropped
+    // for a market order.
+    int add_order(int order_id, int price, int quantity, Side side, std::string_view broker_id);
     void cancel_order(int order_id);
 
     [[nodiscard]] const SideContainer& get_side(Side side) const;
@@ -60,8 +62,8 @@ class LimitOrderBook {
 
     std::unordered_map<int, std::list<Order>::const_iterator> order_id_map{};
 
-    void match_order(SideContainer& near_side, SideContainer& far_side, int price,
-                     int remaining_quantity, int order_id, Side side, std::string_view broker_id);
+    int match_order(SideContainer& near_side, SideContainer& far_side, int price,
+                    int remaining_quantity, int order_id, Side side, std::string_view broker_id);
 
     [[nodiscard]] SideContainer& get_side_mut(Side side);
 };
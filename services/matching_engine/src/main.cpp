@@ -13,15 +13,15 @@ int main(int argc, char* argv[]) {
     const MatchingEngineDependencyFactory dependency_factory{
         .create_trade_publisher =
             [](std::string_view symbol) {
-                return std::make_unique<SharedMemoryPublisher<Trade, TradeRingBuffer>>(
-                    TradeRingBuffer ::open_exist_shm(std::format(
+                return std::make_unique<SharedMemoryPublisher<Trade, TradeBroadcastRingBuffer>>(
+                    TradeBroadcastRingBuffer::open_exist_shm(std::format(
                         "{}_{}_{}", symbol, core::constants::TRADE_SHM_FILE, SERVER_NAME)));
             },
         .create_orderbook_snapshot_publisher =
             [](std::string_view symbol) {
                 return std::make_unique<SharedMemoryPublisher<TopOrderBookLevelAggregates,
-                                                              OrderbookSnapshotRingBuffer>>(
-                    OrderbookSnapshotRingBuffer::open_exist_shm(
+                                                              OrderbookSnapshotSlot>>(
+                    OrderbookSnapshotSlot::open_exist_shm(
                         std::format("{}_{}_{}", symbol,
                                     core::constants::ORDERBOOK_SNAPSHOT_SHM_FILE, SERVER_NAME)));
             },
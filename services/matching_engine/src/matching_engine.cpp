@@ -64,7 +64,8 @@ void MatchingEngine::run() {
                 .transform([&](std::string&& new_message) -> std::optional<std::string> {
                     const auto container = transport::deserialize_container(new_message);
 
-                    process_container(container, limit_order_books, trade_events, *inbound_server,
+                    process_container(container, limit_order_books, trade_events,
+                                      unfilled_market_cancels, *inbound_server,
                                       order_response_connection_id, incoming_request_connection_id);
 
                     return new_message;
@@ -84,10 +85,77 @@ void MatchingEngine::run() {
     }
 }
 
+// Sends queued trades in order, then the unfilled market order cancels. A cancel is held back while
+// any trade is queued, so the Order Manager never sees an order cancelled before its last fill.
+// Whatever fails to send stays queued for the next new order.
+static void send_queued_responses(
+    std::queue<Trade>& trade_events,
+    std::queue<core::CancelOrderResponseContainer>& unfilled_market_cancels,
+    transport::InboundServer& inbound_server, int order_response_connection_id) {
+    while (!trade_events.empty()) {
+        const auto current_trade = trade_events.front();
+
+        const auto trade_container =
+            core::TradeContainer{.ticker = current_trade.ticker,
+                                 .price = current_trade.price,
+                                 .quantity = current_trade.quantity,
+                                 .trade_id = current_trade.trade_id,
+                                 .taker_id = current_trade.taker_id,
+                                 .maker_id = current_trade.maker_id,
+                                 .taker_order_id = current_trade.taker_order_id,
+                                 .maker_order_id = current_trade.maker_order_id,
+                                 .is_taker_buyer = current_trade.is_taker_buyer};
+
+        const auto res =
+            inbound_server
+                .send(order_response_connection_id,
+                      transport::serialize_container(trade_container))
+                .transform(
+                    [&] { logger->info("[ME] Successfully sent Trade: {}", trade_container); })
+                .or_else([&](int) -> std::expected<void, int> {
+                    logger->error("[ME] Failed to sent Trade: {}", trade_container);
+
+                    return std::unexpected{-1};
+                });
+
+        if (!res.has_value()) {
+            return;
+        }
+
+        trade_events.pop();
+    }
+
+    while (!unfilled_market_cancels.empty()) {
+        const auto& cancel_response = unfilled_market_cancels.front();
+
+        const auto res =
+            inbound_server
+                .send(order_response_connection_id, transport::serialize_container(cancel_response))
+                .transform([&] {
+                    logger->info("[ME] Successfully sent unfilled market order Cancel Response: {}",
+                                 cancel_response);
+                })
+                .or_else([&](int) -> std::expected<void, int> {
+                    logger->error("[ME] Failed to sent unfilled market order Cancel Response: {}",
+                                  cancel_response);
+
+                    return std::unexpected{-1};
+                });
+
+        if (!res.has_value()) {
+            return;
+        }
+
+        unfilled_market_cancels.pop();
+    }
+}
+
 void process_container(const core::Container& container,
                        std::unordered_map<std::string, LimitOrderBook>& limit_order_books,
-                       std::queue<Trade>& trade_events, transport::InboundServer& inbound_server,
-                       int order_response_connection_id, int incoming_request_connection_id) {
+                       std::queue<Trade>& trade_events,
+                       std::queue<core::CancelOrderResponseContainer>& unfilled_market_cancels,
+                       transport::InboundServer& inbound_server, int order_response_connection_id,
+                       int incoming_request_connection_id) {
     auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
         boost::contract::check c = boost::contract::function().precondition(
             [&] { BOOST_CONTRACT_ASSERT(new_order.order_id.has_value()); });
@@ -96,45 +164,24 @@ void process_container(const core::Container& container,
 
         auto& limit_order_book = limit_order_books.at(new_order.symbol);
 
-        limit_order_book.add_order(
+        const int unfilled_quantity = limit_order_book.add_order(
             new_order.order_id.value(),
             new_order.price.value_or((new_order.side == Side::bid) ? MARKET_BID_ORDER_PRICE
                                                                    : MARKET_ASK_ORDER_PRICE),
             new_order.order_qty, (new_order.side == Side::bid) ? Side::bid : Side::ask,
             new_order.sender_comp_id);
 
-        while (!trade_events.empty()) {
-            const auto current_trade = trade_events.front();
-
-            const auto trade_container =
-                core::TradeContainer{.ticker = current_trade.ticker,
-                                     .price = current_trade.price,
-                                     .quantity = current_trade.quantity,
-                                     .trade_id = current_trade.trade_id,
-                                     .taker_id = current_trade.taker_id,
-                                     .maker_id = current_trade.maker_id,
-                                     .taker_order_id = current_trade.taker_order_id,
-                                     .maker_order_id = current_trade.maker_order_id,
-                                     .is_taker_buyer = current_trade.is_taker_buyer};
-
-            const auto res =
-                inbound_server
-                    .send(order_response_connection_id,
-                          transport::serialize_container(trade_container))
-                    .transform(
-                        [&] { logger->info("[ME] Successfully sent Trade: {}", trade_container); })
-                    .or_else([&](int) -> std::expected<void, int> {
-                        logger->error("[ME] Failed to sent Trade: {}", trade_container);
-
-                        return std::unexpected{-1};
-                    });
-
-            if (!res.has_value()) {
-                break;
-            }
-
-            trade_events.pop();
+        // A market order never rests. What it could not fill is reported cancelled, as for an IOC
+        // order, so the Order Manager learns the order is done.
+        if (!new_order.price.has_value() && unfilled_quantity > 0) {
+            unfilled_market_cancels.push(
+                core::CancelOrderResponseContainer{.order_id = new_order.order_id.value(),
+                                                   .cl_ord_id = new_order.cl_ord_id,
+                                                   .success = true});
         }
+
+        send_queued_responses(trade_events, unfilled_market_cancels, inbound_server,
+                              order_response_connection_id);
     }};
     auto cancel_order_handler{[&](const core::CancelOrderRequestContainer& cancel_request) {
         boost::contract::check c = boost::contract::function().precondition(
@@ -175,7 +222,8 @@ void process_container(const core::Container& container,
         auto total_cost =
             limit_order_book.get_fill_cost(fill_cost_query.quantity, fill_cost_query.side);
 
-        const auto response_container = core::FillCostResponseContainer{std::move(total_cost)};
+        const auto response_container = core::FillCostResponseContainer{
+            .total_cost = std::move(total_cost), .request_id = fill_cost_query.request_id};
 
         std::ignore =
             inbound_server
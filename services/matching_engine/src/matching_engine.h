@@ -50,6 +50,8 @@ class MatchingEngine {
     std::chrono::milliseconds flush_interval;
 
     std::queue<Trade> trade_events; // Container for limit order books to dump trade events
+    std::queue<core::CancelOrderResponseContainer>
+        unfilled_market_cancels; // Held back until the trades queued before them are sent
 
     std::unordered_map<std::string, LimitOrderBook>
         limit_order_books; // One limit order book for each symbol
@@ -57,7 +59,9 @@ class MatchingEngine {
 
 void process_container(const core::Container& container,
                        std::unordered_map<std::string, LimitOrderBook>& limit_order_books,
-                       std::queue<Trade>& trade_events, transport::InboundServer& inbound_server,
-                       int order_response_connection_id, int incoming_request_connection_id);
+                       std::queue<Trade>& trade_events,
+                       std::queue<core::CancelOrderResponseContainer>& unfilled_market_cancels,
+                       transport::InboundServer& inbound_server, int order_response_connection_id,
+                       int incoming_request_connection_id);
 
 } // namespace engine
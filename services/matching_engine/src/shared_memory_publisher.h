@@ -1,4 +1,5 @@
 #pragma once
+#include "core/latency_histogram.h"
 #include "publisher.h"
 
 #include <algorithm>
@@ -10,6 +11,9 @@ class SharedMemoryPublisher final : public Publisher<T> {
     explicit SharedMemoryPublisher(RingBufferT ring_buffer) : ring_buffer(std::move(ring_buffer)) {
     }
     bool try_publish(T& msg) override {
+        if constexpr (requires { msg.publish_timestamp_ns; }) {
+            msg.publish_timestamp_ns = core::steady_clock_ns();
+        }
         return ring_buffer.try_push(msg);
     }
 
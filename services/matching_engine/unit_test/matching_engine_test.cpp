@@ -6,6 +6,7 @@
 
 using namespace engine;
 using testing::_;
+using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
@@ -32,6 +33,7 @@ class StubSnapshotPublisher : public Publisher<TopOrderBookLevelAggregates> {
 class MockInboundWebsocketServer : public transport::InboundServer {
   public:
     MOCK_METHOD((std::expected<void, int>), start, (), (override));
+    MOCK_METHOD(void, set_message_notifier, (std::shared_ptr<core::MessageNotifier>), (override));
     MOCK_METHOD(std::vector<transport::InboundConnectionInfo>, get_connection_info, (),
                 (const, override));
     MOCK_METHOD(std::optional<std::string>, dequeue_message, (int), (override));
@@ -112,6 +114,7 @@ class ProcessContainerTest : public testing::Test {
 
     std::unordered_map<std::string, LimitOrderBook> test_limit_order_books;
     std::queue<Trade> trade_events;
+    std::queue<core::CancelOrderResponseContainer> unfilled_market_cancels;
     MockInboundWebsocketServer mock_ws;
 };
 using ProcessContainerDeathTest = ProcessContainerTest;
@@ -119,16 +122,17 @@ using ProcessContainerDeathTest = ProcessContainerTest;
 TEST_F(ProcessContainerDeathTest, InvalidNewOrder) {
     core::NewOrderSingleContainer invalid_order{.order_id = std::nullopt};
 
-    EXPECT_DEATH(
-        process_container(invalid_order, test_limit_order_books, trade_events, mock_ws, 0, 1), "");
+    EXPECT_DEATH(process_container(invalid_order, test_limit_order_books, trade_events,
+                                   unfilled_market_cancels, mock_ws, 0, 1),
+                 "");
 }
 
 TEST_F(ProcessContainerDeathTest, InvalidCancelRequest) {
     core::CancelOrderRequestContainer invalid_request{.order_id = std::nullopt};
 
-    EXPECT_DEATH(
-        process_container(invalid_request, test_limit_order_books, trade_events, mock_ws, 0, 1),
-        "");
+    EXPECT_DEATH(process_container(invalid_request, test_limit_order_books, trade_events,
+                                   unfilled_market_cancels, mock_ws, 0, 1),
+                 "");
 }
 
 TEST_F(ProcessContainerTest, NewOrderAddedNoMatch) {
@@ -145,7 +149,8 @@ TEST_F(ProcessContainerTest, NewOrderAddedNoMatch) {
 
     EXPECT_CALL(mock_ws, send).Times(0);
 
-    process_container(new_order, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(new_order, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
 
     const auto& lob = test_limit_order_books.at("AAPL");
     ASSERT_TRUE(lob.order_id_exists(42));
@@ -191,7 +196,8 @@ TEST_F(ProcessContainerTest, NewOrderMatchSendsTradeContainer) {
             return std::expected<void, int>{};
         }));
 
-    process_container(incoming_bid, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(incoming_bid, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
 
     EXPECT_FALSE(lob.order_id_exists(1));
     EXPECT_FALSE(lob.order_id_exists(2));
@@ -216,11 +222,155 @@ TEST_F(ProcessContainerTest, TradeContainerSendFail) {
 
     EXPECT_CALL(mock_ws, send).WillOnce(Return(std::unexpected{-1}));
 
-    process_container(incoming_bid, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(incoming_bid, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
 
     EXPECT_EQ(trade_events.size(), 1);
 }
 
+TEST_F(ProcessContainerTest, MarketOrderRemainderIsCancelledAfterItsTrades) {
+    auto& lob = test_limit_order_books.at("AAPL");
+    lob.add_order(1, 100, 5, Side::ask, "MAKER");
+
+    core::NewOrderSingleContainer market_bid{.sender_comp_id = "CLIENT",
+                                             .target_comp_id = "ME",
+                                             .order_id = 2,
+                                             .cl_ord_id = 1002,
+                                             .symbol = "AAPL",
+                                             .side = Side::bid,
+                                             .order_qty = 8,
+                                             .ord_type = core::OrderType::market,
+                                             .price = std::nullopt,
+                                             .time_in_force = core::TimeInForce::day};
+
+    InSequence in_sequence;
+    EXPECT_CALL(mock_ws, send(0, _, transport::MessageFormat::binary))
+        .WillOnce(Invoke([](int, const std::string& payload,
+                            transport::MessageFormat) -> std::expected<void, int> {
+            const auto container = transport::deserialize_container(payload);
+            auto trade = std::get_if<core::TradeContainer>(&container);
+            EXPECT_NE(trade, nullptr);
+            if (trade == nullptr) {
+                return std::unexpected{-1};
+            }
+
+            EXPECT_EQ(trade->quantity, 5);
+            EXPECT_EQ(trade->taker_order_id, 2);
+            return std::expected<void, int>{};
+        }));
+    EXPECT_CALL(mock_ws, send(0, _, transport::MessageFormat::binary))
+        .WillOnce(Invoke([](int, const std::string& payload,
+                            transport::MessageFormat) -> std::expected<void, int> {
+            const auto container = transport::deserialize_container(payload);
+            auto cancel_response = std::get_if<core::CancelOrderResponseContainer>(&container);
+            EXPECT_NE(cancel_response, nullptr);
+            if (cancel_response == nullptr) {
+                return std::unexpected{-1};
+            }
+
+            EXPECT_EQ(cancel_response->order_id, 2);
+            EXPECT_EQ(cancel_response->cl_ord_id, 1002);
+            EXPECT_TRUE(cancel_response->success);
+            return std::expected<void, int>{};
+        }));
+
+    process_container(market_bid, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
+
+    EXPECT_FALSE(lob.order_id_exists(2));
+    EXPECT_TRUE(trade_events.empty());
+    EXPECT_TRUE(unfilled_market_cancels.empty());
+}
+
+TEST_F(ProcessContainerTest, MarketOrderRemainderCancelWaitsForUnsentTrades) {
+    auto& lob = test_limit_order_books.at("AAPL");
+    lob.add_order(1, 100, 5, Side::ask, "MAKER");
+
+    core::NewOrderSingleContainer market_bid{.sender_comp_id = "CLIENT",
+                                             .target_comp_id = "ME",
+                                             .order_id = 2,
+                                             .cl_ord_id = 1002,
+                                             .symbol = "AAPL",
+                                             .side = Side::bid,
+                                             .order_qty = 8,
+                                             .ord_type = core::OrderType::market,
+                                             .price = std::nullopt,
+                                             .time_in_force = core::TimeInForce::day};
+
+    EXPECT_CALL(mock_ws, send).WillOnce(Return(std::unexpected{-1}));
+
+    process_container(market_bid, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
+
+    EXPECT_EQ(trade_events.size(), 1);
+    ASSERT_EQ(unfilled_market_cancels.size(), 1);
+    EXPECT_EQ(unfilled_market_cancels.front().order_id, 2);
+
+    testing::Mock::VerifyAndClearExpectations(&mock_ws);
+
+    core::NewOrderSingleContainer resting_bid{.sender_comp_id = "CLIENT",
+                                              .target_comp_id = "ME",
+                                              .order_id = 3,
+                                              .cl_ord_id = 1003,
+                                              .symbol = "AAPL",
+                                              .side = Side::bid,
+                                              .order_qty = 1,
+                                              .ord_type = core::OrderType::limit,
+                                              .price = 90,
+                                              .time_in_force = core::TimeInForce::day};
+
+    // The next order flushes the stuck trade first, then the cancel held back behind it
+    InSequence in_sequence;
+    EXPECT_CALL(mock_ws, send(0, _, transport::MessageFormat::binary))
+        .WillOnce(Invoke([](int, const std::string& payload,
+                            transport::MessageFormat) -> std::expected<void, int> {
+            const auto container = transport::deserialize_container(payload);
+            EXPECT_TRUE(std::holds_alternative<core::TradeContainer>(container));
+            return std::expected<void, int>{};
+        }));
+    EXPECT_CALL(mock_ws, send(0, _, transport::MessageFormat::binary))
+        .WillOnce(Invoke([](int, const std::string& payload,
+                            transport::MessageFormat) -> std::expected<void, int> {
+            const auto container = transport::deserialize_container(payload);
+            auto cancel_response = std::get_if<core::CancelOrderResponseContainer>(&container);
+            EXPECT_NE(cancel_response, nullptr);
+            if (cancel_response == nullptr) {
+                return std::unexpected{-1};
+            }
+
+            EXPECT_EQ(cancel_response->order_id, 2);
+            EXPECT_TRUE(cancel_response->success);
+            return std::expected<void, int>{};
+        }));
+
+    process_container(resting_bid, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
+
+    EXPECT_TRUE(trade_events.empty());
+    EXPECT_TRUE(unfilled_market_cancels.empty());
+}
+
+TEST_F(ProcessContainerTest, FilledMarketOrderSendsOnlyItsTrades) {
+    auto& lob = test_limit_order_books.at("AAPL");
+    lob.add_order(1, 100, 5, Side::bid, "MAKER");
+
+    core::NewOrderSingleContainer market_ask{.sender_comp_id = "CLIENT",
+                                             .target_comp_id = "ME",
+                                             .order_id = 2,
+                                             .cl_ord_id = 1002,
+                                             .symbol = "AAPL",
+                                             .side = Side::ask,
+                                             .order_qty = 5,
+                                             .ord_type = core::OrderType::market,
+                                             .price = std::nullopt,
+                                             .time_in_force = core::TimeInForce::day};
+
+    EXPECT_CALL(mock_ws, send).WillOnce(Return(std::expected<void, int>{}));
+
+    process_container(market_ask, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
+}
+
 TEST_F(ProcessContainerTest, SuccessfulCancel) {
     auto& lob = test_limit_order_books.at("AAPL");
     lob.add_order(1, 100, 5, Side::ask, "MAKER");
@@ -250,7 +400,8 @@ TEST_F(ProcessContainerTest, SuccessfulCancel) {
             return std::expected<void, int>{};
         }));
 
-    process_container(cancel_request, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(cancel_request, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
 
     EXPECT_FALSE(lob.order_id_exists(1));
 }
@@ -281,7 +432,8 @@ TEST_F(ProcessContainerTest, FailedCancel) {
             return std::expected<void, int>{};
         }));
 
-    process_container(cancel_request, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(cancel_request, test_limit_order_books, trade_events, unfilled_market_cancels,
+                      mock_ws, 0, 1);
 }
 
 TEST_F(ProcessContainerTest, FillCostQueryReturnsComputedCost) {
@@ -290,7 +442,7 @@ TEST_F(ProcessContainerTest, FillCostQueryReturnsComputedCost) {
     lob.add_order(2, 101, 20, Side::ask, "MAKER_2");
 
     core::FillCostQueryContainer fill_cost_query{
-        .symbol = "AAPL", .quantity = 25, .side = Side::ask};
+        .symbol = "AAPL", .quantity = 25, .side = Side::ask, .request_id = 7};
 
     EXPECT_CALL(mock_ws, send(1, _, transport::MessageFormat::binary))
         .WillOnce(Invoke([](int, const std::string& payload,
@@ -302,6 +454,7 @@ TEST_F(ProcessContainerTest, FillCostQueryReturnsComputedCost) {
                 return std::unexpected{-1};
             }
 
+            EXPECT_EQ(response->request_id, 7);
             std::ignore = response->total_cost
                               .transform([](int tc) {
                                   EXPECT_EQ(tc, 2515); // 10*100 + 15*101
@@ -315,7 +468,8 @@ TEST_F(ProcessContainerTest, FillCostQueryReturnsComputedCost) {
             return std::expected<void, int>{};
         }));
 
-    process_container(fill_cost_query, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(fill_cost_query, test_limit_order_books, trade_events,
+                      unfilled_market_cancels, mock_ws, 0, 1);
 }
 
 TEST_F(ProcessContainerTest, FillCostQueryWhenNoLiquidity) {
@@ -339,5 +493,6 @@ TEST_F(ProcessContainerTest, FillCostQueryWhenNoLiquidity) {
             return std::expected<void, int>{};
         }));
 
-    process_container(fill_cost_query, test_limit_order_books, trade_events, mock_ws, 0, 1);
+    process_container(fill_cost_query, test_limit_order_books, trade_events,
+                      unfilled_market_cancels, mock_ws, 0, 1);
 }
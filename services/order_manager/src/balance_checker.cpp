@@ -2,10 +2,116 @@
 
 #include <boost/contract.hpp>
 #include <cassert>
+#include <utility>
 
 namespace om {
+BalanceChecker::UserId BalanceChecker::intern_user(std::string_view broker_id) {
+    if (const auto it = user_ids.find(broker_id); it != user_ids.end()) {
+        return it->second;
+    }
+
+    const auto user_id = static_cast<UserId>(accounts.size());
+    user_ids.emplace(broker_id, user_id);
+    accounts.emplace_back();
+    return user_id;
+}
+
+BalanceChecker::SymbolId BalanceChecker::intern_symbol(std::string_view ticker) {
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(!ticker.empty()); });
+
+    if (const auto it = symbol_ids.find(ticker); it != symbol_ids.end()) {
+        return it->second;
+    }
+
+    const auto symbol_id = static_cast<SymbolId>(symbol_ids.size());
+    symbol_ids.emplace(ticker, symbol_id);
+    return symbol_id;
+}
+
+std::optional<BalanceChecker::UserId> BalanceChecker::find_user(std::string_view broker_id) const {
+    if (const auto it = user_ids.find(broker_id); it != user_ids.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<BalanceChecker::SymbolId> BalanceChecker::find_symbol(std::string_view ticker) const {
+    if (const auto it = symbol_ids.find(ticker); it != symbol_ids.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::int64_t>* BalanceChecker::find_balance(UserId user_id, SymbolId symbol_id) {
+    return const_cast<std::optional<std::int64_t>*>(
+        std::as_const(*this).find_balance(user_id, symbol_id));
+}
+
+const std::optional<std::int64_t>* BalanceChecker::find_balance(UserId user_id,
+                                                                SymbolId symbol_id) const {
+    assert(user_id < accounts.size() && "Unknown user id");
+
+    const auto& account = accounts[user_id];
+    if (symbol_id >= account.size() || !account[symbol_id].has_value()) {
+        return nullptr;
+    }
+    return &account[symbol_id];
+}
+
+bool BalanceChecker::owns(UserId user_id, SymbolId symbol_id) const {
+    return find_balance(user_id, symbol_id) != nullptr;
+}
+
+void BalanceChecker::update_balance(UserId user_id, SymbolId symbol_id, std::int64_t delta) {
+    boost::contract::check c = boost::contract::public_function(this).precondition([&] {
+        BOOST_CONTRACT_ASSERT(user_id < accounts.size());
+        BOOST_CONTRACT_ASSERT(symbol_id < symbol_ids.size());
+    });
+
+    if (auto* balance = find_balance(user_id, symbol_id)) {
+        assert(balance->value() + delta >= 0 && "Cannot deduct more balance than available");
+
+        balance->value() += delta;
+        return;
+    }
+
+    auto& account = accounts[user_id];
+    if (symbol_id >= account.size()) {
+        account.resize(symbol_id + 1);
+    }
+    account[symbol_id].emplace(delta);
+}
+
+std::int64_t BalanceChecker::get_balance(UserId user_id, SymbolId symbol_id) const {
+    std::int64_t rtn;
+    boost::contract::check c = boost::contract::public_function(this)
+                                   .precondition([&] {
+                                       BOOST_CONTRACT_ASSERT(user_id < accounts.size());
+                                       BOOST_CONTRACT_ASSERT(owns(user_id, symbol_id));
+                                   })
+                                   .postcondition([&] { BOOST_CONTRACT_ASSERT(rtn >= 0); });
+
+    return rtn = find_balance(user_id, symbol_id)->value();
+}
+
+bool BalanceChecker::try_reserve(UserId user_id, SymbolId symbol_id, std::int64_t amount) {
+    boost::contract::check c = boost::contract::public_function(this).precondition([&] {
+        BOOST_CONTRACT_ASSERT(user_id < accounts.size());
+        BOOST_CONTRACT_ASSERT(amount >= 0);
+    });
+
+    auto* balance = find_balance(user_id, symbol_id);
+    if (balance == nullptr || balance->value() < amount) {
+        return false;
+    }
+
+    balance->value() -= amount;
+    return true;
+}
+
 bool BalanceChecker::broker_id_exists(const std::string& broker_id) const {
-    return balance_map.contains(broker_id);
+    return user_ids.contains(broker_id);
 }
 
 bool BalanceChecker::broker_owns_ticker(const std::string& broker_id,
@@ -15,7 +121,8 @@ bool BalanceChecker::broker_owns_ticker(const std::string& broker_id,
         BOOST_CONTRACT_ASSERT(!ticker.empty());
     });
 
-    return balance_map.at(broker_id).contains(ticker);
+    const auto symbol_id = find_symbol(ticker);
+    return symbol_id.has_value() && owns(find_user(broker_id).value(), symbol_id.value());
 }
 
 void BalanceChecker::update_balance(const std::string& broker_id, const std::string& ticker,
@@ -23,36 +130,17 @@ void BalanceChecker::update_balance(const std::string& broker_id, const std::str
     boost::contract::check c = boost::contract::public_function(this).precondition(
         [&] { BOOST_CONTRACT_ASSERT(!ticker.empty()); });
 
-    // Check if broker has record
-    if (const auto broker_it = balance_map.find(broker_id); broker_it != balance_map.end()) {
-        // Check if broker has ticker's record
-        if (const auto ticker_it = broker_it->second.find(ticker);
-            ticker_it != broker_it->second.end()) {
-            // Check if broker has sufficient balance
-            assert(has_sufficient_balance(broker_id, ticker, delta) &&
-                   "Cannot deduct more balance than available");
-
-            ticker_it->second += delta;
-        } else {
-            broker_it->second.emplace(ticker, delta);
-        }
-    } else {
-        balance_map.emplace(broker_id,
-                            std::unordered_map<std::string, std::int64_t>{{ticker, delta}});
-    }
+    update_balance(intern_user(broker_id), intern_symbol(ticker), delta);
 }
 
 std::int64_t BalanceChecker::get_balance(const std::string& broker_id,
                                          const std::string& ticker) const {
-    std::int64_t rtn;
-    boost::contract::check c = boost::contract::public_function(this)
-                                   .precondition([&] {
-                                       BOOST_CONTRACT_ASSERT(broker_id_exists(broker_id));
-                                       BOOST_CONTRACT_ASSERT(broker_owns_ticker(broker_id, ticker));
-                                   })
-                                   .postcondition([&] { BOOST_CONTRACT_ASSERT(rtn >= 0); });
+    boost::contract::check c = boost::contract::public_function(this).precondition([&] {
+        BOOST_CONTRACT_ASSERT(broker_id_exists(broker_id));
+        BOOST_CONTRACT_ASSERT(broker_owns_ticker(broker_id, ticker));
+    });
 
-    return rtn = balance_map.at(broker_id).at(ticker);
+    return get_balance(find_user(broker_id).value(), find_symbol(ticker).value());
 }
 
 bool BalanceChecker::has_sufficient_balance(const std::string& broker_id, const std::string& ticker,
@@ -1,12 +1,36 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace om {
+// Balances are keyed by interned ids: each broker gets an account that is a flat array indexed by
+// symbol id, so once the ids are resolved a check-and-reserve is a single array access. The
+// string overloads are thin adapters that resolve the ids first, for callers off the hot path.
 class BalanceChecker {
   public:
+    using UserId = std::uint32_t;
+    using SymbolId = std::uint32_t;
+
+    // Returns the existing id or assigns the next one. Ids are dense and never reused.
+    UserId intern_user(std::string_view broker_id);
+    SymbolId intern_symbol(std::string_view ticker);
+
+    std::optional<UserId> find_user(std::string_view broker_id) const;
+    std::optional<SymbolId> find_symbol(std::string_view ticker) const;
+
+    bool owns(UserId user_id, SymbolId symbol_id) const;
+    void update_balance(UserId user_id, SymbolId symbol_id, std::int64_t delta);
+    std::int64_t get_balance(UserId user_id, SymbolId symbol_id) const;
+
+    // Deducts amount and returns true only if the user holds the symbol and can afford it
+    [[nodiscard]] bool try_reserve(UserId user_id, SymbolId symbol_id, std::int64_t amount);
+
     bool broker_id_exists(const std::string& broker_id) const;
     bool broker_owns_ticker(const std::string& broker_id, const std::string& ticker) const;
 
@@ -16,7 +40,23 @@ class BalanceChecker {
                                 std::int64_t delta) const;
 
   private:
-    std::unordered_map<std::string, std::unordered_map<std::string, std::int64_t>>
-        balance_map; // Map(broker_id, Map(ticker, amount))
+    struct StringHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view value) const {
+            return std::hash<std::string_view>{}(value);
+        }
+    };
+    using InternMapContainer =
+        std::unordered_map<std::string, std::uint32_t, StringHash, std::equal_to<>>;
+
+    // Indexed by SymbolId, nullopt where the user has no record of the symbol
+    using Account = std::vector<std::optional<std::int64_t>>;
+
+    std::optional<std::int64_t>* find_balance(UserId user_id, SymbolId symbol_id);
+    const std::optional<std::int64_t>* find_balance(UserId user_id, SymbolId symbol_id) const;
+
+    InternMapContainer user_ids;
+    InternMapContainer symbol_ids;
+    std::vector<Account> accounts; // Indexed by UserId
 };
 } // namespace om
@@ -1,11 +1,25 @@
 #pragma once
+#include "database/balance_write_behind.h"
 #include "database/database_client.h"
 #include "order_manager_database.h"
 
+#include <spdlog/spdlog.h>
+
 namespace om {
 class DatabaseClientWrapper : public OrderManagerDatabase {
   public:
-    explicit DatabaseClientWrapper(bool ensure_init = true) : client{ensure_init} {
+    explicit DatabaseClientWrapper(bool ensure_init = true,
+                                   database::AsyncWriterConfig async_writer_config = {})
+        : client{ensure_init, with_error_logging(std::move(async_writer_config))},
+          balance_write_behind{
+              [this](int server_id, const std::vector<database::BalanceUpsertRow>& rows) {
+                  return balance_write_client.upsert_balances(server_id, rows);
+              },
+              balance_flush_threshold, balance_flush_interval, [](const std::string& err) {
+                  if (auto om_logger = spdlog::get("order_manager_logger")) {
+                      om_logger->error("[OM] Failed to persist balances: {}", err);
+                  }
+              }} {
     }
 
     std::expected<int, std::string> ensure_initial_usd_balances(std::string_view server_name,
@@ -78,13 +92,81 @@ class DatabaseClientWrapper : public OrderManagerDatabase {
             .transform_error([](std::string&& err) { return err; });
     }
 
+    // Staged for the write-behind thread; see BalanceWriteBehind for durability semantics.
     std::expected<void, std::string> update_balance(int user_id, int server_id,
                                                     std::string_view symbol,
                                                     std::int64_t balance) override {
-        return client.update_balance(user_id, server_id, symbol, balance);
+        balance_write_behind.stage(user_id, server_id, symbol, balance);
+        return {};
+    }
+
+    std::expected<std::vector<DbLiveOrderRow>, std::string>
+    get_live_orders(std::string_view server_name) override {
+        return client.query_live_orders(server_name)
+            .transform([](std::vector<database::DatabaseClient::LiveOrderRow>&& live_order_rows) {
+                std::vector<DbLiveOrderRow> db_live_order_rows;
+                db_live_order_rows.reserve(live_order_rows.size());
+
+                for (auto& row : live_order_rows) {
+                    db_live_order_rows.push_back(DbLiveOrderRow{
+                        .order_id = row.order_id,
+                        .cl_order_id = row.cl_order_id,
+                        .sender_comp_id = std::move(row.sender_comp_id),
+                        .symbol = std::move(row.symbol),
+                        .side = row.side == database::to_string(core::Side::bid) ? core::Side::bid
+                                                                                 : core::Side::ask,
+                        .order_qty = row.order_qty,
+                        .price = row.price,
+                        .time_in_force = row.time_in_force ==
+                                                 database::to_string(core::TimeInForce::day)
+                                             ? core::TimeInForce::day
+                                             : core::TimeInForce::gtc,
+                        .filled_qty = row.filled_qty,
+                        .filled_notional = row.filled_notional});
+                }
+
+                return db_live_order_rows;
+            });
+    }
+
+    std::expected<std::optional<int>, std::string>
+    get_max_order_id(std::string_view server_name, int first_order_id,
+                     int end_order_id) override {
+        return client.query_max_order_id(server_name, first_order_id, end_order_id);
+    }
+
+    std::expected<DbOrderIdBlock, std::string> reserve_order_id_block(int server_id, int shard_id,
+                                                                      int floor_order_id,
+                                                                      int block_size) override {
+        return client.reserve_order_id_block(server_id, shard_id, floor_order_id, block_size)
+            .transform([block_size](int reserved_through) {
+                return DbOrderIdBlock{.first_order_id = reserved_through - block_size,
+                                      .end_order_id = reserved_through};
+            });
+    }
+
+    std::expected<int, std::string> claim_order_id_shard_count(int server_id,
+                                                               int shard_count) override {
+        return client.claim_order_id_shard_count(server_id, shard_count);
     }
 
   private:
+    static database::AsyncWriterConfig with_error_logging(database::AsyncWriterConfig config) {
+        config.on_error = [](const std::string& err) {
+            if (auto om_logger = spdlog::get("order_manager_logger")) {
+                om_logger->error("[OM] Failed to persist orders and trades: {}", err);
+            }
+        };
+        return config;
+    }
+
+    static constexpr int balance_flush_threshold{256};
+    static constexpr std::chrono::milliseconds balance_flush_interval{100};
+
     database::DatabaseClient client;
+    // Own connection, only used from the write-behind thread (pqxx connections are not
+    // thread-safe). Declared before balance_write_behind so it outlives the final flush.
+    database::DatabaseClient balance_write_client{false};
+    database::BalanceWriteBehind balance_write_behind;
 };
 } // namespace om
\ No newline at end of file
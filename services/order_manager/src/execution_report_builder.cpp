@@ -0,0 +1,37 @@
+#include "execution_report_builder.h"
+#include "transport/messaging.h"
+
+#include <boost/uuid.hpp>
+#include <charconv>
+#include <limits>
+
+namespace om {
+ExecIdSequence::ExecIdSequence() : prefix{to_string(boost::uuids::time_generator_v7()()) + '-'} {
+}
+
+void ExecIdSequence::next(std::string& exec_id) {
+    char digits[std::numeric_limits<std::uint64_t>::digits10 + 1];
+    const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), ++sequence);
+
+    exec_id.assign(prefix);
+    exec_id.append(digits, end);
+}
+
+ExecutionReportBuilder& ExecutionReportBuilder::for_this_thread() {
+    thread_local ExecutionReportBuilder builder;
+    return builder;
+}
+
+ExecutionReportBuilder::ExecutionReportBuilder() : report{.sender_comp_id = SERVER_NAME} {
+}
+
+core::ExecutionReportContainer& ExecutionReportBuilder::start_report() {
+    exec_id_sequence.next(report.exec_id);
+    return report;
+}
+
+const std::string& ExecutionReportBuilder::serialize() {
+    transport::serialize_container(report, wire_buffer);
+    return wire_buffer;
+}
+} // namespace om
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/containers.h"
+
+#include <cstdint>
+#include <string>
+
+namespace om {
+// Execution report IDs without a UUID generator per report. Each sequence draws one time-ordered
+// UUID as its prefix and numbers reports after it, so IDs stay unique across threads and
+// restarts.
+class ExecIdSequence {
+  public:
+    ExecIdSequence();
+
+    // Overwrites exec_id in place, so a reused string keeps its capacity
+    void next(std::string& exec_id);
+
+  private:
+    std::string prefix;
+    std::uint64_t sequence{0};
+};
+
+// Per-thread scratch report and wire buffer. Both are reused across reports, so once their
+// strings have grown to size building and serializing a report allocates nothing. Reports are
+// built on the thread that sends them, so no report outlives its builder's next call.
+class ExecutionReportBuilder {
+  public:
+    static ExecutionReportBuilder& for_this_thread();
+
+    ExecutionReportBuilder(const ExecutionReportBuilder&) = delete;
+    ExecutionReportBuilder& operator=(const ExecutionReportBuilder&) = delete;
+
+    // The scratch report stamped with a fresh exec ID. Every other field except sender_comp_id
+    // still holds the previous report and must be overwritten by the caller.
+    core::ExecutionReportContainer& start_report();
+
+    // Serializes the scratch report into the wire buffer, valid until the next call
+    const std::string& serialize();
+
+  private:
+    ExecutionReportBuilder();
+
+    ExecIdSequence exec_id_sequence;
+    core::ExecutionReportContainer report;
+    std::string wire_buffer;
+};
+} // namespace om
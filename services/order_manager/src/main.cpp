@@ -1,4 +1,6 @@
 #include "configuration/order_manager_config.h"
+#include "database/ilp_tcp_connection.h"
+#include "database/spill_journal.h"
 #include "database_client_wrapper.h"
 #include "order_manager.h"
 #include "rfl/toml/load.hpp"
@@ -10,6 +12,38 @@ using namespace om;
 int main(int argc, char* argv[]) {
     auto oms_cfg = argc < 2 ? "oms.toml" : argv[1];
     OrderManagerConfig order_manager_config = rfl::toml::load<OrderManagerConfig>(oms_cfg).value();
+    const auto& questdb_config = order_manager_config.questdb;
+
+    // One journal for every shard's writer, drained by a single replayer. Declared before the
+    // Order Manager so it outlives the writers' final flushes.
+    std::shared_ptr<database::SpillJournal> spill_journal;
+    std::optional<database::SpillReplayer> spill_replayer;
+    if (!questdb_config.spill_directory.empty()) {
+        spill_journal = std::make_shared<database::SpillJournal>(database::SpillJournalConfig{
+            .directory = questdb_config.spill_directory,
+            .segment_size = static_cast<std::size_t>(questdb_config.spill_segment_bytes)});
+
+        auto replay_connection = std::make_shared<database::IlpTcpConnection>(
+            questdb_config.ilp_host, static_cast<std::uint16_t>(questdb_config.ilp_port));
+        spill_replayer.emplace(
+            *spill_journal,
+            [replay_connection](std::string_view batch) { return replay_connection->send(batch); },
+            std::chrono::milliseconds{questdb_config.replay_interval_ms},
+            [](const std::string& err) {
+                if (auto om_logger = spdlog::get("order_manager_logger")) {
+                    om_logger->warn("[OM] Spilled QuestDB batches not replayed yet: {}", err);
+                }
+            });
+    }
+
+    const database::AsyncWriterConfig async_writer_config{
+        .flush_threshold = questdb_config.flush_threshold,
+        .flush_interval = std::chrono::milliseconds{questdb_config.flush_interval_ms},
+        .queue_capacity = static_cast<std::size_t>(questdb_config.queue_capacity),
+        .overflow_policy = questdb_config.overflow_policy,
+        .ilp_host = questdb_config.ilp_host,
+        .ilp_port = static_cast<std::uint16_t>(questdb_config.ilp_port),
+        .spill_journal = spill_journal};
 
     const OrderManagerDependencyFactory dependency_factory{
         .create_inbound_server =
@@ -29,11 +63,17 @@ int main(int argc, char* argv[]) {
                 return std::make_unique<transport::OutboundWebsocketClient>(logger);
             },
         .create_database_client =
-            [](bool ensure_init) { return std::make_unique<DatabaseClientWrapper>(ensure_init); }};
+            [&async_writer_config](bool ensure_init) {
+                return std::make_unique<DatabaseClientWrapper>(ensure_init, async_writer_config);
+            }};
 
     OrderManager order_manager{order_manager_config.order_manager_host,
                                order_manager_config.order_manager_port,
-                               order_manager_config.active_symbols, dependency_factory};
+                               order_manager_config.active_symbols, dependency_factory,
+                               order_manager_config.shard_count,
+                               order_manager_config.risk_limits,
+                               order_manager_config.batch_sizes,
+                               order_manager_config.defer_untraded_accounts};
 
     order_manager.init();
     order_manager.wait_for_connections();
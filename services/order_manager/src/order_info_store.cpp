@@ -0,0 +1,139 @@
+#include "order_info_store.h"
+
+#include <boost/contract.hpp>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+namespace om {
+OrderInfoStore::OrderInfoStore(std::size_t archive_capacity, std::size_t window_capacity)
+    : window_capacity{window_capacity}, archive_capacity{archive_capacity} {
+    // Sized once so retiring at steady state never rehashes
+    archived_orders.reserve(archive_capacity);
+}
+
+bool OrderInfoStore::emplace(int order_id, OrderInfo order_info) {
+    if (is_live(order_id)) {
+        return false;
+    }
+
+    const auto window_span = static_cast<std::int64_t>(window_capacity);
+    if (!live_orders.empty() && order_id - std::int64_t{first_live_order_id} >= window_span) {
+        advance_window(static_cast<int>(order_id - window_span + 1));
+    }
+
+    if (live_orders.empty()) {
+        first_live_order_id = order_id;
+    } else if (order_id < first_live_order_id) {
+        const auto gap = static_cast<std::size_t>(first_live_order_id - order_id);
+        // Too old to fit in the window without pushing the newest orders out
+        if (gap + live_orders.size() > window_capacity) {
+            straggler_orders.emplace(order_id, std::move(order_info));
+            ++live_order_count;
+            return true;
+        }
+        live_orders.insert(live_orders.begin(), gap, std::nullopt);
+        first_live_order_id = order_id;
+    }
+
+    const auto index = static_cast<std::size_t>(order_id - first_live_order_id);
+    if (index >= live_orders.size()) {
+        live_orders.resize(index + 1);
+    }
+
+    live_orders[index].emplace(std::move(order_info));
+    ++live_order_count;
+    return true;
+}
+
+bool OrderInfoStore::in_window(int order_id) const {
+    return order_id >= first_live_order_id &&
+           static_cast<std::size_t>(order_id - first_live_order_id) < live_orders.size();
+}
+
+const OrderInfo* OrderInfoStore::find_live(int order_id) const {
+    if (in_window(order_id)) {
+        const auto& slot = live_orders[static_cast<std::size_t>(order_id - first_live_order_id)];
+        return slot.has_value() ? &slot.value() : nullptr;
+    }
+    if (const auto it = straggler_orders.find(order_id); it != straggler_orders.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
+const OrderInfo& OrderInfoStore::at(int order_id) const {
+    if (const auto* order_info = find_live(order_id)) {
+        return *order_info;
+    }
+    if (const auto it = archived_orders.find(order_id); it != archived_orders.end()) {
+        return it->second;
+    }
+    throw std::out_of_range{std::format("Order {} is neither live nor archived", order_id)};
+}
+
+OrderInfo& OrderInfoStore::at(int order_id) {
+    return const_cast<OrderInfo&>(std::as_const(*this).at(order_id));
+}
+
+bool OrderInfoStore::contains(int order_id) const {
+    return is_live(order_id) || archived_orders.contains(order_id);
+}
+
+bool OrderInfoStore::is_live(int order_id) const {
+    return find_live(order_id) != nullptr;
+}
+
+std::optional<int> OrderInfoStore::retire(int order_id) {
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(is_live(order_id)); });
+
+    OrderInfo order_info;
+    if (in_window(order_id)) {
+        auto& slot = live_orders[static_cast<std::size_t>(order_id - first_live_order_id)];
+        order_info = std::move(slot.value());
+        slot.reset();
+        trim_window();
+    } else {
+        order_info = std::move(straggler_orders.extract(order_id).mapped());
+    }
+    --live_order_count;
+
+    std::optional<int> evicted_order_id;
+    if (archive_capacity > 0) {
+        if (archived_orders.size() == archive_capacity) {
+            evicted_order_id = archive_retirement_order.front();
+            archive_retirement_order.pop_front();
+            archived_orders.erase(evicted_order_id.value());
+        }
+        archived_orders.emplace(order_id, std::move(order_info));
+        archive_retirement_order.push_back(order_id);
+    } else {
+        evicted_order_id = order_id;
+    }
+
+    return evicted_order_id;
+}
+
+void OrderInfoStore::advance_window(int new_first_live_order_id) {
+    while (!live_orders.empty() && first_live_order_id < new_first_live_order_id) {
+        if (auto& slot = live_orders.front(); slot.has_value()) {
+            straggler_orders.emplace(first_live_order_id, std::move(slot.value()));
+        }
+        live_orders.pop_front();
+        ++first_live_order_id;
+    }
+    trim_window();
+}
+
+void OrderInfoStore::trim_window() {
+    while (!live_orders.empty() && !live_orders.front().has_value()) {
+        live_orders.pop_front();
+        ++first_live_order_id;
+    }
+    while (!live_orders.empty() && !live_orders.back().has_value()) {
+        live_orders.pop_back();
+    }
+}
+} // namespace om
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core/orders.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace om {
+struct OrderInfo {
+    std::string sender_comp_id;
+    std::string symbol;
+    core::Side side;
+    std::optional<int> price;
+    core::TimeInForce time_in_force;
+    int leaves_qty;
+    int cum_qty;
+    int avg_px;
+
+    int arrival_gateway_id; // Assume that all orders in same order_id chain arrives in same gateway
+
+    // USD a market bid reserved at its quoted fill cost and has not spent yet. Its fills are paid
+    // from it, and whatever is left is released once the order can no longer fill.
+    std::int64_t reserved_usd{0};
+};
+
+// Order state keyed by internal order id. Ids are handed out sequentially, so live orders sit in
+// a dense window indexed by (order_id - first_live_order_id) instead of a hash table. The window
+// spans at most window_capacity ids. A live order that falls further behind the newest one, e.g. a
+// resting GTC order, moves to a sparse straggler map so it cannot pin the window open. Orders that
+// reach a terminal state are retired into a bounded FIFO archive, which keeps them available for
+// late lookups (e.g. a cancel racing a fill) until archive_capacity newer orders have retired.
+// Memory therefore stays proportional to the live orders plus the archive, not to session volume.
+class OrderInfoStore {
+  public:
+    static constexpr std::size_t default_archive_capacity = 1 << 16;
+    static constexpr std::size_t default_window_capacity = 1 << 16;
+
+    // window_capacity must be positive
+    explicit OrderInfoStore(std::size_t archive_capacity = default_archive_capacity,
+                            std::size_t window_capacity = default_window_capacity);
+
+    // Returns false without modifying the store if order_id is already live
+    bool emplace(int order_id, OrderInfo order_info);
+
+    // Looks up live orders first, then the archive. Throws std::out_of_range if neither has it.
+    OrderInfo& at(int order_id);
+    const OrderInfo& at(int order_id) const;
+
+    bool contains(int order_id) const;
+    bool is_live(int order_id) const;
+
+    // Moves a live order into the archive. Returns the id evicted from the archive to make room,
+    // so callers can drop any secondary index they keep for it.
+    std::optional<int> retire(int order_id);
+
+    std::size_t live_count() const {
+        return live_order_count;
+    }
+    std::size_t archived_count() const {
+        return archived_orders.size();
+    }
+    // Live orders held outside the dense window, included in live_count()
+    std::size_t straggler_count() const {
+        return straggler_orders.size();
+    }
+
+  private:
+    const OrderInfo* find_live(int order_id) const;
+    bool in_window(int order_id) const;
+    // Moves live orders below new_first_live_order_id out of the window into the straggler map
+    void advance_window(int new_first_live_order_id);
+    // Drops empty slots at both ends so the window only spans the oldest to the newest live order
+    void trim_window();
+
+    std::size_t window_capacity;
+    std::deque<std::optional<OrderInfo>> live_orders;
+    int first_live_order_id{0};
+    std::unordered_map<int, OrderInfo> straggler_orders;
+    std::size_t live_order_count{0};
+
+    std::size_t archive_capacity;
+    std::unordered_map<int, OrderInfo> archived_orders;
+    std::deque<int> archive_retirement_order; // Oldest retirement at the front
+};
+} // namespace om
@@ -1,10 +1,13 @@
 #include "order_manager.h"
+#include "execution_report_builder.h"
 #include "logger/logger.h"
+#include "order_manager_shard.h"
 #include "transport/messaging.h"
 
+#include <algorithm>
 #include <boost/contract.hpp>
-#include <boost/uuid.hpp>
 #include <cstdint>
+#include <limits>
 
 namespace om {
 
@@ -13,21 +16,83 @@ struct overloaded : Ts... {
     using Ts::operator()...;
 };
 
+// One side of a trade, seen from the order that took part in it
+struct TradeLeg {
+    TradeRole role;
+    int order_id;
+    const std::string& username;
+    bool is_buyer;
+};
+
+// Visits the legs of the trade selected by trade_legs, taker first
+template <class F>
+static void for_each_trade_leg(const core::TradeContainer& trade, TradeLegs trade_legs, F&& f) {
+    if (trade_legs.taker) {
+        f(TradeLeg{.role = TradeRole::taker,
+                   .order_id = trade.taker_order_id,
+                   .username = trade.taker_id,
+                   .is_buyer = trade.is_taker_buyer});
+    }
+    if (trade_legs.maker) {
+        f(TradeLeg{.role = TradeRole::maker,
+                   .order_id = trade.maker_order_id,
+                   .username = trade.maker_id,
+                   .is_buyer = !trade.is_taker_buyer});
+    }
+}
+
+// nullptr for containers without a sender, i.e. those not sent by a Gateway
+static const std::string* find_sender_comp_id(const core::Container& container) {
+    return std::visit(
+        [](const auto& request) -> const std::string* {
+            if constexpr (requires { request.sender_comp_id; }) {
+                return &request.sender_comp_id;
+            }
+            return nullptr;
+        },
+        container);
+}
+
 static std::shared_ptr<spdlog::logger> logger{logger::create_logger(
     "order_manager_logger",
     std::format("{}/logs/{}/order_manager.log", std::string(PROJECT_SOURCE_DIR), SERVER_NAME))};
 
 OrderManager::OrderManager(std::string_view host, int port,
                            const std::vector<std::string>& active_symbols,
-                           const OrderManagerDependencyFactory& dependency_factory)
-    : active_symbols{active_symbols.begin(), active_symbols.end()}, order_request_connection_id{-1},
+                           const OrderManagerDependencyFactory& dependency_factory, int shard_count,
+                           const RiskLimits& risk_limits, const BatchSizes& batch_sizes,
+                           bool defer_untraded_accounts)
+    : active_symbols{active_symbols.begin(), active_symbols.end()}, batch_sizes{batch_sizes},
+      defer_untraded_accounts{defer_untraded_accounts},
+      order_request_connection_id{-1},
       order_response_connection_id{-1}, inbound_server{dependency_factory.create_inbound_server(
                                             host, port, logger, gateway_connection_ids)},
       order_request_outbound_client{dependency_factory.create_outbound_client(logger)},
       order_response_outbound_client{dependency_factory.create_outbound_client(logger)},
-      database_client{dependency_factory.create_database_client(true)}, server_id{-1} {
+      message_notifier{std::make_shared<core::MessageNotifier>()},
+      database_client{dependency_factory.create_database_client(true)}, server_id{-1},
+      last_trade_prices{active_symbols} {
+    assert(shard_count > 0 && "Order Manager needs at least one shard");
+    assert(batch_sizes.matching_engine > 0 && batch_sizes.gateway > 0 &&
+           "Order Manager batch sizes must be positive");
+
+    inbound_server->set_message_notifier(message_notifier);
+    order_request_outbound_client->set_message_notifier(message_notifier);
+    order_response_outbound_client->set_message_notifier(message_notifier);
+
+    // Shards write from their own threads, so each gets its own DB connection
+    shards.reserve(shard_count);
+    for (int shard_id{0}; shard_id < shard_count; ++shard_id) {
+        shards.push_back(std::make_unique<OrderManagerShard>(
+            shard_id, make_shard_order_id_allocator(shard_id, shard_count), this->active_symbols,
+            username_user_id_map, risk_limits, last_trade_prices, *inbound_server,
+            *order_request_outbound_client, dependency_factory.create_database_client(false),
+            logger));
+    }
 }
 
+OrderManager::~OrderManager() = default;
+
 void OrderManager::init() {
     std::ignore =
         inbound_server->start()
@@ -54,13 +119,13 @@ void OrderManager::init() {
                           std::terminate();
                       });
 
-    init_balance_checker(balance_checker, username_user_id_map, *database_client);
-
+    std::int64_t initial_usd{};
     database_client->get_server(SERVER_NAME)
         .transform([&](std::optional<DbServerRow>&& server_row_res) {
             std::move(server_row_res)
                 .transform([&](DbServerRow&& server_row) {
                     server_id = server_row.server_id;
+                    initial_usd = server_row.initial_usd;
                     logger->info("Initialized server ID to {}", server_row.server_id);
                     return server_row;
                 })
@@ -75,12 +140,83 @@ void OrderManager::init() {
             std::terminate();
             return err;
         });
+
+    // Fetched once and split, rather than once per shard
+    const int shard_count = static_cast<int>(shards.size());
+    const std::optional<std::int64_t> deferred_account_usd =
+        defer_untraded_accounts ? std::optional{initial_usd} : std::nullopt;
+    std::ignore =
+        database_client->get_all_users_balances_for_server(SERVER_NAME)
+            .transform([&](std::vector<DbUserBalanceInfo>&& users_balances) {
+                for (int shard_id{0}; shard_id < shard_count; ++shard_id) {
+                    const auto owns_user{[&](int user_id) {
+                        return shard_for_user(user_id, shard_count) == shard_id;
+                    }};
+                    init_balance_checker(shards[shard_id]->get_balance_checker(),
+                                         username_user_id_map, users_balances, owns_user,
+                                         deferred_account_usd);
+                    if (deferred_account_usd.has_value()) {
+                        shards[shard_id]->defer_accounts_holding(deferred_account_usd.value());
+                    }
+                }
+            })
+            .transform_error([](std::string&& err) {
+                logger->error("[OM] Failed to load balances into balance_checker: {}", err);
+                std::terminate();
+                return err;
+            });
+    logger->info("[OM] Users partitioned across {} shards", shard_count);
+
+    // Each shard allocates order IDs from a range that depends on the shard count, and Matching
+    // Engine responses are routed by that range, so the count must not change between runs
+    std::ignore =
+        database_client->claim_order_id_shard_count(server_id, shard_count)
+            .transform([&](int claimed_shard_count) {
+                if (claimed_shard_count != shard_count) {
+                    logger->error("[OM] Order IDs of server {} were allocated across {} shards, "
+                                  "restart with shard_count = {} instead of {}",
+                                  SERVER_NAME, claimed_shard_count, claimed_shard_count,
+                                  shard_count);
+                    std::terminate();
+                }
+            })
+            .transform_error([](std::string&& err) {
+                logger->error("[OM] Failed to claim the order ID shard count: {}", err);
+                std::terminate();
+                return err;
+            });
+
+    // Pick up where a previous run left off, orders it accepted may still rest on the Matching
+    // Engine. Each goes to the shard owning its user, which holds the balance it reserved.
+    std::ignore =
+        database_client->get_live_orders(SERVER_NAME)
+            .transform([&](std::vector<DbLiveOrderRow>&& live_orders) {
+                std::vector<std::vector<DbLiveOrderRow>> shard_live_orders(shard_count);
+                for (auto& live_order : live_orders) {
+                    // restore_live_orders reports orders of unknown users, any shard will do
+                    const auto user_id_it = username_user_id_map.find(live_order.sender_comp_id);
+                    const int shard_id = user_id_it == username_user_id_map.end()
+                                             ? 0
+                                             : shard_for_user(user_id_it->second, shard_count);
+                    shard_live_orders[shard_id].push_back(std::move(live_order));
+                }
+
+                for (int shard_id{0}; shard_id < shard_count; ++shard_id) {
+                    shards[shard_id]->resume(server_id, shard_live_orders[shard_id]);
+                }
+            })
+            .transform_error([](std::string&& err) {
+                logger->error("[OM] Failed to load live orders from DB: {}", err);
+                std::terminate();
+                return err;
+            });
 }
 
-// Load all user balances into the balance_checker
+// Load user balances into the balance_checker
 void init_balance_checker(BalanceChecker& balance_checker,
                           OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
-                          OrderManagerDatabase& database_client) {
+                          OrderManagerDatabase& database_client,
+                          const std::function<bool(int)>& owns_user) {
     boost::contract::check c = boost::contract::function().precondition(
         [] { BOOST_CONTRACT_ASSERT(SERVER_NAME != nullptr); });
 
@@ -89,22 +225,8 @@ void init_balance_checker(BalanceChecker& balance_checker,
     std::ignore =
         database_client.get_all_users_balances_for_server(server_name)
             .transform([&](std::vector<DbUserBalanceInfo>&& users_balances) {
-                assert(users_balances.size() != 0 && "No user balances loaded from DB");
-                logger->info("[OM] Loading balances for {} users into balance_checker",
-                             users_balances.size());
-
-                for (const auto& [user_id, username, balances] : users_balances) {
-                    for (const auto& [symbol, balance] : balances) {
-                        // Initialize balance in balance_checker (delta of 0 just sets the
-                        // balance)
-                        balance_checker.update_balance(username, symbol, balance);
-                        logger->info("[OM] Loaded balance for user {}: {} {}", username, balance,
-                                     symbol);
-
-                        // TODO: Refine this temporary patchwork
-                        username_user_id_map.emplace(username, user_id);
-                    }
-                }
+                init_balance_checker(balance_checker, username_user_id_map, users_balances,
+                                     owns_user);
             })
             .transform_error([](std::string&& err) {
                 logger->error("[OM] Failed to load balances into balance_checker: {}", err);
@@ -113,6 +235,68 @@ void init_balance_checker(BalanceChecker& balance_checker,
             });
 }
 
+void init_balance_checker(BalanceChecker& balance_checker,
+                          OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                          const std::vector<DbUserBalanceInfo>& users_balances,
+                          const std::function<bool(int)>& owns_user,
+                          std::optional<std::int64_t> deferred_account_usd) {
+    assert(users_balances.size() != 0 && "No user balances loaded from DB");
+
+    auto is_untraded{[&](const std::vector<DbBalanceRow>& balances) {
+        return deferred_account_usd.has_value() && balances.size() == 1 &&
+               balances.front().symbol == USD_SYMBOL &&
+               balances.front().balance == deferred_account_usd.value();
+    }};
+
+    std::size_t loaded_user_count{0};
+    std::size_t loaded_balance_count{0};
+    std::size_t deferred_user_count{0};
+    for (const auto& [user_id, username, balances] : users_balances) {
+        // Users without any balance are unknown to the Order Manager, their requests are rejected
+        if (balances.empty()) {
+            continue;
+        }
+
+        // Mapped even when another shard owns the user, to route the user's requests there
+        username_user_id_map.emplace(username, user_id);
+        if (owns_user && !owns_user(user_id)) {
+            continue;
+        }
+
+        if (is_untraded(balances)) {
+            ++deferred_user_count;
+            continue;
+        }
+
+        const auto balance_user_id = balance_checker.intern_user(username);
+        for (const auto& [symbol, balance] : balances) {
+            // The account has no record of the symbol yet, so the delta sets the balance
+            balance_checker.update_balance(balance_user_id, balance_checker.intern_symbol(symbol),
+                                           balance);
+        }
+        ++loaded_user_count;
+        loaded_balance_count += balances.size();
+    }
+
+    logger->info("[OM] Loaded {} balances of {} users into balance_checker, deferred {} untraded "
+                 "users",
+                 loaded_balance_count, loaded_user_count, deferred_user_count);
+}
+
+void materialize_deferred_account(
+    const core::Container& container,
+    const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+    BalanceChecker& balance_checker, std::int64_t deferred_account_usd) {
+    const std::string* sender_comp_id = find_sender_comp_id(container);
+    if (sender_comp_id == nullptr || !username_user_id_map.contains(*sender_comp_id) ||
+        balance_checker.find_user(*sender_comp_id).has_value()) {
+        return;
+    }
+
+    balance_checker.update_balance(*sender_comp_id, USD_SYMBOL, deferred_account_usd);
+    logger->info("[OM] Materialized deferred account of user {}", *sender_comp_id);
+}
+
 // Spin locks until Order Manager is connected from at least one Gateway
 void OrderManager::wait_for_connections() const {
     while (gateway_connection_ids.size() == 0) {
@@ -176,81 +360,268 @@ void OrderManager::connect_matching_engine(std::string host, int port, int try_a
 }
 
 void OrderManager::run() {
-    auto gateway_ids_it = gateway_connection_ids.cbegin();
+    for (auto& shard : shards) {
+        shard->start(server_id, order_request_connection_id);
+    }
 
     while (true) {
-        // Process an incoming request
-        inbound_server->dequeue_message(*gateway_ids_it).transform([&](std::string&& new_message) {
-            auto container = transport::deserialize_container(new_message);
-
-            preprocess_container(container, order_id_map, order_info_map, username_user_id_map,
-                                 *gateway_ids_it, *order_request_outbound_client,
-                                 order_request_connection_id)
-                .transform([&](std::optional<int>&& market_bid_fill_cost) {
-                    const std::string validation_result = validate_container(
-                        container, active_symbols, balance_checker, market_bid_fill_cost);
-
-                    if (validation_result == "ok") {
-                        forward_and_reply(true, container, order_info_map, *gateway_ids_it,
-                                          *order_request_outbound_client,
-                                          order_request_connection_id, *inbound_server);
-                    } else {
-                        forward_and_reply(false, container, order_info_map, *gateway_ids_it,
-                                          *order_request_outbound_client,
-                                          order_request_connection_id, *inbound_server,
-                                          validation_result);
-                    }
+        // Taken before draining, so a message queued behind the drain still wakes the wait below
+        const auto ticket = message_notifier->ticket();
 
-                    update_database(container, server_id, username_user_id_map, order_info_map,
-                                    balance_checker, *database_client, validation_result == "ok");
-                })
-                .transform_error([&](std::string&& err) {
-                    forward_and_reply(false, container, order_info_map, *gateway_ids_it,
-                                      *order_request_outbound_client, order_request_connection_id,
-                                      *inbound_server, err);
+        int routed{route_matching_engine_responses() + route_fill_cost_responses()};
 
-                    update_database(container, server_id, username_user_id_map, order_info_map,
-                                    balance_checker, *database_client, false);
-                    return err;
-                });
+        // Matching Engine responses go again before each Gateway, fills are never stuck behind a
+        // sweep of the Gateways. Indexed, as Gateways connecting from the server thread may grow
+        // the vector.
+        for (std::size_t i{0}; i < gateway_connection_ids.size(); ++i) {
+            routed += route_gateway_requests(gateway_connection_ids[i]);
+            routed += route_matching_engine_responses() + route_fill_cost_responses();
+        }
 
-            return new_message;
-        });
+        if (routed == 0) {
+            message_notifier->wait(ticket);
+        }
+    }
+}
 
-        ++gateway_ids_it;
-        if (gateway_ids_it == gateway_connection_ids.cend()) {
-            gateway_ids_it = gateway_connection_ids.cbegin();
+// Hand incoming requests to the shard owning their sender
+int OrderManager::route_gateway_requests(int gateway_connection_id) {
+    const int shard_count = static_cast<int>(shards.size());
+
+    int routed{0};
+    for (; routed < batch_sizes.gateway; ++routed) {
+        auto new_message = inbound_server->dequeue_message(gateway_connection_id);
+        if (!new_message.has_value()) {
+            break;
         }
 
-        // Process a response container from matching engine
-        order_response_outbound_client->dequeue_message(order_response_connection_id)
-            .transform([&](std::string&& new_message) {
-                const auto container = transport::deserialize_container(new_message);
+        auto container = transport::deserialize_container(new_message.value());
+        const int shard_id = route_gateway_request(container, username_user_id_map, shard_count);
 
-                update_internal_data(container, order_info_map, balance_checker);
+        shards[shard_id]->post(GatewayRequest{.container = std::move(container),
+                                              .arrival_gateway_id = gateway_connection_id});
+    }
 
-                return_execution_report(container, order_id_map, order_info_map, *inbound_server);
+    return routed;
+}
 
-                update_database(container, server_id, username_user_id_map, order_info_map,
-                                balance_checker, *database_client);
+// Hand Fill Cost Responses to the shard that parked the market bid
+int OrderManager::route_fill_cost_responses() {
+    const int shard_count = static_cast<int>(shards.size());
 
-                return new_message;
-            });
+    int routed{0};
+    for (; routed < batch_sizes.matching_engine; ++routed) {
+        auto new_message =
+            order_request_outbound_client->dequeue_message(order_request_connection_id);
+        if (!new_message.has_value()) {
+            break;
+        }
+
+        auto container = transport::deserialize_container(new_message.value());
+        assert(std::holds_alternative<core::FillCostResponseContainer>(container) &&
+               "Unexpected container type received from Matching Engine");
+        logger->info("[OM] Fill Cost Response received: {}",
+                     std::get<core::FillCostResponseContainer>(container));
+
+        const int shard_id = route_matching_engine_response(container, shard_count).first.shard_id;
+        shards[shard_id]->post(MatchingEngineResponse{.container = std::move(container)});
     }
+
+    return routed;
 }
 
-std::expected<std::optional<int>, std::string>
-preprocess_container(core::Container& container, OrderManager::OrderIdMapContainer& order_id_map,
+// Hand response containers from the Matching Engine to the shard(s) owning their orders
+int OrderManager::route_matching_engine_responses() {
+    const int shard_count = static_cast<int>(shards.size());
+
+    int routed{0};
+    for (; routed < batch_sizes.matching_engine; ++routed) {
+        auto new_message =
+            order_response_outbound_client->dequeue_message(order_response_connection_id);
+        if (!new_message.has_value()) {
+            break;
+        }
+
+        auto container = transport::deserialize_container(new_message.value());
+        if (const auto* trade = std::get_if<core::TradeContainer>(&container)) {
+            last_trade_prices.record(trade->ticker, trade->price);
+        }
+
+        const auto [route, maker_route] = route_matching_engine_response(container, shard_count);
+
+        if (maker_route.has_value()) {
+            shards[maker_route->shard_id]->post(MatchingEngineResponse{
+                .container = container, .trade_legs = maker_route->trade_legs});
+        }
+        shards[route.shard_id]->post(MatchingEngineResponse{.container = std::move(container),
+                                                            .trade_legs = route.trade_legs});
+    }
+
+    return routed;
+}
+
+int OrderIdAllocator::next() {
+    if (next_order_id == end_order_id && queued_block.has_value()) {
+        std::tie(next_order_id, end_order_id) = queued_block.value();
+        queued_block.reset();
+    }
+
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(next_order_id < end_order_id); });
+
+    return next_order_id++;
+}
+
+void OrderIdAllocator::restart_at(int first_order_id, int end_order_id) {
+    boost::contract::check c = boost::contract::public_function(this).precondition([&] {
+        BOOST_CONTRACT_ASSERT(first_order_id < end_order_id);
+        BOOST_CONTRACT_ASSERT(end_order_id <= range_end_order_id);
+    });
+
+    next_order_id = first_order_id;
+    this->end_order_id = end_order_id;
+    queued_block.reset();
+}
+
+void OrderIdAllocator::queue_block(int first_order_id, int end_order_id) {
+    boost::contract::check c = boost::contract::public_function(this).precondition([&] {
+        BOOST_CONTRACT_ASSERT(!queued_block.has_value());
+        BOOST_CONTRACT_ASSERT(this->end_order_id <= first_order_id);
+        BOOST_CONTRACT_ASSERT(first_order_id < end_order_id);
+        BOOST_CONTRACT_ASSERT(end_order_id <= range_end_order_id);
+    });
+
+    queued_block.emplace(first_order_id, end_order_id);
+}
+
+int shard_for_user(int user_id, int shard_count) {
+    return user_id % shard_count;
+}
+
+// Splits the non-negative order ID space into shard_count equal contiguous ranges
+static int order_id_range_size(int shard_count) {
+    return std::numeric_limits<int>::max() / shard_count;
+}
+
+int shard_for_order_id(int order_id, int shard_count) {
+    boost::contract::check c = boost::contract::function().precondition([&] {
+        BOOST_CONTRACT_ASSERT(order_id >= 0);
+        BOOST_CONTRACT_ASSERT(order_id / order_id_range_size(shard_count) < shard_count);
+    });
+
+    return order_id / order_id_range_size(shard_count);
+}
+
+OrderIdAllocator make_shard_order_id_allocator(int shard_id, int shard_count) {
+    boost::contract::check c = boost::contract::function().precondition(
+        [&] { BOOST_CONTRACT_ASSERT(0 <= shard_id && shard_id < shard_count); });
+
+    const int range_size = order_id_range_size(shard_count);
+    return OrderIdAllocator{shard_id * range_size, (shard_id + 1) * range_size};
+}
+
+int route_gateway_request(const core::Container& container,
+                          const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                          int shard_count) {
+    const std::string* sender_comp_id = find_sender_comp_id(container);
+    if (sender_comp_id == nullptr) {
+        return 0;
+    }
+
+    const auto it = username_user_id_map.find(*sender_comp_id);
+    return it == username_user_id_map.end() ? 0 : shard_for_user(it->second, shard_count);
+}
+
+std::pair<ShardRoute, std::optional<ShardRoute>>
+route_matching_engine_response(const core::Container& container, int shard_count) {
+    auto fill_cost_response_handler{[&](const core::FillCostResponseContainer& fill_cost_response)
+                                        -> std::pair<ShardRoute, std::optional<ShardRoute>> {
+        // The request ID of a fill cost query is the parked order's internal order ID
+        return {ShardRoute{.shard_id = shard_for_order_id(fill_cost_response.request_id,
+                                                          shard_count)},
+                std::nullopt};
+    }};
+
+    auto trade_handler{[&](const core::TradeContainer& trade)
+                           -> std::pair<ShardRoute, std::optional<ShardRoute>> {
+        const int taker_shard_id = shard_for_order_id(trade.taker_order_id, shard_count);
+        const int maker_shard_id = shard_for_order_id(trade.maker_order_id, shard_count);
+        if (taker_shard_id == maker_shard_id) {
+            return {ShardRoute{.shard_id = taker_shard_id}, std::nullopt};
+        }
+
+        return {ShardRoute{.shard_id = taker_shard_id,
+                           .trade_legs = TradeLegs{.taker = true, .maker = false}},
+                ShardRoute{.shard_id = maker_shard_id,
+                           .trade_legs = TradeLegs{.taker = false, .maker = true}}};
+    }};
+
+    auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response)
+                                     -> std::pair<ShardRoute, std::optional<ShardRoute>> {
+        return {ShardRoute{.shard_id = shard_for_order_id(cancel_response.order_id, shard_count)},
+                std::nullopt};
+    }};
+
+    auto catch_all_handler{[](const auto&) -> std::pair<ShardRoute, std::optional<ShardRoute>> {
+        logger->error("[OM] Received unexpected container from Matching Engine");
+
+        std::terminate();
+    }};
+
+    return std::visit(overloaded{fill_cost_response_handler, trade_handler,
+                                 cancel_response_handler, catch_all_handler},
+                      container);
+}
+
+void restore_live_orders(const std::vector<DbLiveOrderRow>& live_orders,
+                         OrderManager::OrderIdMapContainer& order_id_map,
+                         OrderManager::OrderInfoMapContainer& order_info_map,
+                         const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                         const BalanceChecker& balance_checker, RiskChecker& risk_checker) {
+    for (const auto& live_order : live_orders) {
+        const auto user_id_it = username_user_id_map.find(live_order.sender_comp_id);
+        const auto balance_user_id = balance_checker.find_user(live_order.sender_comp_id);
+        if (user_id_it == username_user_id_map.end() || !balance_user_id.has_value()) {
+            logger->error("[OM] Live order {} belongs to unknown user {}, not restored",
+                          live_order.order_id, live_order.sender_comp_id);
+            continue;
+        }
+
+        const auto transformed_cl_ord_id =
+            live_order.cl_order_id * core::constants::max_user_count + user_id_it->second;
+        order_id_map.insert(OrderManager::OrderIdPair(live_order.order_id, transformed_cl_ord_id));
+
+        order_info_map.emplace(
+            live_order.order_id,
+            OrderInfo{.sender_comp_id = live_order.sender_comp_id,
+                      .symbol = live_order.symbol,
+                      .side = live_order.side,
+                      .price = live_order.price,
+                      .time_in_force = live_order.time_in_force,
+                      .leaves_qty = live_order.order_qty - live_order.filled_qty,
+                      .cum_qty = live_order.filled_qty,
+                      .avg_px = live_order.filled_qty > 0
+                                    ? static_cast<int>(live_order.filled_notional /
+                                                       live_order.filled_qty)
+                                    : 0,
+                      .arrival_gateway_id = unknown_gateway_id});
+
+        risk_checker.on_order_opened(balance_user_id.value());
+    }
+}
+
+std::expected<PreprocessResult, std::string>
+preprocess_container(core::Container& container, OrderIdAllocator& order_id_allocator,
+                     OrderManager::OrderIdMapContainer& order_id_map,
                      OrderManager::OrderInfoMapContainer& order_info_map,
                      const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                     OrderManager::PendingFillCostMapContainer& pending_fill_cost_map,
                      int arrival_gateway_id, transport::OutboundClient& order_request_ws_client,
                      int order_request_connection_id) {
-    // TODO: Fetch latest_assigned_order_id from DB
-    static int latest_assigned_order_id{-1};
     auto new_order_handler{[&](core::NewOrderSingleContainer& new_order)
-                               -> std::expected<std::optional<int>, std::string> {
+                               -> std::expected<PreprocessResult, std::string> {
         // Assign an internal order_id to NewOrderSingleContainer
-        new_order.order_id = ++latest_assigned_order_id;
+        new_order.order_id = order_id_allocator.next();
         logger->info("[OM] New Order Single received: {}", new_order);
 
         if (!username_user_id_map.contains(new_order.sender_comp_id)) {
@@ -278,35 +649,24 @@ preprocess_container(core::Container& container, OrderManager::OrderIdMapContain
                                          .avg_px = 0,
                                          .arrival_gateway_id = arrival_gateway_id});
 
-        // Market bid requires fill cost before proceeding
+        // Market bid requires fill cost before proceeding. Rather than blocking every gateway on
+        // the round trip, park the order until run() picks up the matching response.
         if (new_order.ord_type == core::OrderType::market && new_order.side == core::Side::bid) {
-            // Fetch fill cost from Matching Engine
             const auto fill_cost_query =
                 core::FillCostQueryContainer{.symbol = new_order.symbol,
                                              .quantity = new_order.order_qty,
-                                             .side = core::Side::ask};
+                                             .side = core::Side::ask,
+                                             .request_id = new_order.order_id.value()};
             return order_request_ws_client
                 .send(order_request_connection_id, transport::serialize_container(fill_cost_query))
-                .transform([&] -> std::optional<int> {
+                .transform([&] {
                     logger->info("[OM] Successfully sent Fill Cost Query: {}", fill_cost_query);
 
-                    auto response_message = order_request_ws_client.wait_and_dequeue_message(
-                        order_request_connection_id);
-                    while (!response_message.has_value()) {
-                        response_message = order_request_ws_client.wait_and_dequeue_message(
-                            order_request_connection_id);
-                    }
-
-                    const auto response_container =
-                        transport::deserialize_container(response_message.value());
-                    assert(std::holds_alternative<core::FillCostResponseContainer>(
-                               response_container) &&
-                           "Unexpected container type received from Matching Engine");
-                    const auto fill_cost_response =
-                        std::get<core::FillCostResponseContainer>(response_container);
-                    logger->info("[OM] Fill Cost Response received: {}", fill_cost_response);
-
-                    return fill_cost_response.total_cost;
+                    pending_fill_cost_map.emplace(
+                        fill_cost_query.request_id,
+                        PendingMarketBid{.new_order = new_order,
+                                         .arrival_gateway_id = arrival_gateway_id});
+                    return PreprocessResult::awaiting_fill_cost;
                 })
                 .transform_error([&](int) -> std::string {
                     logger->error("[OM] Failed to send Fill Cost Query: {}", fill_cost_query);
@@ -315,11 +675,11 @@ preprocess_container(core::Container& container, OrderManager::OrderIdMapContain
                 });
         }
 
-        return std::nullopt;
+        return PreprocessResult::ready;
     }};
 
     auto cancel_request_handler{[&](core::CancelOrderRequestContainer& cancel_request)
-                                    -> std::expected<std::optional<int>, std::string> {
+                                    -> std::expected<PreprocessResult, std::string> {
         logger->info("[OM] Cancel Order Request received: {}", cancel_request);
 
         if (!username_user_id_map.contains(cancel_request.sender_comp_id)) {
@@ -335,12 +695,20 @@ preprocess_container(core::Container& container, OrderManager::OrderIdMapContain
         if (const auto it = order_id_map.right.find(transformed_orig_cl_ord_id);
             it != order_id_map.right.end()) {
             cancel_request.order_id.emplace(it->second);
+
+            // A restored order reports to wherever its owner is connected now
+            if (order_info_map.is_live(it->second)) {
+                auto& order_info = order_info_map.at(it->second);
+                if (order_info.arrival_gateway_id == unknown_gateway_id) {
+                    order_info.arrival_gateway_id = arrival_gateway_id;
+                }
+            }
         }
 
-        return std::nullopt;
+        return PreprocessResult::ready;
     }};
 
-    auto catch_all_handler{[](auto&) -> std::expected<std::optional<int>, std::string> {
+    auto catch_all_handler{[](auto&) -> std::expected<PreprocessResult, std::string> {
         logger->error("[OM] UNREACHABLE");
 
         std::terminate();
@@ -350,6 +718,82 @@ preprocess_container(core::Container& container, OrderManager::OrderIdMapContain
                       container);
 }
 
+std::optional<PendingMarketBid>
+take_pending_market_bid(const core::FillCostResponseContainer& fill_cost_response,
+                        OrderManager::PendingFillCostMapContainer& pending_fill_cost_map) {
+    const auto it = pending_fill_cost_map.find(fill_cost_response.request_id);
+    if (it == pending_fill_cost_map.end()) {
+        logger->error("[OM] Fill Cost Response does not match any pending market bid: {}",
+                      fill_cost_response);
+        return std::nullopt;
+    }
+
+    auto pending_market_bid = std::move(it->second);
+    pending_fill_cost_map.erase(it);
+    return pending_market_bid;
+}
+
+std::string check_risk_limits(const core::Container& container,
+                              const BalanceChecker& balance_checker, RiskChecker& risk_checker,
+                              const LastTradePrices& last_trade_prices,
+                              RiskChecker::Clock::time_point now,
+                              std::optional<int> market_bid_fill_cost) {
+    auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) -> std::string {
+        // Unknown users are left for validate_container to reject
+        const auto user_id = balance_checker.find_user(new_order.sender_comp_id);
+        if (!user_id.has_value()) {
+            return "ok";
+        }
+
+        if (!risk_checker.admit_message(user_id.value(), now)) {
+            return "Message rate limit exceeded";
+        }
+        if (!risk_checker.within_order_qty(new_order.order_qty)) {
+            return "Order quantity exceeds limit";
+        }
+        if (!risk_checker.within_open_order_limit(user_id.value())) {
+            return "Open order limit reached";
+        }
+
+        // Market orders carry no price, value them at the quoted fill cost or the last trade
+        const auto last_trade_price = last_trade_prices.find(new_order.symbol);
+        std::optional<std::int64_t> notional;
+        if (new_order.price.has_value()) {
+            notional = static_cast<std::int64_t>(new_order.price.value()) * new_order.order_qty;
+        } else if (new_order.side == core::Side::bid && market_bid_fill_cost.has_value()) {
+            notional = market_bid_fill_cost.value();
+        } else if (last_trade_price.has_value()) {
+            notional = static_cast<std::int64_t>(last_trade_price.value()) * new_order.order_qty;
+        }
+        if (notional.has_value() && !risk_checker.within_order_notional(notional.value())) {
+            return "Order notional exceeds limit";
+        }
+
+        if (new_order.price.has_value() &&
+            !risk_checker.within_price_band(new_order.price.value(), last_trade_price)) {
+            return "Price outside band around last trade";
+        }
+
+        return "ok";
+    }};
+
+    auto cancel_request_handler{
+        [&](const core::CancelOrderRequestContainer& cancel_request) -> std::string {
+            const auto user_id = balance_checker.find_user(cancel_request.sender_comp_id);
+            if (user_id.has_value() && !risk_checker.admit_message(user_id.value(), now)) {
+                return "Message rate limit exceeded";
+            }
+
+            return "ok";
+        }};
+
+    // Unsupported requests are rejected by validate_container
+    auto catch_all_handler{[](const auto&) -> std::string { return "ok"; }};
+
+    return std::visit(overloaded{new_order_handler, cancel_request_handler, catch_all_handler},
+                      container);
+}
+
 std::string validate_container(const core::Container& container,
                                const std::unordered_set<std::string>& active_symbols,
                                BalanceChecker& balance_checker,
@@ -368,40 +812,39 @@ std::string validate_container(const core::Container& container,
             return "Quantity is not positive";
         }
 
-        // A broker must at least have a record for USD at the start
-        if (!balance_checker.broker_id_exists(new_order.sender_comp_id)) {
+        // A broker must at least have a record for USD at the start. Resolve the interned ids once,
+        // every check below is then an array access.
+        const auto user_id = balance_checker.find_user(new_order.sender_comp_id);
+        if (!user_id.has_value()) {
             return "Balance record for not found during validation";
         }
 
         switch (new_order.side) {
-        case core::Side::bid:
-            if (!balance_checker.broker_owns_ticker(new_order.sender_comp_id, USD_SYMBOL)) {
+        case core::Side::bid: {
+            const auto usd_symbol_id = balance_checker.find_symbol(USD_SYMBOL);
+            if (!usd_symbol_id.has_value() ||
+                !balance_checker.owns(user_id.value(), usd_symbol_id.value())) {
                 return "User has no USD balance record";
             }
 
             switch (new_order.ord_type) {
             case core::OrderType::limit: {
                 const std::int64_t reserved_usd =
-                    -static_cast<std::int64_t>(new_order.price.value()) * new_order.order_qty;
-                if (!balance_checker.has_sufficient_balance(new_order.sender_comp_id, USD_SYMBOL,
-                                                            reserved_usd)) {
+                    static_cast<std::int64_t>(new_order.price.value()) * new_order.order_qty;
+                if (!balance_checker.try_reserve(user_id.value(), usd_symbol_id.value(),
+                                                 reserved_usd)) {
                     return "User has insufficient USD balance";
                 }
-
-                balance_checker.update_balance(new_order.sender_comp_id, USD_SYMBOL, reserved_usd);
                 break;
             }
             case core::OrderType::market:
                 return market_bid_fill_cost
                     .transform([&](int fill_cost) {
-                        if (!balance_checker.has_sufficient_balance(new_order.sender_comp_id,
-                                                                    USD_SYMBOL, -fill_cost)) {
+                        if (!balance_checker.try_reserve(user_id.value(), usd_symbol_id.value(),
+                                                         fill_cost)) {
                             return "User has insufficient USD balance";
                         }
 
-                        balance_checker.update_balance(new_order.sender_comp_id, USD_SYMBOL,
-                                                       -fill_cost);
-
                         return "ok";
                     })
                     .value_or("User has insufficient USD balance");
@@ -413,20 +856,21 @@ std::string validate_container(const core::Container& container,
                 std::terminate();
             }
             break;
-        case core::Side::ask:
-            if (!balance_checker.broker_owns_ticker(new_order.sender_comp_id, new_order.symbol)) {
+        }
+        case core::Side::ask: {
+            const auto symbol_id = balance_checker.find_symbol(new_order.symbol);
+            if (!symbol_id.has_value() ||
+                !balance_checker.owns(user_id.value(), symbol_id.value())) {
                 return std::format("User has no {} record", new_order.symbol);
             }
 
-            if (!balance_checker.has_sufficient_balance(new_order.sender_comp_id, new_order.symbol,
-                                                        -new_order.order_qty)) {
+            if (!balance_checker.try_reserve(user_id.value(), symbol_id.value(),
+                                             new_order.order_qty)) {
                 return std::format("User has insufficient {} balance", new_order.symbol);
             }
 
-            balance_checker.update_balance(new_order.sender_comp_id, new_order.symbol,
-                                           -new_order.order_qty);
-
             break;
+        }
         default:
             logger->error("[OM] Unreachable");
 
@@ -478,11 +922,12 @@ void forward_and_reply(bool is_container_valid, const core::Container& container
             });
 
         // Gives immediate execution report as response back to broker
-        const auto execution_report = generate_success_report_container(container, order_info_map);
+        auto& report_builder = ExecutionReportBuilder::for_this_thread();
+        auto& execution_report = report_builder.start_report();
+        fill_success_report(execution_report, container, order_info_map);
 
         inbound_ws_server
-            .send(arrival_gateway_id, transport::serialize_container(execution_report),
-                  transport::MessageFormat::binary)
+            .send(arrival_gateway_id, report_builder.serialize(), transport::MessageFormat::binary)
             .transform([&] {
                 logger->info("[OM] Replied a success execution report: {}", execution_report);
             })
@@ -494,12 +939,13 @@ void forward_and_reply(bool is_container_valid, const core::Container& container
             });
     } else {
         // Give immediate execution report as feedback on rejection to broker
-        const auto execution_report = generate_rejection_report_container(
-            container, order_info_map, order_reject_reason.value());
+        auto& report_builder = ExecutionReportBuilder::for_this_thread();
+        auto& execution_report = report_builder.start_report();
+        fill_rejection_report(execution_report, container, order_info_map,
+                              order_reject_reason.value());
 
         inbound_ws_server
-            .send(arrival_gateway_id, transport::serialize_container(execution_report),
-                  transport::MessageFormat::binary)
+            .send(arrival_gateway_id, report_builder.serialize(), transport::MessageFormat::binary)
             .transform([&] {
                 logger->info("[OM] Replied a rejection execution report: {}", execution_report);
             })
@@ -512,129 +958,129 @@ void forward_and_reply(bool is_container_valid, const core::Container& container
     }
 }
 
-core::ExecutionReportContainer
-generate_rejection_report_container(const core::Container& container,
-                                    const OrderManager::OrderInfoMapContainer& order_info_store,
-                                    std::string_view order_reject_reason) {
+void fill_rejection_report(core::ExecutionReportContainer& report,
+                           const core::Container& container,
+                           const OrderManager::OrderInfoMapContainer& order_info_map,
+                           std::string_view order_reject_reason) {
     auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
-        return core::ExecutionReportContainer{
-            .sender_comp_id = SERVER_NAME,
-            .target_comp_id = new_order.sender_comp_id,
-            .order_id = new_order.order_id.value(),
-            .cl_order_id = new_order.cl_ord_id,
-            .orig_cl_ord_id = std::nullopt,
-            .exec_id = to_string(boost::uuids::time_generator_v7()()),
-            .exec_trans_type = core::ExecTransType::exec_trans_new,
-            .exec_type = core::ExecType::status_rejected,
-            .ord_status = core::OrderStatus::status_rejected,
-            .text = static_cast<std::string>(order_reject_reason),
-            .symbol = new_order.symbol,
-            .side = new_order.side,
-            .price = new_order.price,
-            .time_in_force = new_order.time_in_force,
-            .leaves_qty = 0,
-            .cum_qty = 0,
-            .avg_px = 0};
+        report.target_comp_id = new_order.sender_comp_id;
+        report.order_id = new_order.order_id.value();
+        report.cl_order_id = new_order.cl_ord_id;
+        report.orig_cl_ord_id = std::nullopt;
+        report.exec_trans_type = core::ExecTransType::exec_trans_new;
+        report.exec_type = core::ExecType::status_rejected;
+        report.ord_status = core::OrderStatus::status_rejected;
+        report.text = order_reject_reason;
+        report.symbol = new_order.symbol;
+        report.side = new_order.side;
+        report.price = new_order.price;
+        report.time_in_force = new_order.time_in_force;
+        report.leaves_qty = 0;
+        report.cum_qty = 0;
+        report.avg_px = 0;
     }};
 
     auto cancel_request_handler{[&](const core::CancelOrderRequestContainer& cancel_request) {
-        const auto order_info =
-            cancel_request.order_id
-                .transform([&](int order_id) -> OrderInfo { return order_info_store.at(order_id); })
-                .or_else([]() -> std::optional<OrderInfo> { return OrderInfo{}; })
-                .value();
-
-        return core::ExecutionReportContainer{
-            .sender_comp_id = SERVER_NAME,
-            .target_comp_id = cancel_request.sender_comp_id,
-            .order_id = cancel_request.order_id.value_or(-1),
-            .cl_order_id = cancel_request.cl_ord_id,
-            .orig_cl_ord_id = cancel_request.orig_cl_ord_id,
-            .exec_id = to_string(boost::uuids::time_generator_v7()()),
-            .exec_trans_type = core::ExecTransType::exec_trans_new,
-            .exec_type = core::ExecType::status_rejected,
-            .ord_status = core::OrderStatus::status_rejected,
-            .text = static_cast<std::string>(order_reject_reason),
-            .symbol = order_info.symbol,
-            .side = order_info.side,
-            .price = order_info.price,
-            .time_in_force = order_info.time_in_force,
-            .leaves_qty = 0,
-            .cum_qty = order_info.cum_qty,
-            .avg_px = order_info.avg_px};
+        static const OrderInfo unknown_order_info{};
+        const auto& order_info = cancel_request.order_id.has_value()
+                                     ? order_info_map.at(cancel_request.order_id.value())
+                                     : unknown_order_info;
+
+        report.target_comp_id = cancel_request.sender_comp_id;
+        report.order_id = cancel_request.order_id.value_or(-1);
+        report.cl_order_id = cancel_request.cl_ord_id;
+        report.orig_cl_ord_id = cancel_request.orig_cl_ord_id;
+        report.exec_trans_type = core::ExecTransType::exec_trans_new;
+        report.exec_type = core::ExecType::status_rejected;
+        report.ord_status = core::OrderStatus::status_rejected;
+        report.text = order_reject_reason;
+        report.symbol = order_info.symbol;
+        report.side = order_info.side;
+        report.price = order_info.price;
+        report.time_in_force = order_info.time_in_force;
+        report.leaves_qty = 0;
+        report.cum_qty = order_info.cum_qty;
+        report.avg_px = order_info.avg_px;
     }};
 
     auto catch_all_handler{[](const auto&) {
         logger->error("Unreachable");
 
         std::terminate();
-        return core::ExecutionReportContainer{};
     }};
 
-    return std::visit(overloaded{new_order_handler, cancel_request_handler, catch_all_handler},
-                      container);
+    std::visit(overloaded{new_order_handler, cancel_request_handler, catch_all_handler},
+               container);
 }
 
 core::ExecutionReportContainer
-generate_success_report_container(const core::Container& container,
-                                  const OrderManager::OrderInfoMapContainer& order_info_map) {
-    auto new_order_handler{[](const core::NewOrderSingleContainer& new_order) {
-        return core::ExecutionReportContainer{
-            .sender_comp_id = SERVER_NAME,
-            .target_comp_id = new_order.sender_comp_id,
-            .order_id = new_order.order_id.value(),
-            .cl_order_id = new_order.cl_ord_id,
-            .orig_cl_ord_id = std::nullopt,
-            .exec_id = to_string(boost::uuids::time_generator_v7()()),
-            .exec_trans_type = core::ExecTransType::exec_trans_new,
-            .exec_type = core::ExecType::status_new,
-            .ord_status = core::OrderStatus::status_new,
-            .text = std::nullopt,
-            .symbol = new_order.symbol,
-            .side = new_order.side,
-            .price = new_order.price,
-            .time_in_force = new_order.time_in_force,
-            .leaves_qty = new_order.order_qty,
-            .cum_qty = 0,
-            .avg_px = 0};
+generate_rejection_report_container(const core::Container& container,
+                                    const OrderManager::OrderInfoMapContainer& order_info_map,
+                                    std::string_view order_reject_reason) {
+    auto report = ExecutionReportBuilder::for_this_thread().start_report();
+    fill_rejection_report(report, container, order_info_map, order_reject_reason);
+    return report;
+}
+
+void fill_success_report(core::ExecutionReportContainer& report, const core::Container& container,
+                         const OrderManager::OrderInfoMapContainer& order_info_map) {
+    auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
+        report.target_comp_id = new_order.sender_comp_id;
+        report.order_id = new_order.order_id.value();
+        report.cl_order_id = new_order.cl_ord_id;
+        report.orig_cl_ord_id = std::nullopt;
+        report.exec_trans_type = core::ExecTransType::exec_trans_new;
+        report.exec_type = core::ExecType::status_new;
+        report.ord_status = core::OrderStatus::status_new;
+        report.text = std::nullopt;
+        report.symbol = new_order.symbol;
+        report.side = new_order.side;
+        report.price = new_order.price;
+        report.time_in_force = new_order.time_in_force;
+        report.leaves_qty = new_order.order_qty;
+        report.cum_qty = 0;
+        report.avg_px = 0;
     }};
 
     auto cancel_request_handler{[&](const core::CancelOrderRequestContainer& cancel_request) {
         const auto& order_info = order_info_map.at(cancel_request.order_id.value());
-        return core::ExecutionReportContainer{
-            .sender_comp_id = SERVER_NAME,
-            .target_comp_id = cancel_request.sender_comp_id,
-            .order_id = cancel_request.order_id.value(),
-            .cl_order_id = cancel_request.cl_ord_id,
-            .orig_cl_ord_id = cancel_request.orig_cl_ord_id,
-            .exec_id = to_string(boost::uuids::time_generator_v7()()),
-            .exec_trans_type = core::ExecTransType::exec_trans_new,
-            .exec_type = core::ExecType::status_pending_cancel,
-            .ord_status = core::OrderStatus::status_pending_cancel,
-            .text = std::nullopt,
-            .symbol = order_info.symbol,
-            .side = order_info.side,
-            .price = order_info.price,
-            .time_in_force = order_info.time_in_force,
-            .leaves_qty = order_info.leaves_qty,
-            .cum_qty = order_info.cum_qty,
-            .avg_px = order_info.avg_px};
-    }};
 
-    auto catch_all_handler{[](const auto&) {
-        assert(false && "Unreachable");
-        return core::ExecutionReportContainer{};
+        report.target_comp_id = cancel_request.sender_comp_id;
+        report.order_id = cancel_request.order_id.value();
+        report.cl_order_id = cancel_request.cl_ord_id;
+        report.orig_cl_ord_id = cancel_request.orig_cl_ord_id;
+        report.exec_trans_type = core::ExecTransType::exec_trans_new;
+        report.exec_type = core::ExecType::status_pending_cancel;
+        report.ord_status = core::OrderStatus::status_pending_cancel;
+        report.text = std::nullopt;
+        report.symbol = order_info.symbol;
+        report.side = order_info.side;
+        report.price = order_info.price;
+        report.time_in_force = order_info.time_in_force;
+        report.leaves_qty = order_info.leaves_qty;
+        report.cum_qty = order_info.cum_qty;
+        report.avg_px = order_info.avg_px;
     }};
 
-    return std::visit(overloaded{new_order_handler, cancel_request_handler, catch_all_handler},
-                      container);
+    auto catch_all_handler{[](const auto&) { assert(false && "Unreachable"); }};
+
+    std::visit(overloaded{new_order_handler, cancel_request_handler, catch_all_handler},
+               container);
+}
+
+core::ExecutionReportContainer
+generate_success_report_container(const core::Container& container,
+                                  const OrderManager::OrderInfoMapContainer& order_info_map) {
+    auto report = ExecutionReportBuilder::for_this_thread().start_report();
+    fill_success_report(report, container, order_info_map);
+    return report;
 }
 
 void update_database(const core::Container& container, int server_id,
                      const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
                      const OrderManager::OrderInfoMapContainer& order_info_map,
                      const BalanceChecker& balance_checker, OrderManagerDatabase& database_client,
-                     std::optional<bool> valid_container) {
+                     std::optional<bool> valid_container, TradeLegs trade_legs) {
     auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
         boost::contract::check c = boost::contract::function().precondition([&] {
             BOOST_CONTRACT_ASSERT(new_order.order_id.has_value());
@@ -645,6 +1091,22 @@ void update_database(const core::Container& container, int server_id,
 
         database_client.insert_order(new_order.order_id.value(), new_order,
                                      valid_container.value());
+
+        // Persist the reservation too, so balances restored after a restart already account for
+        // the orders still resting on the Matching Engine
+        if (valid_container.value()) {
+            const std::string& symbol =
+                new_order.side == core::Side::bid ? USD_SYMBOL : new_order.symbol;
+            const auto balance = balance_checker.get_balance(new_order.sender_comp_id, symbol);
+
+            database_client
+                .update_balance(username_user_id_map.at(new_order.sender_comp_id), server_id,
+                                symbol, balance)
+                .transform_error([&](std::string&& err) {
+                    logger->error(err);
+                    return err;
+                });
+        }
     }};
 
     auto cancel_request_handler{[&](const core::CancelOrderRequestContainer& cancel_request) {
@@ -661,57 +1123,29 @@ void update_database(const core::Container& container, int server_id,
     }};
 
     auto trade_handler{[&](const core::TradeContainer& trade) {
-        logger->info("[OM] Persisting Trade: {}", trade);
-        database_client.insert_trade(trade);
-
-        const auto& symbol = trade.ticker;
-        const auto& buyer_id = trade.is_taker_buyer ? trade.taker_id : trade.maker_id;
-        const int buyer_user_id = username_user_id_map.at(buyer_id);
-        const auto& buyer_usd_balance = balance_checker.get_balance(buyer_id, USD_SYMBOL);
-        const auto& buyer_symbol_balance = balance_checker.get_balance(buyer_id, symbol);
+        // When the trade is split across shards, the taker's shard records it
+        if (trade_legs.taker) {
+            logger->info("[OM] Persisting Trade: {}", trade);
+            database_client.insert_trade(trade);
+        }
 
-        database_client.update_balance(buyer_user_id, server_id, USD_SYMBOL, buyer_usd_balance)
-            .transform([&] {
-                logger->info("[OM] Updating {}'s {} balance to {} in DB", buyer_id, USD_SYMBOL,
-                             buyer_usd_balance);
-            })
-            .transform_error([&](std::string&& err) {
-                logger->error(err);
-                return err;
-            });
-        database_client.update_balance(buyer_user_id, server_id, symbol, buyer_symbol_balance)
-            .transform([&] {
-                logger->info("[OM] Updating {}'s {} balance to {} in DB", buyer_id, symbol,
-                             buyer_symbol_balance);
-            })
-            .transform_error([&](std::string&& err) {
-                logger->error(err);
-                return err;
-            });
+        for_each_trade_leg(trade, trade_legs, [&](const TradeLeg& leg) {
+            const int user_id = username_user_id_map.at(leg.username);
 
-        const auto& seller_id = trade.is_taker_buyer ? trade.maker_id : trade.taker_id;
-        const int seller_user_id = username_user_id_map.at(seller_id);
-        const auto& seller_usd_balance = balance_checker.get_balance(seller_id, USD_SYMBOL);
-        const auto& seller_symbol_balance = balance_checker.get_balance(seller_id, symbol);
+            for (const std::string& symbol : {USD_SYMBOL, trade.ticker}) {
+                const auto balance = balance_checker.get_balance(leg.username, symbol);
 
-        database_client.update_balance(seller_user_id, server_id, USD_SYMBOL, seller_usd_balance)
-            .transform([&] {
-                logger->info("[OM] Updating {}'s {} balance to {} in DB", seller_id, USD_SYMBOL,
-                             seller_usd_balance);
-            })
-            .transform_error([&](std::string&& err) {
-                logger->error(err);
-                return err;
-            });
-        database_client.update_balance(seller_user_id, server_id, symbol, seller_symbol_balance)
-            .transform([&] {
-                logger->info("[OM] Updating {}'s {} balance to {} in DB", seller_id, symbol,
-                             seller_symbol_balance);
-            })
-            .transform_error([&](std::string&& err) {
-                logger->error(err);
-                return err;
-            });
+                database_client.update_balance(user_id, server_id, symbol, balance)
+                    .transform([&] {
+                        logger->info("[OM] Updating {}'s {} balance to {} in DB", leg.username,
+                                     symbol, balance);
+                    })
+                    .transform_error([&](std::string&& err) {
+                        logger->error(err);
+                        return err;
+                    });
+            }
+        });
     }};
 
     auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response) {
@@ -722,14 +1156,10 @@ void update_database(const core::Container& container, int server_id,
         if (cancel_response.success) {
             const auto& order_info = order_info_map.at(cancel_response.order_id);
             if (order_info.side == core::Side::bid) {
-                assert(order_info.price.has_value() && "Only limit order should be cancellable");
-
                 database_client.update_balance(
                     username_user_id_map.at(order_info.sender_comp_id), server_id, USD_SYMBOL,
                     balance_checker.get_balance(order_info.sender_comp_id, USD_SYMBOL));
             } else {
-                assert(order_info.price.has_value() && "Only limit order should be cancellable");
-
                 database_client.update_balance(
                     username_user_id_map.at(order_info.sender_comp_id), server_id,
                     order_info.symbol,
@@ -747,64 +1177,82 @@ void update_database(const core::Container& container, int server_id,
 
 void update_internal_data(const core::Container& container,
                           OrderManager::OrderInfoMapContainer& order_info_map,
-                          BalanceChecker& balance_checker) {
+                          BalanceChecker& balance_checker, TradeLegs trade_legs) {
     auto trade_handler{[&](const core::TradeContainer& trade) {
         boost::contract::check c = boost::contract::function().precondition([&] {
-            BOOST_CONTRACT_ASSERT(order_info_map.contains(trade.taker_order_id));
-            BOOST_CONTRACT_ASSERT(order_info_map.contains(trade.maker_order_id));
+            BOOST_CONTRACT_ASSERT(!trade_legs.taker ||
+                                  order_info_map.contains(trade.taker_order_id));
+            BOOST_CONTRACT_ASSERT(!trade_legs.maker ||
+                                  order_info_map.contains(trade.maker_order_id));
         });
 
-        auto& taker_order_info = order_info_map.at(trade.taker_order_id);
-        taker_order_info.avg_px =
-            (taker_order_info.avg_px * taker_order_info.cum_qty + trade.price * trade.quantity) /
-            (trade.quantity + taker_order_info.cum_qty);
-        taker_order_info.leaves_qty -= trade.quantity;
-        taker_order_info.cum_qty += trade.quantity;
-
-        auto& maker_order_info = order_info_map.at(trade.maker_order_id);
-        maker_order_info.avg_px =
-            (maker_order_info.avg_px * maker_order_info.cum_qty + trade.price * trade.quantity) /
-            (trade.quantity + maker_order_info.cum_qty);
-        maker_order_info.leaves_qty -= trade.quantity;
-        maker_order_info.cum_qty += trade.quantity;
-
-        // Buyer's stock balance should increase from buying
-        const auto& buyer_id = trade.is_taker_buyer ? trade.taker_id : trade.maker_id;
-        balance_checker.update_balance(buyer_id, trade.ticker, trade.quantity);
-
-        // A limit buyer may pay a lower price than the original order stated, refund the
-        // excess deducted balance
-        const auto buyer_order_id =
-            trade.is_taker_buyer ? trade.taker_order_id : trade.maker_order_id;
-
-        order_info_map.at(buyer_order_id).price.transform([&](int price) {
-            const auto price_improvement = price - trade.price;
-            assert(price_improvement >= 0 && "Only price improvement should happen");
-
-            if (price_improvement > 0)
-                balance_checker.update_balance(buyer_id, USD_SYMBOL,
-                                               price_improvement * trade.quantity);
-
-            return price;
-        });
+        for_each_trade_leg(trade, trade_legs, [&](const TradeLeg& leg) {
+            auto& order_info = order_info_map.at(leg.order_id);
+            order_info.avg_px =
+                (order_info.avg_px * order_info.cum_qty + trade.price * trade.quantity) /
+                (trade.quantity + order_info.cum_qty);
+            order_info.leaves_qty -= trade.quantity;
+            order_info.cum_qty += trade.quantity;
+
+            if (leg.is_buyer) {
+                // Buyer's stock balance should increase from buying
+                balance_checker.update_balance(leg.username, trade.ticker, trade.quantity);
+
+                // A limit buyer may pay a lower price than the original order stated, refund the
+                // excess deducted balance
+                order_info.price.transform([&](int price) {
+                    const auto price_improvement = price - trade.price;
+                    assert(price_improvement >= 0 && "Only price improvement should happen");
+
+                    if (price_improvement > 0)
+                        balance_checker.update_balance(leg.username, USD_SYMBOL,
+                                                       price_improvement * trade.quantity);
+
+                    return price;
+                });
 
-        // Seller's USD balance should increase from selling stocks
-        const auto& seller_id = trade.is_taker_buyer ? trade.maker_id : trade.taker_id;
-        balance_checker.update_balance(seller_id, USD_SYMBOL, trade.price * trade.quantity);
+                // A market buyer pays each fill out of its reserved fill cost. The quote may have
+                // gone stale, so a fill the reservation no longer covers is debited directly.
+                if (!order_info.price.has_value()) {
+                    const auto notional = static_cast<std::int64_t>(trade.price) * trade.quantity;
+                    const auto covered = std::min(notional, order_info.reserved_usd);
+                    order_info.reserved_usd -= covered;
+                    if (notional > covered) {
+                        balance_checker.update_balance(leg.username, USD_SYMBOL,
+                                                       covered - notional);
+                    }
+                    if (order_info.leaves_qty == 0 && order_info.reserved_usd > 0) {
+                        balance_checker.update_balance(leg.username, USD_SYMBOL,
+                                                       order_info.reserved_usd);
+                        order_info.reserved_usd = 0;
+                    }
+                }
+            } else {
+                // Seller's USD balance should increase from selling stocks
+                balance_checker.update_balance(leg.username, USD_SYMBOL,
+                                               trade.price * trade.quantity);
+            }
+        });
     }};
 
     auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response) {
         if (cancel_response.success) {
-            const auto& order_info = order_info_map.at(cancel_response.order_id);
+            auto& order_info = order_info_map.at(cancel_response.order_id);
 
+            // A market order is cancelled when the Matching Engine drops its unfilled remainder.
+            // A market bid reserved a fill cost rather than a price per share, so it gets back
+            // what its fills did not spend while a limit bid gets a refund per unfilled share.
             if (order_info.side == core::Side::bid) {
-                assert(order_info.price.has_value() && "Only limit order should be cancellable");
-
-                balance_checker.update_balance(order_info.sender_comp_id, USD_SYMBOL,
-                                               order_info.price.value() * order_info.leaves_qty);
+                if (order_info.price.has_value()) {
+                    balance_checker.update_balance(order_info.sender_comp_id, USD_SYMBOL,
+                                                   order_info.price.value() *
+                                                       order_info.leaves_qty);
+                } else {
+                    balance_checker.update_balance(order_info.sender_comp_id, USD_SYMBOL,
+                                                   order_info.reserved_usd);
+                    order_info.reserved_usd = 0;
+                }
             } else {
-                assert(order_info.price.has_value() && "Only limit order should be cancellable");
-
                 balance_checker.update_balance(order_info.sender_comp_id, order_info.symbol,
                                                order_info.leaves_qty);
             }
@@ -820,47 +1268,123 @@ void update_internal_data(const core::Container& container,
     std::visit(overloaded{trade_handler, cancel_response_handler, catch_all_handler}, container);
 }
 
-void return_execution_report(const core::Container& container,
-                             const OrderManager::OrderIdMapContainer& order_id_map,
-                             const OrderManager::OrderInfoMapContainer& order_info_map,
-                             transport::InboundServer& inbound_ws_server) {
+void update_risk_state(const core::Container& container,
+                       const OrderManager::OrderInfoMapContainer& order_info_map,
+                       const BalanceChecker& balance_checker, RiskChecker& risk_checker,
+                       std::optional<bool> valid_container, TradeLegs trade_legs) {
+    auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
+        boost::contract::check c = boost::contract::function().precondition(
+            [&] { BOOST_CONTRACT_ASSERT(valid_container.has_value()); });
+
+        // Only orders forwarded to the Matching Engine count as open
+        if (valid_container.value()) {
+            risk_checker.on_order_opened(
+                balance_checker.find_user(new_order.sender_comp_id).value());
+        }
+    }};
+
     auto trade_handler{[&](const core::TradeContainer& trade) {
-        const auto [taker_exec_report, maker_exec_report] =
-            generate_matched_order_report_containers(trade, order_id_map, order_info_map);
+        for_each_trade_leg(trade, trade_legs, [&](const TradeLeg& leg) {
+            if (order_info_map.at(leg.order_id).leaves_qty == 0) {
+                risk_checker.on_order_closed(balance_checker.find_user(leg.username).value());
+            }
+        });
+    }};
 
-        const int taker_order_arrival_gateway_id{
-            order_info_map.at(trade.taker_order_id).arrival_gateway_id};
-        inbound_ws_server
-            .send(taker_order_arrival_gateway_id, transport::serialize_container(taker_exec_report))
-            .transform([&] {
-                logger->info("Successfully returned execution report: {}", taker_exec_report);
-            })
-            .transform_error([&](int err) {
-                logger->error("Failed to returned execution report: {}", taker_exec_report);
+    auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response) {
+        if (cancel_response.success) {
+            const auto& order_info = order_info_map.at(cancel_response.order_id);
+            risk_checker.on_order_closed(
+                balance_checker.find_user(order_info.sender_comp_id).value());
+        }
+    }};
 
-                return err;
-            });
+    // Cancel requests and execution reports do not open or close an order on their own
+    auto catch_all_handler{[](const auto&) {}};
 
-        const int maker_order_arrival_gateway_id{
-            order_info_map.at(trade.maker_order_id).arrival_gateway_id};
-        inbound_ws_server
-            .send(maker_order_arrival_gateway_id, transport::serialize_container(maker_exec_report))
-            .transform([&] {
-                logger->info("Successfully returned execution report: {}", maker_exec_report);
-            })
-            .transform_error([&](int err) {
-                logger->error("Failed to returned execution report: {}", maker_exec_report);
+    std::visit(overloaded{new_order_handler, trade_handler, cancel_response_handler,
+                          catch_all_handler},
+               container);
+}
 
-                return err;
-            });
+// Moves orders that can no longer trade out of the live set. Must run after every other handler
+// for the container, since the execution reports and DB rows above still read the order's state.
+void retire_terminal_orders(const core::Container& container,
+                            OrderManager::OrderIdMapContainer& order_id_map,
+                            OrderManager::OrderInfoMapContainer& order_info_map,
+                            std::optional<bool> valid_container) {
+    auto retire{[&](int order_id) {
+        if (!order_info_map.is_live(order_id)) {
+            return;
+        }
+        // The archive is bounded, forget the client order ID of whichever order it pushed out
+        if (const auto evicted_order_id = order_info_map.retire(order_id)) {
+            order_id_map.left.erase(evicted_order_id.value());
+        }
     }};
+
+    auto new_order_handler{[&](const core::NewOrderSingleContainer& new_order) {
+        boost::contract::check c = boost::contract::function().precondition(
+            [&] { BOOST_CONTRACT_ASSERT(valid_container.has_value()); });
+
+        // A rejected order never reaches the Matching Engine
+        if (!valid_container.value() && new_order.order_id.has_value()) {
+            retire(new_order.order_id.value());
+        }
+    }};
+
+    auto trade_handler{[&](const core::TradeContainer& trade) {
+        for (const int order_id : {trade.taker_order_id, trade.maker_order_id}) {
+            if (order_info_map.is_live(order_id) && order_info_map.at(order_id).leaves_qty == 0) {
+                retire(order_id);
+            }
+        }
+    }};
+
     auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response) {
-        const auto exec_report = generate_cancel_response_report_container(
-            cancel_response, order_id_map, order_info_map);
+        if (cancel_response.success) {
+            retire(cancel_response.order_id);
+        }
+    }};
+
+    // Cancel requests and execution reports do not end an order's lifecycle on their own
+    auto catch_all_handler{[](const auto&) {}};
+
+    std::visit(overloaded{new_order_handler, trade_handler, cancel_response_handler,
+                          catch_all_handler},
+               container);
+}
+
+void return_execution_report(const core::Container& container,
+                             const OrderManager::OrderIdMapContainer& order_id_map,
+                             const OrderManager::OrderInfoMapContainer& order_info_map,
+                             transport::InboundServer& inbound_ws_server, TradeLegs trade_legs) {
+    auto trade_handler{[&](const core::TradeContainer& trade) {
+        for_each_trade_leg(trade, trade_legs, [&](const TradeLeg& leg) {
+            auto& report_builder = ExecutionReportBuilder::for_this_thread();
+            auto& exec_report = report_builder.start_report();
+            fill_matched_order_report(exec_report, trade, leg.role, order_id_map, order_info_map);
+
+            const int arrival_gateway_id{order_info_map.at(leg.order_id).arrival_gateway_id};
+            inbound_ws_server.send(arrival_gateway_id, report_builder.serialize())
+                .transform([&] {
+                    logger->info("Successfully returned execution report: {}", exec_report);
+                })
+                .transform_error([&](int err) {
+                    logger->error("Failed to returned execution report: {}", exec_report);
+
+                    return err;
+                });
+        });
+    }};
+    auto cancel_response_handler{[&](const core::CancelOrderResponseContainer& cancel_response) {
+        auto& report_builder = ExecutionReportBuilder::for_this_thread();
+        auto& exec_report = report_builder.start_report();
+        fill_cancel_response_report(exec_report, cancel_response, order_id_map, order_info_map);
+
         const int orig_order_arrival_gateway_id{
             order_info_map.at(cancel_response.order_id).arrival_gateway_id};
-        inbound_ws_server
-            .send(orig_order_arrival_gateway_id, transport::serialize_container(exec_report))
+        inbound_ws_server.send(orig_order_arrival_gateway_id, report_builder.serialize())
             .transform(
                 [&] { logger->info("Successfully returned execution report: {}", exec_report); })
             .transform_error([&](int err) {
@@ -878,81 +1402,88 @@ void return_execution_report(const core::Container& container,
     std::visit(overloaded{trade_handler, cancel_response_handler, catch_all_handler}, container);
 }
 
+void fill_matched_order_report(core::ExecutionReportContainer& report,
+                               const core::TradeContainer& trade, TradeRole role,
+                               const OrderManager::OrderIdMapContainer& order_id_map,
+                               const OrderManager::OrderInfoMapContainer& order_info_map) {
+    const bool is_taker = role == TradeRole::taker;
+    const int order_id = is_taker ? trade.taker_order_id : trade.maker_order_id;
+    const auto& order_info = order_info_map.at(order_id);
+
+    report.target_comp_id = is_taker ? trade.taker_id : trade.maker_id;
+    report.order_id = order_id;
+    report.cl_order_id = order_id_map.left.at(order_id) / core::constants::max_user_count;
+    report.orig_cl_ord_id = std::nullopt;
+    report.exec_trans_type = core::ExecTransType::exec_trans_new;
+    report.exec_type = (order_info.leaves_qty == 0) ? core::ExecType::status_filled
+                                                    : core::ExecType::status_partially_filled;
+    report.ord_status = (order_info.leaves_qty == 0) ? core::OrderStatus::status_filled
+                                                     : core::OrderStatus::status_partially_filled;
+    report.text = std::nullopt;
+    report.symbol = trade.ticker;
+    report.side = (trade.is_taker_buyer == is_taker) ? core::Side::bid : core::Side::ask;
+    report.price = trade.price;
+    report.time_in_force = order_info.time_in_force;
+    report.leaves_qty = order_info.leaves_qty;
+    report.cum_qty = order_info.cum_qty;
+    report.avg_px = order_info.avg_px;
+}
+
+core::ExecutionReportContainer
+generate_matched_order_report_container(const core::TradeContainer& trade, TradeRole role,
+                                        const OrderManager::OrderIdMapContainer& order_id_map,
+                                        const OrderManager::OrderInfoMapContainer& order_info_map) {
+    auto report = ExecutionReportBuilder::for_this_thread().start_report();
+    fill_matched_order_report(report, trade, role, order_id_map, order_info_map);
+    return report;
+}
+
 // Generates (Taker Order Execution Report, Maker Order Execution Report)
 std::pair<core::ExecutionReportContainer, core::ExecutionReportContainer>
 generate_matched_order_report_containers(
     const core::TradeContainer& trade, const OrderManager::OrderIdMapContainer& order_id_map,
     const OrderManager::OrderInfoMapContainer& order_info_map) {
-    const core::ExecutionReportContainer taker_order_report_container{
-        .sender_comp_id = SERVER_NAME,
-        .target_comp_id = trade.taker_id,
-        .order_id = trade.taker_order_id,
-        .cl_order_id = order_id_map.left.at(trade.taker_order_id) / core::constants::max_user_count,
-        .exec_id = to_string(boost::uuids::time_generator_v7()()),
-        .exec_trans_type = core::ExecTransType::exec_trans_new,
-        .exec_type = (order_info_map.at(trade.taker_order_id).leaves_qty == 0)
-                         ? core::ExecType::status_filled
-                         : core::ExecType::status_partially_filled,
-        .ord_status = (order_info_map.at(trade.taker_order_id).leaves_qty == 0)
-                          ? core::OrderStatus::status_filled
-                          : core::OrderStatus::status_partially_filled,
-        .symbol = trade.ticker,
-        .side = (trade.is_taker_buyer) ? core::Side::bid : core::Side::ask,
-        .price = trade.price,
-        .time_in_force = order_info_map.at(trade.taker_order_id).time_in_force,
-        .leaves_qty = order_info_map.at(trade.taker_order_id).leaves_qty,
-        .cum_qty = order_info_map.at(trade.taker_order_id).cum_qty,
-        .avg_px = order_info_map.at(trade.taker_order_id).avg_px};
-
-    const core::ExecutionReportContainer maker_order_report_container{
-        .sender_comp_id = SERVER_NAME,
-        .target_comp_id = trade.maker_id,
-        .order_id = trade.maker_order_id,
-        .cl_order_id = order_id_map.left.at(trade.maker_order_id) / core::constants::max_user_count,
-        .exec_id = to_string(boost::uuids::time_generator_v7()()),
-        .exec_trans_type = core::ExecTransType::exec_trans_new,
-        .exec_type = (order_info_map.at(trade.maker_order_id).leaves_qty == 0)
-                         ? core::ExecType::status_filled
-                         : core::ExecType::status_partially_filled,
-        .ord_status = (order_info_map.at(trade.maker_order_id).leaves_qty == 0)
-                          ? core::OrderStatus::status_filled
-                          : core::OrderStatus::status_partially_filled,
-        .symbol = trade.ticker,
-        .side = (trade.is_taker_buyer) ? core::Side::ask : core::Side::bid,
-        .price = trade.price,
-        .time_in_force = order_info_map.at(trade.maker_order_id).time_in_force,
-        .leaves_qty = order_info_map.at(trade.maker_order_id).leaves_qty,
-        .cum_qty = order_info_map.at(trade.maker_order_id).cum_qty,
-        .avg_px = order_info_map.at(trade.maker_order_id).avg_px};
+    auto taker_order_report_container = generate_matched_order_report_container(
+        trade, TradeRole::taker, order_id_map, order_info_map);
+    auto maker_order_report_container = generate_matched_order_report_container(
+        trade, TradeRole::maker, order_id_map, order_info_map);
 
     return std::pair{std::move(taker_order_report_container),
                      std::move(maker_order_report_container)};
 }
 
+void fill_cancel_response_report(core::ExecutionReportContainer& report,
+                                 const core::CancelOrderResponseContainer& cancel_response,
+                                 const OrderManager::OrderIdMapContainer& order_id_map,
+                                 const OrderManager::OrderInfoMapContainer& order_info_map) {
+    const auto& order_info = order_info_map.at(cancel_response.order_id);
+
+    report.target_comp_id = order_info.sender_comp_id;
+    report.order_id = cancel_response.order_id;
+    report.cl_order_id = cancel_response.cl_ord_id;
+    report.orig_cl_ord_id =
+        order_id_map.left.at(cancel_response.order_id) / core::constants::max_user_count;
+    report.exec_trans_type = core::ExecTransType::exec_trans_new;
+    report.exec_type = (cancel_response.success) ? core::ExecType::status_canceled
+                                                 : core::ExecType::status_rejected;
+    report.ord_status = (cancel_response.success) ? core::OrderStatus::status_canceled
+                                                  : core::OrderStatus::status_rejected;
+    report.text = cancel_response.success ? "" : "Order had already been matched";
+    report.symbol = order_info.symbol;
+    report.side = order_info.side;
+    report.price = order_info.price;
+    report.time_in_force = order_info.time_in_force;
+    report.leaves_qty = 0;
+    report.cum_qty = order_info.cum_qty;
+    report.avg_px = order_info.avg_px;
+}
+
 core::ExecutionReportContainer generate_cancel_response_report_container(
     const core::CancelOrderResponseContainer& cancel_response,
     const OrderManager::OrderIdMapContainer& order_id_map,
     const OrderManager::OrderInfoMapContainer& order_info_map) {
-    return core::ExecutionReportContainer{
-        .sender_comp_id = SERVER_NAME,
-        .target_comp_id = order_info_map.at(cancel_response.order_id).sender_comp_id,
-        .order_id = cancel_response.order_id,
-        .cl_order_id = cancel_response.cl_ord_id,
-        .orig_cl_ord_id =
-            order_id_map.left.at(cancel_response.order_id) / core::constants::max_user_count,
-        .exec_id = to_string(boost::uuids::time_generator_v7()()),
-        .exec_trans_type = core::ExecTransType::exec_trans_new,
-        .exec_type = (cancel_response.success) ? core::ExecType::status_canceled
-                                               : core::ExecType::status_rejected,
-        .ord_status = (cancel_response.success) ? core::OrderStatus::status_canceled
-                                                : core::OrderStatus::status_rejected,
-        .text = cancel_response.success ? "" : "Order had already been matched",
-        .symbol = order_info_map.at(cancel_response.order_id).symbol,
-        .side = order_info_map.at(cancel_response.order_id).side,
-        .price = order_info_map.at(cancel_response.order_id).price,
-        .time_in_force = order_info_map.at(cancel_response.order_id).time_in_force,
-        .leaves_qty = 0,
-        .cum_qty = order_info_map.at(cancel_response.order_id).cum_qty,
-        .avg_px = order_info_map.at(cancel_response.order_id).avg_px};
-};
+    auto report = ExecutionReportBuilder::for_this_thread().start_report();
+    fill_cancel_response_report(report, cancel_response, order_id_map, order_info_map);
+    return report;
+}
 } // namespace om
@@ -2,30 +2,92 @@
 
 #include "balance_checker.h"
 #include "core/containers.h"
+#include "order_info_store.h"
 #include "order_manager_database.h"
+#include "risk_checker.h"
 #include "transport/inbound_server.h"
 #include "transport/outbound_client.h"
 #include "websocket_client.h"
 
 #include <boost/bimap.hpp>
+#include <chrono>
 #include <unordered_set>
 
 namespace om {
 inline const std::string USD_SYMBOL = "USD";
 
-struct OrderInfo {
-    std::string sender_comp_id;
-    std::string symbol;
-    core::Side side;
-    std::optional<int> price;
-    core::TimeInForce time_in_force;
-    int leaves_qty;
-    int cum_qty;
-    int avg_px;
-
-    int arrival_gateway_id; // Assume that all orders in same order_id chain arrives in same gateway
+// Arrival Gateway of orders restored after a restart, until a request tells where the owner is
+inline constexpr int unknown_gateway_id = -1;
+
+// A market bid waiting on its Fill Cost Response before it can be validated
+struct PendingMarketBid {
+    core::NewOrderSingleContainer new_order;
+    int arrival_gateway_id;
+};
+
+enum class PreprocessResult {
+    ready,             // Proceed to validation
+    awaiting_fill_cost // Parked until the Matching Engine answers the fill cost query
+};
+
+enum class TradeRole { taker, maker };
+
+// The legs of a trade to apply. A trade between users on different shards is split, so each
+// shard only touches the order and balances it owns.
+struct TradeLegs {
+    bool taker{true};
+    bool maker{true};
+};
+
+// Hands out internal order IDs sequentially from [first_order_id, end_order_id). Each shard owns
+// a disjoint range, so an order ID alone tells which shard the order lives on.
+//
+// Once the shard persists its IDs, allocation is narrowed to blocks reserved in the DB ahead of
+// use: the shard queues the next block while the current one still has IDs, so next() itself
+// never waits on the DB.
+class OrderIdAllocator {
+  public:
+    OrderIdAllocator(int first_order_id, int end_order_id)
+        : next_order_id{first_order_id}, end_order_id{end_order_id},
+          range_end_order_id{end_order_id} {
+    }
+
+    int next();
+
+    // Discards what is left of the current and queued blocks and continues from the given block
+    void restart_at(int first_order_id, int end_order_id);
+
+    // Queues a block to continue from once the current one runs out
+    void queue_block(int first_order_id, int end_order_id);
+
+    bool has_queued_block() const {
+        return queued_block.has_value();
+    }
+
+    int peek_next() const {
+        return next_order_id;
+    }
+
+    int range_end() const {
+        return range_end_order_id;
+    }
+
+  private:
+    int next_order_id;
+    int end_order_id;
+    int range_end_order_id;
+    std::optional<std::pair<int, int>> queued_block;
 };
 
+// IDs reserved per DB round trip, so a refill is rare next to the orders it covers
+inline constexpr int order_id_block_size = 1 << 14;
+
+// Least time between attempts to reserve the next block after one fails, so a DB outage is not
+// hit on every message while the current block lasts
+inline constexpr std::chrono::milliseconds order_id_block_retry_interval{1000};
+
+class OrderManagerShard;
+
 struct OrderManagerDependencyFactory {
     std::function<std::unique_ptr<transport::InboundServer>(
         std::string_view, int, std::shared_ptr<spdlog::logger>, std::vector<int>&)>
@@ -40,7 +102,11 @@ struct OrderManagerDependencyFactory {
 class OrderManager {
   public:
     OrderManager(std::string_view host, int port, const std::vector<std::string>& active_symbols,
-                 const OrderManagerDependencyFactory& dependency_factory);
+                 const OrderManagerDependencyFactory& dependency_factory, int shard_count = 1,
+                 const RiskLimits& risk_limits = {},
+                 const BatchSizes& batch_sizes = {.matching_engine = 64, .gateway = 16},
+                 bool defer_untraded_accounts = false);
+    ~OrderManager();
     void init();
     void wait_for_connections() const;
     void connect_matching_engine(std::string host, int port, int try_attempts = 5);
@@ -48,11 +114,19 @@ class OrderManager {
 
     using OrderIdMapContainer = boost::bimap<int, int>;
     using OrderIdPair = OrderIdMapContainer::value_type;
-    using OrderInfoMapContainer = std::unordered_map<int, OrderInfo>;
+    using OrderInfoMapContainer = OrderInfoStore;
     using UsernameToUserIdMapContainer = std::unordered_map<std::string, int>;
+    using PendingFillCostMapContainer = std::unordered_map<int, PendingMarketBid>;
 
   private:
+    // Each routes up to one batch of messages from its source, returning how many it routed
+    int route_gateway_requests(int gateway_connection_id);
+    int route_fill_cost_responses();
+    int route_matching_engine_responses();
+
     const std::unordered_set<std::string> active_symbols;
+    const BatchSizes batch_sizes;
+    const bool defer_untraded_accounts;
 
     std::vector<int> gateway_connection_ids;
     int order_request_connection_id;
@@ -62,30 +136,99 @@ class OrderManager {
     std::unique_ptr<transport::OutboundClient> order_request_outbound_client;
     std::unique_ptr<transport::OutboundClient> order_response_outbound_client;
 
-    BalanceChecker balance_checker;
+    // Rung by all three transports, run() sleeps on it while every queue is empty
+    std::shared_ptr<core::MessageNotifier> message_notifier;
+
+    // Covers every user on the server, read-only once init() returns so shards can share it
     UsernameToUserIdMapContainer username_user_id_map;
 
     std::unique_ptr<OrderManagerDatabase> database_client;
     int server_id;
 
-    // Left is internal order ID, Right is sender id + client order ID (for preventing a user
-    // having duplicate client order ID)
-    OrderIdMapContainer order_id_map;
+    // Updated by run() from every trade, read by all shards for price band checks
+    LastTradePrices last_trade_prices;
 
-    OrderInfoMapContainer order_info_map;
+    // run() only routes messages, each user's balances and orders live on exactly one shard.
+    // Declared last so the shard workers stop before the transports they send on are destroyed.
+    std::vector<std::unique_ptr<OrderManagerShard>> shards;
 };
 
+// A shard to deliver a message to, and for trades the legs it owns
+struct ShardRoute {
+    int shard_id;
+    TradeLegs trade_legs{};
+};
+
+// Users are spread over shards by user ID, and each shard allocates order IDs from its own
+// contiguous range, so routing in either direction needs no shared lookup table.
+int shard_for_user(int user_id, int shard_count);
+int shard_for_order_id(int order_id, int shard_count);
+OrderIdAllocator make_shard_order_id_allocator(int shard_id, int shard_count);
+
+// Routes by sender_comp_id. Unknown senders go to shard 0, which rejects them.
+int route_gateway_request(const core::Container& container,
+                          const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                          int shard_count);
+
+// Routes by order ID. A trade whose taker and maker live on different shards also yields a second
+// route, for the maker's leg.
+std::pair<ShardRoute, std::optional<ShardRoute>>
+route_matching_engine_response(const core::Container& container, int shard_count);
+
+// Loads balances of the users owns_user accepts (all users if empty). username_user_id_map is
+// filled for every user regardless, since requests are routed before reaching a shard.
 void init_balance_checker(BalanceChecker& balance_checker,
                           OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
-                          OrderManagerDatabase& database_client);
+                          OrderManagerDatabase& database_client,
+                          const std::function<bool(int)>& owns_user = {});
 
-[[nodiscard]] std::expected<std::optional<int>, std::string>
-preprocess_container(core::Container& container, OrderManager::OrderIdMapContainer& order_id_map,
+// As above, from balances already fetched, so several shards can share one fetch. Users holding
+// exactly deferred_account_usd USD and nothing else are only mapped, not loaded;
+// materialize_deferred_account creates their accounts on first use.
+void init_balance_checker(BalanceChecker& balance_checker,
+                          OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                          const std::vector<DbUserBalanceInfo>& users_balances,
+                          const std::function<bool(int)>& owns_user = {},
+                          std::optional<std::int64_t> deferred_account_usd = std::nullopt);
+
+// Gives the sender of a request deferred by init_balance_checker their initial USD balance. Does
+// nothing for unknown senders or accounts that already exist.
+void materialize_deferred_account(
+    const core::Container& container,
+    const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+    BalanceChecker& balance_checker, std::int64_t deferred_account_usd);
+
+// Rebuilds the state of orders still resting on the Matching Engine from before a restart. Their
+// balance reservations are already reflected in the persisted balances, so nothing is reserved
+// again. The Gateway they arrived on is gone, reports go to unknown_gateway_id until the owner
+// sends a cancel for them.
+void restore_live_orders(const std::vector<DbLiveOrderRow>& live_orders,
+                         OrderManager::OrderIdMapContainer& order_id_map,
+                         OrderManager::OrderInfoMapContainer& order_info_map,
+                         const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                         const BalanceChecker& balance_checker, RiskChecker& risk_checker);
+
+[[nodiscard]] std::expected<PreprocessResult, std::string>
+preprocess_container(core::Container& container, OrderIdAllocator& order_id_allocator,
+                     OrderManager::OrderIdMapContainer& order_id_map,
                      OrderManager::OrderInfoMapContainer& order_info_map,
                      const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                     OrderManager::PendingFillCostMapContainer& pending_fill_cost_map,
                      int arrival_gateway_id, transport::OutboundClient& order_request_ws_client,
                      int order_request_connection_id);
 
+[[nodiscard]] std::optional<PendingMarketBid>
+take_pending_market_bid(const core::FillCostResponseContainer& fill_cost_response,
+                        OrderManager::PendingFillCostMapContainer& pending_fill_cost_map);
+
+// Applies the pre-trade risk limits. Must run before validate_container, which reserves balance
+// once an order passes. Returns "ok" or the reason to reject.
+std::string check_risk_limits(const core::Container& container,
+                              const BalanceChecker& balance_checker, RiskChecker& risk_checker,
+                              const LastTradePrices& last_trade_prices,
+                              RiskChecker::Clock::time_point now,
+                              std::optional<int> market_bid_fill_cost = std::nullopt);
+
 std::string validate_container(const core::Container& container,
                                const std::unordered_set<std::string>& active_symbols,
                                BalanceChecker& balance_checker,
@@ -97,6 +240,17 @@ void forward_and_reply(bool is_container_valid, const core::Container& container
                        int order_request_connection_id, transport::InboundServer& inbound_ws_server,
                        const std::optional<std::string_view>& order_reject_reason = std::nullopt);
 
+// The fill_*_report functions overwrite every field of report except sender_comp_id and
+// exec_id, so an ExecutionReportBuilder's scratch report can be refilled without allocating.
+// The generate_*_report_container functions return a standalone copy instead.
+void fill_rejection_report(core::ExecutionReportContainer& report,
+                           const core::Container& container,
+                           const OrderManager::OrderInfoMapContainer& order_info_map,
+                           std::string_view order_reject_reason);
+
+void fill_success_report(core::ExecutionReportContainer& report, const core::Container& container,
+                         const OrderManager::OrderInfoMapContainer& order_info_map);
+
 core::ExecutionReportContainer
 generate_rejection_report_container(const core::Container& container,
                                     const OrderManager::OrderInfoMapContainer& order_info_map,
@@ -110,16 +264,44 @@ void update_database(const core::Container& container, int server_id,
                      const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
                      const OrderManager::OrderInfoMapContainer& order_info_map,
                      const BalanceChecker& balance_checker, OrderManagerDatabase& database_client,
-                     std::optional<bool> valid_container = std::nullopt);
+                     std::optional<bool> valid_container = std::nullopt, TradeLegs trade_legs = {});
 
 void update_internal_data(const core::Container& container,
                           OrderManager::OrderInfoMapContainer& order_info_map,
-                          BalanceChecker& balance_checker);
+                          BalanceChecker& balance_checker, TradeLegs trade_legs = {});
+
+// Keeps the open order counts behind max_open_orders_per_user in step with order lifecycles
+void update_risk_state(const core::Container& container,
+                       const OrderManager::OrderInfoMapContainer& order_info_map,
+                       const BalanceChecker& balance_checker, RiskChecker& risk_checker,
+                       std::optional<bool> valid_container = std::nullopt,
+                       TradeLegs trade_legs = {});
+
+void retire_terminal_orders(const core::Container& container,
+                            OrderManager::OrderIdMapContainer& order_id_map,
+                            OrderManager::OrderInfoMapContainer& order_info_map,
+                            std::optional<bool> valid_container = std::nullopt);
 
 void return_execution_report(const core::Container& container,
                              const OrderManager::OrderIdMapContainer& order_id_map,
                              const OrderManager::OrderInfoMapContainer& order_info_map,
-                             transport::InboundServer& inbound_ws_server);
+                             transport::InboundServer& inbound_ws_server,
+                             TradeLegs trade_legs = {});
+
+void fill_matched_order_report(core::ExecutionReportContainer& report,
+                               const core::TradeContainer& trade, TradeRole role,
+                               const OrderManager::OrderIdMapContainer& order_id_map,
+                               const OrderManager::OrderInfoMapContainer& order_info_map);
+
+void fill_cancel_response_report(core::ExecutionReportContainer& report,
+                                 const core::CancelOrderResponseContainer& cancel_response,
+                                 const OrderManager::OrderIdMapContainer& order_id_map,
+                                 const OrderManager::OrderInfoMapContainer& order_info_map);
+
+core::ExecutionReportContainer
+generate_matched_order_report_container(const core::TradeContainer& trade, TradeRole role,
+                                        const OrderManager::OrderIdMapContainer& order_id_map,
+                                        const OrderManager::OrderInfoMapContainer& order_info_map);
 
 std::pair<core::ExecutionReportContainer, core::ExecutionReportContainer>
 generate_matched_order_report_containers(const core::TradeContainer& trade,
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "core/containers.h"
+#include "core/orders.h"
 #include <cstdint>
 #include <expected>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -30,6 +32,26 @@ struct DbServerRow {
     int initial_usd{100000};
 };
 
+// A limit order still resting on the Matching Engine, rebuilt from persisted orders and trades
+struct DbLiveOrderRow {
+    int order_id{};
+    int cl_order_id{};
+    std::string sender_comp_id;
+    std::string symbol;
+    core::Side side{};
+    int order_qty{};
+    int price{};
+    core::TimeInForce time_in_force{};
+    int filled_qty{};
+    std::int64_t filled_notional{};
+};
+
+// Order IDs [first_order_id, end_order_id) reserved for one shard
+struct DbOrderIdBlock {
+    int first_order_id{};
+    int end_order_id{};
+};
+
 class OrderManagerDatabase {
   public:
     virtual ~OrderManagerDatabase() = default;
@@ -56,7 +78,24 @@ class OrderManagerDatabase {
     virtual std::expected<std::optional<DbServerRow>, std::string>
     get_server(const std::string_view& server_name) = 0;
 
+    // May persist asynchronously; success means the balance was accepted, not yet committed.
     virtual std::expected<void, std::string>
     update_balance(int user_id, int server_id, std::string_view symbol, std::int64_t balance) = 0;
+
+    virtual std::expected<std::vector<DbLiveOrderRow>, std::string>
+    get_live_orders(std::string_view server_name) = 0;
+
+    virtual std::expected<std::optional<int>, std::string>
+    get_max_order_id(std::string_view server_name, int first_order_id, int end_order_id) = 0;
+
+    // Persists a raised order ID ceiling for the shard, never below floor_order_id. IDs of the
+    // returned block are safe to hand out even if the Order Manager restarts.
+    virtual std::expected<DbOrderIdBlock, std::string>
+    reserve_order_id_block(int server_id, int shard_id, int floor_order_id, int block_size) = 0;
+
+    // Returns the shard count the server's order ID blocks were reserved under, recording
+    // shard_count if none has been yet
+    virtual std::expected<int, std::string> claim_order_id_shard_count(int server_id,
+                                                                       int shard_count) = 0;
 };
 } // namespace om
@@ -0,0 +1,224 @@
+#include "order_manager_shard.h"
+
+#include <boost/contract.hpp>
+
+namespace om {
+OrderManagerShard::OrderManagerShard(
+    int shard_id, OrderIdAllocator order_id_allocator,
+    const std::unordered_set<std::string>& active_symbols,
+    const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+    const RiskLimits& risk_limits, const LastTradePrices& last_trade_prices,
+    transport::InboundServer& inbound_server,
+    transport::OutboundClient& order_request_outbound_client,
+    std::unique_ptr<OrderManagerDatabase> database_client, std::shared_ptr<spdlog::logger> logger)
+    : shard_id{shard_id}, order_id_allocator{order_id_allocator}, reserves_order_id_blocks{false},
+      next_order_id_block_attempt{}, active_symbols{active_symbols},
+      username_user_id_map{username_user_id_map}, last_trade_prices{last_trade_prices},
+      inbound_server{inbound_server}, order_request_outbound_client{order_request_outbound_client},
+      order_request_connection_id{-1}, database_client{std::move(database_client)},
+      server_id{-1}, logger{std::move(logger)}, risk_checker{risk_limits} {
+}
+
+OrderManagerShard::~OrderManagerShard() {
+    if (worker.joinable()) {
+        worker.request_stop();
+        inbox.enqueue(StopShard{});
+    }
+}
+
+void OrderManagerShard::start(int server_id, int order_request_connection_id) {
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(!worker.joinable()); });
+
+    this->server_id = server_id;
+    this->order_request_connection_id = order_request_connection_id;
+    worker = std::jthread{[this](std::stop_token stop_token) { work(stop_token); }};
+
+    logger->info("[OM] Shard {} started", shard_id);
+}
+
+void OrderManagerShard::resume(int server_id, const std::vector<DbLiveOrderRow>& live_orders) {
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(!worker.joinable()); });
+
+    this->server_id = server_id;
+
+    restore_live_orders(live_orders, order_id_map, order_info_map, username_user_id_map,
+                        balance_checker, risk_checker);
+
+    // The reserved ceiling covers every ID handed out by a run that reserved blocks, the highest
+    // persisted ID covers runs from before blocks were reserved
+    int floor_order_id{order_id_allocator.peek_next()};
+    std::ignore =
+        database_client
+            ->get_max_order_id(SERVER_NAME, floor_order_id, order_id_allocator.range_end())
+            .transform([&](std::optional<int> max_order_id) {
+                if (max_order_id.has_value()) {
+                    floor_order_id = max_order_id.value() + 1;
+                }
+            })
+            .transform_error([this](std::string&& err) {
+                logger->error("[OM] Shard {} failed to fetch its highest order ID: {}", shard_id,
+                              err);
+                std::terminate();
+                return err;
+            });
+
+    const auto order_id_block = reserve_order_id_block(floor_order_id);
+    if (!order_id_block.has_value()) {
+        std::terminate();
+    }
+    order_id_allocator.restart_at(order_id_block->first_order_id, order_id_block->end_order_id);
+    reserves_order_id_blocks = true;
+    queue_next_order_id_block();
+
+    logger->info("[OM] Shard {} restored {} live orders, allocating order IDs from {}", shard_id,
+                 order_info_map.live_count(), order_id_allocator.peek_next());
+}
+
+std::optional<DbOrderIdBlock> OrderManagerShard::reserve_order_id_block(int floor_order_id) {
+    const auto order_id_block = database_client->reserve_order_id_block(
+        server_id, shard_id, floor_order_id, order_id_block_size);
+    if (!order_id_block.has_value()) {
+        logger->error("[OM] Shard {} failed to reserve order IDs: {}", shard_id,
+                      order_id_block.error());
+        return std::nullopt;
+    }
+    if (order_id_block->end_order_id > order_id_allocator.range_end()) {
+        logger->error("[OM] Shard {} has run out of order IDs, reserved through {}", shard_id,
+                      order_id_block->end_order_id);
+        return std::nullopt;
+    }
+
+    return order_id_block.value();
+}
+
+void OrderManagerShard::queue_next_order_id_block() {
+    const auto now = std::chrono::steady_clock::now();
+    if (!reserves_order_id_blocks || order_id_allocator.has_queued_block() ||
+        now < next_order_id_block_attempt) {
+        return;
+    }
+
+    if (const auto order_id_block = reserve_order_id_block(order_id_allocator.peek_next())) {
+        order_id_allocator.queue_block(order_id_block->first_order_id,
+                                       order_id_block->end_order_id);
+    } else {
+        next_order_id_block_attempt = now + order_id_block_retry_interval;
+    }
+}
+
+void OrderManagerShard::post(ShardMessage message) {
+    inbox.enqueue(std::move(message));
+}
+
+void OrderManagerShard::work(std::stop_token stop_token) {
+    while (!stop_token.stop_requested()) {
+        auto message = inbox.wait_and_dequeue();
+        std::visit(
+            [this](auto& message) {
+                if constexpr (!std::is_same_v<std::decay_t<decltype(message)>, StopShard>) {
+                    process(message);
+                }
+            },
+            message);
+
+        // Refilled between messages, so handing out an order ID never waits on the DB. A failed
+        // reservation is retried after the first message once order_id_block_retry_interval
+        // has passed.
+        queue_next_order_id_block();
+    }
+}
+
+void OrderManagerShard::process(GatewayRequest& request) {
+    auto& [container, arrival_gateway_id] = request;
+
+    if (deferred_account_usd.has_value()) {
+        materialize_deferred_account(container, username_user_id_map, balance_checker,
+                                     deferred_account_usd.value());
+    }
+
+    preprocess_container(container, order_id_allocator, order_id_map, order_info_map,
+                         username_user_id_map, pending_fill_cost_map, arrival_gateway_id,
+                         order_request_outbound_client, order_request_connection_id)
+        .transform([&](PreprocessResult preprocess_result) {
+            if (preprocess_result == PreprocessResult::ready) {
+                validate_and_dispatch(container, arrival_gateway_id);
+            }
+        })
+        .transform_error([&](std::string&& err) {
+            forward_and_reply(false, container, order_info_map, arrival_gateway_id,
+                              order_request_outbound_client, order_request_connection_id,
+                              inbound_server, err);
+
+            update_database(container, server_id, username_user_id_map, order_info_map,
+                            balance_checker, *database_client, false);
+
+            retire_terminal_orders(container, order_id_map, order_info_map, false);
+            return err;
+        });
+}
+
+void OrderManagerShard::process(MatchingEngineResponse& response) {
+    auto& [container, trade_legs] = response;
+
+    // Resume a parked market bid once the Matching Engine has priced it
+    if (const auto* fill_cost_response = std::get_if<core::FillCostResponseContainer>(&container)) {
+        if (auto pending_market_bid =
+                take_pending_market_bid(*fill_cost_response, pending_fill_cost_map)) {
+            core::Container new_order{std::move(pending_market_bid->new_order)};
+            validate_and_dispatch(new_order, pending_market_bid->arrival_gateway_id,
+                                  fill_cost_response->total_cost);
+        }
+        return;
+    }
+
+    update_internal_data(container, order_info_map, balance_checker, trade_legs);
+
+    update_risk_state(container, order_info_map, balance_checker, risk_checker, std::nullopt,
+                      trade_legs);
+
+    return_execution_report(container, order_id_map, order_info_map, inbound_server, trade_legs);
+
+    update_database(container, server_id, username_user_id_map, order_info_map, balance_checker,
+                    *database_client, std::nullopt, trade_legs);
+
+    retire_terminal_orders(container, order_id_map, order_info_map);
+}
+
+void OrderManagerShard::validate_and_dispatch(core::Container& container, int arrival_gateway_id,
+                                              std::optional<int> market_bid_fill_cost) {
+    std::string validation_result =
+        check_risk_limits(container, balance_checker, risk_checker, last_trade_prices,
+                          RiskChecker::Clock::now(), market_bid_fill_cost);
+    if (validation_result == "ok") {
+        validation_result =
+            validate_container(container, active_symbols, balance_checker, market_bid_fill_cost);
+    }
+
+    if (validation_result == "ok") {
+        // Fills of a market bid are settled against the fill cost it just reserved
+        if (market_bid_fill_cost.has_value()) {
+            const auto& new_order = std::get<core::NewOrderSingleContainer>(container);
+            order_info_map.at(new_order.order_id.value()).reserved_usd =
+                market_bid_fill_cost.value();
+        }
+
+        forward_and_reply(true, container, order_info_map, arrival_gateway_id,
+                          order_request_outbound_client, order_request_connection_id,
+                          inbound_server);
+    } else {
+        forward_and_reply(false, container, order_info_map, arrival_gateway_id,
+                          order_request_outbound_client, order_request_connection_id,
+                          inbound_server, validation_result);
+    }
+
+    update_database(container, server_id, username_user_id_map, order_info_map, balance_checker,
+                    *database_client, validation_result == "ok");
+
+    update_risk_state(container, order_info_map, balance_checker, risk_checker,
+                      validation_result == "ok");
+
+    retire_terminal_orders(container, order_id_map, order_info_map, validation_result == "ok");
+}
+} // namespace om
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "core/thread_safe_queue.h"
+#include "order_manager.h"
+
+#include <memory>
+#include <thread>
+#include <variant>
+
+namespace om {
+// A request from a Gateway, tagged with the connection it arrived on
+struct GatewayRequest {
+    core::Container container;
+    int arrival_gateway_id;
+};
+
+// A Fill Cost Response, Trade or Cancel Order Response from the Matching Engine
+struct MatchingEngineResponse {
+    core::Container container;
+    TradeLegs trade_legs{};
+};
+
+// Wakes the worker so it notices it has been asked to stop
+struct StopShard {};
+
+using ShardMessage = std::variant<GatewayRequest, MatchingEngineResponse, StopShard>;
+
+// Owns the balances and orders of a disjoint subset of users. Every check, report and DB write
+// for those users runs on the shard's worker thread, so shards share no mutable state and the
+// Order Manager scales with cores rather than with one run loop. The one exception is the Gateway
+// and Matching Engine connections every shard sends on, WebsocketManager::send serializes those.
+class OrderManagerShard {
+  public:
+    OrderManagerShard(int shard_id, OrderIdAllocator order_id_allocator,
+                      const std::unordered_set<std::string>& active_symbols,
+                      const OrderManager::UsernameToUserIdMapContainer& username_user_id_map,
+                      const RiskLimits& risk_limits, const LastTradePrices& last_trade_prices,
+                      transport::InboundServer& inbound_server,
+                      transport::OutboundClient& order_request_outbound_client,
+                      std::unique_ptr<OrderManagerDatabase> database_client,
+                      std::shared_ptr<spdlog::logger> logger);
+    ~OrderManagerShard();
+
+    OrderManagerShard(const OrderManagerShard&) = delete;
+    OrderManagerShard& operator=(const OrderManagerShard&) = delete;
+
+    // The server and Matching Engine connection IDs are only known once the Order Manager is
+    // initialized and connected, so the worker is not spawned on construction
+    void start(int server_id, int order_request_connection_id);
+
+    // Restores the shard's orders still resting on the Matching Engine, and from then on hands
+    // out order IDs only from blocks persisted in the DB, so they stay unique across restarts.
+    // Only safe before start().
+    void resume(int server_id, const std::vector<DbLiveOrderRow>& live_orders);
+
+    // Users init_balance_checker deferred get an account with this much USD on their first
+    // request. Only safe before start().
+    void defer_accounts_holding(std::int64_t initial_usd) {
+        deferred_account_usd = initial_usd;
+    }
+
+    void post(ShardMessage message);
+
+    // Only safe to touch before start()
+    BalanceChecker& get_balance_checker() {
+        return balance_checker;
+    }
+
+  private:
+    void work(std::stop_token stop_token);
+    void process(GatewayRequest& request);
+    void process(MatchingEngineResponse& response);
+    void validate_and_dispatch(core::Container& container, int arrival_gateway_id,
+                               std::optional<int> market_bid_fill_cost = std::nullopt);
+    std::optional<DbOrderIdBlock> reserve_order_id_block(int floor_order_id);
+    void queue_next_order_id_block();
+
+    const int shard_id;
+    OrderIdAllocator order_id_allocator;
+    bool reserves_order_id_blocks;
+    std::chrono::steady_clock::time_point next_order_id_block_attempt;
+
+    const std::unordered_set<std::string>& active_symbols;
+    const OrderManager::UsernameToUserIdMapContainer& username_user_id_map;
+    const LastTradePrices& last_trade_prices;
+
+    transport::InboundServer& inbound_server;
+    transport::OutboundClient& order_request_outbound_client;
+    int order_request_connection_id;
+
+    std::unique_ptr<OrderManagerDatabase> database_client;
+    int server_id;
+
+    std::shared_ptr<spdlog::logger> logger;
+
+    BalanceChecker balance_checker;
+    RiskChecker risk_checker;
+    std::optional<std::int64_t> deferred_account_usd;
+
+    // Left is internal order ID, Right is sender id + client order ID (for preventing a user
+    // having duplicate client order ID). Holds live and archived orders only, entries are erased
+    // once their order falls out of the order_info_map archive.
+    OrderManager::OrderIdMapContainer order_id_map;
+
+    OrderManager::OrderInfoMapContainer order_info_map;
+
+    // Keyed by fill cost query request ID, which is the parked order's internal order ID
+    OrderManager::PendingFillCostMapContainer pending_fill_cost_map;
+
+    core::ThreadSafeQueue<ShardMessage> inbox;
+
+    // Declared last so it is joined before the state it works on is destroyed
+    std::jthread worker;
+};
+} // namespace om
@@ -0,0 +1,103 @@
+#include "risk_checker.h"
+
+#include <algorithm>
+#include <boost/contract.hpp>
+#include <cstdlib>
+
+namespace om {
+LastTradePrices::LastTradePrices(const std::vector<std::string>& symbols) {
+    for (const auto& symbol : symbols) {
+        prices.try_emplace(symbol, 0);
+    }
+}
+
+void LastTradePrices::record(std::string_view symbol, int price) {
+    if (const auto it = prices.find(symbol); it != prices.end()) {
+        it->second.store(price, std::memory_order_relaxed);
+    }
+}
+
+std::optional<int> LastTradePrices::find(std::string_view symbol) const {
+    const auto it = prices.find(symbol);
+    if (it == prices.end()) {
+        return std::nullopt;
+    }
+
+    // Trades only happen at positive prices, 0 means none yet
+    const int price = it->second.load(std::memory_order_relaxed);
+    return price > 0 ? std::optional<int>{price} : std::nullopt;
+}
+
+RiskChecker::RiskChecker(const RiskLimits& risk_limits)
+    : risk_limits{risk_limits},
+      message_interval_ns{risk_limits.max_messages_per_second > 0
+                              ? 1'000'000'000 / risk_limits.max_messages_per_second
+                              : 0},
+      message_burst_tolerance_ns{message_interval_ns *
+                                 (std::max(risk_limits.message_burst, 1) - 1)} {
+}
+
+RiskChecker::UserRiskState& RiskChecker::state_for(BalanceChecker::UserId user_id) {
+    if (user_id >= user_states.size()) {
+        user_states.resize(user_id + 1);
+    }
+    return user_states[user_id];
+}
+
+bool RiskChecker::admit_message(BalanceChecker::UserId user_id, Clock::time_point now) {
+    if (risk_limits.max_messages_per_second <= 0) {
+        return true;
+    }
+
+    auto& state = state_for(user_id);
+    const std::int64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    const std::int64_t theoretical_arrival_ns =
+        std::max(state.throttle_theoretical_arrival_ns, now_ns);
+
+    if (theoretical_arrival_ns - now_ns > message_burst_tolerance_ns) {
+        return false;
+    }
+
+    state.throttle_theoretical_arrival_ns = theoretical_arrival_ns + message_interval_ns;
+    return true;
+}
+
+bool RiskChecker::within_order_qty(int order_qty) const {
+    return risk_limits.max_order_qty <= 0 || order_qty <= risk_limits.max_order_qty;
+}
+
+bool RiskChecker::within_order_notional(std::int64_t notional) const {
+    return risk_limits.max_order_notional <= 0 || notional <= risk_limits.max_order_notional;
+}
+
+bool RiskChecker::within_open_order_limit(BalanceChecker::UserId user_id) const {
+    return risk_limits.max_open_orders_per_user <= 0 ||
+           open_order_count(user_id) < risk_limits.max_open_orders_per_user;
+}
+
+bool RiskChecker::within_price_band(int price, std::optional<int> last_trade_price) const {
+    if (risk_limits.price_band_bps <= 0 || !last_trade_price.has_value()) {
+        return true;
+    }
+
+    const std::int64_t deviation = std::abs(static_cast<std::int64_t>(price) - *last_trade_price);
+    return deviation * 10'000 <=
+           static_cast<std::int64_t>(*last_trade_price) * risk_limits.price_band_bps;
+}
+
+void RiskChecker::on_order_opened(BalanceChecker::UserId user_id) {
+    ++state_for(user_id).open_order_count;
+}
+
+void RiskChecker::on_order_closed(BalanceChecker::UserId user_id) {
+    boost::contract::check c = boost::contract::public_function(this).precondition(
+        [&] { BOOST_CONTRACT_ASSERT(open_order_count(user_id) > 0); });
+
+    --user_states[user_id].open_order_count;
+}
+
+int RiskChecker::open_order_count(BalanceChecker::UserId user_id) const {
+    return user_id < user_states.size() ? user_states[user_id].open_order_count : 0;
+}
+} // namespace om
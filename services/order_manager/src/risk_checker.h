@@ -0,0 +1,76 @@
+#pragma once
+
+#include "balance_checker.h"
+#include "configuration/order_manager_config.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace om {
+// Last traded price per active symbol. Written by the router as trades arrive and read by every
+// shard, so the price band sees trades between users of other shards too. The symbol set is fixed
+// on construction, which keeps reads lock-free.
+class LastTradePrices {
+  public:
+    explicit LastTradePrices(const std::vector<std::string>& symbols);
+
+    void record(std::string_view symbol, int price);
+
+    // nullopt until the symbol has traded, or for an unknown symbol
+    std::optional<int> find(std::string_view symbol) const;
+
+  private:
+    struct StringHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view value) const {
+            return std::hash<std::string_view>{}(value);
+        }
+    };
+
+    std::unordered_map<std::string, std::atomic<int>, StringHash, std::equal_to<>> prices;
+};
+
+// Per-user pre-trade risk state of one shard. State is indexed by the shard's interned
+// BalanceChecker user ids and updated incrementally, so every check is a few compares and no
+// allocation once a user has been seen.
+class RiskChecker {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RiskChecker(const RiskLimits& risk_limits);
+
+    // Counts the message against the user's rate limit. Returns false, without consuming
+    // allowance, if the user is over it.
+    [[nodiscard]] bool admit_message(BalanceChecker::UserId user_id, Clock::time_point now);
+
+    bool within_order_qty(int order_qty) const;
+    bool within_order_notional(std::int64_t notional) const;
+    bool within_open_order_limit(BalanceChecker::UserId user_id) const;
+    bool within_price_band(int price, std::optional<int> last_trade_price) const;
+
+    void on_order_opened(BalanceChecker::UserId user_id);
+    void on_order_closed(BalanceChecker::UserId user_id);
+    int open_order_count(BalanceChecker::UserId user_id) const;
+
+  private:
+    struct UserRiskState {
+        int open_order_count{0};
+        // Generic cell rate algorithm: the earliest time the next message conforms
+        std::int64_t throttle_theoretical_arrival_ns{0};
+    };
+
+    UserRiskState& state_for(BalanceChecker::UserId user_id);
+
+    const RiskLimits risk_limits;
+    const std::int64_t message_interval_ns;
+    const std::int64_t message_burst_tolerance_ns;
+
+    std::vector<UserRiskState> user_states; // Indexed by BalanceChecker::UserId
+};
+} // namespace om
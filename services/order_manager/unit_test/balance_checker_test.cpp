@@ -228,3 +228,76 @@ TEST_F(HasSufficientBalanceTest, ZeroDelta) {
     EXPECT_TRUE(
         balance_checker.has_sufficient_balance(std::string{BROKER_ID_1}, std::string{TICKER_1}, 0));
 }
+
+// =====================================================================
+// InternedIdTest
+// =====================================================================
+
+class InternedIdTest : public testing::Test {
+  protected:
+    BalanceChecker balance_checker;
+
+    void SetUp() override {
+        balance_checker.update_balance(std::string{BROKER_ID_1}, std::string{TICKER_1}, 1000);
+    }
+};
+using InternedIdDeathTest = InternedIdTest;
+
+TEST_F(InternedIdTest, InterningIsIdempotent) {
+    EXPECT_EQ(balance_checker.intern_user(BROKER_ID_1), balance_checker.intern_user(BROKER_ID_1));
+    EXPECT_EQ(balance_checker.intern_symbol(TICKER_1), balance_checker.intern_symbol(TICKER_1));
+    EXPECT_NE(balance_checker.intern_user(BROKER_ID_1), balance_checker.intern_user(BROKER_ID_2));
+}
+
+TEST_F(InternedIdTest, FindDoesNotIntern) {
+    EXPECT_FALSE(balance_checker.find_user(BROKER_ID_2).has_value());
+    EXPECT_FALSE(balance_checker.find_symbol(TICKER_2).has_value());
+    EXPECT_FALSE(balance_checker.broker_id_exists(std::string{BROKER_ID_2}));
+}
+
+TEST_F(InternedIdTest, IdAndStringViewsAgree) {
+    const auto user_id = balance_checker.find_user(BROKER_ID_1).value();
+    const auto symbol_id = balance_checker.find_symbol(TICKER_1).value();
+
+    balance_checker.update_balance(user_id, symbol_id, 250);
+
+    EXPECT_TRUE(balance_checker.owns(user_id, symbol_id));
+    EXPECT_EQ(balance_checker.get_balance(user_id, symbol_id), 1250);
+    EXPECT_EQ(balance_checker.get_balance(std::string{BROKER_ID_1}, std::string{TICKER_1}), 1250);
+}
+
+TEST_F(InternedIdTest, SymbolKnownToOtherUserIsNotOwned) {
+    balance_checker.update_balance(std::string{BROKER_ID_2}, std::string{TICKER_2}, 10);
+
+    EXPECT_FALSE(balance_checker.owns(balance_checker.find_user(BROKER_ID_1).value(),
+                                      balance_checker.find_symbol(TICKER_2).value()));
+}
+
+TEST_F(InternedIdTest, TryReserveDeductsWhenAffordable) {
+    const auto user_id = balance_checker.find_user(BROKER_ID_1).value();
+    const auto symbol_id = balance_checker.find_symbol(TICKER_1).value();
+
+    EXPECT_TRUE(balance_checker.try_reserve(user_id, symbol_id, 1000));
+    EXPECT_EQ(balance_checker.get_balance(user_id, symbol_id), 0);
+}
+
+TEST_F(InternedIdTest, TryReserveLeavesBalanceWhenUnaffordable) {
+    const auto user_id = balance_checker.find_user(BROKER_ID_1).value();
+    const auto symbol_id = balance_checker.find_symbol(TICKER_1).value();
+
+    EXPECT_FALSE(balance_checker.try_reserve(user_id, symbol_id, 1001));
+    EXPECT_EQ(balance_checker.get_balance(user_id, symbol_id), 1000);
+}
+
+TEST_F(InternedIdTest, TryReserveFailsWithoutRecord) {
+    const auto user_id = balance_checker.find_user(BROKER_ID_1).value();
+
+    EXPECT_FALSE(balance_checker.try_reserve(user_id, balance_checker.intern_symbol(TICKER_2), 0));
+}
+
+TEST_F(InternedIdDeathTest, TryReserveNegativeAmount) {
+    const auto user_id = balance_checker.find_user(BROKER_ID_1).value();
+    const auto symbol_id = balance_checker.find_symbol(TICKER_1).value();
+
+    EXPECT_DEATH(std::ignore = balance_checker.try_reserve(user_id, symbol_id, -1), "");
+}
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include "execution_report_builder.h"
+#include "order_manager.h"
+#include "transport/messaging.h"
+
+#include <boost/uuid.hpp>
+
+using namespace om;
+
+namespace {
+// A partial fill of a resting limit order, the most common report on the hot path
+struct MatchedOrderFixture {
+    MatchedOrderFixture() {
+        order_id_map.insert(OrderManager::OrderIdPair(
+            maker_order_id, 100 * core::constants::max_user_count + 2));
+        order_info_map.emplace(maker_order_id,
+                               OrderInfo{.sender_comp_id = "market_maker_7",
+                                         .symbol = "AAPL",
+                                         .side = core::Side::ask,
+                                         .price = 150,
+                                         .time_in_force = core::TimeInForce::gtc,
+                                         .leaves_qty = 90,
+                                         .cum_qty = 10,
+                                         .avg_px = 150,
+                                         .arrival_gateway_id = 1});
+    }
+
+    static constexpr int maker_order_id{22};
+
+    OrderManager::OrderIdMapContainer order_id_map;
+    OrderManager::OrderInfoMapContainer order_info_map;
+    const core::TradeContainer trade{.ticker = "AAPL",
+                                     .price = 150,
+                                     .quantity = 10,
+                                     .trade_id = "T1",
+                                     .taker_id = "taker_client_3",
+                                     .maker_id = "market_maker_7",
+                                     .taker_order_id = 11,
+                                     .maker_order_id = maker_order_id,
+                                     .is_taker_buyer = true};
+};
+} // namespace
+
+// What every report used to cost: a fresh UUID generator, a standalone container and a new wire
+// string
+static void BM_ExecutionReport_UuidPerReport(benchmark::State& state) {
+    MatchedOrderFixture fixture;
+    for (auto _ : state) {
+        auto report = generate_matched_order_report_container(
+            fixture.trade, TradeRole::maker, fixture.order_id_map, fixture.order_info_map);
+        report.exec_id = to_string(boost::uuids::time_generator_v7()());
+        benchmark::DoNotOptimize(transport::serialize_container(report));
+    }
+}
+
+static void BM_ExecutionReport_Builder(benchmark::State& state) {
+    MatchedOrderFixture fixture;
+    auto& report_builder = ExecutionReportBuilder::for_this_thread();
+    for (auto _ : state) {
+        auto& report = report_builder.start_report();
+        fill_matched_order_report(report, fixture.trade, TradeRole::maker, fixture.order_id_map,
+                                  fixture.order_info_map);
+        benchmark::DoNotOptimize(report_builder.serialize().data());
+    }
+}
+
+static void BM_ExecIdSequence_Next(benchmark::State& state) {
+    ExecIdSequence exec_id_sequence;
+    std::string exec_id;
+    for (auto _ : state) {
+        exec_id_sequence.next(exec_id);
+        benchmark::DoNotOptimize(exec_id.data());
+    }
+}
+
+BENCHMARK(BM_ExecutionReport_UuidPerReport)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_ExecutionReport_Builder)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_ExecIdSequence_Next)->Unit(benchmark::kNanosecond);
+
+BENCHMARK_MAIN();
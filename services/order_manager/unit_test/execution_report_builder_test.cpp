@@ -0,0 +1,58 @@
+#include "execution_report_builder.h"
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <unordered_set>
+
+using namespace om;
+
+// =====================================================================
+// ExecIdSequenceTest
+// =====================================================================
+
+TEST(ExecIdSequenceTest, IdsAreUniqueWithinASequence) {
+    ExecIdSequence exec_id_sequence;
+    std::unordered_set<std::string> exec_ids;
+    std::string exec_id;
+
+    for (int i = 0; i < 1000; ++i) {
+        exec_id_sequence.next(exec_id);
+        EXPECT_TRUE(exec_ids.insert(exec_id).second);
+    }
+}
+
+TEST(ExecIdSequenceTest, SequencesDoNotCollide) {
+    ExecIdSequence first_sequence;
+    ExecIdSequence second_sequence;
+    std::string first_exec_id;
+    std::string second_exec_id;
+
+    first_sequence.next(first_exec_id);
+    second_sequence.next(second_exec_id);
+
+    EXPECT_NE(first_exec_id, second_exec_id);
+}
+
+// =====================================================================
+// ExecutionReportBuilderTest
+// =====================================================================
+
+TEST(ExecutionReportBuilderTest, EveryReportGetsAFreshExecId) {
+    auto& builder = ExecutionReportBuilder::for_this_thread();
+
+    const std::string first_exec_id = builder.start_report().exec_id;
+    const auto& report = builder.start_report();
+
+    EXPECT_EQ(report.sender_comp_id, SERVER_NAME);
+    EXPECT_FALSE(report.exec_id.empty());
+    EXPECT_NE(report.exec_id, first_exec_id);
+}
+
+TEST(ExecutionReportBuilderTest, EachThreadHasItsOwnBuilder) {
+    const auto* main_thread_builder = &ExecutionReportBuilder::for_this_thread();
+    const ExecutionReportBuilder* other_thread_builder = nullptr;
+
+    std::thread{[&] { other_thread_builder = &ExecutionReportBuilder::for_this_thread(); }}.join();
+
+    EXPECT_NE(main_thread_builder, other_thread_builder);
+}
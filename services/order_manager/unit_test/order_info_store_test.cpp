@@ -0,0 +1,149 @@
+#include "order_info_store.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace om;
+
+namespace {
+OrderInfo make_order_info(int leaves_qty) {
+    return OrderInfo{.sender_comp_id = "CLIENT",
+                     .symbol = "AAPL",
+                     .side = core::Side::bid,
+                     .price = 100,
+                     .time_in_force = core::TimeInForce::gtc,
+                     .leaves_qty = leaves_qty,
+                     .cum_qty = 0,
+                     .avg_px = 0,
+                     .arrival_gateway_id = 1};
+}
+} // namespace
+
+class OrderInfoStoreTest : public testing::Test {
+  protected:
+    OrderInfoStore store{2};
+};
+
+TEST_F(OrderInfoStoreTest, EmplacedOrderIsLive) {
+    EXPECT_TRUE(store.emplace(5, make_order_info(10)));
+
+    EXPECT_TRUE(store.is_live(5));
+    EXPECT_TRUE(store.contains(5));
+    EXPECT_EQ(store.at(5).leaves_qty, 10);
+    EXPECT_EQ(store.live_count(), 1);
+}
+
+TEST_F(OrderInfoStoreTest, DuplicateEmplaceIsRejected) {
+    store.emplace(5, make_order_info(10));
+
+    EXPECT_FALSE(store.emplace(5, make_order_info(99)));
+    EXPECT_EQ(store.at(5).leaves_qty, 10);
+    EXPECT_EQ(store.live_count(), 1);
+}
+
+TEST_F(OrderInfoStoreTest, OutOfOrderIdsAreAddressable) {
+    store.emplace(10, make_order_info(1));
+    store.emplace(3, make_order_info(2));
+    store.emplace(20, make_order_info(3));
+
+    EXPECT_EQ(store.at(10).leaves_qty, 1);
+    EXPECT_EQ(store.at(3).leaves_qty, 2);
+    EXPECT_EQ(store.at(20).leaves_qty, 3);
+    EXPECT_FALSE(store.contains(4));
+    EXPECT_EQ(store.live_count(), 3);
+}
+
+TEST_F(OrderInfoStoreTest, UnknownOrderThrows) {
+    store.emplace(1, make_order_info(1));
+
+    EXPECT_THROW(std::ignore = store.at(0), std::out_of_range);
+    EXPECT_THROW(std::ignore = store.at(2), std::out_of_range);
+}
+
+TEST_F(OrderInfoStoreTest, RetiredOrderRemainsReadableFromArchive) {
+    store.emplace(1, make_order_info(0));
+    store.emplace(2, make_order_info(5));
+
+    EXPECT_FALSE(store.retire(1).has_value());
+
+    EXPECT_FALSE(store.is_live(1));
+    EXPECT_TRUE(store.contains(1));
+    EXPECT_EQ(store.at(1).leaves_qty, 0);
+    EXPECT_EQ(store.live_count(), 1);
+    EXPECT_EQ(store.archived_count(), 1);
+}
+
+TEST_F(OrderInfoStoreTest, FullArchiveEvictsOldestRetirement) {
+    for (int order_id = 0; order_id < 3; ++order_id) {
+        store.emplace(order_id, make_order_info(0));
+    }
+
+    EXPECT_FALSE(store.retire(2).has_value());
+    EXPECT_FALSE(store.retire(0).has_value());
+    EXPECT_EQ(store.retire(1), 2);
+
+    EXPECT_FALSE(store.contains(2));
+    EXPECT_TRUE(store.contains(0));
+    EXPECT_TRUE(store.contains(1));
+    EXPECT_EQ(store.archived_count(), 2);
+    EXPECT_EQ(store.live_count(), 0);
+}
+
+TEST_F(OrderInfoStoreTest, StoreIsReusableAfterDraining) {
+    store.emplace(7, make_order_info(0));
+    store.retire(7);
+
+    EXPECT_TRUE(store.emplace(8, make_order_info(4)));
+    EXPECT_TRUE(store.is_live(8));
+    EXPECT_EQ(store.at(7).leaves_qty, 0);
+}
+
+TEST(OrderInfoStoreWindowTest, LaggingLiveOrderDoesNotPinTheWindow) {
+    OrderInfoStore store{2, 4};
+    store.emplace(0, make_order_info(10));
+
+    // Order 0 rests while a long run of newer orders comes and goes
+    for (int order_id = 1; order_id <= 1000; ++order_id) {
+        store.emplace(order_id, make_order_info(0));
+        store.retire(order_id);
+    }
+
+    EXPECT_TRUE(store.is_live(0));
+    EXPECT_EQ(store.at(0).leaves_qty, 10);
+    EXPECT_EQ(store.straggler_count(), 1);
+    EXPECT_EQ(store.live_count(), 1);
+
+    EXPECT_EQ(store.retire(0), 999);
+    EXPECT_FALSE(store.is_live(0));
+    EXPECT_TRUE(store.contains(0));
+    EXPECT_EQ(store.straggler_count(), 0);
+    EXPECT_EQ(store.live_count(), 0);
+}
+
+TEST(OrderInfoStoreWindowTest, OrdersOutsideTheWindowStayAddressable) {
+    OrderInfoStore store{2, 4};
+
+    store.emplace(100, make_order_info(1));
+    store.emplace(101, make_order_info(2));
+    store.emplace(110, make_order_info(3));
+    store.emplace(50, make_order_info(4));
+
+    EXPECT_EQ(store.at(100).leaves_qty, 1);
+    EXPECT_EQ(store.at(101).leaves_qty, 2);
+    EXPECT_EQ(store.at(110).leaves_qty, 3);
+    EXPECT_EQ(store.at(50).leaves_qty, 4);
+    EXPECT_FALSE(store.emplace(100, make_order_info(99)));
+    EXPECT_EQ(store.straggler_count(), 3);
+    EXPECT_EQ(store.live_count(), 4);
+
+    store.retire(101);
+    EXPECT_TRUE(store.contains(101));
+    EXPECT_FALSE(store.is_live(101));
+    EXPECT_EQ(store.live_count(), 3);
+}
+
+using OrderInfoStoreDeathTest = OrderInfoStoreTest;
+
+TEST_F(OrderInfoStoreDeathTest, RetiringUnknownOrderViolatesContract) {
+    EXPECT_DEATH(store.retire(1), "");
+}
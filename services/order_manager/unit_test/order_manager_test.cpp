@@ -1,4 +1,5 @@
 #include "order_manager.h"
+#include "order_manager_shard.h"
 #include "transport/inbound_server.h"
 #include "transport/messaging.h"
 #include "transport/outbound_client.h"
@@ -6,6 +7,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <future>
+#include <limits>
 #include <unordered_set>
 #include <vector>
 
@@ -23,6 +26,7 @@ constexpr int TEST_PORT{1234};
 class MockInboundServer : public transport::InboundServer {
   public:
     MOCK_METHOD((std::expected<void, int>), start, (), (override));
+    MOCK_METHOD(void, set_message_notifier, (std::shared_ptr<core::MessageNotifier>), (override));
     MOCK_METHOD(std::vector<transport::InboundConnectionInfo>, get_connection_info, (),
                 (const, override));
     MOCK_METHOD(std::optional<std::string>, dequeue_message, (int), (override));
@@ -33,6 +37,7 @@ class MockInboundServer : public transport::InboundServer {
 class MockOutboundClient : public transport::OutboundClient {
   public:
     MOCK_METHOD((std::expected<void, int>), start, (), (override));
+    MOCK_METHOD(void, set_message_notifier, (std::shared_ptr<core::MessageNotifier>), (override));
     MOCK_METHOD((std::expected<int, int>), connect, (std::string_view, std::string_view),
                 (override));
     MOCK_METHOD(std::optional<std::string>, dequeue_message, (int), (override));
@@ -59,9 +64,20 @@ class MockDatabaseClient : public OrderManagerDatabase {
                 (const std::string_view&), (override));
     MOCK_METHOD((std::expected<void, std::string>), update_balance,
                 (int, int, std::string_view, std::int64_t), (override));
+    MOCK_METHOD((std::expected<std::vector<DbLiveOrderRow>, std::string>), get_live_orders,
+                (std::string_view), (override));
+    MOCK_METHOD((std::expected<std::optional<int>, std::string>), get_max_order_id,
+                (std::string_view, int, int), (override));
+    MOCK_METHOD((std::expected<DbOrderIdBlock, std::string>), reserve_order_id_block,
+                (int, int, int, int), (override));
+    MOCK_METHOD((std::expected<int, std::string>), claim_order_id_shard_count, (int, int),
+                (override));
 };
 
 class BaseOrderManagerTest : public testing::Test {
+    // Declared before test_om, whose construction counts the clients it creates
+    int creation_count = 0;
+
   protected:
     MockInboundServer* mock_inbound_server;
     MockOutboundClient* mock_order_request_client;
@@ -94,17 +110,17 @@ class BaseOrderManagerTest : public testing::Test {
                   ++creation_count;
                   return ws;
               };
-              dependency_factory.create_database_client = [this](bool) {
+              dependency_factory.create_database_client = [this](bool ensure_init) {
                   auto db = std::make_unique<MockDatabaseClient>();
-                  mock_database_client = db.get();
+                  // Shards get their own clients, keep hold of the Order Manager's
+                  if (ensure_init) {
+                      mock_database_client = db.get();
+                  }
                   return db;
               };
               return OrderManager(TEST_HOST, TEST_PORT, active_symbols, dependency_factory);
           }()} {
     }
-
-  private:
-    int creation_count = 0;
 };
 
 using OrderManagerInitTest = BaseOrderManagerTest;
@@ -128,6 +144,44 @@ TEST_F(OrderManagerInitDeathTest, OrderResponseClientStartFailure) {
     EXPECT_DEATH(test_om.init(), "");
 }
 
+TEST_F(OrderManagerInitDeathTest, ShardCountChangedSinceOrderIdsWereReserved) {
+    ON_CALL(*mock_database_client, get_server)
+        .WillByDefault(Return(std::optional<DbServerRow>{DbServerRow{.server_id = 1}}));
+    ON_CALL(*mock_database_client, claim_order_id_shard_count(1, 1)).WillByDefault(Return(2));
+
+    EXPECT_DEATH(test_om.init(), "");
+}
+
+TEST(OrderManagerConstructionTest, EveryTransportWakesTheSameRunLoop) {
+    std::vector<std::shared_ptr<core::MessageNotifier>> message_notifiers;
+    auto save_notifier{[&](std::shared_ptr<core::MessageNotifier> message_notifier) {
+        message_notifiers.push_back(std::move(message_notifier));
+    }};
+
+    OrderManagerDependencyFactory dependency_factory{
+        .create_inbound_server =
+            [&](std::string_view, int, std::shared_ptr<spdlog::logger>, std::vector<int>&) {
+                auto ws = std::make_unique<NiceMock<MockInboundServer>>();
+                EXPECT_CALL(*ws, set_message_notifier).WillOnce(Invoke(save_notifier));
+                return ws;
+            },
+        .create_outbound_client =
+            [&](std::shared_ptr<spdlog::logger>) {
+                auto ws = std::make_unique<NiceMock<MockOutboundClient>>();
+                EXPECT_CALL(*ws, set_message_notifier).WillOnce(Invoke(save_notifier));
+                return ws;
+            },
+        .create_database_client =
+            [](bool) { return std::make_unique<NiceMock<MockDatabaseClient>>(); }};
+
+    OrderManager order_manager{TEST_HOST, TEST_PORT, {"AAPL"}, dependency_factory};
+
+    ASSERT_EQ(message_notifiers.size(), 3);
+    EXPECT_NE(message_notifiers[0], nullptr);
+    EXPECT_EQ(message_notifiers[0], message_notifiers[1]);
+    EXPECT_EQ(message_notifiers[0], message_notifiers[2]);
+}
+
 class BalanceCheckerInitTest : public testing::Test {
   protected:
     BalanceChecker balance_checker;
@@ -192,6 +246,61 @@ TEST_F(BalanceCheckerInitTest, LoadsBalancesForMultipleUsersAndTickers) {
     EXPECT_EQ(username_user_id_map.at("bob"), 1);
 }
 
+TEST_F(BalanceCheckerInitTest, LoadsOnlyOwnedUsersButMapsEveryUser) {
+    EXPECT_CALL(mock_db, get_all_users_balances_for_server(_))
+        .WillOnce(Return(std::vector<DbUserBalanceInfo>{
+            {.user_id = 0, .username = "alice", .balances = {{.symbol = "USD", .balance = 1500}}},
+            {.user_id = 1, .username = "bob", .balances = {{.symbol = "USD", .balance = 2500}}},
+        }));
+
+    init_balance_checker(balance_checker, username_user_id_map, mock_db,
+                         [](int user_id) { return user_id == 1; });
+
+    EXPECT_FALSE(balance_checker.broker_id_exists("alice"));
+    EXPECT_EQ(balance_checker.get_balance("bob", "USD"), 2500);
+
+    EXPECT_EQ(username_user_id_map.at("alice"), 0);
+    EXPECT_EQ(username_user_id_map.at("bob"), 1);
+}
+
+TEST_F(BalanceCheckerInitTest, DefersUsersHoldingOnlyInitialUsd) {
+    const std::vector<DbUserBalanceInfo> users_balances{
+        {.user_id = 0, .username = "alice", .balances = {{.symbol = "USD", .balance = 1000}}},
+        {.user_id = 1, .username = "bob", .balances = {{.symbol = "USD", .balance = 900}}},
+        {.user_id = 2,
+         .username = "carol",
+         .balances = {{.symbol = "USD", .balance = 1000}, {.symbol = "AAPL", .balance = 5}}},
+        {.user_id = 3, .username = "dave", .balances = {}},
+    };
+
+    init_balance_checker(balance_checker, username_user_id_map, users_balances, {}, 1000);
+
+    EXPECT_FALSE(balance_checker.broker_id_exists("alice"));
+    EXPECT_EQ(balance_checker.get_balance("bob", "USD"), 900);
+    EXPECT_EQ(balance_checker.get_balance("carol", "AAPL"), 5);
+
+    EXPECT_EQ(username_user_id_map.at("alice"), 0);
+    EXPECT_FALSE(username_user_id_map.contains("dave"));
+}
+
+TEST_F(BalanceCheckerInitTest, DeferredAccountMaterializesOnFirstRequest) {
+    username_user_id_map.emplace("alice", 0);
+    const core::Container new_order = core::NewOrderSingleContainer{.sender_comp_id = "alice"};
+    const core::Container stranger_order =
+        core::NewOrderSingleContainer{.sender_comp_id = "STRANGER"};
+
+    materialize_deferred_account(new_order, username_user_id_map, balance_checker, 1000);
+    materialize_deferred_account(stranger_order, username_user_id_map, balance_checker, 1000);
+
+    EXPECT_EQ(balance_checker.get_balance("alice", "USD"), 1000);
+    EXPECT_FALSE(balance_checker.broker_id_exists("STRANGER"));
+
+    // An existing account is left alone
+    balance_checker.update_balance("alice", "USD", -300);
+    materialize_deferred_account(new_order, username_user_id_map, balance_checker, 1000);
+    EXPECT_EQ(balance_checker.get_balance("alice", "USD"), 700);
+}
+
 using ConnectMatchingEngineTest = BaseOrderManagerTest;
 
 TEST_F(ConnectMatchingEngineTest, ConnectsBothMatchingEngineClientsOnFirstTry) {
@@ -265,6 +374,8 @@ class PreprocessContainerTest : public testing::Test {
     OrderManager::OrderIdMapContainer order_id_map;
     OrderManager::OrderInfoMapContainer order_info_map;
     OrderManager::UsernameToUserIdMapContainer username_user_id_map;
+    OrderManager::PendingFillCostMapContainer pending_fill_cost_map;
+    OrderIdAllocator order_id_allocator{0, std::numeric_limits<int>::max()};
     MockOutboundClient mock_order_request_client;
 
     PreprocessContainerTest() {
@@ -285,9 +396,10 @@ TEST_F(PreprocessContainerTest, NewOrderUnknownSender) {
                                       .price = 100,
                                       .time_in_force = core::TimeInForce::gtc};
 
-    preprocess_container(new_order, order_id_map, order_info_map, username_user_id_map, 0,
-                         mock_order_request_client, 0)
-        .transform([](std::optional<int>) { ADD_FAILURE(); })
+    preprocess_container(new_order, order_id_allocator, order_id_map, order_info_map,
+                         username_user_id_map, pending_fill_cost_map, 0, mock_order_request_client,
+                         0)
+        .transform([](PreprocessResult) { ADD_FAILURE(); })
         .transform_error([](std::string&& err) -> std::string {
             // TODO: Check correct error after error enums are established
             SUCCEED();
@@ -320,9 +432,10 @@ TEST_F(PreprocessContainerTest, NewOrderDuplicateClOrdId) {
                                       .price = 100,
                                       .time_in_force = core::TimeInForce::gtc};
 
-    preprocess_container(new_order_1, order_id_map, order_info_map, username_user_id_map, 0,
-                         mock_order_request_client, 0)
-        .transform([&](std::optional<int>) {
+    preprocess_container(new_order_1, order_id_allocator, order_id_map, order_info_map,
+                         username_user_id_map, pending_fill_cost_map, 0, mock_order_request_client,
+                         0)
+        .transform([&](PreprocessResult) {
             EXPECT_EQ(order_id_map.left.at(
                           std::get<core::NewOrderSingleContainer>(new_order_1).order_id.value()),
                       100 * core::constants::max_user_count + 1);
@@ -332,9 +445,10 @@ TEST_F(PreprocessContainerTest, NewOrderDuplicateClOrdId) {
             return err;
         });
 
-    preprocess_container(new_order_2, order_id_map, order_info_map, username_user_id_map, 0,
-                         mock_order_request_client, 0)
-        .transform([](std::optional<int>) { ADD_FAILURE(); })
+    preprocess_container(new_order_2, order_id_allocator, order_id_map, order_info_map,
+                         username_user_id_map, pending_fill_cost_map, 0, mock_order_request_client,
+                         0)
+        .transform([](PreprocessResult) { ADD_FAILURE(); })
         .transform_error([](std::string&& err) -> std::string {
             SUCCEED();
             return err;
@@ -354,8 +468,9 @@ TEST_F(PreprocessContainerTest, NonMarketBidNewOrder) {
                                       .price = 100,
                                       .time_in_force = core::TimeInForce::gtc};
 
-    std::ignore = preprocess_container(new_order, order_id_map, order_info_map,
-                                       username_user_id_map, 0, mock_order_request_client, 0);
+    std::ignore = preprocess_container(new_order, order_id_allocator, order_id_map, order_info_map,
+                                       username_user_id_map, pending_fill_cost_map, 0,
+                                       mock_order_request_client, 0);
 
     std::ignore =
         std::get<core::NewOrderSingleContainer>(new_order)
@@ -412,25 +527,30 @@ TEST_F(PreprocessContainerTest, MarketBidNewOrder) {
             EXPECT_EQ(query->symbol, "AAPL");
             EXPECT_EQ(query->quantity, 10);
             EXPECT_EQ(query->side, core::Side::ask);
+            EXPECT_EQ(query->request_id, 0);
 
             return std::expected<void, int>{};
         }));
 
-    EXPECT_CALL(mock_order_request_client, wait_and_dequeue_message(0))
-        .WillOnce(Return(
-            transport::serialize_container(core::FillCostResponseContainer{.total_cost = 1000})));
+    // The OM must not block on the Matching Engine's reply
+    EXPECT_CALL(mock_order_request_client, wait_and_dequeue_message).Times(0);
 
-    preprocess_container(new_order, order_id_map, order_info_map, username_user_id_map, 0,
-                         mock_order_request_client, 0)
-        .transform([](std::optional<int> fill_cost) {
-            EXPECT_EQ(fill_cost.value(), 1000);
-            return fill_cost;
+    preprocess_container(new_order, order_id_allocator, order_id_map, order_info_map,
+                         username_user_id_map, pending_fill_cost_map, 0, mock_order_request_client,
+                         0)
+        .transform([](PreprocessResult preprocess_result) {
+            EXPECT_EQ(preprocess_result, PreprocessResult::awaiting_fill_cost);
+            return preprocess_result;
         })
         .transform_error([](std::string&& err) -> std::string {
             ADD_FAILURE();
             return err;
         });
 
+    ASSERT_TRUE(pending_fill_cost_map.contains(0));
+    EXPECT_EQ(pending_fill_cost_map.at(0).new_order.order_id, 0);
+    EXPECT_EQ(pending_fill_cost_map.at(0).arrival_gateway_id, 0);
+
     std::ignore =
         std::get<core::NewOrderSingleContainer>(new_order)
             .order_id
@@ -474,13 +594,45 @@ TEST_F(PreprocessContainerTest, MarketBidNewOrderFillCostQueryFail) {
 
     EXPECT_CALL(mock_order_request_client, send).WillOnce(Return(std::unexpected{-1}));
 
-    std::ignore = preprocess_container(new_order, order_id_map, order_info_map,
-                                       username_user_id_map, 0, mock_order_request_client, 0)
-                      .transform([](std::optional<int>) { ADD_FAILURE(); })
+    std::ignore = preprocess_container(new_order, order_id_allocator, order_id_map, order_info_map,
+                                       username_user_id_map, pending_fill_cost_map, 0,
+                                       mock_order_request_client, 0)
+                      .transform([](PreprocessResult) { ADD_FAILURE(); })
                       .transform_error([](std::string&& err) -> std::string {
                           SUCCEED();
                           return err;
                       });
+
+    EXPECT_TRUE(pending_fill_cost_map.empty());
+}
+
+TEST_F(PreprocessContainerTest, FillCostResponseResumesPendingMarketBid) {
+    pending_fill_cost_map.emplace(
+        7, PendingMarketBid{.new_order = core::NewOrderSingleContainer{.sender_comp_id = "CLIENT",
+                                                                       .order_id = 7},
+                            .arrival_gateway_id = 3});
+
+    const auto pending_market_bid = take_pending_market_bid(
+        core::FillCostResponseContainer{.total_cost = 1000, .request_id = 7},
+        pending_fill_cost_map);
+
+    ASSERT_TRUE(pending_market_bid.has_value());
+    EXPECT_EQ(pending_market_bid->new_order.order_id, 7);
+    EXPECT_EQ(pending_market_bid->arrival_gateway_id, 3);
+    EXPECT_TRUE(pending_fill_cost_map.empty());
+}
+
+TEST_F(PreprocessContainerTest, UnmatchedFillCostResponseIsIgnored) {
+    pending_fill_cost_map.emplace(
+        7, PendingMarketBid{.new_order = core::NewOrderSingleContainer{.sender_comp_id = "CLIENT",
+                                                                       .order_id = 7},
+                            .arrival_gateway_id = 3});
+
+    EXPECT_FALSE(take_pending_market_bid(
+                     core::FillCostResponseContainer{.total_cost = 1000, .request_id = 8},
+                     pending_fill_cost_map)
+                     .has_value());
+    EXPECT_EQ(pending_fill_cost_map.size(), 1);
 }
 
 TEST_F(PreprocessContainerTest, CancelRequestUnknownSender) {
@@ -493,9 +645,10 @@ TEST_F(PreprocessContainerTest, CancelRequestUnknownSender) {
                                                                        .side = core::Side::bid,
                                                                        .order_qty = 10};
 
-    std::ignore = preprocess_container(cancel_request, order_id_map, order_info_map,
-                                       username_user_id_map, 0, mock_order_request_client, 0)
-                      .transform([](std::optional<int>) { ADD_FAILURE(); })
+    std::ignore = preprocess_container(cancel_request, order_id_allocator, order_id_map,
+                                       order_info_map, username_user_id_map, pending_fill_cost_map,
+                                       0, mock_order_request_client, 0)
+                      .transform([](PreprocessResult) { ADD_FAILURE(); })
                       .transform_error([](std::string&& err) -> std::string {
                           // TODO: Check correct error after error enums are established
                           SUCCEED();
@@ -516,8 +669,9 @@ TEST_F(PreprocessContainerTest, ValidCancelRequest) {
     order_id_map.insert(OrderManager::OrderIdPair(0, 100 * core::constants::max_user_count + 1));
     username_user_id_map.emplace("CLIENT", 1);
 
-    std::ignore = preprocess_container(cancel_request, order_id_map, order_info_map,
-                                       username_user_id_map, 0, mock_order_request_client, 0);
+    std::ignore = preprocess_container(cancel_request, order_id_allocator, order_id_map,
+                                       order_info_map, username_user_id_map, pending_fill_cost_map,
+                                       0, mock_order_request_client, 0);
 
     std::get<core::CancelOrderRequestContainer>(cancel_request)
         .order_id
@@ -531,6 +685,34 @@ TEST_F(PreprocessContainerTest, ValidCancelRequest) {
         });
 }
 
+TEST_F(PreprocessContainerTest, CancelRequestRehomesRestoredOrder) {
+    core::Container cancel_request = core::CancelOrderRequestContainer{.sender_comp_id = "CLIENT",
+                                                                       .target_comp_id = "OM",
+                                                                       .order_id = std::nullopt,
+                                                                       .orig_cl_ord_id = 100,
+                                                                       .cl_ord_id = 1234,
+                                                                       .symbol = "AAPL",
+                                                                       .side = core::Side::bid,
+                                                                       .order_qty = 10};
+
+    order_id_map.insert(OrderManager::OrderIdPair(0, 100 * core::constants::max_user_count + 1));
+    order_info_map.emplace(0, OrderInfo{.sender_comp_id = "CLIENT",
+                                        .symbol = "AAPL",
+                                        .side = core::Side::bid,
+                                        .price = 100,
+                                        .time_in_force = core::TimeInForce::gtc,
+                                        .leaves_qty = 10,
+                                        .cum_qty = 0,
+                                        .avg_px = 0,
+                                        .arrival_gateway_id = unknown_gateway_id});
+
+    std::ignore = preprocess_container(cancel_request, order_id_allocator, order_id_map,
+                                       order_info_map, username_user_id_map, pending_fill_cost_map,
+                                       7, mock_order_request_client, 0);
+
+    EXPECT_EQ(order_info_map.at(0).arrival_gateway_id, 7);
+}
+
 TEST_F(PreprocessContainerTest, InvalidCancelRequest) {
     core::Container cancel_request = core::CancelOrderRequestContainer{.sender_comp_id = "CLIENT",
                                                                        .target_comp_id = "OM",
@@ -543,8 +725,9 @@ TEST_F(PreprocessContainerTest, InvalidCancelRequest) {
 
     username_user_id_map.emplace("CLIENT", 1);
 
-    std::ignore = preprocess_container(cancel_request, order_id_map, order_info_map,
-                                       username_user_id_map, 0, mock_order_request_client, 0);
+    std::ignore = preprocess_container(cancel_request, order_id_allocator, order_id_map,
+                                       order_info_map, username_user_id_map, pending_fill_cost_map,
+                                       0, mock_order_request_client, 0);
 
     std::get<core::CancelOrderRequestContainer>(cancel_request)
         .order_id
@@ -804,6 +987,294 @@ TEST_F(ValidateContainerTest, InvalidCancelRequest) {
     EXPECT_NE(validate_container(cancel_request, active_symbols, balance_checker), "ok");
 }
 
+class CheckRiskLimitsTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        balance_checker.update_balance("CLIENT", USD_SYMBOL, 1'000'000);
+    }
+
+    static core::NewOrderSingleContainer make_limit_bid(int order_qty, int price) {
+        return core::NewOrderSingleContainer{.sender_comp_id = "CLIENT",
+                                             .target_comp_id = "OM",
+                                             .order_id = 0,
+                                             .cl_ord_id = 100,
+                                             .symbol = "AAPL",
+                                             .side = core::Side::bid,
+                                             .order_qty = order_qty,
+                                             .ord_type = core::OrderType::limit,
+                                             .price = price,
+                                             .time_in_force = core::TimeInForce::gtc};
+    }
+
+    BalanceChecker balance_checker;
+    LastTradePrices last_trade_prices{{"AAPL"}};
+    const RiskChecker::Clock::time_point now{RiskChecker::Clock::now()};
+};
+
+TEST_F(CheckRiskLimitsTest, OrderWithinLimitsPasses) {
+    RiskChecker risk_checker{RiskLimits{.max_order_qty = 10,
+                                        .max_order_notional = 1000,
+                                        .max_open_orders_per_user = 1,
+                                        .max_messages_per_second = 1,
+                                        .price_band_bps = 1000}};
+    last_trade_prices.record("AAPL", 100);
+
+    EXPECT_EQ(check_risk_limits(make_limit_bid(10, 100), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "ok");
+}
+
+TEST_F(CheckRiskLimitsTest, RejectsEachBreachedLimit) {
+    RiskChecker risk_checker{RiskLimits{
+        .max_order_qty = 10, .max_order_notional = 1000, .price_band_bps = 1000}};
+
+    EXPECT_EQ(check_risk_limits(make_limit_bid(11, 1), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "Order quantity exceeds limit");
+    EXPECT_EQ(check_risk_limits(make_limit_bid(10, 101), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "Order notional exceeds limit");
+
+    last_trade_prices.record("AAPL", 50);
+    EXPECT_EQ(check_risk_limits(make_limit_bid(10, 56), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "Price outside band around last trade");
+}
+
+TEST_F(CheckRiskLimitsTest, MarketOrdersValuedAtFillCostOrLastTrade) {
+    RiskChecker risk_checker{RiskLimits{.max_order_notional = 1000}};
+    auto market_bid = make_limit_bid(10, 0);
+    market_bid.ord_type = core::OrderType::market;
+    market_bid.price = std::nullopt;
+    auto market_ask = market_bid;
+    market_ask.side = core::Side::ask;
+
+    EXPECT_EQ(check_risk_limits(market_bid, balance_checker, risk_checker, last_trade_prices, now,
+                                1001),
+              "Order notional exceeds limit");
+    EXPECT_EQ(check_risk_limits(market_ask, balance_checker, risk_checker, last_trade_prices, now),
+              "ok");
+
+    last_trade_prices.record("AAPL", 101);
+    EXPECT_EQ(check_risk_limits(market_ask, balance_checker, risk_checker, last_trade_prices, now),
+              "Order notional exceeds limit");
+}
+
+TEST_F(CheckRiskLimitsTest, OpenOrderLimitCountsOnlyAcceptedOrders) {
+    RiskChecker risk_checker{RiskLimits{.max_open_orders_per_user = 1}};
+    const core::Container new_order = make_limit_bid(10, 100);
+    const OrderManager::OrderInfoMapContainer order_info_map;
+
+    update_risk_state(new_order, order_info_map, balance_checker, risk_checker, false);
+    EXPECT_EQ(check_risk_limits(new_order, balance_checker, risk_checker, last_trade_prices, now),
+              "ok");
+
+    update_risk_state(new_order, order_info_map, balance_checker, risk_checker, true);
+    EXPECT_EQ(check_risk_limits(new_order, balance_checker, risk_checker, last_trade_prices, now),
+              "Open order limit reached");
+}
+
+TEST_F(CheckRiskLimitsTest, ThrottlesNewOrdersAndCancels) {
+    RiskChecker risk_checker{RiskLimits{.max_messages_per_second = 1}};
+    const core::Container cancel_request =
+        core::CancelOrderRequestContainer{.sender_comp_id = "CLIENT", .symbol = "AAPL"};
+
+    EXPECT_EQ(check_risk_limits(make_limit_bid(10, 100), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "ok");
+    EXPECT_EQ(check_risk_limits(cancel_request, balance_checker, risk_checker, last_trade_prices,
+                                now),
+              "Message rate limit exceeded");
+    EXPECT_EQ(check_risk_limits(make_limit_bid(10, 100), balance_checker, risk_checker,
+                                last_trade_prices, now),
+              "Message rate limit exceeded");
+}
+
+TEST_F(CheckRiskLimitsTest, UnknownSenderIsLeftToValidation) {
+    RiskChecker risk_checker{RiskLimits{.max_order_qty = 1}};
+    auto new_order = make_limit_bid(10, 100);
+    new_order.sender_comp_id = "STRANGER";
+
+    EXPECT_EQ(check_risk_limits(new_order, balance_checker, risk_checker, last_trade_prices, now),
+              "ok");
+}
+
+class UpdateRiskStateTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        balance_checker.update_balance("TAKER", USD_SYMBOL, 10'000);
+        balance_checker.update_balance("MAKER", "AAPL", 100);
+        taker_id = balance_checker.find_user("TAKER").value();
+        maker_id = balance_checker.find_user("MAKER").value();
+    }
+
+    void add_order(int order_id, const std::string& sender_comp_id, core::Side side,
+                   int leaves_qty) {
+        order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = sender_comp_id,
+                                                   .symbol = "AAPL",
+                                                   .side = side,
+                                                   .price = 100,
+                                                   .time_in_force = core::TimeInForce::gtc,
+                                                   .leaves_qty = leaves_qty,
+                                                   .cum_qty = 0,
+                                                   .avg_px = 0,
+                                                   .arrival_gateway_id = 1});
+    }
+
+    OrderManager::OrderInfoMapContainer order_info_map;
+    BalanceChecker balance_checker;
+    RiskChecker risk_checker{RiskLimits{}};
+    BalanceChecker::UserId taker_id{};
+    BalanceChecker::UserId maker_id{};
+};
+
+TEST_F(UpdateRiskStateTest, FilledOrdersCloseAndPartialFillsStayOpen) {
+    add_order(11, "TAKER", core::Side::bid, 3);
+    add_order(22, "MAKER", core::Side::ask, 0);
+    risk_checker.on_order_opened(taker_id);
+    risk_checker.on_order_opened(maker_id);
+
+    const core::Container trade = core::TradeContainer{.ticker = "AAPL",
+                                                       .price = 100,
+                                                       .quantity = 7,
+                                                       .trade_id = "T1",
+                                                       .taker_id = "TAKER",
+                                                       .maker_id = "MAKER",
+                                                       .taker_order_id = 11,
+                                                       .maker_order_id = 22,
+                                                       .is_taker_buyer = true};
+
+    update_risk_state(trade, order_info_map, balance_checker, risk_checker);
+
+    EXPECT_EQ(risk_checker.open_order_count(taker_id), 1);
+    EXPECT_EQ(risk_checker.open_order_count(maker_id), 0);
+}
+
+TEST_F(UpdateRiskStateTest, OnlyOwnedTradeLegsClose) {
+    add_order(22, "MAKER", core::Side::ask, 0);
+    risk_checker.on_order_opened(maker_id);
+
+    const core::Container trade = core::TradeContainer{.ticker = "AAPL",
+                                                       .price = 100,
+                                                       .quantity = 7,
+                                                       .trade_id = "T1",
+                                                       .taker_id = "TAKER",
+                                                       .maker_id = "MAKER",
+                                                       .taker_order_id = 11,
+                                                       .maker_order_id = 22,
+                                                       .is_taker_buyer = true};
+
+    update_risk_state(trade, order_info_map, balance_checker, risk_checker, std::nullopt,
+                      TradeLegs{.taker = false, .maker = true});
+
+    EXPECT_EQ(risk_checker.open_order_count(maker_id), 0);
+}
+
+TEST_F(UpdateRiskStateTest, OnlySuccessfulCancelCloses) {
+    add_order(11, "TAKER", core::Side::bid, 10);
+    risk_checker.on_order_opened(taker_id);
+
+    update_risk_state(core::CancelOrderResponseContainer{.order_id = 11, .success = false},
+                      order_info_map, balance_checker, risk_checker);
+    EXPECT_EQ(risk_checker.open_order_count(taker_id), 1);
+
+    update_risk_state(core::CancelOrderResponseContainer{.order_id = 11, .success = true},
+                      order_info_map, balance_checker, risk_checker);
+    EXPECT_EQ(risk_checker.open_order_count(taker_id), 0);
+}
+
+TEST_F(UpdateRiskStateTest, UnfilledMarketOrdersCloseOnTheirCancelResponse) {
+    RiskChecker limited_risk_checker{RiskLimits{.max_open_orders_per_user = 1}};
+
+    for (int order_id = 0; order_id < 1500; ++order_id) {
+        const core::NewOrderSingleContainer market_bid{.sender_comp_id = "TAKER",
+                                                       .order_id = order_id,
+                                                       .symbol = "AAPL",
+                                                       .side = core::Side::bid,
+                                                       .order_qty = 10,
+                                                       .ord_type = core::OrderType::market,
+                                                       .price = std::nullopt};
+        order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = "TAKER",
+                                                   .symbol = "AAPL",
+                                                   .side = core::Side::bid,
+                                                   .price = std::nullopt,
+                                                   .time_in_force = core::TimeInForce::day,
+                                                   .leaves_qty = 10,
+                                                   .cum_qty = 0,
+                                                   .avg_px = 0,
+                                                   .arrival_gateway_id = 1});
+        ASSERT_TRUE(limited_risk_checker.within_open_order_limit(taker_id));
+        update_risk_state(market_bid, order_info_map, balance_checker, limited_risk_checker, true);
+
+        // The Matching Engine drops the remainder of a market order it could not fill
+        update_risk_state(core::CancelOrderResponseContainer{.order_id = order_id, .success = true},
+                          order_info_map, balance_checker, limited_risk_checker);
+    }
+
+    EXPECT_EQ(limited_risk_checker.open_order_count(taker_id), 0);
+}
+
+class RestoreLiveOrdersTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        balance_checker.update_balance("CLIENT", USD_SYMBOL, 10'000);
+        username_user_id_map.emplace("CLIENT", 1);
+    }
+
+    OrderManager::OrderIdMapContainer order_id_map;
+    OrderManager::OrderInfoMapContainer order_info_map;
+    OrderManager::UsernameToUserIdMapContainer username_user_id_map;
+    BalanceChecker balance_checker;
+    RiskChecker risk_checker{RiskLimits{}};
+};
+
+TEST_F(RestoreLiveOrdersTest, RestoresPartiallyFilledOrder) {
+    const std::vector<DbLiveOrderRow> live_orders{{.order_id = 42,
+                                                   .cl_order_id = 100,
+                                                   .sender_comp_id = "CLIENT",
+                                                   .symbol = "AAPL",
+                                                   .side = core::Side::bid,
+                                                   .order_qty = 10,
+                                                   .price = 120,
+                                                   .time_in_force = core::TimeInForce::gtc,
+                                                   .filled_qty = 4,
+                                                   .filled_notional = 4 * 110}};
+
+    restore_live_orders(live_orders, order_id_map, order_info_map, username_user_id_map,
+                        balance_checker, risk_checker);
+
+    ASSERT_TRUE(order_info_map.is_live(42));
+    const auto& order_info = order_info_map.at(42);
+    EXPECT_EQ(order_info.sender_comp_id, "CLIENT");
+    EXPECT_EQ(order_info.price, 120);
+    EXPECT_EQ(order_info.leaves_qty, 6);
+    EXPECT_EQ(order_info.cum_qty, 4);
+    EXPECT_EQ(order_info.avg_px, 110);
+    EXPECT_EQ(order_info.arrival_gateway_id, unknown_gateway_id);
+
+    EXPECT_EQ(order_id_map.left.at(42), 100 * core::constants::max_user_count + 1);
+    EXPECT_EQ(risk_checker.open_order_count(balance_checker.find_user("CLIENT").value()), 1);
+
+    // Reserved balance is already net of the order, restoring must not reserve it again
+    EXPECT_EQ(balance_checker.get_balance("CLIENT", USD_SYMBOL), 10'000);
+}
+
+TEST_F(RestoreLiveOrdersTest, SkipsOrdersOfUnknownUsers) {
+    const std::vector<DbLiveOrderRow> live_orders{{.order_id = 42,
+                                                   .cl_order_id = 100,
+                                                   .sender_comp_id = "STRANGER",
+                                                   .symbol = "AAPL",
+                                                   .side = core::Side::ask,
+                                                   .order_qty = 10,
+                                                   .price = 120}};
+
+    restore_live_orders(live_orders, order_id_map, order_info_map, username_user_id_map,
+                        balance_checker, risk_checker);
+
+    EXPECT_FALSE(order_info_map.contains(42));
+    EXPECT_TRUE(order_id_map.empty());
+}
+
 class GenerateRejectionReportContainerTest : public testing::Test {
   protected:
     OrderManager::OrderInfoMapContainer order_info_map;
@@ -956,6 +1427,49 @@ TEST_F(GenerateSuccessReportContainerTest,
     EXPECT_FALSE(success.exec_id.empty());
 }
 
+TEST(FillReportTest, RefillingAReportOverwritesEveryField) {
+    const OrderManager::OrderInfoMapContainer order_info_map;
+    const core::Container rejected_order =
+        core::NewOrderSingleContainer{.sender_comp_id = "CLIENT_1",
+                                      .target_comp_id = "OM",
+                                      .order_id = 1,
+                                      .cl_ord_id = 100,
+                                      .symbol = "GOOGL",
+                                      .side = core::Side::bid,
+                                      .order_qty = 5,
+                                      .ord_type = core::OrderType::limit,
+                                      .price = 90,
+                                      .time_in_force = core::TimeInForce::day};
+    const core::Container accepted_order =
+        core::NewOrderSingleContainer{.sender_comp_id = "CLIENT_2",
+                                      .target_comp_id = "OM",
+                                      .order_id = 2,
+                                      .cl_ord_id = 200,
+                                      .symbol = "AAPL",
+                                      .side = core::Side::ask,
+                                      .order_qty = 10,
+                                      .ord_type = core::OrderType::market,
+                                      .price = std::nullopt,
+                                      .time_in_force = core::TimeInForce::gtc};
+
+    core::ExecutionReportContainer report{.sender_comp_id = SERVER_NAME};
+    fill_rejection_report(report, rejected_order, order_info_map, "Insufficient balance");
+    fill_success_report(report, accepted_order, order_info_map);
+
+    EXPECT_EQ(report.sender_comp_id, SERVER_NAME);
+    EXPECT_EQ(report.target_comp_id, "CLIENT_2");
+    EXPECT_EQ(report.order_id, 2);
+    EXPECT_EQ(report.cl_order_id, 200);
+    EXPECT_EQ(report.exec_type, core::ExecType::status_new);
+    EXPECT_EQ(report.ord_status, core::OrderStatus::status_new);
+    EXPECT_EQ(report.text, std::nullopt);
+    EXPECT_EQ(report.symbol, "AAPL");
+    EXPECT_EQ(report.side, core::Side::ask);
+    EXPECT_EQ(report.price, std::nullopt);
+    EXPECT_EQ(report.time_in_force, core::TimeInForce::gtc);
+    EXPECT_EQ(report.leaves_qty, 10);
+}
+
 class ForwardAndReplyTest : public testing::Test {
   protected:
     MockOutboundClient mock_order_request_client;
@@ -1357,6 +1871,105 @@ TEST_F(UpdateInternalDataTest, TradeWithTakerAsBuyerWithPriceImprovementAndRefun
     EXPECT_EQ(balance_checker.get_balance("MAKER", USD_SYMBOL), 500);
 }
 
+TEST_F(UpdateInternalDataTest, MarketBidFillsAreSettledAgainstItsReservation) {
+    order_info_map.emplace(11, OrderInfo{.sender_comp_id = "TAKER",
+                                         .symbol = "AAPL",
+                                         .side = core::Side::bid,
+                                         .price = std::nullopt,
+                                         .time_in_force = core::TimeInForce::day,
+                                         .leaves_qty = 5,
+                                         .cum_qty = 0,
+                                         .avg_px = 0,
+                                         .arrival_gateway_id = 1,
+                                         .reserved_usd = 1000});
+
+    for (const auto [maker_order_id, maker_price] : {std::pair{22, 100}, std::pair{33, 110}}) {
+        order_info_map.emplace(maker_order_id, OrderInfo{.sender_comp_id = "MAKER",
+                                                         .symbol = "AAPL",
+                                                         .side = core::Side::ask,
+                                                         .price = maker_price,
+                                                         .time_in_force = core::TimeInForce::gtc,
+                                                         .leaves_qty = 5,
+                                                         .cum_qty = 0,
+                                                         .avg_px = 0,
+                                                         .arrival_gateway_id = 2});
+    }
+
+    // The quoted fill cost of 1000 has been reserved already
+    balance_checker.update_balance("TAKER", USD_SYMBOL, 0);
+
+    update_internal_data(core::TradeContainer{.ticker = "AAPL",
+                                              .price = 100,
+                                              .quantity = 3,
+                                              .trade_id = "T1",
+                                              .taker_id = "TAKER",
+                                              .maker_id = "MAKER",
+                                              .taker_order_id = 11,
+                                              .maker_order_id = 22,
+                                              .is_taker_buyer = true},
+                         order_info_map, balance_checker);
+
+    EXPECT_EQ(order_info_map.at(11).reserved_usd, 700);
+    EXPECT_EQ(balance_checker.get_balance("TAKER", USD_SYMBOL), 0);
+
+    update_internal_data(core::TradeContainer{.ticker = "AAPL",
+                                              .price = 110,
+                                              .quantity = 2,
+                                              .trade_id = "T2",
+                                              .taker_id = "TAKER",
+                                              .maker_id = "MAKER",
+                                              .taker_order_id = 11,
+                                              .maker_order_id = 33,
+                                              .is_taker_buyer = true},
+                         order_info_map, balance_checker);
+
+    // The final fill releases whatever the 520 spent left of the reservation
+    EXPECT_EQ(order_info_map.at(11).reserved_usd, 0);
+    EXPECT_EQ(balance_checker.get_balance("TAKER", USD_SYMBOL), 480);
+    EXPECT_EQ(balance_checker.get_balance("TAKER", "AAPL"), 5);
+}
+
+TEST_F(UpdateInternalDataTest, MarketBidFillBeyondAStaleQuoteDebitsTheExcess) {
+    order_info_map.emplace(11, OrderInfo{.sender_comp_id = "TAKER",
+                                         .symbol = "AAPL",
+                                         .side = core::Side::bid,
+                                         .price = std::nullopt,
+                                         .time_in_force = core::TimeInForce::day,
+                                         .leaves_qty = 5,
+                                         .cum_qty = 0,
+                                         .avg_px = 0,
+                                         .arrival_gateway_id = 1,
+                                         .reserved_usd = 500});
+
+    order_info_map.emplace(22, OrderInfo{.sender_comp_id = "MAKER",
+                                         .symbol = "AAPL",
+                                         .side = core::Side::ask,
+                                         .price = 120,
+                                         .time_in_force = core::TimeInForce::gtc,
+                                         .leaves_qty = 5,
+                                         .cum_qty = 0,
+                                         .avg_px = 0,
+                                         .arrival_gateway_id = 2});
+
+    balance_checker.update_balance("TAKER", USD_SYMBOL, 1000);
+
+    update_internal_data(core::TradeContainer{.ticker = "AAPL",
+                                              .price = 120,
+                                              .quantity = 5,
+                                              .trade_id = "T1",
+                                              .taker_id = "TAKER",
+                                              .maker_id = "MAKER",
+                                              .taker_order_id = 11,
+                                              .maker_order_id = 22,
+                                              .is_taker_buyer = true},
+                         order_info_map, balance_checker);
+
+    // The book moved after the quote, so the 100 the reservation does not cover is debited
+    EXPECT_EQ(order_info_map.at(11).reserved_usd, 0);
+    EXPECT_EQ(balance_checker.get_balance("TAKER", USD_SYMBOL), 900);
+    EXPECT_EQ(balance_checker.get_balance("MAKER", USD_SYMBOL), 600);
+}
+
 TEST_F(UpdateInternalDataTest, SuccessfulBidCancelResponseRefundsReservedUsd) {
     constexpr int order_id = 55;
     order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = "CLIENT",
@@ -1401,6 +2014,36 @@ TEST_F(UpdateInternalDataTest, SuccessfulAskCancelResponseRefundsRemainingShares
     EXPECT_EQ(balance_checker.get_balance("CLIENT", "AAPL"), 4);
 }
 
+TEST_F(UpdateInternalDataTest, MarketOrderCancelResponsesRefundWhatTheReservationLeft) {
+    for (const auto [order_id, side] : {std::pair{88, core::Side::bid}, {99, core::Side::ask}}) {
+        order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = "CLIENT",
+                                                   .symbol = "AAPL",
+                                                   .side = side,
+                                                   .price = std::nullopt,
+                                                   .time_in_force = core::TimeInForce::day,
+                                                   .leaves_qty = 3,
+                                                   .cum_qty = 2,
+                                                   .avg_px = 123,
+                                                   .arrival_gateway_id = 0});
+    }
+    order_info_map.at(88).reserved_usd = 250;
+
+    balance_checker.update_balance("CLIENT", USD_SYMBOL, 10);
+    balance_checker.update_balance("CLIENT", "AAPL", 1);
+
+    update_internal_data(
+        core::CancelOrderResponseContainer{.order_id = 88, .cl_ord_id = 1, .success = true},
+        order_info_map, balance_checker);
+    update_internal_data(
+        core::CancelOrderResponseContainer{.order_id = 99, .cl_ord_id = 2, .success = true},
+        order_info_map, balance_checker);
+
+    // The bid gets back the unspent part of its fill cost, not a per-share refund
+    EXPECT_EQ(balance_checker.get_balance("CLIENT", USD_SYMBOL), 260);
+    EXPECT_EQ(order_info_map.at(88).reserved_usd, 0);
+    EXPECT_EQ(balance_checker.get_balance("CLIENT", "AAPL"), 4);
+}
+
 TEST_F(UpdateInternalDataTest, RejectedCancelResponseDoesNotChangeBalances) {
     constexpr int order_id = 77;
     order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = "CLIENT",
@@ -1423,6 +2066,40 @@ TEST_F(UpdateInternalDataTest, RejectedCancelResponseDoesNotChangeBalances) {
     EXPECT_EQ(balance_checker.get_balance("CLIENT", USD_SYMBOL), 42);
 }
 
+TEST_F(UpdateInternalDataTest, MakerLegOnlyUpdatesMakerOrderAndBalances) {
+    order_info_map.emplace(22, OrderInfo{.sender_comp_id = "MAKER",
+                                         .symbol = "AAPL",
+                                         .side = core::Side::ask,
+                                         .price = 100,
+                                         .time_in_force = core::TimeInForce::gtc,
+                                         .leaves_qty = 7,
+                                         .cum_qty = 0,
+                                         .avg_px = 0,
+                                         .arrival_gateway_id = 2});
+
+    // The taker's order lives on another shard
+    const core::TradeContainer trade{.ticker = "AAPL",
+                                     .price = 100,
+                                     .quantity = 4,
+                                     .trade_id = "T1",
+                                     .taker_id = "TAKER",
+                                     .maker_id = "MAKER",
+                                     .taker_order_id = 11,
+                                     .maker_order_id = 22,
+                                     .is_taker_buyer = true};
+
+    update_internal_data(trade, order_info_map, balance_checker,
+                         TradeLegs{.taker = false, .maker = true});
+
+    const auto& maker = order_info_map.at(22);
+    EXPECT_EQ(maker.leaves_qty, 3);
+    EXPECT_EQ(maker.cum_qty, 4);
+    EXPECT_EQ(maker.avg_px, 100);
+
+    EXPECT_EQ(balance_checker.get_balance("MAKER", USD_SYMBOL), 400);
+    EXPECT_FALSE(balance_checker.broker_id_exists("TAKER"));
+}
+
 using UpdateInternalDataDeathTest = UpdateInternalDataTest;
 
 TEST_F(UpdateInternalDataDeathTest, MissingTakerOrderInfo) {
@@ -1473,6 +2150,93 @@ TEST_F(UpdateInternalDataDeathTest, MissingMakerOrderInfo) {
     EXPECT_DEATH(update_internal_data(trade, order_info_map, balance_checker), "");
 }
 
+class RetireTerminalOrdersTest : public testing::Test {
+  protected:
+    OrderManager::OrderIdMapContainer order_id_map;
+    OrderManager::OrderInfoMapContainer order_info_map{1};
+
+    void add_order(int order_id, int leaves_qty) {
+        order_id_map.insert(OrderManager::OrderIdPair(
+            order_id, order_id * core::constants::max_user_count + 1));
+        order_info_map.emplace(order_id, OrderInfo{.sender_comp_id = "CLIENT",
+                                                   .symbol = "AAPL",
+                                                   .side = core::Side::bid,
+                                                   .price = 100,
+                                                   .time_in_force = core::TimeInForce::gtc,
+                                                   .leaves_qty = leaves_qty,
+                                                   .cum_qty = 0,
+                                                   .avg_px = 0,
+                                                   .arrival_gateway_id = 1});
+    }
+};
+
+TEST_F(RetireTerminalOrdersTest, FilledOrdersAreRetiredAndPartialFillsStayLive) {
+    add_order(11, 3);
+    add_order(22, 0);
+
+    const core::TradeContainer trade{.ticker = "AAPL",
+                                     .price = 100,
+                                     .quantity = 7,
+                                     .trade_id = "T1",
+                                     .taker_id = "CLIENT",
+                                     .maker_id = "CLIENT",
+                                     .taker_order_id = 11,
+                                     .maker_order_id = 22,
+                                     .is_taker_buyer = true};
+    retire_terminal_orders(trade, order_id_map, order_info_map);
+
+    EXPECT_TRUE(order_info_map.is_live(11));
+    EXPECT_FALSE(order_info_map.is_live(22));
+    EXPECT_EQ(order_info_map.at(22).leaves_qty, 0);
+    EXPECT_EQ(order_id_map.size(), 2);
+}
+
+TEST_F(RetireTerminalOrdersTest, SuccessfulCancelRetiresOrder) {
+    add_order(5, 10);
+
+    retire_terminal_orders(core::CancelOrderResponseContainer{.order_id = 5, .success = true},
+                           order_id_map, order_info_map);
+
+    EXPECT_FALSE(order_info_map.is_live(5));
+}
+
+TEST_F(RetireTerminalOrdersTest, FailedCancelLeavesOrderLive) {
+    add_order(5, 10);
+
+    retire_terminal_orders(core::CancelOrderResponseContainer{.order_id = 5, .success = false},
+                           order_id_map, order_info_map);
+
+    EXPECT_TRUE(order_info_map.is_live(5));
+}
+
+TEST_F(RetireTerminalOrdersTest, OnlyRejectedNewOrdersAreRetired) {
+    add_order(1, 10);
+    add_order(2, 10);
+
+    core::NewOrderSingleContainer accepted{.sender_comp_id = "CLIENT", .order_id = 1};
+    retire_terminal_orders(accepted, order_id_map, order_info_map, true);
+    core::NewOrderSingleContainer rejected{.sender_comp_id = "CLIENT", .order_id = 2};
+    retire_terminal_orders(rejected, order_id_map, order_info_map, false);
+
+    EXPECT_TRUE(order_info_map.is_live(1));
+    EXPECT_FALSE(order_info_map.is_live(2));
+}
+
+TEST_F(RetireTerminalOrdersTest, ArchiveEvictionForgetsClientOrderId) {
+    add_order(1, 10);
+    add_order(2, 10);
+
+    retire_terminal_orders(core::CancelOrderResponseContainer{.order_id = 1, .success = true},
+                           order_id_map, order_info_map);
+    retire_terminal_orders(core::CancelOrderResponseContainer{.order_id = 2, .success = true},
+                           order_id_map, order_info_map);
+
+    EXPECT_FALSE(order_info_map.contains(1));
+    EXPECT_EQ(order_id_map.left.count(1), 0);
+    EXPECT_TRUE(order_info_map.contains(2));
+    EXPECT_EQ(order_id_map.left.count(2), 1);
+}
+
 class GenerateMatchedOrderReportContainersTest : public testing::Test {
   protected:
     OrderManager::OrderIdMapContainer order_id_map;
@@ -1827,6 +2591,9 @@ class UpdateDatabaseTest : public testing::Test {
 using UpdateDatabaseDeathTest = UpdateDatabaseTest;
 
 TEST_F(UpdateDatabaseTest, NewOrderPersistsOrderWithValidationFlag) {
+    username_user_id_map.emplace("CLIENT", 1);
+    balance_checker.update_balance("CLIENT", "AAPL", 90);
+
     const core::NewOrderSingleContainer new_order{.sender_comp_id = "CLIENT",
                                                   .target_comp_id = "OM",
                                                   .order_id = 42,
@@ -1842,11 +2609,36 @@ TEST_F(UpdateDatabaseTest, NewOrderPersistsOrderWithValidationFlag) {
 
     EXPECT_CALL(mock_db, insert_order(_, _, _))
         .WillOnce(Return(std::expected<void, std::string>{}));
+    // The reservation made on acceptance is persisted with the order
+    EXPECT_CALL(mock_db, update_balance(1, server_id, std::string_view{"AAPL"}, 90))
+        .WillOnce(Return(std::expected<void, std::string>{}));
 
     update_database(container, server_id, username_user_id_map, order_info_map, balance_checker,
                     mock_db, true);
 }
 
+TEST_F(UpdateDatabaseTest, RejectedNewOrderLeavesBalancesUntouched) {
+    const core::NewOrderSingleContainer new_order{.sender_comp_id = "CLIENT",
+                                                  .target_comp_id = "OM",
+                                                  .order_id = 42,
+                                                  .cl_ord_id = 100,
+                                                  .symbol = "AAPL",
+                                                  .side = core::Side::bid,
+                                                  .order_qty = 10,
+                                                  .ord_type = core::OrderType::limit,
+                                                  .price = 123,
+                                                  .time_in_force = core::TimeInForce::gtc};
+
+    core::Container container = new_order;
+
+    EXPECT_CALL(mock_db, insert_order(_, _, false))
+        .WillOnce(Return(std::expected<void, std::string>{}));
+    EXPECT_CALL(mock_db, update_balance).Times(0);
+
+    update_database(container, server_id, username_user_id_map, order_info_map, balance_checker,
+                    mock_db, false);
+}
+
 TEST_F(UpdateDatabaseTest, CancelRequestPersistsRequestWithValidationFlag) {
     const core::CancelOrderRequestContainer cancel_request{.sender_comp_id = "CLIENT",
                                                            .target_comp_id = "OM",
@@ -1904,6 +2696,39 @@ TEST_F(UpdateDatabaseTest, TradePersistsTradeWithoutValidationFlag) {
                     mock_db);
 }
 
+TEST_F(UpdateDatabaseTest, MakerLegPersistsOnlyMakerBalances) {
+    const core::TradeContainer trade{.ticker = "AAPL",
+                                     .price = 100,
+                                     .quantity = 4,
+                                     .trade_id = "T-1",
+                                     .taker_id = "TAKER",
+                                     .maker_id = "MAKER",
+                                     .taker_order_id = 11,
+                                     .maker_order_id = 22,
+                                     .is_taker_buyer = true};
+
+    username_user_id_map.emplace("TAKER", 11);
+    username_user_id_map.emplace("MAKER", 22);
+
+    balance_checker.update_balance("MAKER", USD_SYMBOL, 300);
+    balance_checker.update_balance("MAKER", "AAPL", 8);
+
+    core::Container container = trade;
+
+    // The taker's shard records the trade row
+    EXPECT_CALL(mock_db, insert_trade(_)).Times(0);
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_db, update_balance(22, server_id, std::string_view{USD_SYMBOL}, 300))
+            .WillOnce(Return(std::expected<void, std::string>{}));
+        EXPECT_CALL(mock_db, update_balance(22, server_id, std::string_view{"AAPL"}, 8))
+            .WillOnce(Return(std::expected<void, std::string>{}));
+    }
+
+    update_database(container, server_id, username_user_id_map, order_info_map, balance_checker,
+                    mock_db, std::nullopt, TradeLegs{.taker = false, .maker = true});
+}
+
 TEST_F(UpdateDatabaseTest, CancelResponsePersistsResponseWithoutValidationFlag) {
     const core::CancelOrderResponseContainer cancel_response{
         .order_id = 33, .cl_ord_id = 404, .success = true};
@@ -2000,3 +2825,292 @@ TEST_F(UpdateDatabaseDeathTest, CancelRequestWithoutValidityFlagDies) {
                         balance_checker, mock_db, std::nullopt),
         "");
 }
+
+TEST(OrderIdAllocatorTest, HandsOutSequentialIds) {
+    OrderIdAllocator order_id_allocator{5, 8};
+
+    EXPECT_EQ(order_id_allocator.next(), 5);
+    EXPECT_EQ(order_id_allocator.next(), 6);
+    EXPECT_EQ(order_id_allocator.next(), 7);
+}
+
+TEST(OrderIdAllocatorDeathTest, ExhaustedRangeViolatesContract) {
+    OrderIdAllocator order_id_allocator{5, 6};
+    std::ignore = order_id_allocator.next();
+
+    EXPECT_DEATH(std::ignore = order_id_allocator.next(), "");
+}
+
+TEST(OrderIdAllocatorTest, ContinuesFromQueuedBlock) {
+    OrderIdAllocator order_id_allocator{0, 100};
+    order_id_allocator.restart_at(10, 12);
+    order_id_allocator.queue_block(20, 22);
+
+    EXPECT_EQ(order_id_allocator.next(), 10);
+    EXPECT_EQ(order_id_allocator.next(), 11);
+    EXPECT_TRUE(order_id_allocator.has_queued_block());
+    EXPECT_EQ(order_id_allocator.next(), 20);
+    EXPECT_FALSE(order_id_allocator.has_queued_block());
+    EXPECT_EQ(order_id_allocator.next(), 21);
+}
+
+TEST(OrderIdAllocatorDeathTest, BlockBeyondRangeViolatesContract) {
+    OrderIdAllocator order_id_allocator{0, 100};
+
+    EXPECT_DEATH(order_id_allocator.restart_at(90, 110), "");
+    EXPECT_DEATH(order_id_allocator.queue_block(100, 110), "");
+}
+
+TEST(OrderIdAllocatorDeathTest, ExhaustedBlockWithoutQueuedBlockViolatesContract) {
+    OrderIdAllocator order_id_allocator{0, 100};
+    order_id_allocator.restart_at(10, 11);
+    std::ignore = order_id_allocator.next();
+
+    EXPECT_DEATH(std::ignore = order_id_allocator.next(), "");
+}
+
+TEST(ShardRoutingTest, SingleShardAllocatesFromZero) {
+    auto order_id_allocator = make_shard_order_id_allocator(0, 1);
+
+    EXPECT_EQ(order_id_allocator.next(), 0);
+    EXPECT_EQ(shard_for_order_id(std::numeric_limits<int>::max() - 1, 1), 0);
+}
+
+TEST(ShardRoutingTest, ShardOrderIdRangesMapBackToTheirShard) {
+    constexpr int shard_count = 4;
+
+    for (int shard_id{0}; shard_id < shard_count; ++shard_id) {
+        auto order_id_allocator = make_shard_order_id_allocator(shard_id, shard_count);
+
+        EXPECT_EQ(shard_for_order_id(order_id_allocator.next(), shard_count), shard_id);
+        EXPECT_EQ(shard_for_order_id(order_id_allocator.next(), shard_count), shard_id);
+    }
+}
+
+TEST(ShardRoutingTest, GatewayRequestRoutedBySenderUserId) {
+    const OrderManager::UsernameToUserIdMapContainer username_user_id_map{{"alice", 4},
+                                                                          {"bob", 7}};
+
+    const core::Container new_order = core::NewOrderSingleContainer{.sender_comp_id = "bob"};
+    const core::Container cancel_request =
+        core::CancelOrderRequestContainer{.sender_comp_id = "alice"};
+
+    EXPECT_EQ(route_gateway_request(new_order, username_user_id_map, 3), shard_for_user(7, 3));
+    EXPECT_EQ(route_gateway_request(cancel_request, username_user_id_map, 3),
+              shard_for_user(4, 3));
+}
+
+TEST(ShardRoutingTest, UnknownSenderRoutedToFirstShard) {
+    const core::Container new_order = core::NewOrderSingleContainer{.sender_comp_id = "STRANGER"};
+
+    EXPECT_EQ(route_gateway_request(new_order, {}, 3), 0);
+}
+
+TEST(ShardRoutingTest, TradeWithinOneShardIsRoutedOnce) {
+    constexpr int shard_count = 2;
+    const core::Container trade = core::TradeContainer{.taker_order_id = 3, .maker_order_id = 1};
+
+    const auto [route, maker_route] = route_matching_engine_response(trade, shard_count);
+
+    EXPECT_EQ(route.shard_id, 0);
+    EXPECT_TRUE(route.trade_legs.taker);
+    EXPECT_TRUE(route.trade_legs.maker);
+    EXPECT_FALSE(maker_route.has_value());
+}
+
+TEST(ShardRoutingTest, CrossShardTradeIsSplitByLeg) {
+    constexpr int shard_count = 2;
+    auto maker_shard_allocator = make_shard_order_id_allocator(1, shard_count);
+    const core::Container trade =
+        core::TradeContainer{.taker_order_id = 3, .maker_order_id = maker_shard_allocator.next()};
+
+    const auto [route, maker_route] = route_matching_engine_response(trade, shard_count);
+
+    EXPECT_EQ(route.shard_id, 0);
+    EXPECT_TRUE(route.trade_legs.taker);
+    EXPECT_FALSE(route.trade_legs.maker);
+
+    ASSERT_TRUE(maker_route.has_value());
+    EXPECT_EQ(maker_route->shard_id, 1);
+    EXPECT_FALSE(maker_route->trade_legs.taker);
+    EXPECT_TRUE(maker_route->trade_legs.maker);
+}
+
+TEST(ShardRoutingTest, CancelResponseAndFillCostResponseRoutedByOrderId) {
+    constexpr int shard_count = 3;
+    auto order_id_allocator = make_shard_order_id_allocator(2, shard_count);
+    const int order_id = order_id_allocator.next();
+
+    const core::Container cancel_response =
+        core::CancelOrderResponseContainer{.order_id = order_id, .success = true};
+    const core::Container fill_cost_response =
+        core::FillCostResponseContainer{.total_cost = 100, .request_id = order_id};
+
+    EXPECT_EQ(route_matching_engine_response(cancel_response, shard_count).first.shard_id, 2);
+    EXPECT_EQ(route_matching_engine_response(fill_cost_response, shard_count).first.shard_id, 2);
+}
+
+class OrderManagerShardTest : public testing::Test {
+  protected:
+    const std::unordered_set<std::string> active_symbols{"AAPL"};
+    const OrderManager::UsernameToUserIdMapContainer username_user_id_map{{"CLIENT", 1}};
+    const LastTradePrices last_trade_prices{{"AAPL"}};
+    NiceMock<MockInboundServer> mock_inbound_server;
+    NiceMock<MockOutboundClient> mock_order_request_client;
+    OrderManagerShard shard{0,
+                            make_shard_order_id_allocator(0, 1),
+                            active_symbols,
+                            username_user_id_map,
+                            RiskLimits{},
+                            last_trade_prices,
+                            mock_inbound_server,
+                            mock_order_request_client,
+                            std::make_unique<NiceMock<MockDatabaseClient>>(),
+                            spdlog::default_logger()};
+};
+
+TEST_F(OrderManagerShardTest, WorkerRejectsRequestFromUnknownSender) {
+    std::promise<core::ExecutionReportContainer> reply;
+
+    EXPECT_CALL(mock_inbound_server, send(3, _, _))
+        .WillOnce(Invoke([&](int, const std::string& payload,
+                             transport::MessageFormat) -> std::expected<void, int> {
+            const auto container = transport::deserialize_container(payload);
+            reply.set_value(std::get<core::ExecutionReportContainer>(container));
+            return {};
+        }));
+
+    shard.start(1, 0);
+    shard.post(GatewayRequest{.container =
+                                  core::NewOrderSingleContainer{.sender_comp_id = "STRANGER",
+                                                                .cl_ord_id = 100,
+                                                                .symbol = "AAPL",
+                                                                .side = core::Side::ask,
+                                                                .order_qty = 10,
+                                                                .ord_type = core::OrderType::limit,
+                                                                .price = 100},
+                              .arrival_gateway_id = 3});
+
+    auto reply_future = reply.get_future();
+    ASSERT_EQ(reply_future.wait_for(std::chrono::seconds{5}), std::future_status::ready);
+    const auto execution_report = reply_future.get();
+    EXPECT_EQ(execution_report.target_comp_id, "STRANGER");
+    EXPECT_EQ(execution_report.ord_status, core::OrderStatus::status_rejected);
+}
+
+TEST(OrderManagerShardResumeTest, AllocatesFromReservedBlocksAbovePersistedOrderIds) {
+    const std::unordered_set<std::string> active_symbols{"AAPL"};
+    const OrderManager::UsernameToUserIdMapContainer username_user_id_map{{"CLIENT", 1}};
+    const LastTradePrices last_trade_prices{{"AAPL"}};
+    NiceMock<MockInboundServer> mock_inbound_server;
+    NiceMock<MockOutboundClient> mock_order_request_client;
+
+    auto database_client = std::make_unique<NiceMock<MockDatabaseClient>>();
+    auto* mock_database_client = database_client.get();
+    {
+        InSequence sequence;
+        EXPECT_CALL(*mock_database_client,
+                    get_max_order_id(_, 0, std::numeric_limits<int>::max()))
+            .WillOnce(Return(std::optional<int>{41}));
+        EXPECT_CALL(*mock_database_client, reserve_order_id_block(1, 0, 42, order_id_block_size))
+            .WillOnce(Return(DbOrderIdBlock{.first_order_id = 500,
+                                            .end_order_id = 500 + order_id_block_size}));
+        EXPECT_CALL(*mock_database_client, reserve_order_id_block(1, 0, 500, order_id_block_size))
+            .WillOnce(Return(DbOrderIdBlock{.first_order_id = 500 + order_id_block_size,
+                                            .end_order_id = 500 + 2 * order_id_block_size}));
+    }
+
+    std::promise<int> persisted_order_id;
+    EXPECT_CALL(*mock_database_client, insert_order(_, _, _))
+        .WillOnce(Invoke([&](int internal_order_id, const core::NewOrderSingleContainer&,
+                             bool) -> std::expected<void, std::string> {
+            persisted_order_id.set_value(internal_order_id);
+            return {};
+        }));
+
+    OrderManagerShard shard{0,
+                            make_shard_order_id_allocator(0, 1),
+                            active_symbols,
+                            username_user_id_map,
+                            RiskLimits{},
+                            last_trade_prices,
+                            mock_inbound_server,
+                            mock_order_request_client,
+                            std::move(database_client),
+                            spdlog::default_logger()};
+
+    shard.resume(1, {});
+    shard.start(1, 0);
+    shard.post(GatewayRequest{.container =
+                                  core::NewOrderSingleContainer{.sender_comp_id = "CLIENT",
+                                                                .cl_ord_id = 100,
+                                                                .symbol = "AAPL",
+                                                                .side = core::Side::ask,
+                                                                .order_qty = 10,
+                                                                .ord_type = core::OrderType::limit,
+                                                                .price = 100},
+                              .arrival_gateway_id = 3});
+
+    auto persisted_order_id_future = persisted_order_id.get_future();
+    ASSERT_EQ(persisted_order_id_future.wait_for(std::chrono::seconds{5}),
+              std::future_status::ready);
+    EXPECT_EQ(persisted_order_id_future.get(), 500);
+}
+
+TEST(OrderManagerShardResumeTest, FailedBlockReservationIsNotRetriedOnEveryMessage) {
+    const std::unordered_set<std::string> active_symbols{"AAPL"};
+    const OrderManager::UsernameToUserIdMapContainer username_user_id_map{{"CLIENT", 1}};
+    const LastTradePrices last_trade_prices{{"AAPL"}};
+    NiceMock<MockInboundServer> mock_inbound_server;
+    NiceMock<MockOutboundClient> mock_order_request_client;
+
+    auto database_client = std::make_unique<NiceMock<MockDatabaseClient>>();
+    auto* mock_database_client = database_client.get();
+    ON_CALL(*mock_database_client, get_max_order_id).WillByDefault(Return(std::nullopt));
+    // The block handed out on resume succeeds, queueing the one after it keeps failing
+    EXPECT_CALL(*mock_database_client, reserve_order_id_block)
+        .WillOnce(
+            Return(DbOrderIdBlock{.first_order_id = 0, .end_order_id = order_id_block_size}))
+        .WillOnce(Return(std::unexpected{std::string{"connection lost"}}));
+
+    std::promise<void> orders_persisted;
+    int persisted_order_count = 0;
+    EXPECT_CALL(*mock_database_client, insert_order(_, _, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](int, const core::NewOrderSingleContainer&,
+                                   bool) -> std::expected<void, std::string> {
+            if (++persisted_order_count == 3) {
+                orders_persisted.set_value();
+            }
+            return {};
+        }));
+
+    OrderManagerShard shard{0,
+                            make_shard_order_id_allocator(0, 1),
+                            active_symbols,
+                            username_user_id_map,
+                            RiskLimits{},
+                            last_trade_prices,
+                            mock_inbound_server,
+                            mock_order_request_client,
+                            std::move(database_client),
+                            spdlog::default_logger()};
+
+    shard.resume(1, {});
+    shard.start(1, 0);
+    for (int cl_ord_id = 100; cl_ord_id < 103; ++cl_ord_id) {
+        shard.post(GatewayRequest{
+            .container = core::NewOrderSingleContainer{.sender_comp_id = "CLIENT",
+                                                       .cl_ord_id = cl_ord_id,
+                                                       .symbol = "AAPL",
+                                                       .side = core::Side::ask,
+                                                       .order_qty = 10,
+                                                       .ord_type = core::OrderType::limit,
+                                                       .price = 100},
+            .arrival_gateway_id = 3});
+    }
+
+    // Well within order_id_block_retry_interval, so the failed reservation is not repeated
+    ASSERT_EQ(orders_persisted.get_future().wait_for(std::chrono::seconds{5}),
+              std::future_status::ready);
+}
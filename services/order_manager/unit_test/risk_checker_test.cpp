@@ -0,0 +1,115 @@
+#include "risk_checker.h"
+#include <gtest/gtest.h>
+
+using namespace om;
+using namespace std::chrono_literals;
+
+constexpr BalanceChecker::UserId USER_1{0};
+constexpr BalanceChecker::UserId USER_2{1};
+
+// =====================================================================
+// LastTradePricesTest
+// =====================================================================
+
+TEST(LastTradePricesTest, NoPriceUntilSymbolTrades) {
+    LastTradePrices last_trade_prices{{"AAPL", "GOOGL"}};
+
+    EXPECT_FALSE(last_trade_prices.find("AAPL").has_value());
+
+    last_trade_prices.record("AAPL", 150);
+    last_trade_prices.record("AAPL", 155);
+
+    EXPECT_EQ(last_trade_prices.find("AAPL"), 155);
+    EXPECT_FALSE(last_trade_prices.find("GOOGL").has_value());
+}
+
+TEST(LastTradePricesTest, UnknownSymbolIsIgnored) {
+    LastTradePrices last_trade_prices{{"AAPL"}};
+
+    last_trade_prices.record("MSFT", 300);
+
+    EXPECT_FALSE(last_trade_prices.find("MSFT").has_value());
+}
+
+// =====================================================================
+// RiskCheckerTest
+// =====================================================================
+
+TEST(RiskCheckerTest, ZeroLimitsDisableEveryCheck) {
+    RiskChecker risk_checker{RiskLimits{}};
+    const auto now = RiskChecker::Clock::now();
+
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(risk_checker.admit_message(USER_1, now));
+        risk_checker.on_order_opened(USER_1);
+    }
+    EXPECT_TRUE(risk_checker.within_order_qty(1'000'000));
+    EXPECT_TRUE(risk_checker.within_order_notional(1'000'000'000'000));
+    EXPECT_TRUE(risk_checker.within_open_order_limit(USER_1));
+    EXPECT_TRUE(risk_checker.within_price_band(1, 1000));
+}
+
+TEST(RiskCheckerTest, OrderQtyAndNotionalLimitsAreInclusive) {
+    RiskChecker risk_checker{RiskLimits{.max_order_qty = 100, .max_order_notional = 10'000}};
+
+    EXPECT_TRUE(risk_checker.within_order_qty(100));
+    EXPECT_FALSE(risk_checker.within_order_qty(101));
+    EXPECT_TRUE(risk_checker.within_order_notional(10'000));
+    EXPECT_FALSE(risk_checker.within_order_notional(10'001));
+}
+
+TEST(RiskCheckerTest, OpenOrderLimitIsPerUser) {
+    RiskChecker risk_checker{RiskLimits{.max_open_orders_per_user = 2}};
+
+    risk_checker.on_order_opened(USER_1);
+    EXPECT_TRUE(risk_checker.within_open_order_limit(USER_1));
+
+    risk_checker.on_order_opened(USER_1);
+    EXPECT_FALSE(risk_checker.within_open_order_limit(USER_1));
+    EXPECT_TRUE(risk_checker.within_open_order_limit(USER_2));
+
+    risk_checker.on_order_closed(USER_1);
+    EXPECT_TRUE(risk_checker.within_open_order_limit(USER_1));
+    EXPECT_EQ(risk_checker.open_order_count(USER_1), 1);
+}
+
+TEST(RiskCheckerTest, PriceBandAroundLastTrade) {
+    RiskChecker risk_checker{RiskLimits{.price_band_bps = 1000}};
+
+    EXPECT_TRUE(risk_checker.within_price_band(500, std::nullopt));
+    EXPECT_TRUE(risk_checker.within_price_band(110, 100));
+    EXPECT_TRUE(risk_checker.within_price_band(90, 100));
+    EXPECT_FALSE(risk_checker.within_price_band(111, 100));
+    EXPECT_FALSE(risk_checker.within_price_band(89, 100));
+}
+
+TEST(RiskCheckerTest, MessageRateAllowsBurstThenRefills) {
+    RiskChecker risk_checker{RiskLimits{.max_messages_per_second = 10, .message_burst = 3}};
+    const auto now = RiskChecker::Clock::now();
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(risk_checker.admit_message(USER_1, now));
+    }
+    EXPECT_FALSE(risk_checker.admit_message(USER_1, now));
+    EXPECT_TRUE(risk_checker.admit_message(USER_2, now));
+
+    // One message is earned back every 100ms
+    EXPECT_FALSE(risk_checker.admit_message(USER_1, now + 99ms));
+    EXPECT_TRUE(risk_checker.admit_message(USER_1, now + 100ms));
+    EXPECT_FALSE(risk_checker.admit_message(USER_1, now + 100ms));
+}
+
+TEST(RiskCheckerTest, MessageRateWithoutBurstSpacesMessages) {
+    RiskChecker risk_checker{RiskLimits{.max_messages_per_second = 2}};
+    const auto now = RiskChecker::Clock::now();
+
+    EXPECT_TRUE(risk_checker.admit_message(USER_1, now));
+    EXPECT_FALSE(risk_checker.admit_message(USER_1, now + 499ms));
+    EXPECT_TRUE(risk_checker.admit_message(USER_1, now + 500ms));
+}
+
+TEST(RiskCheckerDeathTest, ClosingMoreOrdersThanOpenedAborts) {
+    RiskChecker risk_checker{RiskLimits{}};
+
+    EXPECT_DEATH(risk_checker.on_order_closed(USER_1), "");
+}
@@ -52,6 +52,7 @@ int main() {
         md_ws_clients.push_back(md_ws_client);
 
         auto md_handler = std::make_shared<MarketDataHandler>(md_ws_client);
+        md_handler->subscribe(config.tickers);
         md_handler->start();
         md_handlers.push_back(md_handler);
 
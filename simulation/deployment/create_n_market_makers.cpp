@@ -52,6 +52,7 @@ int main() {
 
         // Create and start the market data handler
         auto md_handler = std::make_shared<MarketDataHandler>(ws_client, market_maker_logger);
+        md_handler->subscribe(config.tickers);
         md_handler->start();
         md_handlers.push_back(md_handler);
 
@@ -58,6 +58,7 @@ int main() {
         ws_clients.push_back(ws_client);
 
         auto md_handler = std::make_shared<MarketDataHandler>(ws_client, noise_trader_logger);
+        md_handler->subscribe(config.tickers);
         md_handler->start();
         md_handlers.push_back(md_handler);
 
@@ -73,6 +73,12 @@ public:
         }
     }
 
+    // Asks the MDP for only these tickers' trades and best levels instead of every symbol. Call
+    // before start(), the requests go out once the connection is open.
+    void subscribe(std::vector<std::string> tickers) {
+        m_subscription_tickers = std::move(tickers);
+    }
+
     OrderBookSnapshot get_latest_orderbook(const std::string& ticker) {
         std::lock_guard<std::mutex> lock(m_mutex);
         return m_orderbooks[ticker];
@@ -93,6 +99,9 @@ public:
 private:
     void consume_loop() {
         while (m_running) {
+            if (!m_subscribed && !m_subscription_tickers.empty()) {
+                send_subscriptions();
+            }
             auto msg_opt = m_ws_client->dequeue_message(0);
             if (msg_opt) {
                 process_message(*msg_opt);
@@ -100,6 +109,25 @@ private:
         }
     }
 
+    void send_subscriptions() {
+        const auto metadata = m_ws_client->get_metadata(0);
+        if (!metadata || metadata->get_status() != transport::ConnectionStatus::open) {
+            return;
+        }
+        for (const auto& ticker : m_subscription_tickers) {
+            for (const auto* channel : {"trades", "top_of_book"}) {
+                nlohmann::json request{
+                    {"op", "subscribe"}, {"symbol", ticker}, {"channel", channel}};
+                auto res = m_ws_client->send(0, request.dump(), transport::MessageFormat::text);
+                if (!res && m_logger) {
+                    m_logger->error("[MarketDataHandler] Failed to subscribe to {} {}", ticker,
+                                    channel);
+                }
+            }
+        }
+        m_subscribed = true;
+    }
+
     void process_message(const std::string& msg) {
         try {
             auto j = nlohmann::json::parse(msg);
@@ -177,6 +205,9 @@ private:
     std::atomic<bool> m_running;
     std::thread m_thread;
 
+    std::vector<std::string> m_subscription_tickers;
+    bool m_subscribed{false};
+
     const size_t m_max_trades_window = 1000; // N past trades
 };
 